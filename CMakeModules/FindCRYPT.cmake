@@ -0,0 +1,24 @@
+if(CRYPT_LIBRARIES AND CRYPT_INCLUDE_DIRS)
+    set(CRYPT_FOUND TRUE)
+else()
+    find_path(
+        CRYPT_INCLUDE_DIR
+        NAMES crypt.h
+        PATHS /usr/include /usr/local/include /opt/local/include /sw/include ${CMAKE_INCLUDE_PATH} ${CMAKE_INSTALL_PREFIX}/include
+    )
+
+    find_library(
+        CRYPT_LIBRARY
+        NAMES crypt
+        PATHS /usr/lib /usr/lib64 /usr/local/lib /usr/local/lib64 /opt/local/lib /sw/lib ${CMAKE_LIBRARY_PATH} ${CMAKE_INSTALL_PREFIX}/lib
+    )
+
+    if(CRYPT_INCLUDE_DIR AND CRYPT_LIBRARY)
+        set(CRYPT_FOUND TRUE)
+    else(CRYPT_INCLUDE_DIR AND CRYPT_LIBRARY)
+        set(CRYPT_FOUND FALSE)
+    endif(CRYPT_INCLUDE_DIR AND CRYPT_LIBRARY)
+
+    set(CRYPT_INCLUDE_DIRS ${CRYPT_INCLUDE_DIR})
+    set(CRYPT_LIBRARIES ${CRYPT_LIBRARY})
+endif()
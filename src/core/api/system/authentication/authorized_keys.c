@@ -0,0 +1,892 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "authorized_keys.h"
+#include "key_index.h"
+#include "core/common.h"
+
+#include "core/data/system/authentication/authorized_key/list.h"
+
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <sysrepo.h>
+
+#include <utlist.h>
+
+#define SYSTEM_AUTHENTICATION_AUTHORIZED_KEYS_FILE "authorized_keys"
+#define SYSTEM_AUTHENTICATION_AUTHORIZED_KEYS_TEMP_FILE "authorized_keys+"
+
+static int system_authentication_authorized_keys_home(const char *user, char *buffer, size_t size);
+static bool system_authentication_authorized_keys_is_type(const char *iter, const char *end);
+static int system_authentication_authorized_keys_add_changes(system_authentication_authorized_key_change_t **changes, system_authorized_key_element_t *head, bool removed);
+static int system_authentication_authorized_keys_keep(system_authentication_authorized_key_line_t **lines, size_t *count, size_t *size, const char *line, size_t length, const char *data, size_t data_length, uint64_t hash);
+static int system_authentication_authorized_keys_affect(uint64_t **hashes, size_t *count, size_t *size, uint64_t hash);
+static int system_authentication_authorized_keys_build_user_index(const char *user);
+static int system_authentication_authorized_keys_write_index(const char *user, system_authentication_authorized_key_line_t *lines, size_t line_count, uint64_t *hashes, size_t hash_count);
+static int system_authentication_authorized_keys_write_entry(int user_fd, const char *user, uint64_t hash, const system_authentication_authorized_key_line_t *lines, size_t line_count);
+static int system_authentication_authorized_keys_compare_line(const void *a, const void *b);
+static int system_authentication_authorized_keys_compare_hash(const void *a, const void *b);
+
+int system_authentication_authorized_keys_apply(const char *user, system_authorized_key_element_t *created, system_authorized_key_element_t *modified, system_authorized_key_element_t *deleted)
+{
+	int error = 0;
+	char path_buffer[PATH_MAX] = {0};
+	int home_fd = -1;
+	int ssh_fd = -1;
+	int in_fd = -1;
+	int out_fd = -1;
+	FILE *in_file = NULL;
+	FILE *out_file = NULL;
+	struct stat home_stat = {0};
+	char *line = NULL;
+	size_t line_size = 0;
+	ssize_t line_length = 0;
+	bool ssh_created = false;
+	bool renamed = false;
+	system_authentication_authorized_key_view_t view = {0};
+	system_authentication_authorized_key_change_t *changes = NULL;
+	system_authentication_authorized_key_change_t *change = NULL, *tmp_change = NULL;
+	system_authentication_authorized_key_line_t *lines = NULL;
+	size_t line_count = 0, lines_size = 0;
+	uint64_t *hashes = NULL;
+	size_t hash_count = 0, hashes_size = 0;
+	char name_buffer[NAME_MAX + 1] = {0};
+	size_t new_line_length = 0;
+	uint64_t hash = 0;
+
+	if (system_authentication_authorized_keys_add_changes(&changes, created, false) ||
+		system_authentication_authorized_keys_add_changes(&changes, modified, false) ||
+		system_authentication_authorized_keys_add_changes(&changes, deleted, true)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_authorized_keys_add_changes() failed");
+		goto error_out;
+	}
+
+	if (!changes) {
+		goto out;
+	}
+
+	error = system_authentication_authorized_keys_home(user, path_buffer, sizeof(path_buffer));
+	if (error) {
+		goto error_out;
+	}
+
+	home_fd = open(path_buffer, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (home_fd == -1 || fstat(home_fd, &home_stat) == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to open home directory %s (%s)", path_buffer, strerror(errno));
+		goto error_out;
+	}
+
+	// ~/.ssh and authorized_keys belong to the owner of the home directory
+	if (mkdirat(home_fd, ".ssh", 0700) == 0) {
+		ssh_created = true;
+	} else if (errno != EEXIST) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "mkdirat() error for %s/.ssh (%s)", path_buffer, strerror(errno));
+		goto error_out;
+	}
+
+	ssh_fd = openat(home_fd, ".ssh", O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	if (ssh_fd == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "openat() error for %s/.ssh (%s)", path_buffer, strerror(errno));
+		goto error_out;
+	}
+
+	if (ssh_created && fchown(ssh_fd, home_stat.st_uid, home_stat.st_gid) == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fchown() error for %s/.ssh (%s)", path_buffer, strerror(errno));
+		goto error_out;
+	}
+
+	in_fd = openat(ssh_fd, SYSTEM_AUTHENTICATION_AUTHORIZED_KEYS_FILE, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+	if (in_fd == -1 && errno != ENOENT) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "openat() error for %s/.ssh/%s (%s)", path_buffer, SYSTEM_AUTHENTICATION_AUTHORIZED_KEYS_FILE, strerror(errno));
+		goto error_out;
+	}
+
+	if (in_fd != -1) {
+		in_file = fdopen(in_fd, "r");
+		if (!in_file) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "fdopen() error (%s)", strerror(errno));
+			goto error_out;
+		}
+		in_fd = -1;
+	}
+
+	out_fd = openat(ssh_fd, SYSTEM_AUTHENTICATION_AUTHORIZED_KEYS_TEMP_FILE, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0600);
+	if (out_fd == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "openat() error for %s/.ssh/%s (%s)", path_buffer, SYSTEM_AUTHENTICATION_AUTHORIZED_KEYS_TEMP_FILE, strerror(errno));
+		goto error_out;
+	}
+
+	if (fchown(out_fd, home_stat.st_uid, home_stat.st_gid) == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fchown() error (%s)", strerror(errno));
+		goto error_out;
+	}
+
+	out_file = fdopen(out_fd, "w");
+	if (!out_file) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fdopen() error (%s)", strerror(errno));
+		goto error_out;
+	}
+	out_fd = -1;
+
+	// existing lines - only managed lines of changed keys are replaced or dropped
+	while (in_file && (line_length = getline(&line, &line_size, in_file)) != -1) {
+		if (line_length && line[line_length - 1] == '\n') {
+			line[--line_length] = 0;
+		}
+
+		// comments and malformed lines are copied as they are
+		if (system_authentication_authorized_keys_parse(line, (size_t) line_length, &view)) {
+			if (fprintf(out_file, "%s\n", line) < 0) {
+				goto error_out;
+			}
+			continue;
+		}
+
+		hash = system_authentication_key_index_hash(view.data, view.data_length);
+
+		// other keys are copied as they are - they stay in the index with the managed lines of the same hash
+		if (!system_authentication_authorized_keys_is_managed(&view)) {
+			if (fprintf(out_file, "%s\n", line) < 0 || system_authentication_authorized_keys_keep(&lines, &line_count, &lines_size, line, (size_t) line_length, view.data, view.data_length, hash)) {
+				goto error_out;
+			}
+			continue;
+		}
+
+		change = NULL;
+		if (view.name_length < sizeof(name_buffer)) {
+			memcpy(name_buffer, view.name, view.name_length);
+			name_buffer[view.name_length] = 0;
+			HASH_FIND_STR(changes, name_buffer, change);
+		}
+
+		if (!change) {
+			if (fprintf(out_file, "%s\n", line) < 0 || system_authentication_authorized_keys_keep(&lines, &line_count, &lines_size, line, (size_t) line_length, view.data, view.data_length, hash)) {
+				goto error_out;
+			}
+			continue;
+		}
+
+		// the old key data is not indexed anymore
+		if (system_authentication_authorized_keys_affect(&hashes, &hash_count, &hashes_size, hash)) {
+			goto error_out;
+		}
+
+		// replaced in place - duplicates of the same name are dropped
+		if (change->applied || !change->key) {
+			change->applied = true;
+			continue;
+		}
+		change->applied = true;
+
+		if (fprintf(out_file, "%s %s %s\n", change->key->algorithm, change->key->data, change->name) < 0) {
+			goto error_out;
+		}
+	}
+
+	// keys not found in the file are appended
+	HASH_ITER(hh, changes, change, tmp_change)
+	{
+		if (!change->applied && change->key && fprintf(out_file, "%s %s %s\n", change->key->algorithm, change->key->data, change->name) < 0) {
+			goto error_out;
+		}
+	}
+
+	if (fflush(out_file) || fsync(fileno(out_file))) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to write %s/.ssh/%s (%s)", path_buffer, SYSTEM_AUTHENTICATION_AUTHORIZED_KEYS_TEMP_FILE, strerror(errno));
+		goto error_out;
+	}
+
+	if (renameat(ssh_fd, SYSTEM_AUTHENTICATION_AUTHORIZED_KEYS_TEMP_FILE, ssh_fd, SYSTEM_AUTHENTICATION_AUTHORIZED_KEYS_FILE) == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "renameat() error for %s/.ssh/%s (%s)", path_buffer, SYSTEM_AUTHENTICATION_AUTHORIZED_KEYS_FILE, strerror(errno));
+		goto error_out;
+	}
+	renamed = true;
+
+	// new and replaced keys are indexed with the kept lines of the same hash
+	HASH_ITER(hh, changes, change, tmp_change)
+	{
+		if (!change->key) {
+			continue;
+		}
+
+		new_line_length = strlen(change->key->algorithm) + strlen(change->key->data) + strlen(change->name) + 2;
+		if (new_line_length >= line_size) {
+			free(line);
+			line_size = new_line_length + 1;
+			line = malloc(line_size);
+			if (!line) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "malloc() failed");
+				goto error_out;
+			}
+		}
+		snprintf(line, line_size, "%s %s %s", change->key->algorithm, change->key->data, change->name);
+
+		hash = system_authentication_key_index_hash(change->key->data, strlen(change->key->data));
+
+		if (system_authentication_authorized_keys_keep(&lines, &line_count, &lines_size, line, new_line_length, change->key->data, strlen(change->key->data), hash) ||
+			system_authentication_authorized_keys_affect(&hashes, &hash_count, &hashes_size, hash)) {
+			goto error_out;
+		}
+	}
+
+	error = system_authentication_authorized_keys_write_index(user, lines, line_count, hashes, hash_count);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_authorized_keys_write_index() error (%d) for user %s", error, user);
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (out_file) {
+		fclose(out_file);
+	}
+
+	if (!renamed && ssh_fd != -1) {
+		unlinkat(ssh_fd, SYSTEM_AUTHENTICATION_AUTHORIZED_KEYS_TEMP_FILE, 0);
+	}
+
+	if (in_file) {
+		fclose(in_file);
+	}
+
+	if (in_fd != -1) {
+		close(in_fd);
+	}
+
+	if (out_fd != -1) {
+		close(out_fd);
+	}
+
+	if (ssh_fd != -1) {
+		close(ssh_fd);
+	}
+
+	if (home_fd != -1) {
+		close(home_fd);
+	}
+
+	HASH_ITER(hh, changes, change, tmp_change)
+	{
+		HASH_DEL(changes, change);
+		free(change);
+	}
+
+	for (size_t i = 0; i < line_count; i++) {
+		free(lines[i].line);
+	}
+
+	free(lines);
+	free(hashes);
+	free(line);
+
+	return error;
+}
+
+int system_authentication_authorized_keys_parse(const char *line, size_t length, system_authentication_authorized_key_view_t *view)
+{
+	const char *end = line + length;
+	const char *iter = line;
+	bool quoted = false;
+
+	*view = (system_authentication_authorized_key_view_t){0};
+
+	while (iter < end && (*iter == ' ' || *iter == '\t')) {
+		iter++;
+	}
+
+	if (iter == end || *iter == '#') {
+		return -1;
+	}
+
+	// options are separated from the key type by whitespace outside of quotes
+	if (!system_authentication_authorized_keys_is_type(iter, end)) {
+		view->options = iter;
+		while (iter < end && (quoted || (*iter != ' ' && *iter != '\t'))) {
+			if (*iter == '\\' && quoted && iter + 1 < end) {
+				iter++;
+			} else if (*iter == '"') {
+				quoted = !quoted;
+			}
+			iter++;
+		}
+		view->options_length = (size_t) (iter - view->options);
+
+		while (iter < end && (*iter == ' ' || *iter == '\t')) {
+			iter++;
+		}
+
+		if (quoted || !system_authentication_authorized_keys_is_type(iter, end)) {
+			return -1;
+		}
+	}
+
+	view->algorithm = iter;
+	while (iter < end && *iter != ' ' && *iter != '\t') {
+		iter++;
+	}
+	view->algorithm_length = (size_t) (iter - view->algorithm);
+
+	while (iter < end && (*iter == ' ' || *iter == '\t')) {
+		iter++;
+	}
+
+	view->data = iter;
+	while (iter < end && *iter != ' ' && *iter != '\t') {
+		iter++;
+	}
+	view->data_length = (size_t) (iter - view->data);
+
+	while (iter < end && (*iter == ' ' || *iter == '\t')) {
+		iter++;
+	}
+
+	// the comment is the key name - it can contain spaces
+	view->name = iter;
+	while (end > iter && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) {
+		end--;
+	}
+	view->name_length = (size_t) (end - iter);
+
+	return view->data_length ? 0 : -1;
+}
+
+bool system_authentication_authorized_keys_is_managed(const system_authentication_authorized_key_view_t *view)
+{
+	// the plugin writes lines without options and with the key name as the comment
+	return !view->options_length && view->name_length;
+}
+
+bool system_authentication_authorized_keys_check_name(const char *name)
+{
+	// the name ends the line - a newline in it would add lines to the file
+	for (const char *iter = name; *iter; iter++) {
+		if (iscntrl((unsigned char) *iter)) {
+			return false;
+		}
+	}
+
+	return *name != 0;
+}
+
+bool system_authentication_authorized_keys_check_algorithm(const char *algorithm)
+{
+	// the algorithm is the first field of the line - it is split on whitespace when read
+	for (const char *iter = algorithm; *iter; iter++) {
+		if (isspace((unsigned char) *iter) || iscntrl((unsigned char) *iter)) {
+			return false;
+		}
+	}
+
+	return *algorithm != 0;
+}
+
+int system_authentication_authorized_keys_remove_index(const char *user)
+{
+	int error = 0;
+	int index_fd = -1;
+	int user_fd = -1;
+	DIR *dir = NULL;
+	struct dirent *dir_entry = NULL;
+
+	if (system_authentication_key_index_check_user(user)) {
+		goto error_out;
+	}
+
+	// the index is kept only if its directory exists
+	index_fd = open(SYSTEM_AUTHENTICATION_KEY_INDEX_DIRECTORY, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (index_fd == -1) {
+		goto out;
+	}
+
+	user_fd = openat(index_fd, user, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	if (user_fd == -1) {
+		goto out;
+	}
+
+	dir = fdopendir(user_fd);
+	if (!dir) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fdopendir() error (%s)", strerror(errno));
+		goto error_out;
+	}
+
+	while ((dir_entry = readdir(dir)) != NULL) {
+		if (strcmp(dir_entry->d_name, ".") && strcmp(dir_entry->d_name, "..")) {
+			unlinkat(user_fd, dir_entry->d_name, 0);
+		}
+	}
+
+	if (unlinkat(index_fd, user, AT_REMOVEDIR) == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "unlinkat() error for the key index of user %s (%s)", user, strerror(errno));
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (dir) {
+		closedir(dir);
+	} else if (user_fd != -1) {
+		close(user_fd);
+	}
+
+	if (index_fd != -1) {
+		close(index_fd);
+	}
+
+	return error;
+}
+
+int system_authentication_authorized_keys_build_index(void)
+{
+	int error = 0;
+	int index_fd = -1;
+	DIR *dir = NULL;
+	struct dirent *dir_entry = NULL;
+
+	// the index is kept only if its directory exists
+	index_fd = open(SYSTEM_AUTHENTICATION_KEY_INDEX_DIRECTORY, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (index_fd == -1) {
+		goto out;
+	}
+
+	if (system_authentication_authorized_keys_build_user_index("root")) {
+		error = -1;
+	}
+
+	dir = opendir(SYSTEM_AUTHENTICATION_HOME_DIRECTORY);
+	if (!dir) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "opendir() error for %s (%s)", SYSTEM_AUTHENTICATION_HOME_DIRECTORY, strerror(errno));
+		goto error_out;
+	}
+
+	// every home directory is indexed - a user failing to index does not stop the others
+	while ((dir_entry = readdir(dir)) != NULL) {
+		if (dir_entry->d_name[0] == '.' || (dir_entry->d_type != DT_DIR && dir_entry->d_type != DT_UNKNOWN) || system_authentication_key_index_check_user(dir_entry->d_name)) {
+			continue;
+		}
+
+		if (system_authentication_authorized_keys_build_user_index(dir_entry->d_name)) {
+			error = -1;
+		}
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (dir) {
+		closedir(dir);
+	}
+
+	if (index_fd != -1) {
+		close(index_fd);
+	}
+
+	return error;
+}
+
+static int system_authentication_authorized_keys_home(const char *user, char *buffer, size_t size)
+{
+	int error = 0;
+
+	if (!strcmp(user, "root")) {
+		error = snprintf(buffer, size, "/root");
+	} else {
+		error = snprintf(buffer, size, "%s/%s", SYSTEM_AUTHENTICATION_HOME_DIRECTORY, user);
+	}
+
+	if (error < 0 || (size_t) error >= size) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
+		return -1;
+	}
+
+	return 0;
+}
+
+static bool system_authentication_authorized_keys_is_type(const char *iter, const char *end)
+{
+	const size_t length = (size_t) (end - iter);
+
+	return (length > 4 && !memcmp(iter, "ssh-", 4)) || (length > 6 && !memcmp(iter, "ecdsa-", 6)) || (length > 3 && !memcmp(iter, "sk-", 3));
+}
+
+static int system_authentication_authorized_keys_add_changes(system_authentication_authorized_key_change_t **changes, system_authorized_key_element_t *head, bool removed)
+{
+	system_authorized_key_element_t *iter = NULL;
+	system_authentication_authorized_key_change_t *change = NULL;
+
+	LL_FOREACH(head, iter)
+	{
+		// new keys need both parts of the line
+		if (!iter->key.name || (!removed && (!iter->key.algorithm || !iter->key.data))) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Incomplete authorized key %s", iter->key.name ? iter->key.name : "");
+			return -1;
+		}
+
+		// keys not checked by the change callbacks - key data is a single field like the algorithm
+		if (!removed && (!system_authentication_authorized_keys_check_name(iter->key.name) || !system_authentication_authorized_keys_check_algorithm(iter->key.algorithm) || !system_authentication_authorized_keys_check_algorithm(iter->key.data))) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Invalid authorized key line for key %s", iter->key.name);
+			return -1;
+		}
+
+		HASH_FIND_STR(*changes, iter->key.name, change);
+		if (!change) {
+			change = calloc(1, sizeof(*change));
+			if (!change) {
+				return -1;
+			}
+
+			change->name = iter->key.name;
+			HASH_ADD_KEYPTR(hh, *changes, change->name, strlen(change->name), change);
+		}
+
+		change->key = removed ? NULL : &iter->key;
+	}
+
+	return 0;
+}
+
+static int system_authentication_authorized_keys_keep(system_authentication_authorized_key_line_t **lines, size_t *count, size_t *size, const char *line, size_t length, const char *data, size_t data_length, uint64_t hash)
+{
+	system_authentication_authorized_key_line_t *new_lines = NULL;
+	char *entry_line = NULL;
+
+	if (*count == *size) {
+		new_lines = realloc(*lines, (*size ? *size * 2 : 16) * sizeof(**lines));
+		if (!new_lines) {
+			return -1;
+		}
+		*lines = new_lines;
+		*size = *size ? *size * 2 : 16;
+	}
+
+	// index lines start with the key data - the helper finds the offered key without parsing options
+	entry_line = malloc(data_length + length + 2);
+	if (!entry_line) {
+		return -1;
+	}
+	memcpy(entry_line, data, data_length);
+	entry_line[data_length] = ' ';
+	memcpy(entry_line + data_length + 1, line, length);
+	entry_line[data_length + length + 1] = 0;
+
+	(*lines)[*count].line = entry_line;
+	(*lines)[*count].hash = hash;
+	(*count)++;
+
+	return 0;
+}
+
+static int system_authentication_authorized_keys_affect(uint64_t **hashes, size_t *count, size_t *size, uint64_t hash)
+{
+	uint64_t *new_hashes = NULL;
+
+	if (*count == *size) {
+		new_hashes = realloc(*hashes, (*size ? *size * 2 : 16) * sizeof(**hashes));
+		if (!new_hashes) {
+			return -1;
+		}
+		*hashes = new_hashes;
+		*size = *size ? *size * 2 : 16;
+	}
+
+	(*hashes)[(*count)++] = hash;
+
+	return 0;
+}
+
+static int system_authentication_authorized_keys_build_user_index(const char *user)
+{
+	int error = 0;
+	char path_buffer[PATH_MAX] = {0};
+	int home_fd = -1;
+	int ssh_fd = -1;
+	int in_fd = -1;
+	FILE *in_file = NULL;
+	char *line = NULL;
+	size_t line_size = 0;
+	ssize_t line_length = 0;
+	system_authentication_authorized_key_view_t view = {0};
+	system_authentication_authorized_key_line_t *lines = NULL;
+	size_t line_count = 0, lines_size = 0;
+
+	// stale entries are dropped - the new user directory gets entries of all lines
+	error = system_authentication_authorized_keys_remove_index(user);
+	if (error) {
+		goto error_out;
+	}
+
+	error = system_authentication_authorized_keys_home(user, path_buffer, sizeof(path_buffer));
+	if (error) {
+		goto error_out;
+	}
+
+	// users without authorized_keys have nothing to index
+	home_fd = open(path_buffer, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (home_fd == -1) {
+		goto out;
+	}
+
+	ssh_fd = openat(home_fd, ".ssh", O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	if (ssh_fd == -1) {
+		goto out;
+	}
+
+	in_fd = openat(ssh_fd, SYSTEM_AUTHENTICATION_AUTHORIZED_KEYS_FILE, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+	if (in_fd == -1) {
+		goto out;
+	}
+
+	in_file = fdopen(in_fd, "r");
+	if (!in_file) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fdopen() error (%s)", strerror(errno));
+		goto error_out;
+	}
+	in_fd = -1;
+
+	// all keys are indexed - sshd reads only the index if AuthorizedKeysFile is disabled
+	while ((line_length = getline(&line, &line_size, in_file)) != -1) {
+		if (line_length && line[line_length - 1] == '\n') {
+			line[--line_length] = 0;
+		}
+
+		if (system_authentication_authorized_keys_parse(line, (size_t) line_length, &view)) {
+			continue;
+		}
+
+		if (system_authentication_authorized_keys_keep(&lines, &line_count, &lines_size, line, (size_t) line_length, view.data, view.data_length, system_authentication_key_index_hash(view.data, view.data_length))) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_authorized_keys_keep() failed");
+			goto error_out;
+		}
+	}
+
+	error = system_authentication_authorized_keys_write_index(user, lines, line_count, NULL, 0);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_authorized_keys_write_index() error (%d) for user %s", error, user);
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (in_file) {
+		fclose(in_file);
+	}
+
+	if (in_fd != -1) {
+		close(in_fd);
+	}
+
+	if (ssh_fd != -1) {
+		close(ssh_fd);
+	}
+
+	if (home_fd != -1) {
+		close(home_fd);
+	}
+
+	for (size_t i = 0; i < line_count; i++) {
+		free(lines[i].line);
+	}
+
+	free(lines);
+	free(line);
+
+	return error;
+}
+
+static int system_authentication_authorized_keys_write_index(const char *user, system_authentication_authorized_key_line_t *lines, size_t line_count, uint64_t *hashes, size_t hash_count)
+{
+	int error = 0;
+	int index_fd = -1;
+	int user_fd = -1;
+	bool user_created = false;
+	uint64_t hash = 0;
+	size_t hash_iter = 0, line_iter = 0, first_line = 0;
+
+	if (!hash_count && !line_count) {
+		goto out;
+	}
+
+	// the index is kept only if its directory exists - sshd reads authorized_keys otherwise
+	index_fd = open(SYSTEM_AUTHENTICATION_KEY_INDEX_DIRECTORY, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (index_fd == -1) {
+		goto out;
+	}
+
+	if (system_authentication_key_index_check_user(user)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to index keys of user %s", user);
+		goto error_out;
+	}
+
+	if (mkdirat(index_fd, user, 0755) == 0) {
+		user_created = true;
+	} else if (errno != EEXIST) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "mkdirat() error for the key index of user %s (%s)", user, strerror(errno));
+		goto error_out;
+	}
+
+	user_fd = openat(index_fd, user, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	if (user_fd == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "openat() error for the key index of user %s (%s)", user, strerror(errno));
+		goto error_out;
+	}
+
+	// lines and hashes are walked in hash order - every entry is written once with all lines of its hash
+	if (line_count) {
+		qsort(lines, line_count, sizeof(*lines), system_authentication_authorized_keys_compare_line);
+	}
+
+	if (hash_count) {
+		qsort(hashes, hash_count, sizeof(*hashes), system_authentication_authorized_keys_compare_hash);
+	}
+
+	// a new user directory gets entries of all lines - otherwise only affected entries are rewritten
+	while (hash_iter < hash_count || (user_created && line_iter < line_count)) {
+		if (user_created && line_iter < line_count && (hash_iter == hash_count || lines[line_iter].hash <= hashes[hash_iter])) {
+			hash = lines[line_iter].hash;
+		} else {
+			hash = hashes[hash_iter];
+		}
+
+		while (hash_iter < hash_count && hashes[hash_iter] == hash) {
+			hash_iter++;
+		}
+
+		while (line_iter < line_count && lines[line_iter].hash < hash) {
+			line_iter++;
+		}
+
+		first_line = line_iter;
+		while (line_iter < line_count && lines[line_iter].hash == hash) {
+			line_iter++;
+		}
+
+		if (system_authentication_authorized_keys_write_entry(user_fd, user, hash, lines + first_line, line_iter - first_line)) {
+			goto error_out;
+		}
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (user_fd != -1) {
+		close(user_fd);
+	}
+
+	if (index_fd != -1) {
+		close(index_fd);
+	}
+
+	return error;
+}
+
+static int system_authentication_authorized_keys_write_entry(int user_fd, const char *user, uint64_t hash, const system_authentication_authorized_key_line_t *lines, size_t line_count)
+{
+	int error = 0;
+	int entry_fd = -1;
+	FILE *entry_file = NULL;
+	char name_buffer[SYSTEM_AUTHENTICATION_KEY_INDEX_NAME_SIZE] = {0};
+	char temp_buffer[SYSTEM_AUTHENTICATION_KEY_INDEX_NAME_SIZE + 1] = {0};
+
+	system_authentication_key_index_name(hash, name_buffer);
+	snprintf(temp_buffer, sizeof(temp_buffer), "%s+", name_buffer);
+
+	// an entry without lines is removed
+	if (!line_count) {
+		if (unlinkat(user_fd, name_buffer, 0) == -1 && errno != ENOENT) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "unlinkat() error for the key index of user %s (%s)", user, strerror(errno));
+			goto error_out;
+		}
+		goto out;
+	}
+
+	entry_fd = openat(user_fd, temp_buffer, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0644);
+	if (entry_fd == -1 || (entry_file = fdopen(entry_fd, "w")) == NULL) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to write the key index of user %s (%s)", user, strerror(errno));
+		goto error_out;
+	}
+	entry_fd = -1;
+
+	for (size_t i = 0; i < line_count; i++) {
+		if (fprintf(entry_file, "%s\n", lines[i].line) < 0) {
+			goto error_out;
+		}
+	}
+
+	error = fclose(entry_file);
+	entry_file = NULL;
+	if (error) {
+		goto error_out;
+	}
+
+	if (renameat(user_fd, temp_buffer, user_fd, name_buffer) == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "renameat() error for the key index of user %s (%s)", user, strerror(errno));
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (entry_file) {
+		fclose(entry_file);
+	}
+
+	if (entry_fd != -1) {
+		close(entry_fd);
+	}
+
+	return error;
+}
+
+static int system_authentication_authorized_keys_compare_line(const void *a, const void *b)
+{
+	const uint64_t hash_a = ((const system_authentication_authorized_key_line_t *) a)->hash;
+	const uint64_t hash_b = ((const system_authentication_authorized_key_line_t *) b)->hash;
+
+	return (hash_a > hash_b) - (hash_a < hash_b);
+}
+
+static int system_authentication_authorized_keys_compare_hash(const void *a, const void *b)
+{
+	const uint64_t hash_a = *(const uint64_t *) a;
+	const uint64_t hash_b = *(const uint64_t *) b;
+
+	return (hash_a > hash_b) - (hash_a < hash_b);
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_API_AUTHENTICATION_AUTHORIZED_KEYS_H
+#define SYSTEM_PLUGIN_API_AUTHENTICATION_AUTHORIZED_KEYS_H
+
+#include "core/types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <uthash.h>
+
+typedef struct system_authentication_authorized_key_view_s system_authentication_authorized_key_view_t;
+typedef struct system_authentication_authorized_key_change_s system_authentication_authorized_key_change_t;
+typedef struct system_authentication_authorized_key_line_s system_authentication_authorized_key_line_t;
+
+// parts of a line of authorized_keys pointing into the line - not NUL terminated
+struct system_authentication_authorized_key_view_s {
+	const char *options; ///< Options before the key type - NULL if the line has none.
+	size_t options_length;
+	const char *algorithm;
+	size_t algorithm_length;
+	const char *data;
+	size_t data_length;
+	const char *name;
+	size_t name_length;
+};
+
+struct system_authentication_authorized_key_change_s {
+	const char *name;					///< Key name - the comment of the managed line.
+	const system_authorized_key_t *key; ///< New key - NULL if the key is removed.
+	bool applied;						///< Line of the key found in the file.
+	UT_hash_handle hh;
+};
+
+// key line kept in the file after the changes - used for updating the index
+struct system_authentication_authorized_key_line_s {
+	uint64_t hash; ///< Index hash of the key data.
+	char *line;	   ///< Key data and the whole line without the newline.
+};
+
+// split a line into options, key type, key data and comment - empty, comment and malformed lines are rejected
+int system_authentication_authorized_keys_parse(const char *line, size_t length, system_authentication_authorized_key_view_t *view);
+
+// managed keys are written as "<algorithm> <key-data> <name>" lines - other lines of the file are kept as they are
+bool system_authentication_authorized_keys_is_managed(const system_authentication_authorized_key_view_t *view);
+
+// key names must not contain control characters and algorithms must not contain whitespace - both are written into the line as they are
+bool system_authentication_authorized_keys_check_name(const char *name);
+bool system_authentication_authorized_keys_check_algorithm(const char *algorithm);
+
+// add, replace and remove managed lines by key name - the file is replaced atomically
+int system_authentication_authorized_keys_apply(const char *user, system_authorized_key_element_t *created, system_authorized_key_element_t *modified, system_authorized_key_element_t *deleted);
+
+// index all keys of root and of every home directory, including lines not managed by the plugin - stale entries are dropped
+int system_authentication_authorized_keys_build_index(void);
+
+// drop the index of a deleted user
+int system_authentication_authorized_keys_remove_index(const char *user);
+
+#endif // SYSTEM_PLUGIN_API_AUTHENTICATION_AUTHORIZED_KEYS_H
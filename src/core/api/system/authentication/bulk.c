@@ -0,0 +1,456 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+// explicit_bzero()
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "bulk.h"
+#include "scan.h"
+#include "core/common.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <linux/limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <sysrepo.h>
+#include <utlist.h>
+
+// batches run the password hashing and all change callbacks of their users
+#define SYSTEM_AUTHENTICATION_BULK_TIMEOUT_MS 60000
+
+// first line of exported files - skipped by the import as a comment, marks files an export may replace
+#define SYSTEM_AUTHENTICATION_BULK_EXPORT_HEADER "# sysrepo-plugin-system export-users\n"
+
+static void *system_authentication_bulk_worker(void *arg);
+static int system_authentication_bulk_set_user(sr_session_ctx_t *session, const system_authentication_record_t *record);
+static int system_authentication_bulk_apply(system_authentication_bulk_t *bulk, sr_session_ctx_t *session, uint64_t offset, uint32_t count);
+static int system_authentication_bulk_check_export(const char *path);
+
+void system_authentication_bulk_init(system_authentication_bulk_t *bulk)
+{
+	*bulk = (system_authentication_bulk_t){0};
+	pthread_mutex_init(&bulk->lock, NULL);
+}
+
+int system_authentication_bulk_import(system_authentication_bulk_t *bulk, sr_conn_ctx_t *connection, const char *path, uint32_t batch_size)
+{
+	int error = 0;
+	char *new_path = NULL;
+
+	if (access(path, R_OK) != 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to read %s: %s", path, strerror(errno));
+		goto error_out;
+	}
+
+	new_path = strdup(path);
+	if (!new_path) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "strdup() failed");
+		goto error_out;
+	}
+
+	pthread_mutex_lock(&bulk->lock);
+
+	if (bulk->status.running) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Import of %s is already running", bulk->path);
+		pthread_mutex_unlock(&bulk->lock);
+		goto error_out;
+	}
+
+	// the worker of the last import has finished - it does not take the lock anymore
+	if (bulk->started) {
+		pthread_join(bulk->worker, NULL);
+		bulk->started = false;
+	}
+
+	free(bulk->path);
+	bulk->path = new_path;
+	new_path = NULL;
+
+	bulk->connection = connection;
+	bulk->batch_size = batch_size ? batch_size : SYSTEM_AUTHENTICATION_BULK_BATCH_SIZE;
+	bulk->stop = false;
+	bulk->status = (system_authentication_bulk_status_t){.running = true};
+
+	error = pthread_create(&bulk->worker, NULL, system_authentication_bulk_worker, bulk);
+	if (error) {
+		bulk->status.running = false;
+		pthread_mutex_unlock(&bulk->lock);
+		SRPLG_LOG_ERR(PLUGIN_NAME, "pthread_create() error (%d)", error);
+		goto error_out;
+	}
+
+	bulk->started = true;
+
+	pthread_mutex_unlock(&bulk->lock);
+
+	SRPLG_LOG_INF(PLUGIN_NAME, "Importing users from %s in batches of %u users", path, batch_size ? batch_size : SYSTEM_AUTHENTICATION_BULK_BATCH_SIZE);
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	free(new_path);
+
+	return error;
+}
+
+int system_authentication_bulk_export(const system_local_user_element_t *head, const char *path, uint32_t *count)
+{
+	int error = 0;
+	const system_local_user_element_t *iter = NULL;
+	char temp_path[PATH_MAX] = {0};
+	int fd = -1;
+	FILE *file = NULL;
+
+	*count = 0;
+
+	// the path is given by the client - only files written by an earlier export are replaced
+	if (system_authentication_bulk_check_export(path)) {
+		goto error_out;
+	}
+
+	if (snprintf(temp_path, sizeof(temp_path), "%s.XXXXXX", path) >= (int) sizeof(temp_path)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Export path %s too long", path);
+		temp_path[0] = 0;
+		goto error_out;
+	}
+
+	// password hashes are exported - only the owner can read the file, an existing file or link is never opened
+	fd = mkostemp(temp_path, O_CLOEXEC);
+	if (fd == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "mkostemp() failed for %s: %s", temp_path, strerror(errno));
+		temp_path[0] = 0;
+		goto error_out;
+	}
+
+	file = fdopen(fd, "w");
+	if (!file) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fdopen() failed: %s", strerror(errno));
+		goto error_out;
+	}
+	fd = -1;
+
+	if (fputs(SYSTEM_AUTHENTICATION_BULK_EXPORT_HEADER, file) == EOF) {
+		goto write_error;
+	}
+
+	LL_FOREACH(head, iter)
+	{
+		if (fprintf(file, "%s:%s\n", iter->user.name, iter->user.password ? iter->user.password : "") < 0) {
+			goto write_error;
+		}
+		(*count)++;
+	}
+
+	// the file has to be on disk before it replaces an earlier export
+	if (fflush(file) != 0 || fsync(fileno(file)) != 0) {
+		goto write_error;
+	}
+
+	if (fclose(file) != 0) {
+		file = NULL;
+		goto write_error;
+	}
+	file = NULL;
+
+	if (rename(temp_path, path) != 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "rename() failed for %s: %s", path, strerror(errno));
+		goto error_out;
+	}
+
+	goto out;
+
+write_error:
+	SRPLG_LOG_ERR(PLUGIN_NAME, "Error writing %s: %s", temp_path, strerror(errno));
+
+error_out:
+	error = -1;
+
+	if (temp_path[0]) {
+		unlink(temp_path);
+	}
+
+out:
+	if (file) {
+		fclose(file);
+	}
+
+	if (fd != -1) {
+		close(fd);
+	}
+
+	return error;
+}
+
+void system_authentication_bulk_get_status(system_authentication_bulk_t *bulk, system_authentication_bulk_status_t *status)
+{
+	pthread_mutex_lock(&bulk->lock);
+	*status = bulk->status;
+	pthread_mutex_unlock(&bulk->lock);
+}
+
+void system_authentication_bulk_free(system_authentication_bulk_t *bulk)
+{
+	pthread_mutex_lock(&bulk->lock);
+	bulk->stop = true;
+	pthread_mutex_unlock(&bulk->lock);
+
+	if (bulk->started) {
+		pthread_join(bulk->worker, NULL);
+	}
+
+	free(bulk->path);
+
+	pthread_mutex_destroy(&bulk->lock);
+}
+
+static void *system_authentication_bulk_worker(void *arg)
+{
+	int error = 0;
+	system_authentication_bulk_t *bulk = arg;
+	sr_session_ctx_t *session = NULL;
+	FILE *file = NULL;
+	struct stat file_stat = {0};
+	char *line = NULL;
+	size_t line_size = 0;
+	ssize_t line_length = 0;
+	uint64_t offset = 0;
+	system_authentication_scan_t line_scan = {0};
+	system_authentication_record_t record = {0};
+	uint32_t count = 0;
+	bool stop = false;
+
+	error = sr_session_start(bulk->connection, SR_DS_RUNNING, &session);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_session_start() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	// the file is read, not mapped - the caller may change it while it is imported
+	file = fopen(bulk->path, "re");
+	if (!file || fstat(fileno(file), &file_stat) == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to open %s: %s", bulk->path, strerror(errno));
+		goto error_out;
+	}
+
+	pthread_mutex_lock(&bulk->lock);
+	bulk->status.total_bytes = (uint64_t) file_stat.st_size;
+	pthread_mutex_unlock(&bulk->lock);
+
+	while (!stop && (line_length = getline(&line, &line_size, file)) != -1) {
+		offset += (uint64_t) line_length;
+
+		// every line is scanned on its own - empty lines and comments yield no record
+		line_scan = (system_authentication_scan_t){.data = line, .size = (size_t) line_length};
+		if (!system_authentication_scan_next(&line_scan, &record)) {
+			continue;
+		}
+
+		error = system_authentication_bulk_set_user(session, &record);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_bulk_set_user() error (%d)", error);
+			goto error_out;
+		}
+
+		if (++count < bulk->batch_size) {
+			continue;
+		}
+
+		error = system_authentication_bulk_apply(bulk, session, offset, count);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_bulk_apply() error (%d)", error);
+			goto error_out;
+		}
+		count = 0;
+
+		pthread_mutex_lock(&bulk->lock);
+		stop = bulk->stop;
+		pthread_mutex_unlock(&bulk->lock);
+	}
+
+	if (ferror(file)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Error reading %s", bulk->path);
+		goto error_out;
+	}
+
+	if (count) {
+		error = system_authentication_bulk_apply(bulk, session, offset, count);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_bulk_apply() error (%d)", error);
+			goto error_out;
+		}
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	pthread_mutex_lock(&bulk->lock);
+	bulk->status.running = false;
+	bulk->status.failed = error != 0;
+	SRPLG_LOG_INF(PLUGIN_NAME, "Import of %s %s after %u users in %u batches", bulk->path, error ? "failed" : (stop ? "stopped" : "finished"), bulk->status.imported_users, bulk->status.batches);
+	pthread_mutex_unlock(&bulk->lock);
+
+	if (file) {
+		fclose(file);
+	}
+
+	// cleartext passwords of the last line read
+	if (line) {
+		explicit_bzero(line, line_size);
+		free(line);
+	}
+
+	if (session) {
+		// changes of a failed batch are not kept in the session
+		sr_session_stop(session);
+	}
+
+	return NULL;
+}
+
+static int system_authentication_bulk_set_user(sr_session_ctx_t *session, const system_authentication_record_t *record)
+{
+	int error = 0;
+	const system_authentication_field_t *name = &record->fields[0];
+	const char *password_end = NULL;
+	size_t password_length = 0;
+	char name_buffer[SYSTEM_AUTHENTICATION_NAME_MAX] = {0};
+	char password_buffer[SYSTEM_AUTHENTICATION_HASH_MAX] = {0};
+	char xpath_buffer[PATH_MAX] = {0};
+
+	// the name ends up in a predicate of the path
+	if (!name->length || name->length >= sizeof(name_buffer) || memchr(name->value, '\'', name->length)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Invalid user name %.*s", (int) name->length, name->value);
+		goto error_out;
+	}
+
+	memcpy(name_buffer, name->value, name->length);
+
+	// cleartext passwords can contain colons - the password is the rest of the record
+	if (record->count > 1) {
+		password_end = record->fields[record->count - 1].value + record->fields[record->count - 1].length;
+		password_length = (size_t) (password_end - record->fields[1].value);
+	}
+
+	if (password_length >= sizeof(password_buffer)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Password of user %s too long", name_buffer);
+		goto error_out;
+	}
+
+	if (password_length) {
+		memcpy(password_buffer, record->fields[1].value, password_length);
+		snprintf(xpath_buffer, sizeof(xpath_buffer), SYSTEM_AUTHENTICATION_USER_YANG_PATH "[name='%s']/password", name_buffer);
+	} else {
+		snprintf(xpath_buffer, sizeof(xpath_buffer), SYSTEM_AUTHENTICATION_USER_YANG_PATH "[name='%s']", name_buffer);
+	}
+
+	// existing users are kept - only the password is changed if given
+	error = sr_set_item_str(session, xpath_buffer, password_length ? password_buffer : NULL, NULL, 0);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_set_item_str() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	// cleartext passwords are hashed in the update event
+	explicit_bzero(password_buffer, sizeof(password_buffer));
+
+	return error;
+}
+
+static int system_authentication_bulk_apply(system_authentication_bulk_t *bulk, sr_session_ctx_t *session, uint64_t offset, uint32_t count)
+{
+	int error = 0;
+
+	// one transaction per batch - users are stored with one write of the user database by the apply worker
+	error = sr_apply_changes(session, SYSTEM_AUTHENTICATION_BULK_TIMEOUT_MS);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_apply_changes() error (%d): %s", error, sr_strerror(error));
+		sr_discard_changes(session);
+		goto error_out;
+	}
+
+	pthread_mutex_lock(&bulk->lock);
+	bulk->status.imported_users += count;
+	bulk->status.batches++;
+	bulk->status.processed_bytes = offset;
+	SRPLG_LOG_INF(PLUGIN_NAME, "Imported batch %u with %u users [ %" PRIu64 " of %" PRIu64 " bytes ]", bulk->status.batches, count, bulk->status.processed_bytes, bulk->status.total_bytes);
+	pthread_mutex_unlock(&bulk->lock);
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	return error;
+}
+
+static int system_authentication_bulk_check_export(const char *path)
+{
+	int error = 0;
+	int fd = -1;
+	struct stat file_stat = {0};
+	char header[sizeof(SYSTEM_AUTHENTICATION_BULK_EXPORT_HEADER) - 1] = {0};
+
+	// links and special files are not opened - a FIFO would block the RPC
+	fd = open(path, O_RDONLY | O_NOFOLLOW | O_NONBLOCK | O_CLOEXEC);
+	if (fd == -1) {
+		if (errno == ENOENT) {
+			goto out;
+		}
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Refusing to replace %s: %s", path, strerror(errno));
+		goto error_out;
+	}
+
+	if (fstat(fd, &file_stat) == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fstat() failed for %s: %s", path, strerror(errno));
+		goto error_out;
+	}
+
+	// exports are private regular files of the plugin starting with the header
+	if (!S_ISREG(file_stat.st_mode) || file_stat.st_nlink != 1 || file_stat.st_uid != geteuid() || (file_stat.st_mode & 0077) ||
+		read(fd, header, sizeof(header)) != (ssize_t) sizeof(header) || memcmp(header, SYSTEM_AUTHENTICATION_BULK_EXPORT_HEADER, sizeof(header))) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Refusing to replace %s - not a file written by export-users", path);
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (fd != -1) {
+		close(fd);
+	}
+
+	return error;
+}
@@ -0,0 +1,64 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_API_AUTHENTICATION_BULK_H
+#define SYSTEM_PLUGIN_API_AUTHENTICATION_BULK_H
+
+#include "core/types.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <pthread.h>
+#include <sysrepo_types.h>
+
+// users changed in one transaction of an import if not set by the caller
+#define SYSTEM_AUTHENTICATION_BULK_BATCH_SIZE 1000
+
+typedef struct system_authentication_bulk_status_s system_authentication_bulk_status_t;
+typedef struct system_authentication_bulk_s system_authentication_bulk_t;
+
+struct system_authentication_bulk_status_s {
+	bool running;			  ///< An import is in progress.
+	bool failed;			  ///< The last import stopped on an error.
+	uint32_t imported_users;  ///< Users of the current or last import applied to the running datastore.
+	uint32_t batches;		  ///< Batches of the current or last import applied to the running datastore.
+	uint64_t processed_bytes; ///< Bytes of the imported file read so far.
+	uint64_t total_bytes;	  ///< Size of the imported file.
+};
+
+// users are imported from a file by a background thread - every batch is one running datastore transaction
+struct system_authentication_bulk_s {
+	pthread_t worker;							///< Thread importing the file.
+	pthread_mutex_t lock;						///< Protects the worker state and the status.
+	bool started;								///< Worker thread started and not yet joined.
+	bool stop;									///< Worker thread should stop after the current batch.
+	sr_conn_ctx_t *connection;					///< Connection used for the import session.
+	char *path;									///< File being imported.
+	uint32_t batch_size;						///< Users changed in one transaction.
+	system_authentication_bulk_status_t status; ///< Status exposed as operational data.
+};
+
+void system_authentication_bulk_init(system_authentication_bulk_t *bulk);
+
+// start importing "name:password" records of the file into the running datastore - only one import runs at a time
+int system_authentication_bulk_import(system_authentication_bulk_t *bulk, sr_conn_ctx_t *connection, const char *path, uint32_t batch_size);
+
+// write users in the import format - the file is replaced once complete
+int system_authentication_bulk_export(const system_local_user_element_t *head, const char *path, uint32_t *count);
+
+void system_authentication_bulk_get_status(system_authentication_bulk_t *bulk, system_authentication_bulk_status_t *status);
+
+// stop the import after the current batch - batches already applied stay in the datastore
+void system_authentication_bulk_free(system_authentication_bulk_t *bulk);
+
+#endif // SYSTEM_PLUGIN_API_AUTHENTICATION_BULK_H
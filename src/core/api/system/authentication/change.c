@@ -13,6 +13,11 @@
 #include "change.h"
 #include "core/common.h"
 #include "libyang/tree_data.h"
+#include "core/api/system/authentication/authorized_keys.h"
+#include "core/api/system/authentication/key_data.h"
+#include "core/api/system/authentication/load.h"
+#include "core/api/system/authentication/patch.h"
+#include "core/api/system/authentication/scope.h"
 #include "core/api/system/authentication/store.h"
 #include "core/data/system/authentication/authorized_key.h"
 #include "core/data/system/authentication/authorized_key/list.h"
@@ -25,188 +30,225 @@
 
 #include <assert.h>
 #include <linux/limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sysrepo.h>
-#include <sysrepo/xpath.h>
+
+#include <srpc.h>
 
 #include <unistd.h>
 #include <utlist.h>
+#include <uthash.h>
 
-static int system_authentication_change_user_extract_name(sr_session_ctx_t *session, const struct lyd_node *node, char *name_buffer, size_t buffer_size);
-static int system_authentication_change_user_authorized_key_extract_name(sr_session_ctx_t *session, const struct lyd_node *node, char *name_buffer, size_t buffer_size);
-static int delete_home_directory(const char *username);
+static const struct lyd_node *system_authentication_change_get_list_node(const struct lyd_node *node, const char *list_name);
+static system_local_user_change_t *system_authentication_change_user_get_record(system_ctx_t *ctx, const struct lyd_node *node);
+static int system_authentication_change_user_get_keys(system_ctx_t *ctx, system_local_user_change_t *record, sr_change_oper_t operation, system_authorized_key_element_t ***keys);
+static system_authorized_key_element_t *system_authentication_change_user_get_key(system_ctx_t *ctx, system_local_user_change_t *record, const struct lyd_node *node, sr_change_oper_t operation);
+static int system_authentication_change_user_apply_keys(system_ctx_t *ctx, system_local_user_change_t *record);
+static int system_authentication_change_user_patch_created(system_authentication_patch_t *patch, const um_db_t *db, system_local_user_element_t *head);
+static int system_authentication_change_user_patch_scope_group(system_authentication_patch_t *patch, const system_authentication_scope_filter_t *filter, system_local_user_element_t *head);
 
-int system_authentication_user_apply_changes(system_ctx_t *ctx)
+int system_authentication_user_apply_changes(system_ctx_t *ctx, system_local_user_changes_t *changes)
 {
 	int error = 0;
 	um_db_t *user_db = NULL;
-	um_user_t *temp_user = NULL;
-	bool has_user_changes = false;
-	char file_path_buffer[PATH_MAX] = {0};
-
-	system_local_user_element_t *user_iter = NULL;
-	system_authorized_key_element_t *key_iter = NULL;
-
-	SRPLG_LOG_INF(PLUGIN_NAME, "Created users:");
-	LL_FOREACH(ctx->temp_users.created, user_iter)
-	{
-		SRPLG_LOG_INF(PLUGIN_NAME, "\t %s : %s", user_iter->user.name, user_iter->user.password);
+	system_local_user_change_t *record = NULL, *tmp_record = NULL;
+	system_local_user_element_t *created_head = NULL;
+	system_local_user_t temp_created = {0};
+	system_authentication_patch_t patch = {0};
+	system_authentication_scope_filter_t filter = {0};
+
+	system_authentication_patch_init(&patch);
+
+	// database loaded once when the changes were prepared - used for new UIDs and GIDs and for checking users
+	user_db = changes->db;
+	if (!user_db) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "User database not loaded for the changes");
+		goto error_out;
 	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "(Non)modified users:");
-	LL_FOREACH(ctx->temp_users.modified, user_iter)
-	{
-		SRPLG_LOG_INF(PLUGIN_NAME, "\t %s : %s", user_iter->user.name, user_iter->user.password);
+	error = system_authentication_scope_get_filter(&ctx->user_scope, &filter);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_scope_get_filter() error (%d)", error);
+		goto error_out;
 	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Deleted users:");
-	LL_FOREACH(ctx->temp_users.deleted, user_iter)
+	// changed records of all users in one pass
+	HASH_ITER(hh, changes->users, record, tmp_record)
 	{
-		SRPLG_LOG_INF(PLUGIN_NAME, "\t %s", user_iter->user.name);
-	}
+		switch (record->operation) {
+			case SR_OP_CREATED:
+				SRPLG_LOG_INF(PLUGIN_NAME, "Creating user %s", record->name);
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Created user keys:");
-	LL_FOREACH(ctx->temp_users.keys.created, user_iter)
-	{
-		SRPLG_LOG_INF(PLUGIN_NAME, "\tKeys for user %s:", user_iter->user.name);
-		LL_FOREACH(user_iter->user.key_head, key_iter)
-		{
-			SRPLG_LOG_INF(PLUGIN_NAME, "\t\t %s : %s : %s", key_iter->key.name, key_iter->key.algorithm, key_iter->key.data);
-		}
-	}
+				// created users are added below with the shared store API
+				system_local_user_init(&temp_created);
+				temp_created.name = record->name;
+				temp_created.password = record->password;
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Modified user keys:");
-	LL_FOREACH(ctx->temp_users.keys.modified, user_iter)
-	{
-		SRPLG_LOG_INF(PLUGIN_NAME, "\tKeys for user %s:", user_iter->user.name);
-		LL_FOREACH(user_iter->user.key_head, key_iter)
-		{
-			SRPLG_LOG_INF(PLUGIN_NAME, "\t\t %s : %s : %s", key_iter->key.name, key_iter->key.algorithm, key_iter->key.data);
-		}
-	}
+				error = system_local_user_list_add(&created_head, temp_created);
+				if (error) {
+					SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_add() error (%d) for user %s", error, record->name);
+					goto error_out;
+				}
+				break;
+			case SR_OP_MODIFIED:
+				if (!(record->changed & SYSTEM_LOCAL_USER_CHANGE_PASSWORD)) {
+					break;
+				}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Deleted user keys:");
-	LL_FOREACH(ctx->temp_users.keys.deleted, user_iter)
-	{
-		SRPLG_LOG_INF(PLUGIN_NAME, "\tKeys for user %s:", user_iter->user.name);
-		LL_FOREACH(user_iter->user.key_head, key_iter)
-		{
-			SRPLG_LOG_INF(PLUGIN_NAME, "\t\t %s : %s : %s", key_iter->key.name, key_iter->key.algorithm, key_iter->key.data);
+				if (!um_db_get_user(user_db, record->name)) {
+					SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to find user %s in the user database", record->name);
+					goto error_out;
+				}
+
+				SRPLG_LOG_INF(PLUGIN_NAME, "Changing password for user %s", record->name);
+				error = system_authentication_patch_set_field(&patch, SYSTEM_AUTHENTICATION_PATCH_SHADOW, record->name, 1, record->password ? record->password : SYSTEM_AUTHENTICATION_LOCKED_PASSWORD);
+				if (error) {
+					SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_patch_set_field() error (%d)", error);
+					goto error_out;
+				}
+				break;
+			case SR_OP_DELETED:
+				SRPLG_LOG_INF(PLUGIN_NAME, "Deleting user %s", record->name);
+
+				// remove user and user group records
+				for (int file = SYSTEM_AUTHENTICATION_PATCH_PASSWD; file < SYSTEM_AUTHENTICATION_PATCH_FILE_COUNT; file++) {
+					error = system_authentication_patch_remove(&patch, (enum system_authentication_patch_file_e) file, record->name);
+					if (error) {
+						SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_patch_remove() error (%d) for user %s", error, record->name);
+						goto error_out;
+					}
+				}
+				break;
+			case SR_OP_MOVED:
+				break;
 		}
 	}
 
-#define APPLY_CHANGES
-
-#ifdef APPLY_CHANGES
+	// new UIDs and GIDs are taken from the database
+	error = system_authentication_store_user_db(ctx, user_db, &filter, created_head);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_store_user_db() error (%d)", error);
+		goto error_out;
+	}
 
-	// for created users - use store API
-	error = system_authentication_store_user(ctx, ctx->temp_users.created);
+	error = system_authentication_change_user_patch_created(&patch, user_db, created_head);
 	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_store_user() error (%d)", error);
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_patch_created() error (%d)", error);
 		goto error_out;
 	}
 
-	user_db = um_db_new();
+	error = system_authentication_change_user_patch_scope_group(&patch, &filter, created_head);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_patch_scope_group() error (%d)", error);
+		goto error_out;
+	}
 
-	error = um_db_load(user_db);
+	// only the changed records are written - files without changes are not touched
+	error = system_authentication_patch_commit(&patch);
 	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_load() error (%d)", error);
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_patch_commit() error (%d)", error);
 		goto error_out;
 	}
 
-	if (ctx->temp_users.modified || ctx->temp_users.deleted) {
-		has_user_changes = true;
+	// created users have their UID and GID only after the database is stored
+	error = system_authentication_store_user_home(ctx, user_db, created_head);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_store_user_home() error (%d)", error);
+		goto error_out;
 	}
 
-	// for modified users - iterate and change passwords
-	LL_FOREACH(ctx->temp_users.modified, user_iter)
+	// home directories and keys - in the same order as the database changes
+	HASH_ITER(hh, changes->users, record, tmp_record)
 	{
-		// get user
-		temp_user = um_db_get_user(user_db, user_iter->user.name);
-		if (!temp_user) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to find user %s in the user database", user_iter->user.name);
-			goto error_out;
-		}
-
-		// if the password has changed - store new value
-		if ((user_iter->user.password == NULL && um_user_get_password_hash(temp_user) != NULL) || strcmp(user_iter->user.password, um_user_get_password_hash(temp_user))) {
-			SRPLG_LOG_INF(PLUGIN_NAME, "Password changed for %s: %s --> %s", user_iter->user.name, um_user_get_password_hash(temp_user), user_iter->user.password);
-			error = um_user_set_password_hash(temp_user, user_iter->user.password);
+		if (record->operation == SR_OP_DELETED) {
+			// keys are removed together with the home directory - only moved into the trash here
+			error = system_authentication_trash_home(&ctx->home_trash, record->name);
 			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "um_user_set_password_hash() error (%d)", error);
+				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_trash_home() error (%d)", error);
 				goto error_out;
 			}
-		}
-	}
 
-	// for deleted users - delete recursively home directory and remove user from the database
-	LL_FOREACH(ctx->temp_users.deleted, user_iter)
-	{
-		// 1. remove home directory of the user
-		error = delete_home_directory(user_iter->user.name);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "delete_home_directory() error (%d)", error);
-			goto error_out;
+			error = system_authentication_authorized_keys_remove_index(record->name);
+			if (error) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_authorized_keys_remove_index() error (%d)", error);
+				goto error_out;
+			}
+			continue;
 		}
 
-		// 2. remove user and user group from the database
-		error = um_db_delete_user(user_db, user_iter->user.name);
+		error = system_authentication_change_user_apply_keys(ctx, record);
 		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_delete_user() error (%d) for user %s", error, user_iter->user.name);
-			goto error_out;
-		}
-		error = um_db_delete_group(user_db, user_iter->user.name);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_delete_group() error (%d) for user %s", error, user_iter->user.name);
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_apply_keys() error (%d) for user %s", error, record->name);
 			goto error_out;
 		}
 	}
 
-	if (has_user_changes) {
-		error = um_db_store(user_db);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_store() error (%d)", error);
-			goto error_out;
-		}
-	}
+	goto out;
 
-	LL_FOREACH(ctx->temp_users.keys.created, user_iter)
-	{
-		error = system_authentication_store_user_authorized_key(ctx, user_iter->user.name, user_iter->user.key_head);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_store_user_authorized_key() error (%d) for user %s", error, user_iter->user.name);
-			goto error_out;
-		}
+error_out:
+	error = -1;
+
+out:
+	system_local_user_list_free(&created_head);
+	system_authentication_patch_free(&patch);
+	system_authentication_scope_filter_free(&filter);
+
+	return error;
+}
+
+int system_authentication_change_user_check(system_ctx_t *ctx, system_local_user_changes_t *changes)
+{
+	int error = 0;
+	system_authentication_scope_filter_t filter = {0};
+	system_local_user_change_t *record = NULL, *tmp_record = NULL;
+	const um_user_t *user = NULL;
+
+	if (!changes->users) {
+		goto out;
 	}
 
-	LL_FOREACH(ctx->temp_users.keys.modified, user_iter)
-	{
-		error = system_authentication_store_user_authorized_key(ctx, user_iter->user.name, user_iter->user.key_head);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_store_user_authorized_key() error (%d) for user %s", error, user_iter->user.name);
-			goto error_out;
-		}
+	error = system_authentication_scope_get_filter(&ctx->user_scope, &filter);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_scope_get_filter() error (%d)", error);
+		goto error_out;
 	}
 
-	LL_FOREACH(ctx->temp_users.keys.deleted, user_iter)
+	HASH_ITER(hh, changes->users, record, tmp_record)
 	{
-		LL_FOREACH(user_iter->user.key_head, key_iter)
-		{
-			if (snprintf(file_path_buffer, sizeof(file_path_buffer), "/home/%s/.ssh/%s", user_iter->user.name, key_iter->key.name) < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error");
+		if (record->operation == SR_OP_CREATED) {
+			// UID and groups of created users are set by the plugin - only the name is checked
+			if (!system_authentication_scope_filter_contains_name(&filter, record->name)) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "User %s is outside of the managed user scope", record->name);
+				goto error_out;
+			}
+
+			if (filter.group && !um_db_get_group(changes->db, filter.group)) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "Group %s of the managed user scope not found in the group database", filter.group);
 				goto error_out;
 			}
 
-			// file path written - remove file
-			error = remove(file_path_buffer);
-			if (error != 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "remove() failed (%d)", error);
+			// the group of a created user is written as a whole record - an existing group would be replaced
+			if (um_db_get_group(changes->db, record->name)) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to create user %s - group %s already exists", record->name, record->name);
 				goto error_out;
 			}
+			continue;
+		}
+
+		// changes of users missing from the system would fail only in the worker after the commit
+		user = um_db_get_user(changes->db, record->name);
+		if (!user) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to find user %s in the user database", record->name);
+			goto error_out;
+		}
+
+		if (!system_authentication_scope_filter_contains(&filter, record->name, (unsigned int) um_user_get_uid(user), (unsigned int) um_user_get_gid(user))) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "User %s is outside of the managed user scope", record->name);
+			goto error_out;
 		}
 	}
-#else
-	goto error_out;
-#endif
 
 	goto out;
 
@@ -214,51 +256,63 @@ error_out:
 	error = -1;
 
 out:
-	if (user_db) {
-		um_db_free(user_db);
-	}
+	system_authentication_scope_filter_free(&filter);
 
 	return error;
 }
 
+void system_authentication_change_user_free(system_local_user_changes_t *changes)
+{
+	system_local_user_change_t *record = NULL, *tmp_record = NULL;
+
+	if (changes->db) {
+		um_db_free(changes->db);
+	}
+
+	HASH_ITER(hh, changes->users, record, tmp_record)
+	{
+		HASH_DEL(changes->users, record);
+
+		free(record->name);
+		if (record->password) {
+			free(record->password);
+		}
+		system_authorized_key_list_free(&record->keys.created);
+		system_authorized_key_list_free(&record->keys.modified);
+		system_authorized_key_list_free(&record->keys.deleted);
+		free(record);
+	}
+
+	*changes = (system_local_user_changes_t){0};
+}
+
 int system_authentication_change_user_name(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
 {
 	int error = 0;
 	system_ctx_t *ctx = priv;
 	const char *node_name = LYD_NAME(change_ctx->node);
 	const char *node_value = lyd_get_value(change_ctx->node);
-	system_local_user_t user = {0};
+	system_local_user_change_t *record = NULL;
 
 	assert(strcmp(node_name, "name") == 0);
 
 	SRPLG_LOG_INF(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
-	system_local_user_init(&user);
+	record = system_authentication_change_user_get_record(ctx, change_ctx->node);
+	if (!record) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_get_record() failed");
+		goto error_out;
+	}
 
 	switch (change_ctx->operation) {
 		case SR_OP_CREATED:
-			// create new user and add it to the created list
-			user.name = (char *) node_value;
-
-			error = system_local_user_list_add(&ctx->temp_users.created, user);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_add() error (%d)", error);
-				goto error_out;
-			}
-
+		case SR_OP_DELETED:
+			// the key is walked first - other nodes of the user see the operation on the whole user
+			record->operation = change_ctx->operation;
 			break;
 		case SR_OP_MODIFIED:
 			// can't modify name
 			break;
-		case SR_OP_DELETED:
-			user.name = (char *) node_value;
-
-			error = system_local_user_list_add(&ctx->temp_users.deleted, user);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_add() error (%d)", error);
-				goto error_out;
-			}
-			break;
 		case SR_OP_MOVED:
 			break;
 	}
@@ -278,85 +332,52 @@ int system_authentication_change_user_password(void *priv, sr_session_ctx_t *ses
 	system_ctx_t *ctx = priv;
 	const char *node_name = LYD_NAME(change_ctx->node);
 	const char *node_value = lyd_get_value(change_ctx->node);
-	char username_buffer[33] = {0};
-	system_local_user_element_t *found_user = NULL;
+	system_local_user_change_t *record = NULL;
+	const char *password = NULL;
 
 	assert(strcmp(node_name, "password") == 0);
 
 	SRPLG_LOG_INF(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
-	// get username
-	error = system_authentication_change_user_extract_name(session, change_ctx->node, username_buffer, sizeof(username_buffer));
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_extract_name() error (%d)", error);
+	// get user record - username is the key of the parent list instance
+	record = system_authentication_change_user_get_record(ctx, change_ctx->node);
+	if (!record) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_get_record() failed");
 		goto error_out;
 	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Recieved user name: %s", username_buffer);
+	SRPLG_LOG_INF(PLUGIN_NAME, "Recieved user name: %s", record->name);
 
-	// got the username - able to continue with operation
 	switch (change_ctx->operation) {
 		case SR_OP_CREATED:
-			// find user and add password
-			found_user = system_local_user_list_find(ctx->temp_users.created, username_buffer);
-			if (!found_user) {
-				// user was not created but now the password is - modified user
-				found_user = system_local_user_list_find(ctx->temp_users.modified, username_buffer);
-				if (found_user) {
-					error = system_local_user_set_password(&found_user->user, node_value);
-					if (error) {
-						SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_set_password() error (%d)", error);
-						goto error_out;
-					}
-				} else {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_find() failed for user %s", username_buffer);
-					goto error_out;
-				}
-			} else {
-				// user found - set password
-				error = system_local_user_set_password(&found_user->user, node_value);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_set_password() error (%d)", error);
-					goto error_out;
-				}
-			}
-
-			break;
 		case SR_OP_MODIFIED:
-			// add user with the username and add the password to the modified list
-			found_user = system_local_user_list_find(ctx->temp_users.modified, username_buffer);
-			if (found_user) {
-				error = system_local_user_set_password(&found_user->user, node_value);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_set_password() error (%d)", error);
-					goto error_out;
-				}
-			} else {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_find() failed for user %s", username_buffer);
-				goto error_out;
-			}
+			password = node_value;
 			break;
 		case SR_OP_DELETED:
-			found_user = system_local_user_list_find(ctx->temp_users.deleted, username_buffer);
-			if (!found_user) {
-				// if user not deleted remove his password - modified user
-				found_user = system_local_user_list_find(ctx->temp_users.modified, username_buffer);
-				if (found_user) {
-					error = system_local_user_set_password(&found_user->user, NULL);
-					if (error) {
-						SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_set_password() error (%d)", error);
-						goto error_out;
-					}
-				} else {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_find() failed for user %s", username_buffer);
-					goto error_out;
-				}
+			// password of a deleted user is removed with the user - modified user has the password removed
+			if (record->operation == SR_OP_DELETED) {
+				goto out;
 			}
 			break;
 		case SR_OP_MOVED:
-			break;
+			goto out;
+	}
+
+	if (record->password) {
+		free(record->password);
+		record->password = NULL;
+	}
+
+	if (password) {
+		record->password = strdup(password);
+		if (!record->password) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "strdup() failed");
+			goto error_out;
+		}
 	}
 
+	record->changed |= SYSTEM_LOCAL_USER_CHANGE_PASSWORD;
+
 	goto out;
 
 error_out:
@@ -366,112 +387,197 @@ out:
 	return error;
 }
 
-static int system_authentication_change_user_extract_name(sr_session_ctx_t *session, const struct lyd_node *node, char *name_buffer, size_t buffer_size)
+int system_authentication_user_change_authorized_key_name(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
 {
 	int error = 0;
+	system_ctx_t *ctx = priv;
+	const char *node_name = LYD_NAME(change_ctx->node);
+	const char *node_value = lyd_get_value(change_ctx->node);
+	system_local_user_change_t *record = NULL;
+	system_authorized_key_element_t **keys = NULL;
+	system_authorized_key_t temp_key = {0};
 
-	const char *name = NULL;
+	assert(strcmp(node_name, "name") == 0);
 
-	sr_xpath_ctx_t xpath_ctx = {0};
-	char path_buffer[PATH_MAX] = {0};
+	SRPLG_LOG_INF(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
-	// get node full path
-	error = (lyd_path(node, LYD_PATH_STD, path_buffer, sizeof(path_buffer)) == NULL);
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_path() failed");
+	record = system_authentication_change_user_get_record(ctx, change_ctx->node);
+	if (!record) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_get_record() failed");
 		goto error_out;
 	}
 
-	// extract key
-	name = sr_xpath_key_value(path_buffer, "user", "name", &xpath_ctx);
-	if (!name) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_xpath_key_value() failed");
-		goto error_out;
-	}
+	SRPLG_LOG_INF(PLUGIN_NAME, "Recieved user name: %s", record->name);
 
-	// store to buffer
-	error = snprintf(name_buffer, buffer_size, "%s", name);
-	if (error < 0) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() failed");
-		goto error_out;
+	// setup data
+	temp_key.name = (char *) node_value;
+
+	switch (change_ctx->operation) {
+		case SR_OP_CREATED:
+		case SR_OP_MODIFIED:
+			if (!system_authentication_authorized_keys_check_name(node_value)) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "Invalid authorized key name of user %s", record->name);
+				goto error_out;
+			}
+			// fall through
+		case SR_OP_DELETED:
+			// get the keys delta of the user matching the operation
+			error = system_authentication_change_user_get_keys(ctx, record, change_ctx->operation, &keys);
+			if (error) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_get_keys() error (%d)", error);
+				goto error_out;
+			}
+
+			// add new key to the user keys
+			error = system_authorized_key_list_append(keys, temp_key, &ctx->temp_user_walk.key);
+			if (error) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_list_append() error (%d)", error);
+				goto error_out;
+			}
+
+			// algorithm and key-data of the key follow - remember where the key is
+			ctx->temp_user_walk.key_node = lyd_parent(change_ctx->node);
+			break;
+		case SR_OP_MOVED:
+			break;
 	}
 
-	error = 0;
 	goto out;
 
 error_out:
 	error = -1;
 
 out:
+
 	return error;
 }
 
-static int system_authentication_change_user_authorized_key_extract_name(sr_session_ctx_t *session, const struct lyd_node *node, char *name_buffer, size_t buffer_size)
+int system_authentication_user_change_authorized_key_algorithm(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
 {
 	int error = 0;
+	system_ctx_t *ctx = priv;
+	const char *node_name = LYD_NAME(change_ctx->node);
+	const char *node_value = lyd_get_value(change_ctx->node);
 
-	const char *name = NULL;
+	system_local_user_change_t *record = NULL;
+	system_authorized_key_element_t *key_el = NULL;
 
-	sr_xpath_ctx_t xpath_ctx = {0};
-	char path_buffer[PATH_MAX] = {0};
+	assert(strcmp(node_name, "algorithm") == 0);
 
-	// get node full path
-	error = (lyd_path(node, LYD_PATH_STD, path_buffer, sizeof(path_buffer)) == NULL);
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_path() failed");
+	SRPLG_LOG_INF(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
+
+	switch (change_ctx->operation) {
+		case SR_OP_CREATED:
+		case SR_OP_MODIFIED:
+			break;
+		case SR_OP_DELETED:
+			// if deleted, information not needed
+			goto out;
+			break;
+		case SR_OP_MOVED:
+			goto out;
+			break;
+	}
+
+	record = system_authentication_change_user_get_record(ctx, change_ctx->node);
+	if (!record) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_get_record() failed");
 		goto error_out;
 	}
 
-	// extract key
-	name = sr_xpath_key_value(path_buffer, "authorized-key", "name", &xpath_ctx);
-	if (!name) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_xpath_key_value() failed");
+	SRPLG_LOG_INF(PLUGIN_NAME, "Recieved user name: %s", record->name);
+
+	key_el = system_authentication_change_user_get_key(ctx, record, change_ctx->node, change_ctx->operation);
+	if (!key_el) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_get_key() failed");
+		goto error_out;
+	}
+
+	if (!system_authentication_authorized_keys_check_algorithm(node_value)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Invalid algorithm of authorized key %s of user %s", key_el->key.name, record->name);
 		goto error_out;
 	}
 
-	// store to buffer
-	error = snprintf(name_buffer, buffer_size, "%s", name);
-	if (error < 0) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() failed");
+	// set algorithm
+	error = system_authorized_key_set_algorithm(&key_el->key, node_value);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_set_algorithm() error (%d)", error);
 		goto error_out;
 	}
 
-	error = 0;
+	// key-data changed in the same commit is checked once it is set - otherwise the current key-data has to match the new algorithm
+	if (!srpc_ly_tree_get_child_leaf(lyd_parent(change_ctx->node), "key-data") && key_el->key.data) {
+		error = system_authentication_key_data_check(key_el->key.algorithm, key_el->key.data);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Invalid authorized key %s of user %s", key_el->key.name, record->name);
+			goto error_out;
+		}
+	}
+
 	goto out;
 
 error_out:
 	error = -1;
 
 out:
+
 	return error;
 }
 
-static int delete_home_directory(const char *username)
+int system_authentication_user_change_authorized_key_key_data(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
 {
 	int error = 0;
-	char home_buffer[PATH_MAX] = {0};
-	char command_buffer[PATH_MAX + 100] = {0};
+	system_ctx_t *ctx = priv;
+	const char *node_name = LYD_NAME(change_ctx->node);
+	const char *node_value = lyd_get_value(change_ctx->node);
+
+	system_local_user_change_t *record = NULL;
+	system_authorized_key_element_t *key_el = NULL;
 
-	error = snprintf(home_buffer, sizeof(home_buffer), "/home/%s", username);
-	if (error < 0) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
+	assert(strcmp(node_name, "key-data") == 0);
+
+	SRPLG_LOG_INF(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
+
+	switch (change_ctx->operation) {
+		case SR_OP_CREATED:
+		case SR_OP_MODIFIED:
+			break;
+		case SR_OP_DELETED:
+			// if deleted, information not needed
+			goto out;
+			break;
+		case SR_OP_MOVED:
+			goto out;
+			break;
+	}
+
+	record = system_authentication_change_user_get_record(ctx, change_ctx->node);
+	if (!record) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_get_record() failed");
 		goto error_out;
 	}
 
-	error = snprintf(command_buffer, sizeof(command_buffer), "rm -r %s", home_buffer);
-	if (error < 0) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
+	SRPLG_LOG_INF(PLUGIN_NAME, "Recieved user name: %s", record->name);
+
+	key_el = system_authentication_change_user_get_key(ctx, record, change_ctx->node, change_ctx->operation);
+	if (!key_el) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_get_key() failed");
+		goto error_out;
+	}
+
+	// set key-data
+	error = system_authorized_key_set_data(&key_el->key, node_value);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_set_data() error (%d)", error);
 		goto error_out;
 	}
 
-	// rm -r should return 0
-	error = system(command_buffer);
-	if (error != 0) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system() failed for command \"%s\"", command_buffer);
+	// malformed keys fail the commit before anything is applied - the algorithm precedes key-data in the walk
+	if (!key_el->key.algorithm || system_authentication_key_data_check(key_el->key.algorithm, key_el->key.data)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Invalid authorized key %s of user %s", key_el->key.name, record->name);
 		goto error_out;
 	}
 
-	error = 0;
 	goto out;
 
 error_out:
@@ -482,120 +588,91 @@ out:
 	return error;
 }
 
-int system_authentication_user_change_authorized_key_name(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
+void system_authentication_change_user_reset_walk(system_ctx_t *ctx)
 {
-	int error = 0;
-	system_ctx_t *ctx = priv;
-	const char *node_name = LYD_NAME(change_ctx->node);
-	const char *node_value = lyd_get_value(change_ctx->node);
-	char username_buffer[33] = {0};
-	system_local_user_element_t *user_el = NULL;
-	system_local_user_t temp_user = {0};
-	system_authorized_key_t temp_key = {0};
+	ctx->temp_user_walk = (system_local_user_walk_t){0};
+}
 
-	assert(strcmp(node_name, "name") == 0);
+static const struct lyd_node *system_authentication_change_get_list_node(const struct lyd_node *node, const char *list_name)
+{
+	// walk up to the list instance - its first child is the key
+	while (node && !(node->schema->nodetype == LYS_LIST && !strcmp(LYD_NAME(node), list_name))) {
+		node = lyd_parent(node);
+	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
+	return node;
+}
 
-	// get username
-	error = system_authentication_change_user_extract_name(session, change_ctx->node, username_buffer, sizeof(username_buffer));
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_extract_name() error (%d)", error);
-		goto error_out;
+static system_local_user_change_t *system_authentication_change_user_get_record(system_ctx_t *ctx, const struct lyd_node *node)
+{
+	system_local_user_walk_t *walk = &ctx->temp_user_walk;
+	system_local_user_change_t *record = NULL;
+	const struct lyd_node *user_node = system_authentication_change_get_list_node(node, "user");
+	const char *name = NULL;
+
+	if (!user_node) {
+		return NULL;
 	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Recieved user name: %s", username_buffer);
+	// changes of one user are walked one after another - look the record up only when the walk reaches the next user
+	if (walk->user_node == user_node) {
+		return walk->record;
+	}
 
-	// setup data
-	temp_user.name = username_buffer;
-	temp_key.name = (char *) node_value;
+	*walk = (system_local_user_walk_t){0};
 
-	switch (change_ctx->operation) {
-		case SR_OP_CREATED:
-			// check for user in the list
-			user_el = system_local_user_list_find(ctx->temp_users.keys.created, username_buffer);
-			if (!user_el) {
-				// user does not exist - create one
+	// list keys are always the first children of the instance
+	name = lyd_get_value(lyd_child(user_node));
 
-				// add user to the list
-				error = system_local_user_list_add(&ctx->temp_users.keys.created, temp_user);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_add() error (%d)", error);
-					goto error_out;
-				}
+	HASH_FIND_STR(ctx->temp_users.users, name, record);
+	if (!record) {
+		record = (system_local_user_change_t *) calloc(1, sizeof(system_local_user_change_t));
+		if (!record) {
+			return NULL;
+		}
 
-				// get user element
-				user_el = system_local_user_list_find(ctx->temp_users.keys.created, username_buffer);
-				if (!user_el) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_find() failed");
-					goto error_out;
-				}
-			}
+		record->name = strdup(name);
+		if (!record->name) {
+			free(record);
+			return NULL;
+		}
 
-			// add new key to the user keys list
-			error = system_authorized_key_list_add(&user_el->user.key_head, temp_key);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_list_add() error (%d)", error);
-				goto error_out;
-			}
-			break;
-		case SR_OP_MODIFIED:
-			// check for user in the list
-			user_el = system_local_user_list_find(ctx->temp_users.keys.modified, username_buffer);
-			if (!user_el) {
-				// user does not exist - create one
+		record->operation = SR_OP_MODIFIED;
 
-				// add user to the list
-				error = system_local_user_list_add(&ctx->temp_users.keys.modified, temp_user);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_add() error (%d)", error);
-					goto error_out;
-				}
+		HASH_ADD_KEYPTR(hh, ctx->temp_users.users, record->name, strlen(record->name), record);
+	}
 
-				// get user element
-				user_el = system_local_user_list_find(ctx->temp_users.keys.modified, username_buffer);
-				if (!user_el) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_find() failed");
-					goto error_out;
-				}
-			}
+	walk->user_node = user_node;
+	walk->record = record;
 
-			// add new key to the user keys list
-			error = system_authorized_key_list_add(&user_el->user.key_head, temp_key);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_list_add() error (%d)", error);
-				goto error_out;
-			}
-			break;
-		case SR_OP_DELETED:
-			// check for user in the list
-			user_el = system_local_user_list_find(ctx->temp_users.keys.deleted, username_buffer);
-			if (!user_el) {
-				// user does not exist - create one
+	return record;
+}
 
-				// add user to the list
-				error = system_local_user_list_add(&ctx->temp_users.keys.deleted, temp_user);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_add() error (%d)", error);
-					goto error_out;
-				}
+static int system_authentication_change_user_get_keys(system_ctx_t *ctx, system_local_user_change_t *record, sr_change_oper_t operation, system_authorized_key_element_t ***keys)
+{
+	int error = 0;
 
-				// get user element
-				user_el = system_local_user_list_find(ctx->temp_users.keys.deleted, username_buffer);
-				if (!user_el) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_find() failed");
+	switch (operation) {
+		case SR_OP_CREATED:
+			*keys = &record->keys.created;
+			break;
+		case SR_OP_MODIFIED:
+			// keys are modified in place - load current keys only for users with a modified key
+			if (!record->keys_loaded) {
+				error = system_authentication_load_user_authorized_key(ctx, record->name, &record->keys.modified);
+				if (error) {
+					SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_load_user_authorized_key() error (%d) for user %s", error, record->name);
 					goto error_out;
 				}
+				record->keys_loaded = true;
 			}
-
-			// add new key to the user keys list
-			error = system_authorized_key_list_add(&user_el->user.key_head, temp_key);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_list_add() error (%d)", error);
-				goto error_out;
-			}
+			*keys = &record->keys.modified;
+			break;
+		case SR_OP_DELETED:
+			*keys = &record->keys.deleted;
 			break;
 		case SR_OP_MOVED:
+			goto error_out;
 			break;
 	}
 
@@ -605,75 +682,48 @@ error_out:
 	error = -1;
 
 out:
-
 	return error;
 }
 
-int system_authentication_user_change_authorized_key_algorithm(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
+static system_authorized_key_element_t *system_authentication_change_user_get_key(system_ctx_t *ctx, system_local_user_change_t *record, const struct lyd_node *node, sr_change_oper_t operation)
 {
 	int error = 0;
-	system_ctx_t *ctx = priv;
-	const char *node_name = LYD_NAME(change_ctx->node);
-	const char *node_value = lyd_get_value(change_ctx->node);
-
-	char username_buffer[33] = {0};
-	char key_buffer[PATH_MAX] = {0};
-
-	system_local_user_element_t *user_el = NULL;
+	system_local_user_walk_t *walk = &ctx->temp_user_walk;
+	const struct lyd_node *key_node = system_authentication_change_get_list_node(node, "authorized-key");
+	system_authorized_key_element_t **keys = NULL;
 	system_authorized_key_element_t *key_el = NULL;
-	system_local_user_element_t **users_list = NULL;
 
-	assert(strcmp(node_name, "algorithm") == 0);
-
-	SRPLG_LOG_INF(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
+	if (!key_node) {
+		return NULL;
+	}
 
-	// get username
-	error = system_authentication_change_user_extract_name(session, change_ctx->node, username_buffer, sizeof(username_buffer));
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_extract_name() error (%d)", error);
-		goto error_out;
+	// key already resolved by an earlier node of the same key
+	if (walk->key_node == key_node) {
+		return walk->key;
 	}
 
-	// get key name
-	error = system_authentication_change_user_authorized_key_extract_name(session, change_ctx->node, key_buffer, sizeof(key_buffer));
+	error = system_authentication_change_user_get_keys(ctx, record, operation, &keys);
 	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_authorized_key_extract_name() error (%d)", error);
-		goto error_out;
+		return NULL;
 	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Recieved user name: %s", username_buffer);
-
-	switch (change_ctx->operation) {
-		case SR_OP_CREATED:
-			users_list = &ctx->temp_users.keys.created;
-			break;
-		case SR_OP_MODIFIED:
-			users_list = &ctx->temp_users.keys.modified;
-			break;
-		case SR_OP_DELETED:
-			// if deleted, information not needed
-			goto out;
-			break;
-		case SR_OP_MOVED:
-			break;
+	key_el = system_authorized_key_list_find(*keys, lyd_get_value(lyd_child(key_node)));
+	if (key_el) {
+		walk->key_node = key_node;
+		walk->key = key_el;
 	}
 
-	user_el = system_local_user_list_find(*users_list, username_buffer);
-	if (!user_el) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_find() failed");
-		goto error_out;
-	}
+	return key_el;
+}
 
-	key_el = system_authorized_key_list_find(user_el->user.key_head, key_buffer);
-	if (!key_el) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_list_find() failed");
-		goto error_out;
-	}
+static int system_authentication_change_user_apply_keys(system_ctx_t *ctx, system_local_user_change_t *record)
+{
+	int error = 0;
 
-	// set algorithm
-	error = system_authorized_key_set_algorithm(&key_el->key, node_value);
+	// all key changes of the user are applied in one rewrite of authorized_keys
+	error = system_authentication_authorized_keys_apply(record->name, record->keys.created, record->keys.modified, record->keys.deleted);
 	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_set_algorithm() error (%d)", error);
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_authorized_keys_apply() error (%d) for user %s", error, record->name);
 		goto error_out;
 	}
 
@@ -683,75 +733,103 @@ error_out:
 	error = -1;
 
 out:
-
 	return error;
 }
 
-int system_authentication_user_change_authorized_key_key_data(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
+static int system_authentication_change_user_patch_created(system_authentication_patch_t *patch, const um_db_t *db, system_local_user_element_t *head)
 {
 	int error = 0;
-	system_ctx_t *ctx = priv;
-	const char *node_name = LYD_NAME(change_ctx->node);
-	const char *node_value = lyd_get_value(change_ctx->node);
+	system_local_user_element_t *iter = NULL;
+	const um_user_t *user = NULL;
+	const char *name = NULL;
+	const char *password = NULL;
+	char line_buffer[PATH_MAX * 2] = {0};
 
-	char username_buffer[33] = {0};
-	char key_buffer[PATH_MAX] = {0};
+	// records in the same format as written by the store API - names, UIDs and GIDs are checked again against the locked files
+	LL_FOREACH(head, iter)
+	{
+		name = iter->user.name;
+		password = iter->user.password ? iter->user.password : SYSTEM_AUTHENTICATION_LOCKED_PASSWORD;
 
-	system_local_user_element_t *user_el = NULL;
-	system_authorized_key_element_t *key_el = NULL;
-	system_local_user_element_t **users_list = NULL;
+		// user has just been added to the database
+		user = um_db_get_user(db, name);
+		assert(user != NULL);
 
-	assert(strcmp(node_name, "key-data") == 0);
+		if (snprintf(line_buffer, sizeof(line_buffer), "%s:x:%u:%u:%s:%s:%s", name, um_user_get_uid(user), um_user_get_gid(user), SYSTEM_AUTHENTICATION_DEFAULT_GECOS, um_user_get_home_path(user), SYSTEM_AUTHENTICATION_DEFAULT_SHELL) < 0) {
+			goto error_out;
+		}
+		error = system_authentication_patch_add(patch, SYSTEM_AUTHENTICATION_PATCH_PASSWD, name, 2, line_buffer);
+		if (error) {
+			goto error_out;
+		}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
+		if (snprintf(line_buffer, sizeof(line_buffer), "%s:%s::%d:%d:%d:::", name, password, SYSTEM_AUTHENTICATION_DEFAULT_CHANGE_MIN, SYSTEM_AUTHENTICATION_DEFAULT_CHANGE_MAX, SYSTEM_AUTHENTICATION_DEFAULT_WARN_DAYS) < 0) {
+			goto error_out;
+		}
+		error = system_authentication_patch_add(patch, SYSTEM_AUTHENTICATION_PATCH_SHADOW, name, 0, line_buffer);
+		if (error) {
+			goto error_out;
+		}
 
-	// get username
-	error = system_authentication_change_user_extract_name(session, change_ctx->node, username_buffer, sizeof(username_buffer));
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_extract_name() error (%d)", error);
-		goto error_out;
-	}
+		// group of the user with the user as the only member
+		if (snprintf(line_buffer, sizeof(line_buffer), "%s:x:%u:%s", name, um_user_get_gid(user), name) < 0) {
+			goto error_out;
+		}
+		error = system_authentication_patch_add(patch, SYSTEM_AUTHENTICATION_PATCH_GROUP, name, 2, line_buffer);
+		if (error) {
+			goto error_out;
+		}
 
-	// get key name
-	error = system_authentication_change_user_authorized_key_extract_name(session, change_ctx->node, key_buffer, sizeof(key_buffer));
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_authorized_key_extract_name() error (%d)", error);
-		goto error_out;
+		if (snprintf(line_buffer, sizeof(line_buffer), "%s:%s:%s:%s", name, password, name, name) < 0) {
+			goto error_out;
+		}
+		error = system_authentication_patch_add(patch, SYSTEM_AUTHENTICATION_PATCH_GSHADOW, name, 0, line_buffer);
+		if (error) {
+			goto error_out;
+		}
 	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Recieved user name: %s", username_buffer);
+	goto out;
 
-	switch (change_ctx->operation) {
-		case SR_OP_CREATED:
-			users_list = &ctx->temp_users.keys.created;
-			break;
-		case SR_OP_MODIFIED:
-			users_list = &ctx->temp_users.keys.modified;
-			break;
-		case SR_OP_DELETED:
-			// if deleted, information not needed
-			goto out;
-			break;
-		case SR_OP_MOVED:
-			break;
+error_out:
+	error = -1;
+
+out:
+	return error;
+}
+
+static int system_authentication_change_user_patch_scope_group(system_authentication_patch_t *patch, const system_authentication_scope_filter_t *filter, system_local_user_element_t *head)
+{
+	int error = 0;
+	system_local_user_element_t *iter = NULL;
+	char *members = NULL;
+	size_t length = 0;
+	size_t offset = 0;
+
+	if (!filter->group || !head) {
+		goto out;
 	}
 
-	user_el = system_local_user_list_find(*users_list, username_buffer);
-	if (!user_el) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_find() failed");
-		goto error_out;
+	// created users are appended to the members in the locked file - gshadow members are not used for lookups
+	LL_FOREACH(head, iter)
+	{
+		length += strlen(iter->user.name) + 1;
 	}
 
-	key_el = system_authorized_key_list_find(user_el->user.key_head, key_buffer);
-	if (!key_el) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_list_find() failed");
+	members = malloc(length + 1);
+	if (!members) {
 		goto error_out;
 	}
 
-	// set key-data
-	error = system_authorized_key_set_data(&key_el->key, node_value);
+	LL_FOREACH(head, iter)
+	{
+		offset += (size_t) sprintf(members + offset, "%s%s", offset ? "," : "", iter->user.name);
+	}
+
+	members[offset] = 0;
+
+	error = system_authentication_patch_append_field(patch, SYSTEM_AUTHENTICATION_PATCH_GROUP, filter->group, 3, members);
 	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_set_data() error (%d)", error);
 		goto error_out;
 	}
 
@@ -761,6 +839,7 @@ error_out:
 	error = -1;
 
 out:
+	free(members);
 
 	return error;
-}
\ No newline at end of file
+}
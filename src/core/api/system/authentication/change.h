@@ -17,8 +17,15 @@
 
 #include <srpc.h>
 
-// apply changes gathered in callback functions below
-int system_authentication_user_apply_changes(system_ctx_t *ctx);
+// apply per-user changes gathered in callback functions below
+int system_authentication_user_apply_changes(system_ctx_t *ctx, system_local_user_changes_t *changes);
+void system_authentication_change_user_free(system_local_user_changes_t *changes);
+
+// check changed users against the database of the changes and the managed user scope - called before anything is planned
+int system_authentication_change_user_check(system_ctx_t *ctx, system_local_user_changes_t *changes);
+
+// reset the currently walked user - called after every changes walk
+void system_authentication_change_user_reset_walk(system_ctx_t *ctx);
 
 int system_authentication_change_user_name(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx);
 int system_authentication_change_user_password(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx);
@@ -40,9 +40,7 @@ srpc_check_status_t system_authentication_check_user(system_ctx_t *ctx, system_l
 	// compare
 	LL_FOREACH(head, user_el)
 	{
-		found_el = NULL;
-
-		LL_SEARCH(*system_head, found_el, user_el, system_local_user_element_cmp_fn);
+		found_el = system_local_user_list_find(*system_head, user_el->user.name);
 
 		if (found_el != NULL) {
 			contains_count++;
@@ -88,9 +86,7 @@ srpc_check_status_t system_authentication_check_user_authorized_key(system_ctx_t
 	// compare
 	LL_FOREACH(head, key_el)
 	{
-		found_el = NULL;
-
-		LL_SEARCH(system_key_head, found_el, key_el, system_authorized_key_element_cmp_fn);
+		found_el = system_authorized_key_list_find(system_key_head, key_el->key.name);
 
 		if (found_el != NULL) {
 			contains_count++;
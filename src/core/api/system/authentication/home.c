@@ -0,0 +1,352 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+// copy_file_range()
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "home.h"
+#include "core/common.h"
+#include "core/work_pool.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <linux/limits.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <sysrepo.h>
+
+typedef struct system_authentication_home_pool_s system_authentication_home_pool_t;
+
+struct system_authentication_home_pool_s {
+	system_authentication_home_t *homes;
+	int home_fd; ///< /home - new directories are created relative to it.
+};
+
+static void system_authentication_home_worker(system_work_pool_t *work_pool, void *arg);
+static int system_authentication_home_create(int home_fd, const system_authentication_home_t *home);
+static int system_authentication_home_copy_dir(int src_fd, int dst_fd, const uid_t uid, const gid_t gid);
+static int system_authentication_home_copy_file(int src_fd, int dst_fd, const char *name, const struct stat *st, const uid_t uid, const gid_t gid);
+static int system_authentication_home_copy_data(int in_fd, int out_fd, off_t size);
+
+int system_authentication_home_provision(system_authentication_home_t *homes, size_t count)
+{
+	int error = 0;
+	system_authentication_home_pool_t pool = {
+		.homes = homes,
+		.home_fd = -1,
+	};
+
+	if (!count) {
+		goto out;
+	}
+
+	pool.home_fd = open(SYSTEM_AUTHENTICATION_HOME_DIRECTORY, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (pool.home_fd == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "open() error for %s (%s)", SYSTEM_AUTHENTICATION_HOME_DIRECTORY, strerror(errno));
+		goto error_out;
+	}
+
+	system_work_pool_run(count, system_authentication_home_worker, &pool);
+
+	for (size_t i = 0; i < count; i++) {
+		if (homes[i].error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to provision home directory of user %s", homes[i].name);
+			error = -1;
+		}
+	}
+
+	if (error) {
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (pool.home_fd != -1) {
+		close(pool.home_fd);
+	}
+
+	return error;
+}
+
+static void system_authentication_home_worker(system_work_pool_t *work_pool, void *arg)
+{
+	system_authentication_home_pool_t *pool = arg;
+	size_t index = 0;
+
+	while (system_work_pool_next(work_pool, &index)) {
+		pool->homes[index].error = system_authentication_home_create(pool->home_fd, &pool->homes[index]);
+	}
+}
+
+static int system_authentication_home_create(int home_fd, const system_authentication_home_t *home)
+{
+	int error = 0;
+	int user_fd = -1;
+	int skel_fd = -1;
+
+	if (mkdirat(home_fd, home->name, 0700) == -1) {
+		if (errno == EEXIST) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Home directory for user %s exists", home->name);
+		} else {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "mkdirat() error for user %s (%s)", home->name, strerror(errno));
+		}
+		goto error_out;
+	}
+
+	user_fd = openat(home_fd, home->name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	if (user_fd == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "openat() error for user %s (%s)", home->name, strerror(errno));
+		goto error_out;
+	}
+
+	if (fchown(user_fd, home->uid, home->gid) == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fchown() error for user %s (%s)", home->name, strerror(errno));
+		goto error_out;
+	}
+
+	skel_fd = open(SYSTEM_AUTHENTICATION_SKEL_DIRECTORY, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (skel_fd == -1) {
+		SRPLG_LOG_INF(PLUGIN_NAME, "Unable to open directory %s", SYSTEM_AUTHENTICATION_SKEL_DIRECTORY);
+		goto error_out;
+	}
+
+	error = system_authentication_home_copy_dir(skel_fd, user_fd, home->uid, home->gid);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_home_copy_dir() error (%d) for user %s", error, home->name);
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (skel_fd != -1) {
+		close(skel_fd);
+	}
+
+	if (user_fd != -1) {
+		close(user_fd);
+	}
+
+	return error;
+}
+
+static int system_authentication_home_copy_dir(int src_fd, int dst_fd, const uid_t uid, const gid_t gid)
+{
+	int error = 0;
+	int dir_fd = -1;
+	int sub_src_fd = -1;
+	int sub_dst_fd = -1;
+	DIR *dir = NULL;
+	struct dirent *dir_entry = NULL;
+	struct stat st = {0};
+	char link_buffer[PATH_MAX] = {0};
+	ssize_t link_length = 0;
+
+	// the directory stream owns the duplicate - the caller keeps its descriptor
+	dir_fd = dup(src_fd);
+	if (dir_fd == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "dup() error (%s)", strerror(errno));
+		goto error_out;
+	}
+
+	dir = fdopendir(dir_fd);
+	if (!dir) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fdopendir() error (%s)", strerror(errno));
+		close(dir_fd);
+		goto error_out;
+	}
+
+	while ((dir_entry = readdir(dir)) != NULL) {
+		if (!strcmp(dir_entry->d_name, ".") || !strcmp(dir_entry->d_name, "..")) {
+			continue;
+		}
+
+		if (fstatat(src_fd, dir_entry->d_name, &st, AT_SYMLINK_NOFOLLOW) == -1) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "fstatat() error for %s (%s)", dir_entry->d_name, strerror(errno));
+			goto error_out;
+		}
+
+		if (S_ISDIR(st.st_mode)) {
+			if (mkdirat(dst_fd, dir_entry->d_name, 0700) == -1) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "mkdirat() error for %s (%s)", dir_entry->d_name, strerror(errno));
+				goto error_out;
+			}
+
+			sub_src_fd = openat(src_fd, dir_entry->d_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+			sub_dst_fd = openat(dst_fd, dir_entry->d_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+			if (sub_src_fd == -1 || sub_dst_fd == -1) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "openat() error for %s (%s)", dir_entry->d_name, strerror(errno));
+				goto error_out;
+			}
+
+			error = system_authentication_home_copy_dir(sub_src_fd, sub_dst_fd, uid, gid);
+			if (error) {
+				goto error_out;
+			}
+
+			// owner first - chown clears set-id bits of the mode
+			if (fchown(sub_dst_fd, uid, gid) == -1 || fchmod(sub_dst_fd, st.st_mode & 07777) == -1) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to set owner and mode of %s (%s)", dir_entry->d_name, strerror(errno));
+				goto error_out;
+			}
+
+			close(sub_src_fd);
+			sub_src_fd = -1;
+			close(sub_dst_fd);
+			sub_dst_fd = -1;
+		} else if (S_ISREG(st.st_mode)) {
+			error = system_authentication_home_copy_file(src_fd, dst_fd, dir_entry->d_name, &st, uid, gid);
+			if (error) {
+				goto error_out;
+			}
+		} else if (S_ISLNK(st.st_mode)) {
+			link_length = readlinkat(src_fd, dir_entry->d_name, link_buffer, sizeof(link_buffer) - 1);
+			if (link_length == -1) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "readlinkat() error for %s (%s)", dir_entry->d_name, strerror(errno));
+				goto error_out;
+			}
+			link_buffer[link_length] = 0;
+
+			if (symlinkat(link_buffer, dst_fd, dir_entry->d_name) == -1 || fchownat(dst_fd, dir_entry->d_name, uid, gid, AT_SYMLINK_NOFOLLOW) == -1) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to copy link %s (%s)", dir_entry->d_name, strerror(errno));
+				goto error_out;
+			}
+		}
+
+		// devices, sockets and fifos are not copied
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (sub_src_fd != -1) {
+		close(sub_src_fd);
+	}
+
+	if (sub_dst_fd != -1) {
+		close(sub_dst_fd);
+	}
+
+	if (dir) {
+		closedir(dir);
+	}
+
+	return error;
+}
+
+static int system_authentication_home_copy_file(int src_fd, int dst_fd, const char *name, const struct stat *st, const uid_t uid, const gid_t gid)
+{
+	int error = 0;
+	int in_fd = -1;
+	int out_fd = -1;
+
+	in_fd = openat(src_fd, name, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+	if (in_fd == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "openat() error for %s (%s)", name, strerror(errno));
+		goto error_out;
+	}
+
+	out_fd = openat(dst_fd, name, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+	if (out_fd == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "openat() error for %s (%s)", name, strerror(errno));
+		goto error_out;
+	}
+
+	// share the data blocks if the filesystem supports reflinks - copy them otherwise
+	if (ioctl(out_fd, FICLONE, in_fd) == -1) {
+		error = system_authentication_home_copy_data(in_fd, out_fd, st->st_size);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to copy %s (%s)", name, strerror(errno));
+			goto error_out;
+		}
+	}
+
+	// owner first - chown clears set-id bits of the mode
+	if (fchown(out_fd, uid, gid) == -1 || fchmod(out_fd, st->st_mode & 07777) == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to set owner and mode of %s (%s)", name, strerror(errno));
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (in_fd != -1) {
+		close(in_fd);
+	}
+
+	if (out_fd != -1) {
+		close(out_fd);
+	}
+
+	return error;
+}
+
+static int system_authentication_home_copy_data(int in_fd, int out_fd, off_t size)
+{
+	char buffer[65536];
+	ssize_t copied = 0;
+	ssize_t written = 0;
+	bool in_kernel = true;
+
+	while (size > 0) {
+		if (in_kernel) {
+			// copied in the kernel - no round trip of the data through user space
+			copied = copy_file_range(in_fd, NULL, out_fd, NULL, (size_t) size, 0);
+			if (copied == -1 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+				in_kernel = false;
+				continue;
+			}
+		} else {
+			copied = read(in_fd, buffer, sizeof(buffer));
+			for (ssize_t offset = 0; copied > 0 && offset < copied; offset += written) {
+				written = write(out_fd, buffer + offset, (size_t) (copied - offset));
+				if (written == -1) {
+					return -1;
+				}
+			}
+		}
+
+		if (copied == -1) {
+			return -1;
+		}
+
+		// file shrunk while copying
+		if (copied == 0) {
+			break;
+		}
+
+		size -= copied;
+	}
+
+	return 0;
+}
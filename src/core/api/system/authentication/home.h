@@ -0,0 +1,31 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_API_AUTHENTICATION_HOME_H
+#define SYSTEM_PLUGIN_API_AUTHENTICATION_HOME_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+typedef struct system_authentication_home_s system_authentication_home_t;
+
+struct system_authentication_home_s {
+	const char *name; ///< User name - the home directory is created in /home.
+	uid_t uid;
+	gid_t gid;
+	int error; ///< Set by the provisioning of this home directory.
+};
+
+// create home directories and copy the skel tree into them - homes are provisioned in parallel
+int system_authentication_home_provision(system_authentication_home_t *homes, size_t count);
+
+#endif // SYSTEM_PLUGIN_API_AUTHENTICATION_HOME_H
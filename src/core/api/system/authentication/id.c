@@ -0,0 +1,145 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "id.h"
+
+#include <string.h>
+
+#include <umgmt.h>
+#include <utlist.h>
+
+static void system_authentication_id_map_init(system_authentication_id_map_t *map);
+static void system_authentication_id_map_mark(system_authentication_id_map_t *map, unsigned int id);
+static int system_authentication_id_map_find(const system_authentication_id_map_t *map, unsigned int from, unsigned int *id);
+static int system_authentication_id_map_get(system_authentication_id_map_t *map, unsigned int *id);
+
+void system_authentication_id_allocator_init(system_authentication_id_allocator_t *allocator, const um_db_t *db)
+{
+	const um_user_element_t *user_iter = NULL;
+	const um_group_element_t *group_iter = NULL;
+
+	system_authentication_id_map_init(&allocator->uids);
+	system_authentication_id_map_init(&allocator->gids);
+
+	LL_FOREACH(um_db_get_user_list_head(db), user_iter)
+	{
+		system_authentication_id_map_mark(&allocator->uids, (unsigned int) um_user_get_uid(user_iter->user));
+	}
+
+	LL_FOREACH(um_db_get_group_list_head(db), group_iter)
+	{
+		system_authentication_id_map_mark(&allocator->gids, (unsigned int) um_group_get_gid(group_iter->group));
+	}
+}
+
+void system_authentication_id_allocator_restrict(system_authentication_id_allocator_t *allocator, const system_authentication_scope_filter_t *filter)
+{
+	unsigned int bit = 0;
+
+	// IDs outside of the ranges are marked without moving the cursor - the search skips them like used ones
+	for (unsigned int id = SYSTEM_AUTHENTICATION_ID_MIN; id <= SYSTEM_AUTHENTICATION_ID_MAX; id++) {
+		if (!system_authentication_scope_filter_contains_uid(filter, id)) {
+			bit = id - SYSTEM_AUTHENTICATION_ID_MIN;
+			allocator->uids.used[bit / 64] |= UINT64_C(1) << (bit % 64);
+		}
+	}
+}
+
+int system_authentication_id_allocator_get(system_authentication_id_allocator_t *allocator, uid_t *uid, gid_t *gid)
+{
+	unsigned int new_uid = 0;
+	unsigned int new_gid = 0;
+
+	if (system_authentication_id_map_get(&allocator->uids, &new_uid)) {
+		return -1;
+	}
+
+	if (system_authentication_id_map_get(&allocator->gids, &new_gid)) {
+		return -1;
+	}
+
+	*uid = (uid_t) new_uid;
+	*gid = (gid_t) new_gid;
+
+	return 0;
+}
+
+static void system_authentication_id_map_init(system_authentication_id_map_t *map)
+{
+	memset(map->used, 0, sizeof(map->used));
+	map->next = SYSTEM_AUTHENTICATION_ID_MIN;
+	map->wrapped = false;
+}
+
+static void system_authentication_id_map_mark(system_authentication_id_map_t *map, unsigned int id)
+{
+	unsigned int bit = 0;
+
+	// IDs outside of the window are never handed out
+	if (id < SYSTEM_AUTHENTICATION_ID_MIN || id > SYSTEM_AUTHENTICATION_ID_MAX) {
+		return;
+	}
+
+	bit = id - SYSTEM_AUTHENTICATION_ID_MIN;
+	map->used[bit / 64] |= UINT64_C(1) << (bit % 64);
+
+	// like useradd - new IDs follow the highest used one
+	if (id >= map->next) {
+		map->next = id + 1;
+	}
+}
+
+static int system_authentication_id_map_find(const system_authentication_id_map_t *map, unsigned int from, unsigned int *id)
+{
+	unsigned int bit = from - SYSTEM_AUTHENTICATION_ID_MIN;
+	size_t word = bit / 64;
+	uint64_t free_bits = 0;
+
+	if (from > SYSTEM_AUTHENTICATION_ID_MAX) {
+		return -1;
+	}
+
+	// free bits of the first word starting at the cursor
+	free_bits = ~map->used[word] & (~UINT64_C(0) << (bit % 64));
+
+	while (!free_bits) {
+		if (++word == SYSTEM_AUTHENTICATION_ID_WORDS) {
+			return -1;
+		}
+		free_bits = ~map->used[word];
+	}
+
+	bit = (unsigned int) (word * 64) + (unsigned int) __builtin_ctzll(free_bits);
+	if (bit >= SYSTEM_AUTHENTICATION_ID_COUNT) {
+		return -1;
+	}
+
+	*id = SYSTEM_AUTHENTICATION_ID_MIN + bit;
+
+	return 0;
+}
+
+static int system_authentication_id_map_get(system_authentication_id_map_t *map, unsigned int *id)
+{
+	if (system_authentication_id_map_find(map, map->next, id)) {
+		// window exhausted above the highest used ID - reuse free IDs from the start once
+		if (map->wrapped || system_authentication_id_map_find(map, SYSTEM_AUTHENTICATION_ID_MIN, id)) {
+			return -1;
+		}
+		map->wrapped = true;
+	}
+
+	system_authentication_id_map_mark(map, *id);
+	map->next = *id + 1;
+
+	return 0;
+}
@@ -0,0 +1,50 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_API_AUTHENTICATION_ID_H
+#define SYSTEM_PLUGIN_API_AUTHENTICATION_ID_H
+
+#include "core/common.h"
+#include "scope.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <umgmt/types.h>
+
+#define SYSTEM_AUTHENTICATION_ID_COUNT (SYSTEM_AUTHENTICATION_ID_MAX - SYSTEM_AUTHENTICATION_ID_MIN + 1)
+#define SYSTEM_AUTHENTICATION_ID_WORDS ((SYSTEM_AUTHENTICATION_ID_COUNT + 63) / 64)
+
+typedef struct system_authentication_id_map_s system_authentication_id_map_t;
+typedef struct system_authentication_id_allocator_s system_authentication_id_allocator_t;
+
+// used IDs of the managed window - one bit per ID
+struct system_authentication_id_map_s {
+	uint64_t used[SYSTEM_AUTHENTICATION_ID_WORDS];
+	unsigned int next; ///< Search for a free ID starts here - the cursor only moves forward within a transaction.
+	bool wrapped;	   ///< IDs below the highest used one are handed out.
+};
+
+// built once per transaction from the loaded database - hands out UIDs and GIDs without scanning the database again
+struct system_authentication_id_allocator_s {
+	system_authentication_id_map_t uids;
+	system_authentication_id_map_t gids;
+};
+
+void system_authentication_id_allocator_init(system_authentication_id_allocator_t *allocator, const um_db_t *db);
+
+// new UIDs are handed out only within the UID ranges of the managed user scope
+void system_authentication_id_allocator_restrict(system_authentication_id_allocator_t *allocator, const system_authentication_scope_filter_t *filter);
+int system_authentication_id_allocator_get(system_authentication_id_allocator_t *allocator, uid_t *uid, gid_t *gid);
+
+#endif // SYSTEM_PLUGIN_API_AUTHENTICATION_ID_H
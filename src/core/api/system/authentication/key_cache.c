@@ -0,0 +1,408 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "key_cache.h"
+#include "authorized_keys.h"
+#include "core/common.h"
+#include "core/work_pool.h"
+
+#include "core/data/system/authentication/authorized_key.h"
+#include "core/data/system/authentication/authorized_key/list.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <sysrepo.h>
+
+#include <utlist.h>
+
+#define SYSTEM_AUTHENTICATION_KEY_CACHE_FILE ".ssh/authorized_keys"
+
+typedef struct system_authentication_key_cache_job_s system_authentication_key_cache_job_t;
+typedef struct system_authentication_key_cache_pool_s system_authentication_key_cache_pool_t;
+
+struct system_authentication_key_cache_job_s {
+	system_local_user_element_t *user;
+	int error; ///< Set by the scan of this user.
+};
+
+struct system_authentication_key_cache_pool_s {
+	system_authentication_key_cache_t *cache;
+	system_authentication_key_cache_job_t *jobs;
+	size_t count;
+	int home_fd; ///< /home - key files are looked up relative to it.
+};
+
+static void system_authentication_key_cache_worker(system_work_pool_t *work_pool, void *arg);
+static int system_authentication_key_cache_scan(system_authentication_key_cache_t *cache, int home_fd, const char *user, system_authorized_key_element_t **head);
+static bool system_authentication_key_cache_is_valid(const system_authentication_key_cache_entry_t *entry, const struct stat *st);
+static int system_authentication_key_cache_parse(int fd, size_t size, system_authorized_key_element_t **keys);
+static int system_authentication_key_cache_copy(const system_authorized_key_element_t *keys, system_authorized_key_element_t **head);
+static void system_authentication_key_cache_drop(system_authentication_key_cache_t *cache, const char *user);
+
+void system_authentication_key_cache_init(system_authentication_key_cache_t *cache)
+{
+	pthread_mutex_init(&cache->lock, NULL);
+	cache->entries = NULL;
+}
+
+int system_authentication_key_cache_load(system_authentication_key_cache_t *cache, const char *user, system_authorized_key_element_t **head)
+{
+	int error = 0;
+	int home_fd = -1;
+
+	home_fd = open(SYSTEM_AUTHENTICATION_HOME_DIRECTORY, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (home_fd == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "open() error for %s (%s)", SYSTEM_AUTHENTICATION_HOME_DIRECTORY, strerror(errno));
+		goto error_out;
+	}
+
+	error = system_authentication_key_cache_scan(cache, home_fd, user, head);
+	if (error) {
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (home_fd != -1) {
+		close(home_fd);
+	}
+
+	return error;
+}
+
+int system_authentication_key_cache_load_users(system_authentication_key_cache_t *cache, system_local_user_element_t *head)
+{
+	int error = 0;
+	system_authentication_key_cache_pool_t pool = {
+		.cache = cache,
+		.jobs = NULL,
+		.count = 0,
+		.home_fd = -1,
+	};
+	system_local_user_element_t *user_iter = NULL;
+
+	LL_COUNT(head, user_iter, pool.count);
+	if (!pool.count) {
+		goto out;
+	}
+
+	pool.jobs = calloc(pool.count, sizeof(*pool.jobs));
+	if (!pool.jobs) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "calloc() failed");
+		goto error_out;
+	}
+
+	pool.count = 0;
+	LL_FOREACH(head, user_iter)
+	{
+		system_authorized_key_list_init(&user_iter->user.key_head);
+		pool.jobs[pool.count++].user = user_iter;
+	}
+
+	pool.home_fd = open(SYSTEM_AUTHENTICATION_HOME_DIRECTORY, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (pool.home_fd == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "open() error for %s (%s)", SYSTEM_AUTHENTICATION_HOME_DIRECTORY, strerror(errno));
+		goto error_out;
+	}
+
+	system_work_pool_run(pool.count, system_authentication_key_cache_worker, &pool);
+
+	for (size_t i = 0; i < pool.count; i++) {
+		if (pool.jobs[i].error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to load authorized keys of user %s", pool.jobs[i].user->user.name);
+			error = -1;
+		}
+	}
+
+	if (error) {
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (pool.home_fd != -1) {
+		close(pool.home_fd);
+	}
+
+	free(pool.jobs);
+
+	return error;
+}
+
+void system_authentication_key_cache_free(system_authentication_key_cache_t *cache)
+{
+	system_authentication_key_cache_entry_t *entry = NULL, *tmp_entry = NULL;
+
+	HASH_ITER(hh, cache->entries, entry, tmp_entry)
+	{
+		HASH_DEL(cache->entries, entry);
+		system_authorized_key_list_free(&entry->keys);
+		free(entry->user);
+		free(entry);
+	}
+
+	pthread_mutex_destroy(&cache->lock);
+}
+
+static void system_authentication_key_cache_worker(system_work_pool_t *work_pool, void *arg)
+{
+	system_authentication_key_cache_pool_t *pool = arg;
+	system_authentication_key_cache_job_t *job = NULL;
+	size_t index = 0;
+
+	while (system_work_pool_next(work_pool, &index)) {
+		job = &pool->jobs[index];
+		job->error = system_authentication_key_cache_scan(pool->cache, pool->home_fd, job->user->user.name, &job->user->user.key_head);
+	}
+}
+
+static int system_authentication_key_cache_scan(system_authentication_key_cache_t *cache, int home_fd, const char *user, system_authorized_key_element_t **head)
+{
+	int error = 0;
+	int user_fd = -1;
+	int keys_fd = -1;
+	struct stat keys_stat = {0};
+	system_authentication_key_cache_entry_t *entry = NULL;
+	system_authorized_key_element_t *keys = NULL;
+	bool locked = false;
+
+	if (!*user || !strcmp(user, ".") || !strcmp(user, "..") || strchr(user, '/')) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Invalid user name %s", user);
+		goto error_out;
+	}
+
+	// root keeps its home outside of /home
+	user_fd = !strcmp(user, "root") ? open("/root", O_RDONLY | O_DIRECTORY | O_CLOEXEC) : openat(home_fd, user, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	if (user_fd == -1 || fstatat(user_fd, SYSTEM_AUTHENTICATION_KEY_CACHE_FILE, &keys_stat, 0) == -1) {
+		if (errno == ENOENT || errno == ENOTDIR) {
+			SRPLG_LOG_INF(PLUGIN_NAME, "No authorized keys for user %s", user);
+			system_authentication_key_cache_drop(cache, user);
+			goto out;
+		}
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to access authorized keys of user %s (%s)", user, strerror(errno));
+		goto error_out;
+	}
+
+	// unchanged files are not read again
+	pthread_mutex_lock(&cache->lock);
+	locked = true;
+
+	HASH_FIND_STR(cache->entries, user, entry);
+	if (entry && system_authentication_key_cache_is_valid(entry, &keys_stat)) {
+		error = system_authentication_key_cache_copy(entry->keys, head);
+		goto out;
+	}
+
+	pthread_mutex_unlock(&cache->lock);
+	locked = false;
+
+	keys_fd = openat(user_fd, SYSTEM_AUTHENTICATION_KEY_CACHE_FILE, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+	if (keys_fd == -1 || fstat(keys_fd, &keys_stat) == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to open authorized keys of user %s (%s)", user, strerror(errno));
+		goto error_out;
+	}
+
+	error = system_authentication_key_cache_parse(keys_fd, (size_t) keys_stat.st_size, &keys);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_key_cache_parse() error (%d) for user %s", error, user);
+		goto error_out;
+	}
+
+	pthread_mutex_lock(&cache->lock);
+	locked = true;
+
+	HASH_FIND_STR(cache->entries, user, entry);
+	if (!entry) {
+		entry = calloc(1, sizeof(*entry));
+		if (!entry || !(entry->user = strdup(user))) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to allocate cache entry for user %s", user);
+			free(entry);
+			goto error_out;
+		}
+		HASH_ADD_KEYPTR(hh, cache->entries, entry->user, strlen(entry->user), entry);
+	}
+
+	// the identity is taken from the parsed file - a file replaced since is parsed again next time
+	system_authorized_key_list_free(&entry->keys);
+	entry->keys = keys;
+	entry->dev = keys_stat.st_dev;
+	entry->ino = keys_stat.st_ino;
+	entry->mtime = keys_stat.st_mtim;
+	entry->size = keys_stat.st_size;
+	keys = NULL;
+
+	error = system_authentication_key_cache_copy(entry->keys, head);
+	if (error) {
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (locked) {
+		pthread_mutex_unlock(&cache->lock);
+	}
+
+	if (keys_fd != -1) {
+		close(keys_fd);
+	}
+
+	if (user_fd != -1) {
+		close(user_fd);
+	}
+
+	system_authorized_key_list_free(&keys);
+
+	return error;
+}
+
+static bool system_authentication_key_cache_is_valid(const system_authentication_key_cache_entry_t *entry, const struct stat *st)
+{
+	return entry->dev == st->st_dev && entry->ino == st->st_ino && entry->size == st->st_size && entry->mtime.tv_sec == st->st_mtim.tv_sec && entry->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+static int system_authentication_key_cache_parse(int fd, size_t size, system_authorized_key_element_t **keys)
+{
+	int error = 0;
+	char *data = NULL;
+	const char *iter = NULL, *end = NULL, *line_end = NULL;
+	system_authentication_authorized_key_view_t view = {0};
+	system_authorized_key_t temp_key = {0};
+	char *buffer = NULL, *new_buffer = NULL;
+	size_t buffer_size = 0;
+	size_t needed = 0;
+
+	if (!size) {
+		goto out;
+	}
+
+	data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (data == MAP_FAILED) {
+		data = NULL;
+		SRPLG_LOG_ERR(PLUGIN_NAME, "mmap() error (%s)", strerror(errno));
+		goto error_out;
+	}
+
+	madvise(data, size, MADV_SEQUENTIAL);
+
+	for (iter = data, end = data + size; iter < end; iter = line_end + 1) {
+		line_end = memchr(iter, '\n', (size_t) (end - iter));
+		if (!line_end) {
+			line_end = end;
+		}
+
+		// keys not written by the plugin are not part of the configuration
+		if (system_authentication_authorized_keys_parse(iter, (size_t) (line_end - iter), &view) || !system_authentication_authorized_keys_is_managed(&view)) {
+			continue;
+		}
+
+		// the views are terminated in one scratch buffer - the list makes its own copies
+		needed = view.algorithm_length + view.data_length + view.name_length + 3;
+		if (needed > buffer_size) {
+			new_buffer = realloc(buffer, needed);
+			if (!new_buffer) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "realloc() failed");
+				goto error_out;
+			}
+			buffer = new_buffer;
+			buffer_size = needed;
+		}
+
+		system_authorized_key_init(&temp_key);
+		temp_key.algorithm = buffer;
+		temp_key.data = temp_key.algorithm + view.algorithm_length + 1;
+		temp_key.name = temp_key.data + view.data_length + 1;
+
+		memcpy(temp_key.algorithm, view.algorithm, view.algorithm_length);
+		temp_key.algorithm[view.algorithm_length] = 0;
+		memcpy(temp_key.data, view.data, view.data_length);
+		temp_key.data[view.data_length] = 0;
+		memcpy(temp_key.name, view.name, view.name_length);
+		temp_key.name[view.name_length] = 0;
+
+		// the first line of a name wins - names are list keys in the datastore
+		if (system_authorized_key_list_find(*keys, temp_key.name)) {
+			continue;
+		}
+
+		error = system_authorized_key_list_add(keys, temp_key);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_list_add() error (%d)", error);
+			goto error_out;
+		}
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+	system_authorized_key_list_free(keys);
+
+out:
+	if (data) {
+		munmap(data, size);
+	}
+
+	free(buffer);
+
+	return error;
+}
+
+static int system_authentication_key_cache_copy(const system_authorized_key_element_t *keys, system_authorized_key_element_t **head)
+{
+	const system_authorized_key_element_t *iter = NULL;
+
+	LL_FOREACH(keys, iter)
+	{
+		if (system_authorized_key_list_add(head, iter->key)) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_list_add() failed");
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static void system_authentication_key_cache_drop(system_authentication_key_cache_t *cache, const char *user)
+{
+	system_authentication_key_cache_entry_t *entry = NULL;
+
+	pthread_mutex_lock(&cache->lock);
+
+	HASH_FIND_STR(cache->entries, user, entry);
+	if (entry) {
+		HASH_DEL(cache->entries, entry);
+		system_authorized_key_list_free(&entry->keys);
+		free(entry->user);
+		free(entry);
+	}
+
+	pthread_mutex_unlock(&cache->lock);
+}
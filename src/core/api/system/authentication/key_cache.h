@@ -0,0 +1,53 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_API_AUTHENTICATION_KEY_CACHE_H
+#define SYSTEM_PLUGIN_API_AUTHENTICATION_KEY_CACHE_H
+
+#include "core/types.h"
+
+#include <pthread.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include <uthash.h>
+
+typedef struct system_authentication_key_cache_entry_s system_authentication_key_cache_entry_t;
+typedef struct system_authentication_key_cache_s system_authentication_key_cache_t;
+
+// parsed managed keys of one authorized_keys file - valid while the file identity below does not change
+struct system_authentication_key_cache_entry_s {
+	char *user;
+	dev_t dev;
+	ino_t ino;
+	struct timespec mtime;
+	off_t size;
+	system_authorized_key_element_t *keys;
+	UT_hash_handle hh; ///< Entries by user name.
+};
+
+struct system_authentication_key_cache_s {
+	pthread_mutex_t lock;							  ///< Protects the entries - files are parsed without holding it.
+	system_authentication_key_cache_entry_t *entries; ///< Parsed files by user name.
+};
+
+void system_authentication_key_cache_init(system_authentication_key_cache_t *cache);
+
+// copy managed keys of the user into the list - the file is parsed only if it changed since the last call
+int system_authentication_key_cache_load(system_authentication_key_cache_t *cache, const char *user, system_authorized_key_element_t **head);
+
+// load keys of all users into their key lists - users are scanned in parallel
+int system_authentication_key_cache_load_users(system_authentication_key_cache_t *cache, system_local_user_element_t *head);
+
+void system_authentication_key_cache_free(system_authentication_key_cache_t *cache);
+
+#endif // SYSTEM_PLUGIN_API_AUTHENTICATION_KEY_CACHE_H
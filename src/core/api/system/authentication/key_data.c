@@ -0,0 +1,306 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "key_data.h"
+#include "core/common.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sysrepo.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define SYSTEM_AUTHENTICATION_KEY_DATA_AVX2
+#endif
+
+// fields of the known key formats - mpint fields are encoded as strings
+#define SYSTEM_AUTHENTICATION_KEY_DATA_FIELDS_MAX 8
+
+#define SYSTEM_AUTHENTICATION_KEY_DATA_CERT_SUFFIX "-cert-v01@openssh.com"
+
+typedef struct system_authentication_key_data_field_s system_authentication_key_data_field_t;
+typedef struct system_authentication_key_data_format_s system_authentication_key_data_format_t;
+
+struct system_authentication_key_data_field_s {
+	const uint8_t *value;
+	uint32_t length;
+};
+
+struct system_authentication_key_data_format_s {
+	const char *algorithm;
+	unsigned int fields; ///< Fields including the format identifier.
+	uint32_t key_length; ///< Length of the second field - 0 if not fixed.
+	const char *curve;	 ///< Curve name in the second field - NULL for other keys.
+};
+
+static const system_authentication_key_data_format_t system_authentication_key_data_formats[] = {
+	{"ssh-rsa", 3, 0, NULL},
+	{"ssh-dss", 5, 0, NULL},
+	{"ssh-ed25519", 2, 32, NULL},
+	{"ecdsa-sha2-nistp256", 3, 0, "nistp256"},
+	{"ecdsa-sha2-nistp384", 3, 0, "nistp384"},
+	{"ecdsa-sha2-nistp521", 3, 0, "nistp521"},
+	{"sk-ssh-ed25519@openssh.com", 3, 32, NULL},
+	{"sk-ecdsa-sha2-nistp256@openssh.com", 4, 0, "nistp256"},
+};
+
+// 6-bit values of the base64 alphabet - 0xff for other characters
+static const uint8_t system_authentication_key_data_base64[256] = {
+	['A'] = 0, ['B'] = 1, ['C'] = 2, ['D'] = 3, ['E'] = 4, ['F'] = 5, ['G'] = 6, ['H'] = 7,
+	['I'] = 8, ['J'] = 9, ['K'] = 10, ['L'] = 11, ['M'] = 12, ['N'] = 13, ['O'] = 14, ['P'] = 15,
+	['Q'] = 16, ['R'] = 17, ['S'] = 18, ['T'] = 19, ['U'] = 20, ['V'] = 21, ['W'] = 22, ['X'] = 23,
+	['Y'] = 24, ['Z'] = 25, ['a'] = 26, ['b'] = 27, ['c'] = 28, ['d'] = 29, ['e'] = 30, ['f'] = 31,
+	['g'] = 32, ['h'] = 33, ['i'] = 34, ['j'] = 35, ['k'] = 36, ['l'] = 37, ['m'] = 38, ['n'] = 39,
+	['o'] = 40, ['p'] = 41, ['q'] = 42, ['r'] = 43, ['s'] = 44, ['t'] = 45, ['u'] = 46, ['v'] = 47,
+	['w'] = 48, ['x'] = 49, ['y'] = 50, ['z'] = 51, ['0'] = 52, ['1'] = 53, ['2'] = 54, ['3'] = 55,
+	['4'] = 56, ['5'] = 57, ['6'] = 58, ['7'] = 59, ['8'] = 60, ['9'] = 61, ['+'] = 62, ['/'] = 63,
+};
+
+static int system_authentication_key_data_decode_tail(const char *data, size_t length, uint8_t *out, size_t *out_length);
+static bool system_authentication_key_data_is_base64(char c);
+static int system_authentication_key_data_read_field(const uint8_t **iter, const uint8_t *end, system_authentication_key_data_field_t *field);
+#ifdef SYSTEM_AUTHENTICATION_KEY_DATA_AVX2
+static size_t system_authentication_key_data_decode_avx2(const char *data, size_t length, uint8_t *out);
+#endif
+
+int system_authentication_key_data_decode(const char *data, size_t length, uint8_t *out, size_t *out_length)
+{
+	size_t done = 0;
+
+	if (!length || length % 4) {
+		return -1;
+	}
+
+#ifdef SYSTEM_AUTHENTICATION_KEY_DATA_AVX2
+	// whole blocks before the last quad - it can hold the padding
+	if (__builtin_cpu_supports("avx2")) {
+		done = system_authentication_key_data_decode_avx2(data, length, out);
+	}
+#endif
+
+	if (system_authentication_key_data_decode_tail(data + done, length - done, out + done / 4 * 3, out_length)) {
+		return -1;
+	}
+
+	*out_length += done / 4 * 3;
+
+	return 0;
+}
+
+int system_authentication_key_data_decode_scalar(const char *data, size_t length, uint8_t *out, size_t *out_length)
+{
+	if (!length || length % 4) {
+		return -1;
+	}
+
+	return system_authentication_key_data_decode_tail(data, length, out, out_length);
+}
+
+int system_authentication_key_data_check(const char *algorithm, const char *data)
+{
+	int error = 0;
+	size_t data_length = strlen(data);
+	uint8_t *blob = NULL;
+	size_t blob_length = 0;
+	const uint8_t *iter = NULL, *end = NULL;
+	system_authentication_key_data_field_t fields[SYSTEM_AUTHENTICATION_KEY_DATA_FIELDS_MAX] = {0};
+	unsigned int field_count = 0;
+	const system_authentication_key_data_format_t *format = NULL;
+	size_t algorithm_length = strlen(algorithm);
+	const size_t suffix_length = sizeof(SYSTEM_AUTHENTICATION_KEY_DATA_CERT_SUFFIX) - 1;
+
+	blob = malloc(SYSTEM_AUTHENTICATION_KEY_DATA_DECODED_SIZE(data_length));
+	if (!blob) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "malloc() failed");
+		goto error_out;
+	}
+
+	if (system_authentication_key_data_decode(data, data_length, blob, &blob_length)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Key data is not valid base64");
+		goto error_out;
+	}
+
+	iter = blob;
+	end = blob + blob_length;
+
+	// string format identifier
+	if (system_authentication_key_data_read_field(&iter, end, &fields[0]) || fields[0].length != algorithm_length || memcmp(fields[0].value, algorithm, algorithm_length)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Key data does not start with the %s format identifier", algorithm);
+		goto error_out;
+	}
+	field_count = 1;
+
+	// certificates carry fields of other types - only the identifier is checked
+	if (algorithm_length > suffix_length && !strcmp(algorithm + algorithm_length - suffix_length, SYSTEM_AUTHENTICATION_KEY_DATA_CERT_SUFFIX)) {
+		goto out;
+	}
+
+	// other fields of public keys are length prefixed and fill the whole blob
+	while (iter < end) {
+		if (field_count == SYSTEM_AUTHENTICATION_KEY_DATA_FIELDS_MAX || system_authentication_key_data_read_field(&iter, end, &fields[field_count])) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Malformed %s key data", algorithm);
+			goto error_out;
+		}
+		field_count++;
+	}
+
+	for (size_t i = 0; i < sizeof(system_authentication_key_data_formats) / sizeof(system_authentication_key_data_formats[0]); i++) {
+		if (!strcmp(system_authentication_key_data_formats[i].algorithm, algorithm)) {
+			format = &system_authentication_key_data_formats[i];
+			break;
+		}
+	}
+
+	// algorithms not known here only need well formed fields
+	if (!format) {
+		goto out;
+	}
+
+	if (field_count != format->fields ||
+		(format->key_length && fields[1].length != format->key_length) ||
+		(format->curve && (fields[1].length != strlen(format->curve) || memcmp(fields[1].value, format->curve, fields[1].length)))) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Malformed %s key data", algorithm);
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	free(blob);
+
+	return error;
+}
+
+static int system_authentication_key_data_decode_tail(const char *data, size_t length, uint8_t *out, size_t *out_length)
+{
+	const uint8_t *const table = system_authentication_key_data_base64;
+	const uint8_t *iter = (const uint8_t *) data;
+	const uint8_t *end = iter + length;
+	uint8_t *out_iter = out;
+	uint32_t value = 0;
+	size_t padding = 0;
+
+	// padding only at the end of the last quad
+	if (end[-1] == '=') {
+		padding = end[-2] == '=' ? 2 : 1;
+	}
+
+	for (; iter + 4 <= end - (padding ? 4 : 0); iter += 4) {
+		if (!system_authentication_key_data_is_base64((char) iter[0]) || !system_authentication_key_data_is_base64((char) iter[1]) ||
+			!system_authentication_key_data_is_base64((char) iter[2]) || !system_authentication_key_data_is_base64((char) iter[3])) {
+			return -1;
+		}
+
+		value = (uint32_t) table[iter[0]] << 18 | (uint32_t) table[iter[1]] << 12 | (uint32_t) table[iter[2]] << 6 | table[iter[3]];
+		*out_iter++ = (uint8_t) (value >> 16);
+		*out_iter++ = (uint8_t) (value >> 8);
+		*out_iter++ = (uint8_t) value;
+	}
+
+	if (padding) {
+		if (!system_authentication_key_data_is_base64((char) iter[0]) || !system_authentication_key_data_is_base64((char) iter[1]) ||
+			(padding == 1 && !system_authentication_key_data_is_base64((char) iter[2]))) {
+			return -1;
+		}
+
+		value = (uint32_t) table[iter[0]] << 18 | (uint32_t) table[iter[1]] << 12 | (padding == 1 ? (uint32_t) table[iter[2]] << 6 : 0);
+		*out_iter++ = (uint8_t) (value >> 16);
+		if (padding == 1) {
+			*out_iter++ = (uint8_t) (value >> 8);
+		}
+	}
+
+	*out_length = (size_t) (out_iter - out);
+
+	return 0;
+}
+
+static bool system_authentication_key_data_is_base64(char c)
+{
+	// 'A' is the only character with the value 0
+	return system_authentication_key_data_base64[(uint8_t) c] || c == 'A';
+}
+
+static int system_authentication_key_data_read_field(const uint8_t **iter, const uint8_t *end, system_authentication_key_data_field_t *field)
+{
+	uint32_t length = 0;
+
+	if (end - *iter < 4) {
+		return -1;
+	}
+
+	length = (uint32_t) (*iter)[0] << 24 | (uint32_t) (*iter)[1] << 16 | (uint32_t) (*iter)[2] << 8 | (*iter)[3];
+	*iter += 4;
+
+	if ((size_t) (end - *iter) < length) {
+		return -1;
+	}
+
+	field->value = *iter;
+	field->length = length;
+	*iter += length;
+
+	return 0;
+}
+
+#ifdef SYSTEM_AUTHENTICATION_KEY_DATA_AVX2
+// 32 characters into 24 bytes per step - character classes and values are looked up by nibbles
+__attribute__((target("avx2"))) static size_t system_authentication_key_data_decode_avx2(const char *data, size_t length, uint8_t *out)
+{
+	const __m256i lut_lo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+											0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+	const __m256i lut_hi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+											0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m256i lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+											  0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m256i pack_shuffle = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+												  2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	const __m256i pack_permute = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1);
+	const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+	__m256i block, hi_nibbles, lo_nibbles, lo, hi, roll;
+	size_t done = 0;
+
+	// the last quad is left to the scalar decoder - every full block before it has no padding
+	while (length - done >= 32 + 4) {
+		block = _mm256_loadu_si256((const __m256i *) (const void *) (data + done));
+
+		hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(block, 4), mask_2f);
+		lo_nibbles = _mm256_and_si256(block, mask_2f);
+		lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+		hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+
+		// invalid characters are reported by the scalar decoder
+		if (!_mm256_testz_si256(lo, hi)) {
+			break;
+		}
+
+		roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(_mm256_cmpeq_epi8(block, mask_2f), hi_nibbles));
+		block = _mm256_add_epi8(block, roll);
+
+		// 4 x 6 bits into 3 bytes in each 32-bit lane
+		block = _mm256_maddubs_epi16(block, _mm256_set1_epi32(0x01400140));
+		block = _mm256_madd_epi16(block, _mm256_set1_epi32(0x00011000));
+		block = _mm256_shuffle_epi8(block, pack_shuffle);
+		block = _mm256_permutevar8x32_epi32(block, pack_permute);
+
+		_mm256_storeu_si256((__m256i *) (void *) (out + done / 4 * 3), block);
+		done += 32;
+	}
+
+	return done;
+}
+#endif
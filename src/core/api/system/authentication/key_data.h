@@ -0,0 +1,34 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_API_AUTHENTICATION_KEY_DATA_H
+#define SYSTEM_PLUGIN_API_AUTHENTICATION_KEY_DATA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// bytes past the decoded data the vector decoder may write
+#define SYSTEM_AUTHENTICATION_KEY_DATA_DECODE_SLACK 32
+
+// upper bound of the decoded size of base64 data - includes the slack
+#define SYSTEM_AUTHENTICATION_KEY_DATA_DECODED_SIZE(length) ((length) / 4 * 3 + SYSTEM_AUTHENTICATION_KEY_DATA_DECODE_SLACK)
+
+// decode padded base64 - the vector decoder is used if the CPU supports it
+int system_authentication_key_data_decode(const char *data, size_t length, uint8_t *out, size_t *out_length);
+
+// decode padded base64 without the vector decoder
+int system_authentication_key_data_decode_scalar(const char *data, size_t length, uint8_t *out, size_t *out_length);
+
+// check the RFC 4253 public key blob - the embedded format identifier has to match the algorithm
+int system_authentication_key_data_check(const char *algorithm, const char *data);
+
+#endif // SYSTEM_PLUGIN_API_AUTHENTICATION_KEY_DATA_H
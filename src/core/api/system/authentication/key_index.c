@@ -0,0 +1,43 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "key_index.h"
+
+#include <stdio.h>
+#include <string.h>
+
+uint64_t system_authentication_key_index_hash(const char *data, size_t length)
+{
+	// FNV-1a - lookups compare the whole key data, collisions only share an index file
+	uint64_t hash = UINT64_C(0xcbf29ce484222325);
+
+	for (size_t i = 0; i < length; i++) {
+		hash ^= (unsigned char) data[i];
+		hash *= UINT64_C(0x100000001b3);
+	}
+
+	return hash;
+}
+
+void system_authentication_key_index_name(uint64_t hash, char name[SYSTEM_AUTHENTICATION_KEY_INDEX_NAME_SIZE])
+{
+	snprintf(name, SYSTEM_AUTHENTICATION_KEY_INDEX_NAME_SIZE, "%016llx", (unsigned long long) hash);
+}
+
+int system_authentication_key_index_check_user(const char *user)
+{
+	if (!*user || !strcmp(user, ".") || !strcmp(user, "..") || strchr(user, '/')) {
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,32 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_API_AUTHENTICATION_KEY_INDEX_H
+#define SYSTEM_PLUGIN_API_AUTHENTICATION_KEY_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// index of authorized keys for the AuthorizedKeysCommand helper - one directory per user, one file per key data hash
+#define SYSTEM_AUTHENTICATION_KEY_INDEX_DIRECTORY "/var/lib/sysrepo-plugin-system/authorized-keys"
+
+// 16 hex digits of the hash and the terminating zero
+#define SYSTEM_AUTHENTICATION_KEY_INDEX_NAME_SIZE 17
+
+// key data is hashed as written in authorized_keys - base64 without the algorithm
+uint64_t system_authentication_key_index_hash(const char *data, size_t length);
+void system_authentication_key_index_name(uint64_t hash, char name[SYSTEM_AUTHENTICATION_KEY_INDEX_NAME_SIZE]);
+
+// user names are used as directory names of the index
+int system_authentication_key_index_check_user(const char *user);
+
+#endif // SYSTEM_PLUGIN_API_AUTHENTICATION_KEY_INDEX_H
@@ -20,6 +20,9 @@
 #include "core/data/system/authentication/local_user/list.h"
 #include "core/data/system/authentication/local_user.h"
 #include "umgmt/user.h"
+#include "key_cache.h"
+#include "scan.h"
+#include "scope.h"
 
 #include <unistd.h>
 #include <dirent.h>
@@ -31,26 +34,132 @@
 
 #include <utlist.h>
 
-static int system_check_file_extension(const char *path, const char *ext);
-
 int system_authentication_load_user(system_ctx_t *ctx, system_local_user_element_t **head)
 {
 	int error = 0;
-
+	system_authentication_scan_t scan = {0};
+	system_authentication_scope_filter_t filter = {0};
+	system_authentication_record_t record = {0};
 	system_local_user_t temp_user = {0};
-	um_db_t *db = NULL;
-	const um_user_element_t *user_head = NULL;
-	const um_user_element_t *user_iter = NULL;
+	system_local_user_element_t *found_user_el = NULL;
+	char name_buffer[SYSTEM_AUTHENTICATION_NAME_MAX] = {0};
+	char hash_buffer[SYSTEM_AUTHENTICATION_HASH_MAX] = {0};
+	unsigned int uid = 0;
+	unsigned int gid = 0;
+
+	error = system_authentication_scope_get_filter(&ctx->user_scope, &filter);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_scope_get_filter() error (%d)", error);
+		goto error_out;
+	}
 
-	db = um_db_new();
-	if (!db) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_new() failed");
+	// passwd - only managed users are copied, system accounts and users outside of the scope are skipped in place
+	error = system_authentication_scan_open(&scan, SYSTEM_AUTHENTICATION_PASSWD_PATH);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_scan_open() error (%d)", error);
 		goto error_out;
 	}
 
-	error = um_db_load(db);
+	while (system_authentication_scan_next(&scan, &record)) {
+		if (record.count < 4 || system_authentication_field_to_id(&record.fields[2], &uid) || system_authentication_field_to_id(&record.fields[3], &gid) || !system_authentication_scope_filter_contains_uid(&filter, uid)) {
+			continue;
+		}
+
+		if (record.fields[0].length >= sizeof(name_buffer)) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "User name too long [ UID = %u ]", uid);
+			goto error_out;
+		}
+
+		memcpy(name_buffer, record.fields[0].value, record.fields[0].length);
+		name_buffer[record.fields[0].length] = 0;
+
+		if (!system_authentication_scope_filter_contains(&filter, name_buffer, uid, gid)) {
+			continue;
+		}
+
+		SRPLG_LOG_INF(PLUGIN_NAME, "Found user %s [ UID = %u ]", name_buffer, uid);
+
+		system_local_user_init(&temp_user);
+		temp_user.name = name_buffer;
+
+		error = system_local_user_list_add(head, temp_user);
+		if (error != 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_add() error (%d) for user %s", error, temp_user.name);
+			goto error_out;
+		}
+	}
+
+	system_authentication_scan_close(&scan);
+
+	// nothing to look up in shadow
+	if (!*head) {
+		goto out;
+	}
+
+	// shadow - hashes are copied only for the users found above
+	error = system_authentication_scan_open(&scan, SYSTEM_AUTHENTICATION_SHADOW_PATH);
 	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_load() error (%d)", error);
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_scan_open() error (%d)", error);
+		goto error_out;
+	}
+
+	while (system_authentication_scan_next(&scan, &record)) {
+		if (record.count < 2 || record.fields[0].length >= sizeof(name_buffer)) {
+			continue;
+		}
+
+		memcpy(name_buffer, record.fields[0].value, record.fields[0].length);
+		name_buffer[record.fields[0].length] = 0;
+
+		found_user_el = system_local_user_list_find(*head, name_buffer);
+		if (!found_user_el) {
+			continue;
+		}
+
+		// no password set for the user
+		if (system_authentication_field_equal(&record.fields[1], "*") || system_authentication_field_equal(&record.fields[1], "!")) {
+			continue;
+		}
+
+		if (record.fields[1].length >= sizeof(hash_buffer)) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Password hash too long for user %s", name_buffer);
+			goto error_out;
+		}
+
+		memcpy(hash_buffer, record.fields[1].value, record.fields[1].length);
+		hash_buffer[record.fields[1].length] = 0;
+
+		error = system_local_user_set_password(&found_user_el->user, hash_buffer);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_set_password() error (%d) for user %s", error, name_buffer);
+			goto error_out;
+		}
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	system_authentication_scan_close(&scan);
+	system_authentication_scope_filter_free(&filter);
+
+	return error;
+}
+
+int system_authentication_load_user_db(system_ctx_t *ctx, const um_db_t *db, system_local_user_element_t **head)
+{
+	int error = 0;
+
+	system_authentication_scope_filter_t filter = {0};
+	system_local_user_t temp_user = {0};
+	const um_user_element_t *user_head = NULL;
+	const um_user_element_t *user_iter = NULL;
+
+	error = system_authentication_scope_get_filter(&ctx->user_scope, &filter);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_scope_get_filter() error (%d)", error);
 		goto error_out;
 	}
 
@@ -60,7 +169,7 @@ int system_authentication_load_user(system_ctx_t *ctx, system_local_user_element
 	{
 		const um_user_t *user = user_iter->user;
 
-		if (um_user_get_uid(user) == 0 || (um_user_get_uid(user) >= 1000 && um_user_get_uid(user) < 65534)) {
+		if (system_authentication_scope_filter_contains(&filter, um_user_get_name(user), (unsigned int) um_user_get_uid(user), (unsigned int) um_user_get_gid(user))) {
 			SRPLG_LOG_INF(PLUGIN_NAME, "Found user %s [ UID = %d ]", um_user_get_name(user), um_user_get_uid(user));
 
 			// add new user
@@ -87,9 +196,7 @@ error_out:
 	error = -1;
 
 out:
-	if (db) {
-		um_db_free(db);
-	}
+	system_authentication_scope_filter_free(&filter);
 
 	return error;
 }
@@ -97,94 +204,31 @@ out:
 int system_authentication_load_user_authorized_key(system_ctx_t *ctx, const char *user, system_authorized_key_element_t **head)
 {
 	int error = 0;
-	char dir_buffer[PATH_MAX] = {0};
-	char path_buffer[PATH_MAX] = {0};
-	char algorithm_buffer[100] = {0};
-	char data_buffer[16384] = {0};
-	FILE *pub_file = NULL;
-
-	system_authorized_key_t temp_key = {0};
 
-	DIR *dir = NULL;
-	struct dirent *dir_entry = NULL;
-
-	if (!strncmp(user, "root", 4)) {
-		if (snprintf(dir_buffer, sizeof(dir_buffer), "/root/.ssh") < 0) {
-			goto error_out;
-		}
-	} else {
-		if (snprintf(dir_buffer, sizeof(dir_buffer), "/home/%s/.ssh", user) < 0) {
-			goto error_out;
-		}
+	// keys are the managed lines of ~/.ssh/authorized_keys - parsed again only if the file changed
+	error = system_authentication_key_cache_load(&ctx->key_cache, user, head);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_key_cache_load() error (%d) for user %s", error, user);
+		goto error_out;
 	}
 
-	// check dir for .ssh key files
-	if ((dir = opendir(dir_buffer)) == NULL) {
-		SRPLG_LOG_INF(PLUGIN_NAME, "~/.ssh directory doesn't exist for user %s", user);
-		goto out;
-	} else {
-		while ((dir_entry = readdir(dir)) != NULL) {
-			if (!system_check_file_extension(dir_entry->d_name, ".pub")) {
-				continue;
-			}
-
-			// found new key
-			system_authorized_key_init(&temp_key);
-			error = system_authorized_key_set_name(&temp_key, dir_entry->d_name);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_set_name() error (%d)", error);
-				goto error_out;
-			}
-
-			// found .pub file - read data
-			error = snprintf(path_buffer, sizeof(path_buffer), "%s/%s", dir_buffer, dir_entry->d_name);
-			if (error < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
-				goto error_out;
-			}
-
-			// open file
-			pub_file = fopen(path_buffer, "r");
-			if (!pub_file) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "fopen() error (%d)", error);
-				goto error_out;
-			}
-
-			// read algorithm and data
-			error = fscanf(pub_file, "%s %s", algorithm_buffer, data_buffer);
-			if (error != 2) {
-				// unable to read both parameters needed - error
-				SRPLG_LOG_ERR(PLUGIN_NAME, "fscanf() error (%d)", error);
-				goto error_out;
-			}
-
-			// got both - setup key and add it to the array
-			error = system_authorized_key_set_algorithm(&temp_key, algorithm_buffer);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_set_algorithm() error (%d)", error);
-				goto error_out;
-			}
+	goto out;
 
-			error = system_authorized_key_set_data(&temp_key, data_buffer);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_set_data() error (%d)", error);
-				goto error_out;
-			}
+error_out:
+	error = -1;
 
-			// append to list
-			error = system_authorized_key_list_add(head, temp_key);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_list_add() error (%d)", error);
-				goto error_out;
-			}
+out:
+	return error;
+}
 
-			// free current data
-			system_authorized_key_free(&temp_key);
+int system_authentication_load_users_authorized_keys(system_ctx_t *ctx, system_local_user_element_t *head)
+{
+	int error = 0;
 
-			// close current file
-			fclose(pub_file);
-			pub_file = NULL;
-		}
+	error = system_authentication_key_cache_load_users(&ctx->key_cache, head);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_key_cache_load_users() error (%d)", error);
+		goto error_out;
 	}
 
 	goto out;
@@ -193,23 +237,5 @@ error_out:
 	error = -1;
 
 out:
-	// close if interrupted
-	if (pub_file) {
-		fclose(pub_file);
-	}
-
-	// if interrurpted the key will have allocated data - free
-	system_authorized_key_free(&temp_key);
-
-	// close dir iterator
-	closedir(dir);
 	return error;
-}
-
-static int system_check_file_extension(const char *path, const char *ext)
-{
-	const size_t path_len = strlen(path);
-	const size_t ext_len = strlen(ext);
-
-	return path_len > ext_len && strncmp(path + (path_len - ext_len), ext, ext_len) == 0;
 }
\ No newline at end of file
@@ -17,6 +17,8 @@
 #include "core/types.h"
 
 int system_authentication_load_user(system_ctx_t *ctx, system_local_user_element_t **head);
+int system_authentication_load_user_db(system_ctx_t *ctx, const um_db_t *db, system_local_user_element_t **head);
 int system_authentication_load_user_authorized_key(system_ctx_t *ctx, const char *user, system_authorized_key_element_t **head);
+int system_authentication_load_users_authorized_keys(system_ctx_t *ctx, system_local_user_element_t *head);
 
 #endif // SYSTEM_PLUGIN_API_AUTHENTICATION_LOAD_H
\ No newline at end of file
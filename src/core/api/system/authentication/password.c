@@ -0,0 +1,158 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+// explicit_bzero()
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "password.h"
+#include "core/common.h"
+#include "core/work_pool.h"
+
+#include <crypt.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sysrepo.h>
+
+typedef struct system_authentication_password_pool_s system_authentication_password_pool_t;
+
+struct system_authentication_password_pool_s {
+	system_authentication_password_t *passwords;
+	const char *prefix; ///< Crypt prefix of the hashing scheme.
+};
+
+static void system_authentication_password_worker(system_work_pool_t *work_pool, void *arg);
+static int system_authentication_password_hash_one(const char *prefix, struct crypt_data *data, system_authentication_password_t *password);
+
+int system_authentication_password_scheme_from_string(const char *name, enum system_authentication_password_scheme_e *scheme)
+{
+	if (!strcmp(name, "sha-512")) {
+		*scheme = SYSTEM_AUTHENTICATION_PASSWORD_SCHEME_SHA_512;
+	} else if (!strcmp(name, "sha-256")) {
+		*scheme = SYSTEM_AUTHENTICATION_PASSWORD_SCHEME_SHA_256;
+	} else if (!strcmp(name, "yescrypt")) {
+		*scheme = SYSTEM_AUTHENTICATION_PASSWORD_SCHEME_YESCRYPT;
+	} else {
+		return -1;
+	}
+
+	return 0;
+}
+
+bool system_authentication_password_is_cleartext(const char *value)
+{
+	return value && !strncmp(value, SYSTEM_AUTHENTICATION_PASSWORD_CLEARTEXT_PREFIX, sizeof(SYSTEM_AUTHENTICATION_PASSWORD_CLEARTEXT_PREFIX) - 1);
+}
+
+int system_authentication_password_hash(system_authentication_password_t *passwords, size_t count, enum system_authentication_password_scheme_e scheme)
+{
+	int error = 0;
+	system_authentication_password_pool_t pool = {
+		.passwords = passwords,
+		.prefix = NULL,
+	};
+
+	if (!count) {
+		goto out;
+	}
+
+	switch (scheme) {
+		case SYSTEM_AUTHENTICATION_PASSWORD_SCHEME_SHA_512:
+			pool.prefix = "$6$";
+			break;
+		case SYSTEM_AUTHENTICATION_PASSWORD_SCHEME_SHA_256:
+			pool.prefix = "$5$";
+			break;
+		case SYSTEM_AUTHENTICATION_PASSWORD_SCHEME_YESCRYPT:
+			pool.prefix = "$y$";
+			break;
+	}
+
+	if (!pool.prefix) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unknown password hashing scheme %d", scheme);
+		goto error_out;
+	}
+
+	system_work_pool_run(count, system_authentication_password_worker, &pool);
+
+	for (size_t i = 0; i < count; i++) {
+		if (passwords[i].error) {
+			error = -1;
+		}
+	}
+
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to hash passwords with prefix %s", pool.prefix);
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	return error;
+}
+
+void system_authentication_password_free(system_authentication_password_t *passwords, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		free(passwords[i].hash);
+		passwords[i].hash = NULL;
+	}
+}
+
+static void system_authentication_password_worker(system_work_pool_t *work_pool, void *arg)
+{
+	system_authentication_password_pool_t *pool = arg;
+	struct crypt_data *data = NULL;
+	size_t index = 0;
+
+	// crypt_r() state is large - one per worker
+	data = calloc(1, sizeof(*data));
+
+	while (system_work_pool_next(work_pool, &index)) {
+		pool->passwords[index].error = data ? system_authentication_password_hash_one(pool->prefix, data, &pool->passwords[index]) : -1;
+	}
+
+	if (data) {
+		explicit_bzero(data, sizeof(*data));
+		free(data);
+	}
+}
+
+static int system_authentication_password_hash_one(const char *prefix, struct crypt_data *data, system_authentication_password_t *password)
+{
+	char salt[CRYPT_GENSALT_OUTPUT_SIZE] = {0};
+	const char *hash = NULL;
+
+	// random salt from the system - default cost of the scheme
+	if (!crypt_gensalt_rn(prefix, 0, NULL, 0, salt, sizeof(salt))) {
+		return -1;
+	}
+
+	hash = crypt_r(password->cleartext, salt, data);
+	if (!hash || hash[0] == '*') {
+		return -1;
+	}
+
+	password->hash = strdup(hash);
+	if (!password->hash) {
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,45 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_API_AUTHENTICATION_PASSWORD_H
+#define SYSTEM_PLUGIN_API_AUTHENTICATION_PASSWORD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// iana-crypt-hash form of a cleartext password
+#define SYSTEM_AUTHENTICATION_PASSWORD_CLEARTEXT_PREFIX "$0$"
+
+typedef struct system_authentication_password_s system_authentication_password_t;
+
+enum system_authentication_password_scheme_e {
+	SYSTEM_AUTHENTICATION_PASSWORD_SCHEME_SHA_512 = 0,
+	SYSTEM_AUTHENTICATION_PASSWORD_SCHEME_SHA_256,
+	SYSTEM_AUTHENTICATION_PASSWORD_SCHEME_YESCRYPT,
+};
+
+struct system_authentication_password_s {
+	const char *cleartext; ///< Password without the $0$ prefix.
+	char *hash;			   ///< Crypt hash of the password - set by the hashing.
+	int error;			   ///< Set by the hashing of this password.
+};
+
+int system_authentication_password_scheme_from_string(const char *name, enum system_authentication_password_scheme_e *scheme);
+
+bool system_authentication_password_is_cleartext(const char *value);
+
+// hash cleartext passwords with a random salt - passwords are hashed in parallel
+int system_authentication_password_hash(system_authentication_password_t *passwords, size_t count, enum system_authentication_password_scheme_e scheme);
+
+void system_authentication_password_free(system_authentication_password_t *passwords, size_t count);
+
+#endif // SYSTEM_PLUGIN_API_AUTHENTICATION_PASSWORD_H
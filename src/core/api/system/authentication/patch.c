@@ -0,0 +1,579 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "patch.h"
+#include "core/common.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/limits.h>
+#include <shadow.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sysrepo.h>
+
+static const char *system_authentication_patch_paths[SYSTEM_AUTHENTICATION_PATCH_FILE_COUNT] = {
+	SYSTEM_AUTHENTICATION_PASSWD_PATH,
+	SYSTEM_AUTHENTICATION_SHADOW_PATH,
+	SYSTEM_AUTHENTICATION_GROUP_PATH,
+	SYSTEM_AUTHENTICATION_GSHADOW_PATH,
+};
+
+static int system_authentication_patch_add_entry(system_authentication_patch_t *patch, enum system_authentication_patch_file_e file, const char *name, enum system_authentication_patch_op_e op, unsigned int field, const char *value);
+static int system_authentication_patch_write_file(const char *path, const char *temp_path, system_authentication_patch_entry_t *entries, system_authentication_patch_entry_t *ids);
+static int system_authentication_patch_find_field(const char *line, size_t length, unsigned int field, const char **field_start, const char **field_end);
+static bool system_authentication_patch_has_member(const char *list, size_t list_length, const char *member, size_t member_length);
+
+void system_authentication_patch_init(system_authentication_patch_t *patch)
+{
+	*patch = (system_authentication_patch_t){0};
+
+	for (size_t i = 0; i < SYSTEM_AUTHENTICATION_PATCH_FILE_COUNT; i++) {
+		patch->paths[i] = system_authentication_patch_paths[i];
+	}
+}
+
+int system_authentication_patch_set(system_authentication_patch_t *patch, enum system_authentication_patch_file_e file, const char *name, const char *line)
+{
+	return system_authentication_patch_add_entry(patch, file, name, SYSTEM_AUTHENTICATION_PATCH_OP_SET, 0, line);
+}
+
+int system_authentication_patch_set_field(system_authentication_patch_t *patch, enum system_authentication_patch_file_e file, const char *name, unsigned int field, const char *value)
+{
+	return system_authentication_patch_add_entry(patch, file, name, SYSTEM_AUTHENTICATION_PATCH_OP_FIELD, field, value);
+}
+
+int system_authentication_patch_remove(system_authentication_patch_t *patch, enum system_authentication_patch_file_e file, const char *name)
+{
+	return system_authentication_patch_add_entry(patch, file, name, SYSTEM_AUTHENTICATION_PATCH_OP_REMOVE, 0, NULL);
+}
+
+int system_authentication_patch_add(system_authentication_patch_t *patch, enum system_authentication_patch_file_e file, const char *name, unsigned int id_field, const char *line)
+{
+	system_authentication_patch_entry_t *entry = NULL;
+	const char *id_start = NULL;
+	const char *id_end = NULL;
+
+	if (id_field) {
+		if (system_authentication_patch_find_field(line, strlen(line), id_field, &id_start, &id_end)) {
+			return -1;
+		}
+
+		// two new records of one patch must not share an ID either
+		HASH_FIND(hh_id, patch->ids[file], id_start, (size_t) (id_end - id_start), entry);
+		if (entry && strcmp(entry->name, name)) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Records %s and %s share the ID %s", entry->name, name, entry->id);
+			return -1;
+		}
+	}
+
+	if (system_authentication_patch_add_entry(patch, file, name, SYSTEM_AUTHENTICATION_PATCH_OP_ADD, id_field, line)) {
+		return -1;
+	}
+
+	if (!id_field) {
+		return 0;
+	}
+
+	HASH_FIND_STR(patch->files[file], name, entry);
+
+	entry->id = strndup(id_start, (size_t) (id_end - id_start));
+	if (!entry->id) {
+		return -1;
+	}
+
+	HASH_ADD_KEYPTR(hh_id, patch->ids[file], entry->id, strlen(entry->id), entry);
+
+	return 0;
+}
+
+int system_authentication_patch_append_field(system_authentication_patch_t *patch, enum system_authentication_patch_file_e file, const char *name, unsigned int field, const char *members)
+{
+	system_authentication_patch_entry_t *entry = NULL;
+	char *value = NULL;
+
+	// members appended to the same field are merged - other changes of the record are replaced
+	HASH_FIND_STR(patch->files[file], name, entry);
+	if (!entry || entry->op != SYSTEM_AUTHENTICATION_PATCH_OP_APPEND || entry->field != field || !entry->value) {
+		return system_authentication_patch_add_entry(patch, file, name, SYSTEM_AUTHENTICATION_PATCH_OP_APPEND, field, members);
+	}
+
+	if (asprintf(&value, "%s,%s", entry->value, members) == -1) {
+		return -1;
+	}
+
+	free(entry->value);
+	entry->value = value;
+
+	return 0;
+}
+
+int system_authentication_patch_commit(system_authentication_patch_t *patch)
+{
+	int error = 0;
+	char temp_paths[SYSTEM_AUTHENTICATION_PATCH_FILE_COUNT][PATH_MAX] = {0};
+	bool written[SYSTEM_AUTHENTICATION_PATCH_FILE_COUNT] = {0};
+	bool changed = false;
+	bool locked = false;
+	struct timespec lock_start = {0};
+	struct timespec lock_end = {0};
+	long lock_wait = 0;
+	size_t i = 0;
+
+	for (i = 0; i < SYSTEM_AUTHENTICATION_PATCH_FILE_COUNT; i++) {
+		if (patch->files[i]) {
+			changed = true;
+		}
+	}
+
+	if (!changed) {
+		goto out;
+	}
+
+	// the lock is held only for writing the patched copies and renaming them
+	clock_gettime(CLOCK_MONOTONIC, &lock_start);
+	if (lckpwdf() != 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "lckpwdf() failed: %s", strerror(errno));
+		goto error_out;
+	}
+	locked = true;
+	clock_gettime(CLOCK_MONOTONIC, &lock_end);
+
+	lock_wait = (lock_end.tv_sec - lock_start.tv_sec) * 1000 + (lock_end.tv_nsec - lock_start.tv_nsec) / 1000000;
+	SRPLG_LOG_INF(PLUGIN_NAME, "Waited %ld ms for the password files lock", lock_wait);
+
+	// originals are replaced only after all patched copies are complete
+	for (i = 0; i < SYSTEM_AUTHENTICATION_PATCH_FILE_COUNT; i++) {
+		if (!patch->files[i]) {
+			continue;
+		}
+
+		if (snprintf(temp_paths[i], sizeof(temp_paths[i]), "%s+", patch->paths[i]) < 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() failed");
+			goto error_out;
+		}
+
+		written[i] = true;
+		error = system_authentication_patch_write_file(patch->paths[i], temp_paths[i], patch->files[i], patch->ids[i]);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_patch_write_file() error (%d) for %s", error, patch->paths[i]);
+			goto error_out;
+		}
+	}
+
+	for (i = 0; i < SYSTEM_AUTHENTICATION_PATCH_FILE_COUNT; i++) {
+		if (!written[i]) {
+			continue;
+		}
+
+		if (rename(temp_paths[i], patch->paths[i]) != 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "rename() failed for %s: %s", patch->paths[i], strerror(errno));
+			goto error_out;
+		}
+		written[i] = false;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	// remove copies which were not renamed
+	for (i = 0; i < SYSTEM_AUTHENTICATION_PATCH_FILE_COUNT; i++) {
+		if (written[i]) {
+			unlink(temp_paths[i]);
+		}
+	}
+
+	if (locked) {
+		ulckpwdf();
+	}
+
+	return error;
+}
+
+void system_authentication_patch_free(system_authentication_patch_t *patch)
+{
+	system_authentication_patch_entry_t *entry = NULL, *tmp_entry = NULL;
+
+	for (size_t i = 0; i < SYSTEM_AUTHENTICATION_PATCH_FILE_COUNT; i++) {
+		HASH_ITER(hh, patch->files[i], entry, tmp_entry)
+		{
+			HASH_DEL(patch->files[i], entry);
+
+			free(entry->name);
+			if (entry->value) {
+				free(entry->value);
+			}
+			if (entry->id) {
+				HASH_DELETE(hh_id, patch->ids[i], entry);
+				free(entry->id);
+			}
+			free(entry);
+		}
+	}
+
+	system_authentication_patch_init(patch);
+}
+
+static int system_authentication_patch_add_entry(system_authentication_patch_t *patch, enum system_authentication_patch_file_e file, const char *name, enum system_authentication_patch_op_e op, unsigned int field, const char *value)
+{
+	int error = 0;
+	system_authentication_patch_entry_t *entry = NULL;
+	char *value_copy = NULL;
+
+	if (value) {
+		value_copy = strdup(value);
+		if (!value_copy) {
+			goto error_out;
+		}
+	}
+
+	// the last change of a record wins
+	HASH_FIND_STR(patch->files[file], name, entry);
+	if (!entry) {
+		entry = (system_authentication_patch_entry_t *) calloc(1, sizeof(system_authentication_patch_entry_t));
+		if (!entry) {
+			goto error_out;
+		}
+
+		entry->name = strdup(name);
+		if (!entry->name) {
+			free(entry);
+			goto error_out;
+		}
+
+		HASH_ADD_KEYPTR(hh, patch->files[file], entry->name, strlen(entry->name), entry);
+	}
+
+	if (entry->value) {
+		free(entry->value);
+	}
+
+	if (entry->id) {
+		HASH_DELETE(hh_id, patch->ids[file], entry);
+		free(entry->id);
+		entry->id = NULL;
+	}
+
+	entry->op = op;
+	entry->field = field;
+	entry->value = value_copy;
+
+	goto out;
+
+error_out:
+	error = -1;
+	if (value_copy) {
+		free(value_copy);
+	}
+
+out:
+	return error;
+}
+
+static int system_authentication_patch_write_file(const char *path, const char *temp_path, system_authentication_patch_entry_t *entries, system_authentication_patch_entry_t *ids)
+{
+	int error = 0;
+	FILE *source = NULL;
+	FILE *target = NULL;
+	int target_fd = -1;
+	struct stat source_stat = {0};
+	char *line = NULL;
+	size_t line_size = 0;
+	ssize_t line_length = 0;
+	size_t name_length = 0;
+	const char *id_start = NULL;
+	const char *id_end = NULL;
+	bool ends_with_newline = true;
+	system_authentication_patch_entry_t *entry = NULL, *tmp_entry = NULL;
+
+	source = fopen(path, "r");
+	if (!source) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fopen() failed for %s: %s", path, strerror(errno));
+		goto error_out;
+	}
+
+	if (fstat(fileno(source), &source_stat) != 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fstat() failed for %s: %s", path, strerror(errno));
+		goto error_out;
+	}
+
+	// the copy replaces the original - keep its owner and mode
+	target_fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+	if (target_fd < 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "open() failed for %s: %s", temp_path, strerror(errno));
+		goto error_out;
+	}
+
+	if (fchown(target_fd, source_stat.st_uid, source_stat.st_gid) != 0 || fchmod(target_fd, source_stat.st_mode & 07777) != 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to set owner and mode of %s: %s", temp_path, strerror(errno));
+		close(target_fd);
+		goto error_out;
+	}
+
+	target = fdopen(target_fd, "w");
+	if (!target) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fdopen() failed for %s: %s", temp_path, strerror(errno));
+		close(target_fd);
+		goto error_out;
+	}
+
+	HASH_ITER(hh, entries, entry, tmp_entry)
+	{
+		entry->applied = false;
+	}
+
+	// lines of unchanged records are copied byte for byte
+	while ((line_length = getline(&line, &line_size, source)) != -1) {
+		name_length = strcspn(line, ":\n");
+
+		entry = NULL;
+		HASH_FIND(hh, entries, line, name_length, entry);
+
+		if (!entry) {
+			// IDs of new records were free when the change was checked - another tool could have taken them since
+			if (ids && !system_authentication_patch_find_field(line, (size_t) line_length, ids->field, &id_start, &id_end)) {
+				HASH_FIND(hh_id, ids, id_start, (size_t) (id_end - id_start), entry);
+				if (entry) {
+					SRPLG_LOG_ERR(PLUGIN_NAME, "ID %s of the new record %s is already used in %s", entry->id, entry->name, path);
+					goto error_out;
+				}
+			}
+
+			if (fwrite(line, 1, (size_t) line_length, target) != (size_t) line_length) {
+				goto write_error;
+			}
+			ends_with_newline = line[line_length - 1] == '\n';
+			continue;
+		}
+
+		entry->applied = true;
+
+		switch (entry->op) {
+			case SYSTEM_AUTHENTICATION_PATCH_OP_SET:
+				if (fprintf(target, "%s\n", entry->value) < 0) {
+					goto write_error;
+				}
+				ends_with_newline = true;
+				break;
+			case SYSTEM_AUTHENTICATION_PATCH_OP_FIELD:
+				error = system_authentication_patch_write_field(target, line, (size_t) line_length, entry->field, entry->value);
+				if (error) {
+					SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to change field %u of %s in %s", entry->field, entry->name, path);
+					goto error_out;
+				}
+				ends_with_newline = line[line_length - 1] == '\n';
+				break;
+			case SYSTEM_AUTHENTICATION_PATCH_OP_APPEND:
+				error = system_authentication_patch_write_members(target, line, (size_t) line_length, entry->field, entry->value);
+				if (error) {
+					SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to append to field %u of %s in %s", entry->field, entry->name, path);
+					goto error_out;
+				}
+				ends_with_newline = line[line_length - 1] == '\n';
+				break;
+			case SYSTEM_AUTHENTICATION_PATCH_OP_ADD:
+				SRPLG_LOG_ERR(PLUGIN_NAME, "New record %s already exists in %s", entry->name, path);
+				goto error_out;
+			case SYSTEM_AUTHENTICATION_PATCH_OP_REMOVE:
+				break;
+		}
+	}
+
+	if (ferror(source)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Error reading %s", path);
+		goto error_out;
+	}
+
+	// records not found in the file
+	HASH_ITER(hh, entries, entry, tmp_entry)
+	{
+		if (entry->applied) {
+			continue;
+		}
+
+		switch (entry->op) {
+			case SYSTEM_AUTHENTICATION_PATCH_OP_SET:
+			case SYSTEM_AUTHENTICATION_PATCH_OP_ADD:
+				if (!ends_with_newline && fputc('\n', target) == EOF) {
+					goto write_error;
+				}
+				if (fprintf(target, "%s\n", entry->value) < 0) {
+					goto write_error;
+				}
+				ends_with_newline = true;
+				break;
+			case SYSTEM_AUTHENTICATION_PATCH_OP_FIELD:
+			case SYSTEM_AUTHENTICATION_PATCH_OP_APPEND:
+				SRPLG_LOG_ERR(PLUGIN_NAME, "Record %s not found in %s", entry->name, path);
+				goto error_out;
+			case SYSTEM_AUTHENTICATION_PATCH_OP_REMOVE:
+				SRPLG_LOG_DBG(PLUGIN_NAME, "Removed record %s not found in %s", entry->name, path);
+				break;
+		}
+	}
+
+	// the copy has to be on disk before it replaces the original
+	if (fflush(target) != 0 || fsync(fileno(target)) != 0) {
+		goto write_error;
+	}
+
+	goto out;
+
+write_error:
+	SRPLG_LOG_ERR(PLUGIN_NAME, "Error writing %s: %s", temp_path, strerror(errno));
+
+error_out:
+	error = -1;
+
+out:
+	if (line) {
+		free(line);
+	}
+
+	if (target && fclose(target) != 0 && !error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fclose() failed for %s: %s", temp_path, strerror(errno));
+		error = -1;
+	}
+
+	if (source) {
+		fclose(source);
+	}
+
+	return error;
+}
+
+int system_authentication_patch_write_field(FILE *file, const char *line, size_t length, unsigned int field, const char *value)
+{
+	const char *end = line + length;
+	const char *field_start = NULL;
+	const char *field_end = NULL;
+	bool newline = length && line[length - 1] == '\n';
+
+	if (newline) {
+		end--;
+	}
+
+	if (system_authentication_patch_find_field(line, length, field, &field_start, &field_end)) {
+		return -1;
+	}
+
+	// fields before and after the changed one are copied as they are
+	if (fwrite(line, 1, (size_t) (field_start - line), file) != (size_t) (field_start - line) ||
+		fputs(value ? value : "", file) == EOF ||
+		fwrite(field_end, 1, (size_t) (end - field_end), file) != (size_t) (end - field_end) ||
+		(newline && fputc('\n', file) == EOF)) {
+		return -1;
+	}
+
+	return 0;
+}
+
+int system_authentication_patch_write_members(FILE *file, const char *line, size_t length, unsigned int field, const char *members)
+{
+	const char *end = line + length;
+	const char *field_start = NULL;
+	const char *field_end = NULL;
+	const char *member = members;
+	size_t member_length = 0;
+	bool newline = length && line[length - 1] == '\n';
+	bool empty = false;
+
+	if (newline) {
+		end--;
+	}
+
+	if (system_authentication_patch_find_field(line, length, field, &field_start, &field_end)) {
+		return -1;
+	}
+
+	// the field up to its end is copied as it is - members added by other tools are kept
+	if (fwrite(line, 1, (size_t) (field_end - line), file) != (size_t) (field_end - line)) {
+		return -1;
+	}
+	empty = field_end == field_start;
+
+	for (; *member; member += member_length + (member[member_length] == ',')) {
+		member_length = strcspn(member, ",");
+
+		// members listed twice in the appended value are written once
+		if (!member_length || system_authentication_patch_has_member(field_start, (size_t) (field_end - field_start), member, member_length) ||
+			(member > members && system_authentication_patch_has_member(members, (size_t) (member - members - 1), member, member_length))) {
+			continue;
+		}
+
+		if ((!empty && fputc(',', file) == EOF) || fwrite(member, 1, member_length, file) != member_length) {
+			return -1;
+		}
+		empty = false;
+	}
+
+	if (fwrite(field_end, 1, (size_t) (end - field_end), file) != (size_t) (end - field_end) || (newline && fputc('\n', file) == EOF)) {
+		return -1;
+	}
+
+	return 0;
+}
+
+static int system_authentication_patch_find_field(const char *line, size_t length, unsigned int field, const char **field_start, const char **field_end)
+{
+	const char *end = line + length;
+	const char *iter = line;
+
+	if (length && line[length - 1] == '\n') {
+		end--;
+	}
+
+	for (unsigned int i = 0; i < field; i++) {
+		iter = memchr(iter, ':', (size_t) (end - iter));
+		if (!iter) {
+			return -1;
+		}
+		iter++;
+	}
+
+	*field_start = iter;
+	*field_end = memchr(iter, ':', (size_t) (end - iter));
+	if (!*field_end) {
+		*field_end = end;
+	}
+
+	return 0;
+}
+
+static bool system_authentication_patch_has_member(const char *list, size_t list_length, const char *member, size_t member_length)
+{
+	const char *end = list + list_length;
+	const char *comma = NULL;
+
+	while (list < end) {
+		comma = memchr(list, ',', (size_t) (end - list));
+		if (!comma) {
+			comma = end;
+		}
+
+		if ((size_t) (comma - list) == member_length && !memcmp(list, member, member_length)) {
+			return true;
+		}
+
+		list = comma + 1;
+	}
+
+	return false;
+}
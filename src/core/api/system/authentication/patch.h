@@ -0,0 +1,80 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_API_AUTHENTICATION_PATCH_H
+#define SYSTEM_PLUGIN_API_AUTHENTICATION_PATCH_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <uthash.h>
+
+typedef struct system_authentication_patch_entry_s system_authentication_patch_entry_t;
+typedef struct system_authentication_patch_s system_authentication_patch_t;
+
+enum system_authentication_patch_file_e {
+	SYSTEM_AUTHENTICATION_PATCH_PASSWD = 0,
+	SYSTEM_AUTHENTICATION_PATCH_SHADOW,
+	SYSTEM_AUTHENTICATION_PATCH_GROUP,
+	SYSTEM_AUTHENTICATION_PATCH_GSHADOW,
+	SYSTEM_AUTHENTICATION_PATCH_FILE_COUNT,
+};
+
+enum system_authentication_patch_op_e {
+	SYSTEM_AUTHENTICATION_PATCH_OP_SET = 0, ///< Replace the whole record - appended if not found.
+	SYSTEM_AUTHENTICATION_PATCH_OP_FIELD,	///< Replace one field of an existing record.
+	SYSTEM_AUTHENTICATION_PATCH_OP_REMOVE,	///< Remove the record.
+	SYSTEM_AUTHENTICATION_PATCH_OP_APPEND,	///< Append members to a list field of an existing record.
+	SYSTEM_AUTHENTICATION_PATCH_OP_ADD,		///< Append a new record - the name and the ID must not be taken in the file.
+};
+
+struct system_authentication_patch_entry_s {
+	char *name;									///< Record name - first field of the line.
+	enum system_authentication_patch_op_e op;	///< Operation on the record.
+	unsigned int field;							///< Replaced field for SYSTEM_AUTHENTICATION_PATCH_OP_FIELD - ID field for SYSTEM_AUTHENTICATION_PATCH_OP_ADD, 0 if not checked.
+	char *value;								///< Whole record or field value without the newline.
+	char *id;									///< ID of an added record - NULL if not checked.
+	bool applied;								///< Record found in the file.
+	UT_hash_handle hh;							///< Entries by name - appended records are written in this order.
+	UT_hash_handle hh_id;						///< Added records by ID.
+};
+
+// changed records of passwd, shadow, group and gshadow - only files with changes are rewritten, other lines are copied as they are
+struct system_authentication_patch_s {
+	system_authentication_patch_entry_t *files[SYSTEM_AUTHENTICATION_PATCH_FILE_COUNT];
+	system_authentication_patch_entry_t *ids[SYSTEM_AUTHENTICATION_PATCH_FILE_COUNT]; ///< Added records by ID - checked against the locked file.
+	const char *paths[SYSTEM_AUTHENTICATION_PATCH_FILE_COUNT]; ///< Patched files - set to the system files by system_authentication_patch_init().
+};
+
+void system_authentication_patch_init(system_authentication_patch_t *patch);
+int system_authentication_patch_set(system_authentication_patch_t *patch, enum system_authentication_patch_file_e file, const char *name, const char *line);
+int system_authentication_patch_set_field(system_authentication_patch_t *patch, enum system_authentication_patch_file_e file, const char *name, unsigned int field, const char *value);
+int system_authentication_patch_remove(system_authentication_patch_t *patch, enum system_authentication_patch_file_e file, const char *name);
+
+// add a new record - the commit fails if the name or the value of the ID field is already taken in the locked file
+int system_authentication_patch_add(system_authentication_patch_t *patch, enum system_authentication_patch_file_e file, const char *name, unsigned int id_field, const char *line);
+
+// add comma separated members to a list field - the field is read from the locked file, members already listed are skipped
+int system_authentication_patch_append_field(system_authentication_patch_t *patch, enum system_authentication_patch_file_e file, const char *name, unsigned int field, const char *members);
+
+// write patched copies of the changed files and rename them over the originals - the password files lock is held only while doing so
+int system_authentication_patch_commit(system_authentication_patch_t *patch);
+
+void system_authentication_patch_free(system_authentication_patch_t *patch);
+
+// write the line with one field replaced - other fields and the newline are copied as they are
+int system_authentication_patch_write_field(FILE *file, const char *line, size_t length, unsigned int field, const char *value);
+
+// write the line with members appended to one comma separated field - members already in the field are not repeated
+int system_authentication_patch_write_members(FILE *file, const char *line, size_t length, unsigned int field, const char *members);
+
+#endif // SYSTEM_PLUGIN_API_AUTHENTICATION_PATCH_H
@@ -0,0 +1,162 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "scan.h"
+#include "core/common.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <sysrepo.h>
+
+int system_authentication_scan_open(system_authentication_scan_t *scan, const char *path)
+{
+	int error = 0;
+	int fd = -1;
+	struct stat st = {0};
+	void *data = NULL;
+
+	*scan = (system_authentication_scan_t){0};
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "open() error for %s (%s)", path, strerror(errno));
+		goto error_out;
+	}
+
+	if (fstat(fd, &st) == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fstat() error for %s (%s)", path, strerror(errno));
+		goto error_out;
+	}
+
+	// nothing to map - scanning yields no records
+	if (st.st_size == 0) {
+		goto out;
+	}
+
+	data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (data == MAP_FAILED) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "mmap() error for %s (%s)", path, strerror(errno));
+		goto error_out;
+	}
+
+	// records are read once from the start to the end
+	(void) madvise(data, (size_t) st.st_size, MADV_SEQUENTIAL);
+
+	scan->data = data;
+	scan->size = (size_t) st.st_size;
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (fd != -1) {
+		close(fd);
+	}
+
+	return error;
+}
+
+int system_authentication_scan_next(system_authentication_scan_t *scan, system_authentication_record_t *record)
+{
+	const char *line = NULL;
+	const char *end = NULL;
+	const char *field = NULL;
+	const char *colon = NULL;
+
+	while (scan->offset < scan->size) {
+		line = scan->data + scan->offset;
+
+		// memchr() is vectorized by libc - no per-byte loop over the file
+		end = memchr(line, '\n', scan->size - scan->offset);
+		if (!end) {
+			end = scan->data + scan->size;
+			scan->offset = scan->size;
+		} else {
+			scan->offset = (size_t) (end - scan->data) + 1;
+		}
+
+		// skip empty lines and comments
+		if (line == end || *line == '#') {
+			continue;
+		}
+
+		record->count = 0;
+		field = line;
+
+		while (record->count < SYSTEM_AUTHENTICATION_SCAN_FIELD_COUNT) {
+			// the last field takes the rest of the line
+			colon = record->count + 1 < SYSTEM_AUTHENTICATION_SCAN_FIELD_COUNT ? memchr(field, ':', (size_t) (end - field)) : NULL;
+
+			record->fields[record->count].value = field;
+			record->fields[record->count].length = (size_t) ((colon ? colon : end) - field);
+			record->count++;
+
+			if (!colon) {
+				break;
+			}
+
+			field = colon + 1;
+		}
+
+		return 1;
+	}
+
+	return 0;
+}
+
+void system_authentication_scan_close(system_authentication_scan_t *scan)
+{
+	if (scan->data) {
+		munmap((void *) scan->data, scan->size);
+	}
+
+	*scan = (system_authentication_scan_t){0};
+}
+
+int system_authentication_field_to_id(const system_authentication_field_t *field, unsigned int *id)
+{
+	unsigned long value = 0;
+
+	if (field->length == 0) {
+		return -1;
+	}
+
+	for (size_t i = 0; i < field->length; i++) {
+		const char c = field->value[i];
+
+		if (c < '0' || c > '9') {
+			return -1;
+		}
+
+		value = value * 10 + (unsigned long) (c - '0');
+		if (value > UINT_MAX) {
+			return -1;
+		}
+	}
+
+	*id = (unsigned int) value;
+
+	return 0;
+}
+
+int system_authentication_field_equal(const system_authentication_field_t *field, const char *value)
+{
+	return strlen(value) == field->length && !memcmp(field->value, value, field->length);
+}
@@ -0,0 +1,51 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_API_AUTHENTICATION_SCAN_H
+#define SYSTEM_PLUGIN_API_AUTHENTICATION_SCAN_H
+
+#include <stddef.h>
+
+// shadow has the most fields of the scanned files - extra fields are left in the last one
+#define SYSTEM_AUTHENTICATION_SCAN_FIELD_COUNT 9
+
+typedef struct system_authentication_field_s system_authentication_field_t;
+typedef struct system_authentication_record_s system_authentication_record_t;
+typedef struct system_authentication_scan_s system_authentication_scan_t;
+
+// view into the mapped file - not NUL terminated
+struct system_authentication_field_s {
+	const char *value;
+	size_t length;
+};
+
+struct system_authentication_record_s {
+	system_authentication_field_t fields[SYSTEM_AUTHENTICATION_SCAN_FIELD_COUNT];
+	size_t count; ///< Number of fields found in the record.
+};
+
+// read-only mapping of a colon separated database file - records are scanned in place without any allocation
+struct system_authentication_scan_s {
+	const char *data;
+	size_t size;
+	size_t offset; ///< Start of the next record.
+};
+
+int system_authentication_scan_open(system_authentication_scan_t *scan, const char *path);
+int system_authentication_scan_next(system_authentication_scan_t *scan, system_authentication_record_t *record);
+void system_authentication_scan_close(system_authentication_scan_t *scan);
+
+// parse a numeric field - returns -1 if the field is not a number
+int system_authentication_field_to_id(const system_authentication_field_t *field, unsigned int *id);
+int system_authentication_field_equal(const system_authentication_field_t *field, const char *value);
+
+#endif // SYSTEM_PLUGIN_API_AUTHENTICATION_SCAN_H
@@ -0,0 +1,277 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "scope.h"
+#include "core/common.h"
+
+#include <errno.h>
+#include <grp.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sysrepo.h>
+
+// root and regular users
+static const system_authentication_scope_range_t system_authentication_scope_default_ranges[] = {
+	{0, 0},
+	{SYSTEM_AUTHENTICATION_ID_MIN, SYSTEM_AUTHENTICATION_ID_MAX},
+};
+
+static int system_authentication_scope_resolve_group(system_authentication_scope_filter_t *filter);
+static int system_authentication_scope_compare_members(const void *a, const void *b);
+
+void system_authentication_scope_init(system_authentication_scope_t *scope)
+{
+	*scope = (system_authentication_scope_t){0};
+	pthread_mutex_init(&scope->lock, NULL);
+}
+
+int system_authentication_scope_set(system_authentication_scope_t *scope, const system_authentication_scope_range_t *ranges, size_t range_count, const char *name_prefix, const char *group)
+{
+	int error = 0;
+	system_authentication_scope_range_t *new_ranges = NULL;
+	char *new_name_prefix = NULL;
+	char *new_group = NULL;
+
+	// everything is copied before the scope is swapped - readers never see a partial scope
+	if (range_count) {
+		new_ranges = malloc(sizeof(*new_ranges) * range_count);
+		if (!new_ranges) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "malloc() failed");
+			goto error_out;
+		}
+		memcpy(new_ranges, ranges, sizeof(*new_ranges) * range_count);
+	}
+
+	if (name_prefix && !(new_name_prefix = strdup(name_prefix))) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "strdup() failed");
+		goto error_out;
+	}
+
+	if (group && !(new_group = strdup(group))) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "strdup() failed");
+		goto error_out;
+	}
+
+	pthread_mutex_lock(&scope->lock);
+
+	free(scope->ranges);
+	free(scope->name_prefix);
+	free(scope->group);
+
+	scope->ranges = new_ranges;
+	scope->range_count = range_count;
+	scope->name_prefix = new_name_prefix;
+	scope->group = new_group;
+
+	pthread_mutex_unlock(&scope->lock);
+
+	goto out;
+
+error_out:
+	error = -1;
+	free(new_ranges);
+	free(new_name_prefix);
+	free(new_group);
+
+out:
+	return error;
+}
+
+int system_authentication_scope_get_filter(system_authentication_scope_t *scope, system_authentication_scope_filter_t *filter)
+{
+	int error = 0;
+	const system_authentication_scope_range_t *ranges = NULL;
+	size_t range_count = 0;
+
+	*filter = (system_authentication_scope_filter_t){0};
+
+	pthread_mutex_lock(&scope->lock);
+
+	ranges = scope->range_count ? scope->ranges : system_authentication_scope_default_ranges;
+	range_count = scope->range_count ? scope->range_count : ARRAY_SIZE(system_authentication_scope_default_ranges);
+
+	filter->ranges = malloc(sizeof(*filter->ranges) * range_count);
+	if (!filter->ranges) {
+		pthread_mutex_unlock(&scope->lock);
+		SRPLG_LOG_ERR(PLUGIN_NAME, "malloc() failed");
+		goto error_out;
+	}
+	memcpy(filter->ranges, ranges, sizeof(*filter->ranges) * range_count);
+	filter->range_count = range_count;
+
+	if (scope->name_prefix) {
+		filter->name_prefix = strdup(scope->name_prefix);
+		filter->name_prefix_length = strlen(scope->name_prefix);
+	}
+
+	if (scope->group) {
+		filter->group = strdup(scope->group);
+	}
+
+	pthread_mutex_unlock(&scope->lock);
+
+	if ((scope->name_prefix && !filter->name_prefix) || (scope->group && !filter->group)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "strdup() failed");
+		goto error_out;
+	}
+
+	// the group database is read without the lock held - it can be a network lookup
+	if (filter->group) {
+		error = system_authentication_scope_resolve_group(filter);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_scope_resolve_group() error (%d)", error);
+			goto error_out;
+		}
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+	system_authentication_scope_filter_free(filter);
+
+out:
+	return error;
+}
+
+bool system_authentication_scope_filter_contains(const system_authentication_scope_filter_t *filter, const char *name, unsigned int uid, unsigned int gid)
+{
+	if (!system_authentication_scope_filter_contains_uid(filter, uid) || !system_authentication_scope_filter_contains_name(filter, name)) {
+		return false;
+	}
+
+	if (filter->group) {
+		if (!filter->group_found) {
+			return false;
+		}
+
+		return gid == filter->gid || (filter->member_count && bsearch(&name, filter->members, filter->member_count, sizeof(*filter->members), system_authentication_scope_compare_members));
+	}
+
+	return true;
+}
+
+bool system_authentication_scope_filter_contains_uid(const system_authentication_scope_filter_t *filter, unsigned int uid)
+{
+	for (size_t i = 0; i < filter->range_count; i++) {
+		if (uid >= filter->ranges[i].min && uid <= filter->ranges[i].max) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool system_authentication_scope_filter_contains_name(const system_authentication_scope_filter_t *filter, const char *name)
+{
+	return !filter->name_prefix || !strncmp(name, filter->name_prefix, filter->name_prefix_length);
+}
+
+void system_authentication_scope_filter_free(system_authentication_scope_filter_t *filter)
+{
+	for (size_t i = 0; i < filter->member_count; i++) {
+		free(filter->members[i]);
+	}
+
+	free(filter->members);
+	free(filter->ranges);
+	free(filter->name_prefix);
+	free(filter->group);
+
+	*filter = (system_authentication_scope_filter_t){0};
+}
+
+void system_authentication_scope_free(system_authentication_scope_t *scope)
+{
+	free(scope->ranges);
+	free(scope->name_prefix);
+	free(scope->group);
+
+	pthread_mutex_destroy(&scope->lock);
+
+	*scope = (system_authentication_scope_t){0};
+}
+
+static int system_authentication_scope_resolve_group(system_authentication_scope_filter_t *filter)
+{
+	int error = 0;
+	struct group group = {0};
+	struct group *result = NULL;
+	char *buffer = NULL, *new_buffer = NULL;
+	size_t buffer_size = 1024;
+	size_t count = 0;
+
+	// groups with many members do not fit the initial buffer
+	do {
+		new_buffer = realloc(buffer, buffer_size);
+		if (!new_buffer) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "realloc() failed");
+			goto error_out;
+		}
+		buffer = new_buffer;
+
+		error = getgrnam_r(filter->group, &group, buffer, buffer_size, &result);
+		buffer_size *= 2;
+	} while (error == ERANGE);
+
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "getgrnam_r() failed for group %s: %s", filter->group, strerror(error));
+		goto error_out;
+	}
+
+	if (!result) {
+		SRPLG_LOG_WRN(PLUGIN_NAME, "Group %s of the managed user scope not found - no users are managed", filter->group);
+		goto out;
+	}
+
+	while (group.gr_mem[count]) {
+		count++;
+	}
+
+	if (count) {
+		filter->members = calloc(count, sizeof(*filter->members));
+		if (!filter->members) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "calloc() failed");
+			goto error_out;
+		}
+
+		for (filter->member_count = 0; filter->member_count < count; filter->member_count++) {
+			filter->members[filter->member_count] = strdup(group.gr_mem[filter->member_count]);
+			if (!filter->members[filter->member_count]) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "strdup() failed");
+				goto error_out;
+			}
+		}
+
+		// looked up for every user of the loaded database
+		qsort(filter->members, filter->member_count, sizeof(*filter->members), system_authentication_scope_compare_members);
+	}
+
+	filter->group_found = true;
+	filter->gid = group.gr_gid;
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	free(buffer);
+
+	return error;
+}
+
+static int system_authentication_scope_compare_members(const void *a, const void *b)
+{
+	return strcmp(*(char *const *) a, *(char *const *) b);
+}
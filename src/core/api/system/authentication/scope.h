@@ -0,0 +1,63 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_API_AUTHENTICATION_SCOPE_H
+#define SYSTEM_PLUGIN_API_AUTHENTICATION_SCOPE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+typedef struct system_authentication_scope_range_s system_authentication_scope_range_t;
+typedef struct system_authentication_scope_s system_authentication_scope_t;
+typedef struct system_authentication_scope_filter_s system_authentication_scope_filter_t;
+
+struct system_authentication_scope_range_s {
+	unsigned int min;
+	unsigned int max;
+};
+
+// local users managed by the plugin - users outside of the scope are not loaded, compared or written
+struct system_authentication_scope_s {
+	pthread_mutex_t lock;
+	system_authentication_scope_range_t *ranges; ///< Managed UID ranges - root and the default UID window if none are set.
+	size_t range_count;
+	char *name_prefix; ///< Managed user names start with the prefix - NULL for any name.
+	char *group;	   ///< Managed users are members of the group - NULL for any group.
+};
+
+// copy of the scope used for one load, store or transaction - the group is resolved once
+struct system_authentication_scope_filter_s {
+	system_authentication_scope_range_t *ranges;
+	size_t range_count;
+	char *name_prefix;
+	size_t name_prefix_length;
+	char *group;
+	bool group_found; ///< The group exists - no user is managed otherwise.
+	gid_t gid;		  ///< Users with the group as their primary group are members.
+	char **members;	  ///< Sorted members of the group.
+	size_t member_count;
+};
+
+void system_authentication_scope_init(system_authentication_scope_t *scope);
+int system_authentication_scope_set(system_authentication_scope_t *scope, const system_authentication_scope_range_t *ranges, size_t range_count, const char *name_prefix, const char *group);
+
+int system_authentication_scope_get_filter(system_authentication_scope_t *scope, system_authentication_scope_filter_t *filter);
+bool system_authentication_scope_filter_contains(const system_authentication_scope_filter_t *filter, const char *name, unsigned int uid, unsigned int gid);
+bool system_authentication_scope_filter_contains_uid(const system_authentication_scope_filter_t *filter, unsigned int uid);
+bool system_authentication_scope_filter_contains_name(const system_authentication_scope_filter_t *filter, const char *name);
+void system_authentication_scope_filter_free(system_authentication_scope_filter_t *filter);
+
+void system_authentication_scope_free(system_authentication_scope_t *scope);
+
+#endif // SYSTEM_PLUGIN_API_AUTHENTICATION_SCOPE_H
@@ -11,13 +11,19 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 #include "store.h"
+#include "authorized_keys.h"
+#include "home.h"
+#include "id.h"
+#include "password.h"
 #include "core/common.h"
 #include "umgmt/group.h"
+#include "core/data/system/authentication/local_user.h"
 
 #include <asm-generic/errno-base.h>
 #include <linux/limits.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <sysrepo.h>
@@ -28,22 +34,22 @@
 #include <pwd.h>
 #include <shadow.h>
 
-#include <srpc.h>
 #include <umgmt.h>
 
-static int system_authentication_user_create_home(const char *username, const uid_t uid, const gid_t gid);
-static int system_authentication_user_copy_skel(const char *username, const uid_t uid, const gid_t gid);
+static int system_authentication_store_hash_passwords(system_ctx_t *ctx, system_local_user_element_t *head);
+static int system_authentication_store_get_passwords(sr_session_ctx_t *session, sr_val_t **values, size_t *count);
 
 int system_authentication_store_user(system_ctx_t *ctx, system_local_user_element_t *head)
 {
 	int error = 0;
-	system_local_user_element_t *iter = NULL;
 	um_db_t *db = NULL;
-	um_user_t *new_user = NULL;
-	um_group_t *new_group = NULL;
-	char home_dir_buffer[PATH_MAX] = {0};
-	bool user_added = false;
-	bool group_added = false;
+	system_authentication_scope_filter_t filter = {0};
+
+	error = system_authentication_scope_get_filter(&ctx->user_scope, &filter);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_scope_get_filter() error (%d)", error);
+		goto error_out;
+	}
 
 	db = um_db_new();
 	if (!db) {
@@ -58,13 +64,90 @@ int system_authentication_store_user(system_ctx_t *ctx, system_local_user_elemen
 		goto error_out;
 	}
 
+	error = system_authentication_store_user_db(ctx, db, &filter, head);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_store_user_db() error (%d)", error);
+		goto error_out;
+	}
+
+	// store database data after all users and user groups have been added
+	error = um_db_store(db);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_store() error (%d)", error);
+		goto error_out;
+	}
+
+	error = system_authentication_store_user_home(ctx, db, head);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_store_user_home() error (%d)", error);
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (db) {
+		um_db_free(db);
+	}
+
+	system_authentication_scope_filter_free(&filter);
+
+	return error;
+}
+
+int system_authentication_store_user_db(system_ctx_t *ctx, um_db_t *db, const system_authentication_scope_filter_t *filter, system_local_user_element_t *head)
+{
+	int error = 0;
+	system_local_user_element_t *iter = NULL;
+	um_user_t *new_user = NULL;
+	um_group_t *new_group = NULL;
+	um_group_t *scope_group = NULL;
+	char home_dir_buffer[PATH_MAX] = {0};
+	bool user_added = false;
+	bool group_added = false;
+	system_authentication_id_allocator_t *id_allocator = NULL;
+	uid_t uid = 0;
+	gid_t gid = 0;
+
+	// used IDs are collected once - new IDs are then handed out without scanning the database for every user
+	id_allocator = malloc(sizeof(*id_allocator));
+	if (!id_allocator) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "malloc() failed");
+		goto error_out;
+	}
+
+	system_authentication_id_allocator_init(id_allocator, db);
+	system_authentication_id_allocator_restrict(id_allocator, filter);
+
+	// new users are added to the group of the managed user scope - otherwise they would not be loaded again
+	if (filter->group && head) {
+		scope_group = um_db_get_group(db, filter->group);
+		if (!scope_group) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Group %s of the managed user scope not found in the group database", filter->group);
+			goto error_out;
+		}
+	}
+
+	// cleartext passwords of the startup datastore never reach shadow
+	error = system_authentication_store_hash_passwords(ctx, head);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_store_hash_passwords() error (%d)", error);
+		goto error_out;
+	}
+
 	// add all users
 	LL_FOREACH(head, iter)
 	{
 		const char *username = iter->user.name;
 		const char *password = iter->user.password;
-		const uid_t uid = um_db_get_new_uid(db);
-		const gid_t gid = um_db_get_new_gid(db);
+
+		if (!system_authentication_scope_filter_contains_name(filter, username)) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "User %s is outside of the managed user scope", username);
+			goto error_out;
+		}
 
 		// check if user already exists
 		if (um_db_get_user(db, username)) {
@@ -72,6 +155,18 @@ int system_authentication_store_user(system_ctx_t *ctx, system_local_user_elemen
 			goto error_out;
 		}
 
+		// the user group is created with the user name - never take over an existing group
+		if (um_db_get_group(db, username)) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Group %s already exists in the database", username);
+			goto error_out;
+		}
+
+		error = system_authentication_id_allocator_get(id_allocator, &uid, &gid);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "No free UID/GID left for user %s", username);
+			goto error_out;
+		}
+
 		// create new user
 		new_user = um_user_new();
 		if (!new_user) {
@@ -141,9 +236,9 @@ int system_authentication_store_user(system_ctx_t *ctx, system_local_user_elemen
 
 		// shadow data
 		um_user_set_last_change(new_user, -1);
-		um_user_set_change_min(new_user, 0);
-		um_user_set_change_max(new_user, 99999);
-		um_user_set_warn_days(new_user, 7);
+		um_user_set_change_min(new_user, SYSTEM_AUTHENTICATION_DEFAULT_CHANGE_MIN);
+		um_user_set_change_max(new_user, SYSTEM_AUTHENTICATION_DEFAULT_CHANGE_MAX);
+		um_user_set_warn_days(new_user, SYSTEM_AUTHENTICATION_DEFAULT_WARN_DAYS);
 		um_user_set_expiration(new_user, -1);
 		um_user_set_inactive_days(new_user, -1);
 
@@ -204,40 +299,13 @@ int system_authentication_store_user(system_ctx_t *ctx, system_local_user_elemen
 			SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_add_group() error (%d)", error);
 			goto error_out;
 		}
-	}
 
-	// store database data after all users and user groups have been added
-	error = um_db_store(db);
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_store() error (%d)", error);
-		goto error_out;
-	}
-
-	// create home directories and copy /etc/skel data
-	LL_FOREACH(head, iter)
-	{
-		const char *username = iter->user.name;
-		const um_user_t *um_user = um_db_get_user(db, username);
-
-		// the user has to be in the database since we've just added him in steps above
-		assert(um_user != NULL);
-
-		// get uid and gid for chown() when creating home directory
-		const uid_t uid = um_user_get_uid(um_user);
-		const gid_t gid = um_user_get_gid(um_user);
-
-		// create home directory
-		error = system_authentication_user_create_home(username, uid, gid);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_user_create_home() error (%d)", error);
-			goto error_out;
-		}
-
-		// copy /etc/skel contents
-		error = system_authentication_user_copy_skel(username, uid, gid);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_user_copy_skel() error (%d)", error);
-			goto error_out;
+		if (scope_group) {
+			error = um_group_add_member(scope_group, new_user);
+			if (error) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "um_group_add_member() error (%d)", error);
+				goto error_out;
+			}
 		}
 	}
 
@@ -255,116 +323,196 @@ out:
 		um_group_free(new_group);
 	}
 
-	if (db) {
-		um_db_free(db);
+	if (id_allocator) {
+		free(id_allocator);
 	}
+
 	return error;
 }
 
-int system_authentication_store_user_authorized_key(system_ctx_t *ctx, const char *user, system_authorized_key_element_t *head)
+int system_authentication_store_user_home(system_ctx_t *ctx, const um_db_t *db, system_local_user_element_t *head)
 {
 	int error = 0;
-	system_authorized_key_element_t *iter;
-	char ssh_path_buffer[PATH_MAX] = {0};
-	char key_path_buffer[PATH_MAX] = {0};
-	DIR *ssh_dir = NULL;
-	FILE *key_file = NULL;
-	bool key_file_opened = false;
-
-	if (strcmp(user, "root")) {
-		error = snprintf(ssh_path_buffer, sizeof(ssh_path_buffer), "/home/%s/.ssh", user);
-		if (error < 0) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() failed");
-			goto error_out;
-		}
+	system_local_user_element_t *iter = NULL;
+	system_authentication_home_t *homes = NULL;
+	size_t home_count = 0;
 
-		ssh_dir = opendir(ssh_path_buffer);
-		if (errno == ENOENT) {
-			// create directory
-			error = mkdir(ssh_path_buffer, 0700);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "mkdir() error (%d) for user %s:%s", error, user, ssh_path_buffer);
-				goto error_out;
-			}
-		}
+	LL_COUNT(head, iter, home_count);
+	if (!home_count) {
+		goto out;
+	}
 
-		// create key files
-		LL_FOREACH(head, iter)
-		{
-			if ((error = snprintf(key_path_buffer, sizeof(key_path_buffer), "%s/%s", ssh_path_buffer, iter->key.name)) < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
-				goto error_out;
-			}
+	homes = calloc(home_count, sizeof(*homes));
+	if (!homes) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "calloc() failed");
+		goto error_out;
+	}
 
-			key_file = fopen(key_path_buffer, "w");
-			if (!key_file) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "fopen() failed");
-				goto error_out;
-			}
-			key_file_opened = true;
+	home_count = 0;
+	LL_FOREACH(head, iter)
+	{
+		const um_user_t *um_user = um_db_get_user(db, iter->user.name);
 
-			error = fprintf(key_file, "%s %s", iter->key.algorithm, iter->key.data);
-			if (error < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "fprintf() error (%d)", error);
-				goto error_out;
-			}
+		// the user has to be in the database since we've just added him in steps above
+		assert(um_user != NULL);
 
-			fclose(key_file);
-			key_file_opened = false;
-		}
+		// uid and gid for the owner of the home directory and the skel copy
+		homes[home_count++] = (system_authentication_home_t){
+			.name = iter->user.name,
+			.uid = um_user_get_uid(um_user),
+			.gid = um_user_get_gid(um_user),
+		};
+	}
+
+	// create home directories and copy /etc/skel data
+	error = system_authentication_home_provision(homes, home_count);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_home_provision() error (%d)", error);
+		goto error_out;
 	}
 
-	error = 0;
 	goto out;
 
 error_out:
 	error = -1;
 
 out:
-	if (ssh_dir) {
-		closedir(ssh_dir);
+	if (homes) {
+		free(homes);
 	}
 
-	if (key_file_opened) {
-		fclose(key_file);
+	return error;
+}
+
+int system_authentication_store_user_authorized_key(system_ctx_t *ctx, const char *user, system_authorized_key_element_t *head)
+{
+	int error = 0;
+
+	// keys are added to ~/.ssh/authorized_keys or replace the managed lines of the same name
+	error = system_authentication_authorized_keys_apply(user, head, NULL, NULL);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_authorized_keys_apply() error (%d) for user %s", error, user);
+		goto error_out;
 	}
 
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
 	return error;
 }
 
-static int system_authentication_user_create_home(const char *username, const uid_t uid, const gid_t gid)
+int system_authentication_store_hash_datastore(system_ctx_t *ctx, sr_session_ctx_t *startup_session, sr_session_ctx_t *running_session)
 {
 	int error = 0;
-	char path_buffer[PATH_MAX] = {0};
-	DIR *home_dir = NULL;
+	sr_val_t *startup_values = NULL, *running_values = NULL;
+	size_t startup_count = 0, running_count = 0;
+	size_t *startup_hashes = NULL, *running_hashes = NULL;
+	system_authentication_password_t *passwords = NULL;
+	size_t count = 0;
+	const char *value = NULL;
+
+	error = system_authentication_store_get_passwords(startup_session, &startup_values, &startup_count);
+	if (error) {
+		goto error_out;
+	}
 
-	error = snprintf(path_buffer, sizeof(path_buffer), "/home/%s", username);
-	if (error < 0) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() failed");
+	error = system_authentication_store_get_passwords(running_session, &running_values, &running_count);
+	if (error) {
 		goto error_out;
 	}
 
-	home_dir = opendir(path_buffer);
-	if (home_dir) {
-		// home dir exists - unable to create it
-		SRPLG_LOG_ERR(PLUGIN_NAME, "Home directory for user %s exists", username);
+	if (!startup_count && !running_count) {
+		goto out;
+	}
+
+	// index of the hash of every value - SIZE_MAX for values already hashed
+	startup_hashes = calloc(startup_count + 1, sizeof(*startup_hashes));
+	running_hashes = calloc(running_count + 1, sizeof(*running_hashes));
+	passwords = calloc(startup_count + running_count, sizeof(*passwords));
+	if (!startup_hashes || !running_hashes || !passwords) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "calloc() failed");
 		goto error_out;
-	} else if (errno == ENOENT) {
-		// create directory
-		error = mkdir(path_buffer, 0700);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "mkdir() error (%d)", error);
+	}
+
+	for (size_t i = 0; i < startup_count; i++) {
+		startup_hashes[i] = SIZE_MAX;
+		if (system_authentication_password_is_cleartext(startup_values[i].data.string_val)) {
+			startup_hashes[i] = count;
+			passwords[count++].cleartext = startup_values[i].data.string_val + sizeof(SYSTEM_AUTHENTICATION_PASSWORD_CLEARTEXT_PREFIX) - 1;
+		}
+	}
+
+	// running is a copy of startup - the same password gets the same hash in both datastores
+	for (size_t i = 0; i < running_count; i++) {
+		running_hashes[i] = SIZE_MAX;
+		value = running_values[i].data.string_val;
+		if (!system_authentication_password_is_cleartext(value)) {
+			continue;
+		}
+
+		for (size_t j = 0; j < startup_count && running_hashes[i] == SIZE_MAX; j++) {
+			// users are listed in the same order in both datastores - the same position is checked first
+			const size_t k = (i + j) % startup_count;
+
+			if (startup_hashes[k] != SIZE_MAX && !strcmp(startup_values[k].xpath, running_values[i].xpath) && !strcmp(startup_values[k].data.string_val, value)) {
+				running_hashes[i] = startup_hashes[k];
+			}
+		}
+
+		if (running_hashes[i] == SIZE_MAX) {
+			running_hashes[i] = count;
+			passwords[count++].cleartext = value + sizeof(SYSTEM_AUTHENTICATION_PASSWORD_CLEARTEXT_PREFIX) - 1;
+		}
+	}
+
+	if (!count) {
+		goto out;
+	}
+
+	SRPLG_LOG_INF(PLUGIN_NAME, "Hashing %zu cleartext passwords of the startup and running datastores", count);
+
+	error = system_authentication_password_hash(passwords, count, __atomic_load_n(&ctx->password_scheme, __ATOMIC_RELAXED));
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_password_hash() error (%d)", error);
+		goto error_out;
+	}
+
+	for (size_t i = 0; i < startup_count; i++) {
+		if (startup_hashes[i] == SIZE_MAX) {
+			continue;
+		}
+
+		error = sr_set_item_str(startup_session, startup_values[i].xpath, passwords[startup_hashes[i]].hash, NULL, 0);
+		if (error != SR_ERR_OK) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "sr_set_item_str() error (%d) for %s: %s", error, startup_values[i].xpath, sr_strerror(error));
 			goto error_out;
 		}
+	}
 
-		// set permissions to the directory
-		error = chown(path_buffer, uid, gid);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "chown() error (%d)", error);
+	for (size_t i = 0; i < running_count; i++) {
+		if (running_hashes[i] == SIZE_MAX) {
+			continue;
+		}
+
+		error = sr_set_item_str(running_session, running_values[i].xpath, passwords[running_hashes[i]].hash, NULL, 0);
+		if (error != SR_ERR_OK) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "sr_set_item_str() error (%d) for %s: %s", error, running_values[i].xpath, sr_strerror(error));
 			goto error_out;
 		}
-	} else {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "opendir() failed");
+	}
+
+	error = sr_apply_changes(startup_session, 0);
+	if (error != SR_ERR_OK) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_apply_changes() error (%d) for the startup datastore: %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	error = sr_apply_changes(running_session, 0);
+	if (error != SR_ERR_OK) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_apply_changes() error (%d) for the running datastore: %s", error, sr_strerror(error));
 		goto error_out;
 	}
 
@@ -372,62 +520,95 @@ static int system_authentication_user_create_home(const char *username, const ui
 
 error_out:
 	error = -1;
+	sr_discard_changes(startup_session);
+	sr_discard_changes(running_session);
 
 out:
-	if (home_dir) {
-		closedir(home_dir);
+	if (passwords) {
+		system_authentication_password_free(passwords, count);
+		free(passwords);
+	}
+
+	free(startup_hashes);
+	free(running_hashes);
+
+	if (startup_values) {
+		sr_free_values(startup_values, startup_count);
+	}
+
+	if (running_values) {
+		sr_free_values(running_values, running_count);
 	}
 
 	return error;
 }
 
-static int system_authentication_user_copy_skel(const char *username, const uid_t uid, const gid_t gid)
+static int system_authentication_store_get_passwords(sr_session_ctx_t *session, sr_val_t **values, size_t *count)
 {
 	int error = 0;
-	char source_buffer[PATH_MAX] = {0};
-	char destination_buffer[PATH_MAX] = {0};
-	char home_path_buffer[PATH_MAX] = {0};
-	char skel_path_buffer[PATH_MAX] = {0};
 
-	DIR *dir = NULL;
-	struct dirent *dir_entry = NULL;
+	error = sr_get_items(session, SYSTEM_AUTHENTICATION_USER_PASSWORD_YANG_PATH, 0, 0, values, count);
+	if (error == SR_ERR_NOT_FOUND) {
+		*values = NULL;
+		*count = 0;
+		return 0;
+	}
 
-	if (snprintf(skel_path_buffer, sizeof(skel_path_buffer), "%s", SYSTEM_AUTHENTICATION_SKEL_DIRECTORY) < 0) {
-		goto error_out;
+	if (error != SR_ERR_OK) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_get_items() error (%d): %s", error, sr_strerror(error));
+		return -1;
 	}
 
-	if (snprintf(home_path_buffer, sizeof(home_path_buffer), "/home/%s", username) < 0) {
+	return 0;
+}
+
+static int system_authentication_store_hash_passwords(system_ctx_t *ctx, system_local_user_element_t *head)
+{
+	int error = 0;
+	system_local_user_element_t *iter = NULL;
+	system_local_user_element_t **users = NULL;
+	system_authentication_password_t *passwords = NULL;
+	size_t count = 0;
+
+	LL_FOREACH(head, iter)
+	{
+		if (system_authentication_password_is_cleartext(iter->user.password)) {
+			count++;
+		}
+	}
+
+	if (!count) {
+		goto out;
+	}
+
+	users = calloc(count, sizeof(*users));
+	passwords = calloc(count, sizeof(*passwords));
+	if (!users || !passwords) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "calloc() failed");
 		goto error_out;
 	}
 
-	if ((dir = opendir(skel_path_buffer)) == NULL) {
-		SRPLG_LOG_INF(PLUGIN_NAME, "Unable to open directory %s", skel_path_buffer);
+	count = 0;
+	LL_FOREACH(head, iter)
+	{
+		if (system_authentication_password_is_cleartext(iter->user.password)) {
+			users[count] = iter;
+			passwords[count].cleartext = iter->user.password + sizeof(SYSTEM_AUTHENTICATION_PASSWORD_CLEARTEXT_PREFIX) - 1;
+			count++;
+		}
+	}
+
+	error = system_authentication_password_hash(passwords, count, __atomic_load_n(&ctx->password_scheme, __ATOMIC_RELAXED));
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_password_hash() error (%d)", error);
 		goto error_out;
-	} else {
-		// copy all files from /etc/skel directory to the user home directory
-		while ((dir_entry = readdir(dir)) != NULL) {
-			if (strcmp(dir_entry->d_name, ".") && strcmp(dir_entry->d_name, "..") && dir_entry->d_type != DT_DIR) {
-				if (snprintf(source_buffer, sizeof(source_buffer), "%s/%s", skel_path_buffer, dir_entry->d_name) < 0) {
-					goto error_out;
-				}
-
-				if (snprintf(destination_buffer, sizeof(destination_buffer), "%s/%s", home_path_buffer, dir_entry->d_name) < 0) {
-					goto error_out;
-				}
-
-				error = srpc_copy_file(source_buffer, destination_buffer);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_copy_file() error (%d) for %s --> %s", error, source_buffer, destination_buffer);
-					goto error_out;
-				}
-
-				// file copied - set its owner
-				error = chown(destination_buffer, uid, gid);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "chown() error (%d) for %s", error, destination_buffer);
-					goto error_out;
-				}
-			}
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		error = system_local_user_set_password(&users[i]->user, passwords[i].hash);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_set_password() error (%d)", error);
+			goto error_out;
 		}
 	}
 
@@ -437,10 +618,12 @@ error_out:
 	error = -1;
 
 out:
-
-	if (dir) {
-		closedir(dir);
+	if (passwords) {
+		system_authentication_password_free(passwords, count);
+		free(passwords);
 	}
 
+	free(users);
+
 	return error;
 }
\ No newline at end of file
@@ -14,8 +14,19 @@
 #define SYSTEM_PLUGIN_API_AUTHENTICATION_STORE_H
 
 #include "core/context.h"
+#include "core/api/system/authentication/scope.h"
 
 int system_authentication_store_user(system_ctx_t *ctx, system_local_user_element_t *head);
+
+// replace cleartext passwords of both datastores by their hash - startup data copied to running does not pass the update event
+int system_authentication_store_hash_datastore(system_ctx_t *ctx, sr_session_ctx_t *startup_session, sr_session_ctx_t *running_session);
+
+// add users and their groups to an already loaded database - the database is not stored
+int system_authentication_store_user_db(system_ctx_t *ctx, um_db_t *db, const system_authentication_scope_filter_t *filter, system_local_user_element_t *head);
+
+// create home directories of users already stored in the database
+int system_authentication_store_user_home(system_ctx_t *ctx, const um_db_t *db, system_local_user_element_t *head);
+
 int system_authentication_store_user_authorized_key(system_ctx_t *ctx, const char *user, system_authorized_key_element_t *head);
 
 #endif // SYSTEM_PLUGIN_API_AUTHENTICATION_STORE_H
\ No newline at end of file
@@ -0,0 +1,498 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "trash.h"
+#include "core/common.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sysrepo.h>
+
+#include <utlist.h>
+
+static void *system_authentication_trash_worker(void *arg);
+static int system_authentication_trash_queue(system_authentication_trash_t *trash, const char *name);
+static int system_authentication_trash_remove(system_authentication_trash_t *trash, int root_fd, const char *name);
+static int system_authentication_trash_walk(system_authentication_trash_t *trash, int root_fd, const char *name, bool remove, system_authentication_trash_entry_t **parts);
+static void system_authentication_trash_account(system_authentication_trash_t *trash, bool remove, uint64_t entries, uint64_t bytes);
+
+int system_authentication_trash_init(system_authentication_trash_t *trash)
+{
+	int error = 0;
+	int dir_fd = -1;
+	DIR *dir = NULL;
+	struct dirent *dir_entry = NULL;
+
+	*trash = (system_authentication_trash_t){
+		.home_fd = -1,
+		.trash_fd = -1,
+	};
+
+	pthread_mutex_init(&trash->lock, NULL);
+	pthread_cond_init(&trash->queued, NULL);
+
+	trash->home_fd = open(SYSTEM_AUTHENTICATION_HOME_DIRECTORY, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (trash->home_fd == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "open() error for %s (%s)", SYSTEM_AUTHENTICATION_HOME_DIRECTORY, strerror(errno));
+		goto error_out;
+	}
+
+	// the trash is kept next to the homes - renaming into it never crosses a filesystem
+	if (mkdirat(trash->home_fd, SYSTEM_AUTHENTICATION_TRASH_DIRECTORY, 0700) == -1 && errno != EEXIST) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "mkdirat() error for %s (%s)", SYSTEM_AUTHENTICATION_TRASH_DIRECTORY, strerror(errno));
+		goto error_out;
+	}
+
+	trash->trash_fd = openat(trash->home_fd, SYSTEM_AUTHENTICATION_TRASH_DIRECTORY, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	if (trash->trash_fd == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "openat() error for %s (%s)", SYSTEM_AUTHENTICATION_TRASH_DIRECTORY, strerror(errno));
+		goto error_out;
+	}
+
+	// homes trashed by a previous run which did not finish removing them
+	dir_fd = dup(trash->trash_fd);
+	if (dir_fd == -1 || (dir = fdopendir(dir_fd)) == NULL) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to read %s (%s)", SYSTEM_AUTHENTICATION_TRASH_DIRECTORY, strerror(errno));
+		if (dir_fd != -1) {
+			close(dir_fd);
+		}
+		goto error_out;
+	}
+
+	while ((dir_entry = readdir(dir)) != NULL) {
+		if (!strcmp(dir_entry->d_name, ".") || !strcmp(dir_entry->d_name, "..")) {
+			continue;
+		}
+
+		error = system_authentication_trash_queue(trash, dir_entry->d_name);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_trash_queue() error (%d)", error);
+			goto error_out;
+		}
+	}
+
+	error = pthread_create(&trash->worker, NULL, system_authentication_trash_worker, trash);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "pthread_create() error (%d)", error);
+		goto error_out;
+	}
+
+	trash->running = true;
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (dir) {
+		closedir(dir);
+	}
+
+	return error;
+}
+
+int system_authentication_trash_home(system_authentication_trash_t *trash, const char *username)
+{
+	int error = 0;
+	char name_buffer[NAME_MAX + 1] = {0};
+	struct timespec now = {0};
+
+	// no worker - the home is removed in place while applying the change
+	if (!trash->running) {
+		if (trash->home_fd == -1) {
+			SRPLG_LOG_WRN(PLUGIN_NAME, "Home directory of user %s not removed - %s is not available", username, SYSTEM_AUTHENTICATION_HOME_DIRECTORY);
+			return 0;
+		}
+
+		error = system_authentication_trash_remove(trash, trash->home_fd, username);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_trash_remove() error (%d) for home directory of user %s", error, username);
+			return -1;
+		}
+
+		return 0;
+	}
+
+	clock_gettime(CLOCK_REALTIME, &now);
+
+	pthread_mutex_lock(&trash->lock);
+
+	error = snprintf(name_buffer, sizeof(name_buffer), "%s.%lld.%u", username, (long long) now.tv_sec, trash->sequence++);
+	if (error < 0 || (size_t) error >= sizeof(name_buffer)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
+		goto error_out;
+	}
+
+	// the only step done while applying the change - the tree is removed by the worker
+	if (renameat(trash->home_fd, username, trash->trash_fd, name_buffer) == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "renameat() error for home directory of user %s (%s)", username, strerror(errno));
+		goto error_out;
+	}
+
+	error = system_authentication_trash_queue(trash, name_buffer);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_trash_queue() error (%d)", error);
+		goto error_out;
+	}
+
+	pthread_cond_signal(&trash->queued);
+
+	error = 0;
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	pthread_mutex_unlock(&trash->lock);
+
+	return error;
+}
+
+void system_authentication_trash_get_status(system_authentication_trash_t *trash, system_authentication_trash_status_t *status)
+{
+	pthread_mutex_lock(&trash->lock);
+	*status = trash->status;
+	pthread_mutex_unlock(&trash->lock);
+}
+
+void system_authentication_trash_free(system_authentication_trash_t *trash)
+{
+	system_authentication_trash_entry_t *entry = NULL, *tmp = NULL;
+
+	if (trash->running) {
+		pthread_mutex_lock(&trash->lock);
+		trash->stop = true;
+		pthread_cond_signal(&trash->queued);
+		pthread_mutex_unlock(&trash->lock);
+
+		pthread_join(trash->worker, NULL);
+		trash->running = false;
+	}
+
+	LL_FOREACH_SAFE(trash->pending, entry, tmp)
+	{
+		LL_DELETE(trash->pending, entry);
+		free(entry->name);
+		free(entry);
+	}
+
+	if (trash->trash_fd != -1) {
+		close(trash->trash_fd);
+	}
+
+	if (trash->home_fd != -1) {
+		close(trash->home_fd);
+	}
+
+	pthread_cond_destroy(&trash->queued);
+	pthread_mutex_destroy(&trash->lock);
+}
+
+static void *system_authentication_trash_worker(void *arg)
+{
+	system_authentication_trash_t *trash = arg;
+	system_authentication_trash_entry_t *entry = NULL;
+
+	pthread_mutex_lock(&trash->lock);
+
+	for (;;) {
+		while (!trash->pending && !trash->stop) {
+			pthread_cond_wait(&trash->queued, &trash->lock);
+		}
+
+		// homes left in the trash are removed on the next start
+		if (trash->stop) {
+			break;
+		}
+
+		entry = trash->pending;
+		LL_DELETE(trash->pending, entry);
+
+		pthread_mutex_unlock(&trash->lock);
+
+		// a failed tree stays in the trash and is removed again on the next start
+		if (system_authentication_trash_remove(trash, trash->trash_fd, entry->name)) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to remove %s/%s/%s", SYSTEM_AUTHENTICATION_HOME_DIRECTORY, SYSTEM_AUTHENTICATION_TRASH_DIRECTORY, entry->name);
+		}
+
+		pthread_mutex_lock(&trash->lock);
+
+		// whatever could not be removed is not pending anymore
+		trash->status.pending_homes--;
+		trash->status.pending_entries = 0;
+		trash->status.pending_bytes = 0;
+
+		free(entry->name);
+		free(entry);
+	}
+
+	pthread_mutex_unlock(&trash->lock);
+
+	return NULL;
+}
+
+// called with the lock held or before the worker is started
+static int system_authentication_trash_queue(system_authentication_trash_t *trash, const char *name)
+{
+	system_authentication_trash_entry_t *entry = NULL;
+
+	entry = malloc(sizeof(*entry));
+	if (!entry) {
+		return -1;
+	}
+
+	entry->name = strdup(name);
+	if (!entry->name) {
+		free(entry);
+		return -1;
+	}
+
+	entry->next = NULL;
+	LL_APPEND(trash->pending, entry);
+	trash->status.pending_homes++;
+
+	return 0;
+}
+
+static int system_authentication_trash_remove(system_authentication_trash_t *trash, int root_fd, const char *name)
+{
+	int error = 0;
+	system_authentication_trash_entry_t *parts = NULL, *part = NULL, *tmp = NULL;
+
+	// size the tree first so the pending counters go down to zero while removing it
+	error = system_authentication_trash_walk(trash, root_fd, name, false, NULL);
+	if (error) {
+		goto error_out;
+	}
+
+	error = system_authentication_trash_walk(trash, root_fd, name, true, &parts);
+	if (error) {
+		goto error_out;
+	}
+
+	// subtrees too deep to be removed with the tree were moved next to it - each may add more parts
+	while (parts) {
+		part = parts;
+		LL_DELETE(parts, part);
+
+		error = system_authentication_trash_walk(trash, root_fd, part->name, false, NULL);
+		if (!error) {
+			error = system_authentication_trash_walk(trash, root_fd, part->name, true, &parts);
+		}
+
+		free(part->name);
+		free(part);
+
+		if (error) {
+			goto error_out;
+		}
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	// parts not removed are left next to the tree
+	LL_FOREACH_SAFE(parts, part, tmp)
+	{
+		free(part->name);
+		free(part);
+	}
+
+	return error;
+}
+
+// walk the tree without recursion - at most SYSTEM_AUTHENTICATION_TRASH_MAX_DEPTH directories are open at once
+static int system_authentication_trash_walk(system_authentication_trash_t *trash, int root_fd, const char *name, bool remove, system_authentication_trash_entry_t **parts)
+{
+	int error = 0;
+	int dir_fd = -1;
+	int parent_fd = -1;
+	DIR *dirs[SYSTEM_AUTHENTICATION_TRASH_MAX_DEPTH] = {0};
+	char *names[SYSTEM_AUTHENTICATION_TRASH_MAX_DEPTH] = {0};
+	int depth = 0;
+	struct dirent *dir_entry = NULL;
+	struct stat st = {0};
+	char part_name[NAME_MAX + 1] = {0};
+	struct timespec now = {0};
+	system_authentication_trash_entry_t *part = NULL;
+
+	if (fstatat(root_fd, name, &st, AT_SYMLINK_NOFOLLOW) == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fstatat() error for %s (%s)", name, strerror(errno));
+		goto error_out;
+	}
+
+	if (!S_ISDIR(st.st_mode)) {
+		if (remove && unlinkat(root_fd, name, 0) == -1) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "unlinkat() error for %s (%s)", name, strerror(errno));
+			goto error_out;
+		}
+
+		system_authentication_trash_account(trash, remove, 1, (uint64_t) st.st_size);
+		goto out;
+	}
+
+	names[0] = strdup(name);
+	if (!names[0]) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "strdup() failed");
+		goto error_out;
+	}
+
+	dir_fd = openat(root_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	if (dir_fd == -1 || (dirs[0] = fdopendir(dir_fd)) == NULL) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to open directory %s (%s)", name, strerror(errno));
+		if (dir_fd != -1) {
+			close(dir_fd);
+		}
+		goto error_out;
+	}
+
+	while (depth >= 0) {
+		dir_entry = readdir(dirs[depth]);
+
+		// directory is empty now - remove it and continue in its parent
+		if (!dir_entry) {
+			closedir(dirs[depth]);
+			dirs[depth] = NULL;
+
+			parent_fd = depth ? dirfd(dirs[depth - 1]) : root_fd;
+			if (remove && unlinkat(parent_fd, names[depth], AT_REMOVEDIR) == -1) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "unlinkat() error for %s (%s)", names[depth], strerror(errno));
+				goto error_out;
+			}
+
+			system_authentication_trash_account(trash, remove, 1, 0);
+
+			free(names[depth]);
+			names[depth] = NULL;
+			depth--;
+			continue;
+		}
+
+		if (!strcmp(dir_entry->d_name, ".") || !strcmp(dir_entry->d_name, "..")) {
+			continue;
+		}
+
+		parent_fd = dirfd(dirs[depth]);
+
+		if (fstatat(parent_fd, dir_entry->d_name, &st, AT_SYMLINK_NOFOLLOW) == -1) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "fstatat() error for %s (%s)", dir_entry->d_name, strerror(errno));
+			goto error_out;
+		}
+
+		if (!S_ISDIR(st.st_mode)) {
+			if (remove && unlinkat(parent_fd, dir_entry->d_name, 0) == -1) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "unlinkat() error for %s (%s)", dir_entry->d_name, strerror(errno));
+				goto error_out;
+			}
+
+			system_authentication_trash_account(trash, remove, 1, (uint64_t) st.st_size);
+			continue;
+		}
+
+		// too deep - sized and removed as a separate part after this tree
+		if (depth + 1 == SYSTEM_AUTHENTICATION_TRASH_MAX_DEPTH) {
+			if (!remove) {
+				continue;
+			}
+
+			clock_gettime(CLOCK_REALTIME, &now);
+
+			pthread_mutex_lock(&trash->lock);
+			error = snprintf(part_name, sizeof(part_name), "%s.%lld.%u", SYSTEM_AUTHENTICATION_TRASH_DIRECTORY, (long long) now.tv_sec, trash->sequence++);
+			pthread_mutex_unlock(&trash->lock);
+			if (error < 0 || (size_t) error >= sizeof(part_name)) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
+				goto error_out;
+			}
+
+			if (renameat(parent_fd, dir_entry->d_name, root_fd, part_name) == -1) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "renameat() error for %s (%s)", dir_entry->d_name, strerror(errno));
+				goto error_out;
+			}
+
+			part = malloc(sizeof(*part));
+			if (!part || (part->name = strdup(part_name)) == NULL) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to remember %s - left in place", part_name);
+				free(part);
+				goto error_out;
+			}
+
+			part->next = NULL;
+			LL_APPEND(*parts, part);
+			continue;
+		}
+
+		names[depth + 1] = strdup(dir_entry->d_name);
+		if (!names[depth + 1]) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "strdup() failed");
+			goto error_out;
+		}
+
+		dir_fd = openat(parent_fd, dir_entry->d_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+		if (dir_fd == -1 || (dirs[depth + 1] = fdopendir(dir_fd)) == NULL) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to open directory %s (%s)", dir_entry->d_name, strerror(errno));
+			if (dir_fd != -1) {
+				close(dir_fd);
+			}
+			free(names[depth + 1]);
+			names[depth + 1] = NULL;
+			goto error_out;
+		}
+
+		depth++;
+	}
+
+	error = 0;
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	for (int i = 0; i < SYSTEM_AUTHENTICATION_TRASH_MAX_DEPTH; i++) {
+		if (dirs[i]) {
+			closedir(dirs[i]);
+		}
+		free(names[i]);
+	}
+
+	return error;
+}
+
+static void system_authentication_trash_account(system_authentication_trash_t *trash, bool remove, uint64_t entries, uint64_t bytes)
+{
+	pthread_mutex_lock(&trash->lock);
+
+	if (remove) {
+		trash->status.pending_entries -= entries;
+		trash->status.pending_bytes -= bytes;
+	} else {
+		trash->status.pending_entries += entries;
+		trash->status.pending_bytes += bytes;
+	}
+
+	pthread_mutex_unlock(&trash->lock);
+}
@@ -0,0 +1,64 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_API_AUTHENTICATION_TRASH_H
+#define SYSTEM_PLUGIN_API_AUTHENTICATION_TRASH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <pthread.h>
+
+// directories open at once while removing a tree - deeper subtrees are moved next to the tree and removed after it
+#define SYSTEM_AUTHENTICATION_TRASH_MAX_DEPTH 32
+
+typedef struct system_authentication_trash_entry_s system_authentication_trash_entry_t;
+typedef struct system_authentication_trash_status_s system_authentication_trash_status_t;
+typedef struct system_authentication_trash_s system_authentication_trash_t;
+
+struct system_authentication_trash_entry_s {
+	char *name; ///< Name of the home directory in the trash directory.
+	system_authentication_trash_entry_t *next;
+};
+
+struct system_authentication_trash_status_s {
+	uint32_t pending_homes;	  ///< Home directories moved to the trash and not yet removed.
+	uint64_t pending_entries; ///< Files and directories of the home being removed which still exist.
+	uint64_t pending_bytes;	  ///< Size of the files of the home being removed which still exist.
+};
+
+// deleted home directories are renamed into the trash on the same filesystem and removed by a background thread
+struct system_authentication_trash_s {
+	pthread_t worker;							  ///< Thread removing trashed home directories.
+	pthread_mutex_t lock;						  ///< Protects the pending list, the worker state and the status.
+	pthread_cond_t queued;						  ///< Signaled when a home is trashed or the worker should stop.
+	bool running;								  ///< Worker thread started.
+	bool stop;									  ///< Worker thread should stop after removing the current home.
+	int home_fd;								  ///< Directory containing the home directories - -1 if it could not be opened.
+	int trash_fd;								  ///< Trash directory - homes left from a previous run are removed on start. -1 if not available.
+	uint32_t sequence;							  ///< Keeps trashed names unique when a user is deleted more than once.
+	system_authentication_trash_entry_t *pending; ///< Trashed homes waiting for the worker.
+	system_authentication_trash_status_t status;  ///< Status exposed as operational data.
+};
+
+// on failure the trash is left usable - homes are then removed synchronously by system_authentication_trash_home()
+int system_authentication_trash_init(system_authentication_trash_t *trash);
+
+// move the home directory of the user into the trash - the directory tree is removed later by the worker, or right away if the worker is not running
+int system_authentication_trash_home(system_authentication_trash_t *trash, const char *username);
+
+void system_authentication_trash_get_status(system_authentication_trash_t *trash, system_authentication_trash_status_t *status);
+
+// stop the worker - homes not yet removed stay in the trash until the next start
+void system_authentication_trash_free(system_authentication_trash_t *trash);
+
+#endif // SYSTEM_PLUGIN_API_AUTHENTICATION_TRASH_H
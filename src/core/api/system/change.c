@@ -15,6 +15,9 @@
 #include "store.h"
 
 #include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <linux/limits.h>
 
 #include <sysrepo.h>
 #include <srpc.h>
@@ -37,6 +40,11 @@ static int system_change_timezone_name_create(system_ctx_t *ctx, const char *val
 static int system_change_timezone_name_modify(system_ctx_t *ctx, const char *old_value, const char *new_value);
 static int system_change_timezone_name_delete(system_ctx_t *ctx);
 
+// executed by the apply worker after the changes are committed
+static int system_change_hostname_execute(void *priv, void *data);
+static int system_change_timezone_name_execute(void *priv, void *data);
+static int system_change_timezone_name_delete_execute(void *priv, void *data);
+
 int system_change_contact(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
 {
 	int error = 0;
@@ -214,10 +222,23 @@ static int system_change_contact_delete(system_ctx_t *ctx)
 static int system_change_hostname_create(system_ctx_t *ctx, const char *value)
 {
 	int error = 0;
+	char *hostname = NULL;
+
+	// sethostname() would fail after the commit - reject the value now
+	if (strlen(value) > SYSTEM_HOSTNAME_LENGTH_MAX) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Hostname %s is longer than %d characters", value, SYSTEM_HOSTNAME_LENGTH_MAX);
+		return -1;
+	}
 
-	error = system_store_hostname(ctx, value);
+	hostname = strdup(value);
+	if (!hostname) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "strdup() failed");
+		return -1;
+	}
+
+	error = system_change_apply_plan_state(&ctx->change_apply, "hostname", system_change_hostname_execute, free, NULL, hostname);
 	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_store_hostname() error (%d)", error);
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_change_apply_plan_state() error (%d)", error);
 		return -1;
 	}
 
@@ -232,15 +253,7 @@ static int system_change_hostname_modify(system_ctx_t *ctx, const char *old_valu
 
 static int system_change_hostname_delete(system_ctx_t *ctx)
 {
-	int error = 0;
-
-	error = system_store_hostname(ctx, "none");
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_store_hostname() error (%d)", error);
-		return -1;
-	}
-
-	return 0;
+	return system_change_hostname_create(ctx, "none");
 }
 
 static int system_change_location_create(system_ctx_t *ctx, const char *value)
@@ -264,10 +277,30 @@ static int system_change_location_delete(system_ctx_t *ctx)
 static int system_change_timezone_name_create(system_ctx_t *ctx, const char *value)
 {
 	int error = 0;
+	char *timezone_name = NULL;
+	char path_buffer[PATH_MAX] = {0};
+
+	// symlink() to a missing zone would fail after the commit - reject the value now
+	error = snprintf(path_buffer, sizeof(path_buffer), "%s/%s", SYSTEM_TIMEZONE_DIR, value);
+	if (error < 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
+		return -1;
+	}
+
+	if (access(path_buffer, F_OK) != 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Timezone %s doesn't exist", value);
+		return -1;
+	}
 
-	error = system_store_timezone_name(ctx, value);
+	timezone_name = strdup(value);
+	if (!timezone_name) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "strdup() failed");
+		return -1;
+	}
+
+	error = system_change_apply_plan_state(&ctx->change_apply, "timezone-name", system_change_timezone_name_execute, free, NULL, timezone_name);
 	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_store_timezone_name() error (%d)", error);
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_change_apply_plan_state() error (%d)", error);
 		return -1;
 	}
 
@@ -282,8 +315,45 @@ static int system_change_timezone_name_modify(system_ctx_t *ctx, const char *old
 
 static int system_change_timezone_name_delete(system_ctx_t *ctx)
 {
-	(void) ctx;
+	int error = 0;
+
+	error = system_change_apply_plan_state(&ctx->change_apply, "timezone-name", system_change_timezone_name_delete_execute, NULL, NULL, NULL);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_change_apply_plan_state() error (%d)", error);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int system_change_hostname_execute(void *priv, void *data)
+{
+	int error = 0;
 
+	error = system_store_hostname(priv, data);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_store_hostname() error (%d)", error);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int system_change_timezone_name_execute(void *priv, void *data)
+{
+	int error = 0;
+
+	error = system_store_timezone_name(priv, data);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_store_timezone_name() error (%d)", error);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int system_change_timezone_name_delete_execute(void *priv, void *data)
+{
 	int error = 0;
 
 	error = access(SYSTEM_LOCALTIME_FILE, F_OK);
@@ -305,4 +375,4 @@ error_out:
 
 out:
 	return error;
-}
\ No newline at end of file
+}
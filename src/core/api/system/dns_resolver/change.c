@@ -55,7 +55,7 @@ int system_dns_resolver_change_search(void *priv, sr_session_ctx_t *session, con
 			}
 
 			// add to the list
-			error = system_dns_search_list_add(&ctx->temp_dns_search, temp_search);
+			error = system_dns_search_list_add(&ctx->temp_dns_resolver.search, temp_search);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_search_list_add() error (%d)", error);
 				goto error_out;
@@ -65,7 +65,7 @@ int system_dns_resolver_change_search(void *priv, sr_session_ctx_t *session, con
 			// not supported - cannot modify leaf-list element, it can be only created and deleted
 			break;
 		case SR_OP_DELETED:
-			error = system_dns_search_list_remove(&ctx->temp_dns_search, node_value);
+			error = system_dns_search_list_remove(&ctx->temp_dns_resolver.search, node_value);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_search_list_remove() error (%d)", error);
 				goto error_out;
@@ -75,6 +75,8 @@ int system_dns_resolver_change_search(void *priv, sr_session_ctx_t *session, con
 			break;
 	}
 
+	ctx->temp_dns_resolver.changed |= SYSTEM_DNS_RESOLVER_CHANGE_SEARCH;
+
 	goto out;
 
 error_out:
@@ -149,7 +151,7 @@ int system_dns_resolver_change_server_address(void *priv, sr_session_ctx_t *sess
 			}
 
 			// add to the list
-			error = system_dns_server_list_add(&ctx->temp_dns_servers, temp_server);
+			error = system_dns_server_list_add(&ctx->temp_dns_resolver.servers, temp_server);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_server_list_add() error (%d)", error);
 				goto error_out;
@@ -157,7 +159,7 @@ int system_dns_resolver_change_server_address(void *priv, sr_session_ctx_t *sess
 			break;
 		case SR_OP_MODIFIED:
 			// get existing and modify
-			found_server_el = system_dns_server_list_find(ctx->temp_dns_servers, change_ctx->previous_value);
+			found_server_el = system_dns_server_list_find(ctx->temp_dns_resolver.servers, change_ctx->previous_value);
 			if (!found_server_el) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_server_list_find() error (%d)", error);
 				goto error_out;
@@ -176,10 +178,13 @@ int system_dns_resolver_change_server_address(void *priv, sr_session_ctx_t *sess
 				SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_server_set_address() error (%d)", error);
 				goto error_out;
 			}
+
+			// both keys changed - index the element again
+			system_dns_server_list_rehash(&ctx->temp_dns_resolver.servers, found_server_el);
 			break;
 		case SR_OP_DELETED:
 			// remove element from the list
-			error = system_dns_server_list_remove(&ctx->temp_dns_servers, node_value);
+			error = system_dns_server_list_remove(&ctx->temp_dns_resolver.servers, node_value);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_server_list_remove() error (%d)", error);
 				goto error_out;
@@ -189,6 +194,8 @@ int system_dns_resolver_change_server_address(void *priv, sr_session_ctx_t *sess
 			break;
 	}
 
+	ctx->temp_dns_resolver.changed |= SYSTEM_DNS_RESOLVER_CHANGE_SERVER;
+
 	goto out;
 
 error_out:
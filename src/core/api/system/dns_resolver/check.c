@@ -43,9 +43,7 @@ srpc_check_status_t system_dns_resolver_check_search(system_ctx_t *ctx, system_d
 	// loaded search list - compare current startup list and the system one
 	LL_FOREACH(head, search_el)
 	{
-		found_el = NULL;
-
-		LL_SEARCH(system_search_head, found_el, search_el, system_dns_search_element_cmp_fn);
+		found_el = system_dns_search_list_find(system_search_head, search_el->search.domain);
 
 		if (found_el != NULL) {
 			contains_count++;
@@ -93,9 +91,8 @@ srpc_check_status_t system_dns_resolver_check_server(system_ctx_t *ctx, system_d
 	// loaded search list - compare current startup list and the system one
 	LL_FOREACH(head, server_el)
 	{
-		found_el = NULL;
-
-		LL_SEARCH(system_server_head, found_el, server_el, system_dns_server_element_cmp_fn);
+		// servers on the system are not named - match by address
+		found_el = system_dns_server_list_find_address(system_server_head, &server_el->server.address);
 
 		if (found_el != NULL) {
 			contains_count++;
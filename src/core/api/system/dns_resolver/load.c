@@ -12,6 +12,7 @@
  */
 #include "load.h"
 #include "core/common.h"
+#include "core/bus.h"
 
 // data
 #include "core/data/system/dns_resolver/server.h"
@@ -25,36 +26,375 @@
 
 #include <sysrepo.h>
 
+#include <time.h>
+
 #include <utlist.h>
 
+#ifdef SYSTEMD
+static uint64_t system_dns_resolver_cache_now(void);
+static int system_dns_resolver_load_reply(sd_bus_message *m, void *userdata, sd_bus_error *ret_error);
+static int system_dns_resolver_cache_sync(system_ctx_t *ctx, sd_bus *bus);
+static int system_dns_resolver_cache_changed(sd_bus_message *m, void *userdata, sd_bus_error *ret_error);
+static int system_dns_resolver_parse_search(sd_bus_message *msg, system_dns_search_element_t **head);
+static int system_dns_resolver_parse_server(sd_bus_message *msg, system_dns_server_element_t **head);
+#endif
+
 int system_dns_resolver_load_search(system_ctx_t *ctx, system_dns_search_element_t **head)
+{
+	return system_dns_resolver_load(ctx, head, NULL);
+}
+
+int system_dns_resolver_load_server(system_ctx_t *ctx, system_dns_server_element_t **head)
+{
+	return system_dns_resolver_load(ctx, NULL, head);
+}
+
+int system_dns_resolver_load(system_ctx_t *ctx, system_dns_search_element_t **search_head, system_dns_server_element_t **server_head)
 {
 	int error = 0;
-	system_dns_search_t tmp_search = {0};
 
 #ifdef SYSTEMD
-	int r;
-	sd_bus_message *msg = NULL;
-	sd_bus_error sdb_err = SD_BUS_ERROR_NULL;
+	int r = 0;
 	sd_bus *bus = NULL;
+	bool bus_acquired = false;
+	system_dns_resolver_cache_t *cache = &ctx->dns_resolver_cache;
+	bool query_search = false;
+	bool query_server = false;
+	sd_bus_slot *search_slot = NULL;
+	sd_bus_slot *server_slot = NULL;
+	sd_bus_message *search_msg = NULL;
+	sd_bus_message *server_msg = NULL;
+	uint64_t now = 0;
+
+	error = system_bus_acquire(&ctx->bus, &bus);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_bus_acquire() error (%d)", error);
+		goto error_out;
+	}
+
+	bus_acquired = true;
+
+	// apply signals received since the last call - on failure the cache is stale and resolved is queried
+	r = system_dns_resolver_cache_sync(ctx, bus);
+	if (r < 0) {
+		SRPLG_LOG_WRN(PLUGIN_NAME, "Unable to sync resolved state cache (%s) - querying resolved", strerror(-r));
+		cache->valid = 0;
+	}
+
+	// resolved only signals some of its changes - parts older than the TTL are queried again
+	now = system_dns_resolver_cache_now();
+	if (now >= cache->search_expires) {
+		cache->valid &= ~(uint32_t) SYSTEM_DNS_RESOLVER_CHANGE_SEARCH;
+	}
+	if (now >= cache->server_expires) {
+		cache->valid &= ~(uint32_t) SYSTEM_DNS_RESOLVER_CHANGE_SERVER;
+	}
+
+	query_search = search_head && !(cache->valid & SYSTEM_DNS_RESOLVER_CHANGE_SEARCH);
+	query_server = server_head && !(cache->valid & SYSTEM_DNS_RESOLVER_CHANGE_SERVER);
+
+	// send both property requests before waiting - the replies are received in one round-trip
+	if (query_search) {
+		r = sd_bus_call_method_async(
+			bus,
+			&search_slot,
+			"org.freedesktop.resolve1",
+			"/org/freedesktop/resolve1",
+			"org.freedesktop.DBus.Properties",
+			"Get",
+			system_dns_resolver_load_reply,
+			&search_msg,
+			"ss",
+			"org.freedesktop.resolve1.Manager",
+			"Domains");
+		if (r < 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "sd_bus_call_method_async() error for Domains: %s", strerror(-r));
+			goto error_out;
+		}
+	}
+
+	if (query_server) {
+		r = sd_bus_call_method_async(
+			bus,
+			&server_slot,
+			"org.freedesktop.resolve1",
+			"/org/freedesktop/resolve1",
+			"org.freedesktop.DBus.Properties",
+			"Get",
+			system_dns_resolver_load_reply,
+			&server_msg,
+			"ss",
+			"org.freedesktop.resolve1.Manager",
+			"DNS");
+		if (r < 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "sd_bus_call_method_async() error for DNS: %s", strerror(-r));
+			goto error_out;
+		}
+	}
+
+	// replies are stored by the reply callback
+	while ((query_search && !search_msg) || (query_server && !server_msg)) {
+		r = sd_bus_process(bus, NULL);
+		if (r < 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "sd_bus_process() error: %s", strerror(-r));
+			goto error_out;
+		}
+
+		if (r > 0) {
+			continue;
+		}
+
+		r = sd_bus_wait(bus, (uint64_t) -1);
+		if (r < 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "sd_bus_wait() error: %s", strerror(-r));
+			goto error_out;
+		}
+	}
+
+	if (search_msg) {
+		system_dns_search_list_free(&cache->search);
+
+		r = system_dns_resolver_parse_search(search_msg, &cache->search);
+		if (r < 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_resolver_parse_search() error (%d)", r);
+			goto error_out;
+		}
+
+		cache->valid |= SYSTEM_DNS_RESOLVER_CHANGE_SEARCH;
+		cache->search_expires = now + SYSTEM_DNS_RESOLVER_CACHE_TTL_MS;
+	}
+
+	if (server_msg) {
+		system_dns_server_list_free(&cache->servers);
+
+		r = system_dns_resolver_parse_server(server_msg, &cache->servers);
+		if (r < 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_resolver_parse_server() error (%d)", r);
+			goto error_out;
+		}
+
+		cache->valid |= SYSTEM_DNS_RESOLVER_CHANGE_SERVER;
+		cache->server_expires = now + SYSTEM_DNS_RESOLVER_CACHE_TTL_MS;
+	}
+
+	// callers own their lists - hand out copies of the cached state
+	if (search_head) {
+		r = system_dns_search_list_copy(search_head, cache->search);
+		if (r < 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_search_list_copy() error (%d)", r);
+			goto error_out;
+		}
+	}
+
+	if (server_head) {
+		r = system_dns_server_list_copy(server_head, cache->servers);
+		if (r < 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_server_list_copy() error (%d)", r);
+			goto error_out;
+		}
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+	// partially parsed lists are not cached
+	if (query_search) {
+		cache->valid &= ~(uint32_t) SYSTEM_DNS_RESOLVER_CHANGE_SEARCH;
+	}
+	if (query_server) {
+		cache->valid &= ~(uint32_t) SYSTEM_DNS_RESOLVER_CHANGE_SERVER;
+	}
+
+out:
+	// unref'ing a slot cancels a call still in flight
+	sd_bus_slot_unref(search_slot);
+	sd_bus_slot_unref(server_slot);
+	sd_bus_message_unref(search_msg);
+	sd_bus_message_unref(server_msg);
+
+	if (bus_acquired) {
+		system_bus_release(&ctx->bus, r);
+	}
+#else
+#endif
+
+	return error;
+}
+
+void system_dns_resolver_cache_free(system_dns_resolver_cache_t *cache)
+{
+	system_dns_search_list_free(&cache->search);
+	system_dns_server_list_free(&cache->servers);
+
+	*cache = (system_dns_resolver_cache_t){0};
+}
+
+#ifdef SYSTEMD
+static uint64_t system_dns_resolver_cache_now(void)
+{
+	struct timespec now = {0};
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t) now.tv_sec * 1000 + (uint64_t) now.tv_nsec / 1000000;
+}
+
+static int system_dns_resolver_load_reply(sd_bus_message *m, void *userdata, sd_bus_error *ret_error)
+{
+	sd_bus_message **reply = (sd_bus_message **) userdata;
+
+	*reply = sd_bus_message_ref(m);
+
+	return 0;
+}
+
+static int system_dns_resolver_cache_sync(system_ctx_t *ctx, sd_bus *bus)
+{
+	int r = 0;
+	system_dns_resolver_cache_t *cache = &ctx->dns_resolver_cache;
+
+	// new connection - signals sent meanwhile were missed and the match has to be added again
+	if (cache->bus_generation != ctx->bus.generation) {
+		cache->valid = 0;
+
+		// floating match - released together with the connection
+		r = sd_bus_match_signal(
+			bus,
+			NULL,
+			"org.freedesktop.resolve1",
+			"/org/freedesktop/resolve1",
+			"org.freedesktop.DBus.Properties",
+			"PropertiesChanged",
+			system_dns_resolver_cache_changed,
+			cache);
+		if (r < 0) {
+			return r;
+		}
+
+		cache->bus_generation = ctx->bus.generation;
+	}
+
+	// dispatch queued signals without blocking
+	do {
+		r = sd_bus_process(bus, NULL);
+	} while (r > 0);
+
+	return r;
+}
+
+static int system_dns_resolver_cache_changed(sd_bus_message *m, void *userdata, sd_bus_error *ret_error)
+{
+	int r = 0;
+	system_dns_resolver_cache_t *cache = (system_dns_resolver_cache_t *) userdata;
+	const char *interface = NULL;
+	const char *property = NULL;
+
+	r = sd_bus_message_read(m, "s", &interface);
+	if (r < 0 || strcmp(interface, "org.freedesktop.resolve1.Manager")) {
+		return 0;
+	}
+
+	r = sd_bus_message_enter_container(m, 'a', "{sv}");
+	if (r < 0) {
+		goto invalid;
+	}
+
+	// changed properties carry their new value
+	while ((r = sd_bus_message_enter_container(m, 'e', "sv")) > 0) {
+		r = sd_bus_message_read(m, "s", &property);
+		if (r < 0) {
+			goto invalid;
+		}
+
+		if (!strcmp(property, "Domains")) {
+			system_dns_search_list_free(&cache->search);
+			cache->valid &= ~(uint32_t) SYSTEM_DNS_RESOLVER_CHANGE_SEARCH;
+
+			r = system_dns_resolver_parse_search(m, &cache->search);
+			if (r < 0) {
+				goto invalid;
+			}
+
+			cache->valid |= SYSTEM_DNS_RESOLVER_CHANGE_SEARCH;
+			cache->search_expires = system_dns_resolver_cache_now() + SYSTEM_DNS_RESOLVER_CACHE_TTL_MS;
+		} else if (!strcmp(property, "DNS")) {
+			system_dns_server_list_free(&cache->servers);
+			cache->valid &= ~(uint32_t) SYSTEM_DNS_RESOLVER_CHANGE_SERVER;
+
+			r = system_dns_resolver_parse_server(m, &cache->servers);
+			if (r < 0) {
+				goto invalid;
+			}
+
+			cache->valid |= SYSTEM_DNS_RESOLVER_CHANGE_SERVER;
+			cache->server_expires = system_dns_resolver_cache_now() + SYSTEM_DNS_RESOLVER_CACHE_TTL_MS;
+		} else {
+			r = sd_bus_message_skip(m, "v");
+			if (r < 0) {
+				goto invalid;
+			}
+		}
+
+		r = sd_bus_message_exit_container(m);
+		if (r < 0) {
+			goto invalid;
+		}
+	}
+
+	if (r < 0) {
+		goto invalid;
+	}
+
+	r = sd_bus_message_exit_container(m);
+	if (r < 0) {
+		goto invalid;
+	}
+
+	// invalidated properties carry no value - they are queried on the next load
+	r = sd_bus_message_enter_container(m, 'a', "s");
+	if (r < 0) {
+		goto invalid;
+	}
+
+	while ((r = sd_bus_message_read(m, "s", &property)) > 0) {
+		if (!strcmp(property, "Domains")) {
+			cache->valid &= ~(uint32_t) SYSTEM_DNS_RESOLVER_CHANGE_SEARCH;
+		} else if (!strcmp(property, "DNS")) {
+			cache->valid &= ~(uint32_t) SYSTEM_DNS_RESOLVER_CHANGE_SERVER;
+		}
+	}
 
-	r = sd_bus_open_system(&bus);
 	if (r < 0) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "Failed to open system bus: %s\n", strerror(-r));
-		error = -1;
 		goto invalid;
 	}
 
-	r = sd_bus_get_property(
-		bus,
-		"org.freedesktop.resolve1",
-		"/org/freedesktop/resolve1",
-		"org.freedesktop.resolve1.Manager",
-		"Domains",
-		&sdb_err,
-		&msg,
-		"a(isb)");
+	return 0;
+
+invalid:
+	// unable to follow the change - query resolved on the next load
+	SRPLG_LOG_WRN(PLUGIN_NAME, "Unable to parse resolved PropertiesChanged signal (%s) - cache marked stale", strerror(-r));
+	cache->valid = 0;
 
+	return 0;
+}
+
+static int system_dns_resolver_parse_search(sd_bus_message *msg, system_dns_search_element_t **head)
+{
+	int error = 0;
+	int r = 0;
+	const sd_bus_error *sdb_err = NULL;
+	system_dns_search_t tmp_search = {0};
+
+	if (sd_bus_message_is_method_error(msg, NULL)) {
+		sdb_err = sd_bus_message_get_error(msg);
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Getting Domains failed: %s", sdb_err ? sdb_err->message : "unknown error");
+		return -2;
+	}
+
+	// property value is wrapped in a variant
+	r = sd_bus_message_enter_container(msg, 'v', "a(isb)");
 	if (r < 0) {
 		error = -2;
 		goto invalid;
@@ -101,30 +441,30 @@ int system_dns_resolver_load_search(system_ctx_t *ctx, system_dns_search_element
 		}
 	}
 
+	// leave the array and the variant - the value can be a part of a properties dictionary
+	r = sd_bus_message_exit_container(msg);
+	if (r >= 0) {
+		r = sd_bus_message_exit_container(msg);
+	}
+	if (r < 0) {
+		error = -9;
+		goto invalid;
+	}
+
 	goto finish;
 
 invalid:
-	SRPLG_LOG_ERR(PLUGIN_NAME, "sd-bus failure (%d): %s", r, sdb_err.message);
-	// error = -1;
+	SRPLG_LOG_ERR(PLUGIN_NAME, "sd-bus failure (%d): %s", r, strerror(-r));
 
 finish:
-	sd_bus_message_unref(msg);
-	sd_bus_flush_close_unref(bus);
-#else
-#endif
-
 	return error;
 }
 
-int system_dns_resolver_load_server(system_ctx_t *ctx, system_dns_server_element_t **head)
+static int system_dns_resolver_parse_server(sd_bus_message *msg, system_dns_server_element_t **head)
 {
 	int error = 0;
-
-#ifdef SYSTEMD
-	int r;
-	sd_bus_message *msg = NULL;
-	sd_bus_error sdb_err = SD_BUS_ERROR_NULL;
-	sd_bus *bus = NULL;
+	int r = 0;
+	const sd_bus_error *sdb_err = NULL;
 	int tmp_ifindex = 0;
 	size_t tmp_length = 0;
 
@@ -132,22 +472,14 @@ int system_dns_resolver_load_server(system_ctx_t *ctx, system_dns_server_element
 
 	system_dns_server_t tmp_server = {0};
 
-	r = sd_bus_open_system(&bus);
-	if (r < 0) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "Failed to open system bus: %s\n", strerror(-r));
-		goto invalid;
+	if (sd_bus_message_is_method_error(msg, NULL)) {
+		sdb_err = sd_bus_message_get_error(msg);
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Getting DNS failed: %s", sdb_err ? sdb_err->message : "unknown error");
+		return -1;
 	}
 
-	r = sd_bus_get_property(
-		bus,
-		"org.freedesktop.resolve1",
-		"/org/freedesktop/resolve1",
-		"org.freedesktop.resolve1.Manager",
-		"DNS",
-		&sdb_err,
-		&msg,
-		"a(iiay)");
-
+	// property value is wrapped in a variant
+	r = sd_bus_message_enter_container(msg, 'v', "a(iiay)");
 	if (r < 0) {
 		goto invalid;
 	}
@@ -219,17 +551,23 @@ int system_dns_resolver_load_server(system_ctx_t *ctx, system_dns_server_element
 		system_dns_server_free(&tmp_server);
 	}
 
+	// leave the array and the variant - the value can be a part of a properties dictionary
+	r = sd_bus_message_exit_container(msg);
+	if (r >= 0) {
+		r = sd_bus_message_exit_container(msg);
+	}
+	if (r < 0) {
+		goto invalid;
+	}
+
 	goto finish;
 
 invalid:
-	SRPLG_LOG_ERR(PLUGIN_NAME, "sd-bus failure (%d): %s", r, sdb_err.message);
+	SRPLG_LOG_ERR(PLUGIN_NAME, "sd-bus failure (%d): %s", r, strerror(-r));
+	system_dns_server_free(&tmp_server);
 	error = -1;
 
 finish:
-	sd_bus_message_unref(msg);
-	sd_bus_flush_close_unref(bus);
-#else
-#endif
-
 	return error;
-}
\ No newline at end of file
+}
+#endif
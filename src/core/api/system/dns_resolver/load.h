@@ -16,7 +16,16 @@
 #include "core/types.h"
 #include "core/context.h"
 
+// resolved does not emit PropertiesChanged for the Manager DNS and Domains properties - changes made by
+// networkd or DHCP are only seen once the cached value expires
+#define SYSTEM_DNS_RESOLVER_CACHE_TTL_MS 5000
+
 int system_dns_resolver_load_search(system_ctx_t *ctx, system_dns_search_element_t **head);
 int system_dns_resolver_load_server(system_ctx_t *ctx, system_dns_server_element_t **head);
 
+// load search domains and servers with both requests in flight at once - either head can be NULL
+int system_dns_resolver_load(system_ctx_t *ctx, system_dns_search_element_t **search_head, system_dns_server_element_t **server_head);
+
+void system_dns_resolver_cache_free(system_dns_resolver_cache_t *cache);
+
 #endif // SYSTEM_PLUGIN_API_DNS_RESOLVER_LOAD_H
\ No newline at end of file
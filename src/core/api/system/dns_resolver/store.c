@@ -12,6 +12,7 @@
  */
 #include "store.h"
 #include "core/common.h"
+#include "core/bus.h"
 
 #ifdef SYSTEMD
 #include <systemd/sd-bus.h>
@@ -21,27 +22,182 @@
 
 #include <utlist.h>
 
+#ifdef SYSTEMD
+static int system_dns_resolver_store_reply(sd_bus_message *m, void *userdata, sd_bus_error *ret_error);
+static int system_dns_resolver_store_check_reply(sd_bus_message *reply, const char *method);
+static int system_dns_resolver_new_search_call(sd_bus *bus, system_dns_search_element_t *head, sd_bus_message **msg);
+static int system_dns_resolver_new_server_call(sd_bus *bus, system_dns_server_element_t *head, sd_bus_message **msg);
+#endif
+
 int system_dns_resolver_store_search(system_ctx_t *ctx, system_dns_search_element_t *head)
+{
+	system_dns_resolver_t resolver = {
+		.search = head,
+		.changed = SYSTEM_DNS_RESOLVER_CHANGE_SEARCH,
+	};
+
+	return system_dns_resolver_store(ctx, &resolver);
+}
+
+int system_dns_resolver_store_server(system_ctx_t *ctx, system_dns_server_element_t *head)
+{
+	system_dns_resolver_t resolver = {
+		.servers = head,
+		.changed = SYSTEM_DNS_RESOLVER_CHANGE_SERVER,
+	};
+
+	return system_dns_resolver_store(ctx, &resolver);
+}
+
+int system_dns_resolver_store(system_ctx_t *ctx, const system_dns_resolver_t *resolver)
 {
 	int error = 0;
-	system_dns_search_element_t *search_iter_el = NULL;
 
 #ifdef SYSTEMD
-	int r;
-	sd_bus_error sdb_err = SD_BUS_ERROR_NULL;
-	sd_bus_message *msg = NULL;
-	sd_bus_message *reply = NULL;
+	int r = 0;
 	sd_bus *bus = NULL;
+	bool bus_acquired = false;
+	bool search = (resolver->changed & SYSTEM_DNS_RESOLVER_CHANGE_SEARCH) != 0;
+	bool server = (resolver->changed & SYSTEM_DNS_RESOLVER_CHANGE_SERVER) != 0;
+	sd_bus_message *search_msg = NULL;
+	sd_bus_message *server_msg = NULL;
+	sd_bus_slot *search_slot = NULL;
+	sd_bus_slot *server_slot = NULL;
+	sd_bus_message *search_reply = NULL;
+	sd_bus_message *server_reply = NULL;
+
+	if (!search && !server) {
+		goto out;
+	}
 
-	r = sd_bus_open_system(&bus);
-	if (r < 0) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "Failed to open system bus: %s\n", strerror(-r));
-		goto invalid;
+	error = system_bus_acquire(&ctx->bus, &bus);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_bus_acquire() error (%d)", error);
+		goto error_out;
+	}
+
+	bus_acquired = true;
+
+	// send both method calls before waiting - resolved is updated in one round-trip
+	if (search) {
+		r = system_dns_resolver_new_search_call(bus, resolver->search, &search_msg);
+		if (r < 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_resolver_new_search_call() error: %s", strerror(-r));
+			goto error_out;
+		}
+
+		r = sd_bus_call_async(bus, &search_slot, search_msg, system_dns_resolver_store_reply, &search_reply, 0);
+		if (r < 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "sd_bus_call_async() error for SetLinkDomains: %s", strerror(-r));
+			goto error_out;
+		}
+	}
+
+	if (server) {
+		r = system_dns_resolver_new_server_call(bus, resolver->servers, &server_msg);
+		if (r < 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_resolver_new_server_call() error: %s", strerror(-r));
+			goto error_out;
+		}
+
+		r = sd_bus_call_async(bus, &server_slot, server_msg, system_dns_resolver_store_reply, &server_reply, 0);
+		if (r < 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "sd_bus_call_async() error for SetLinkDNS: %s", strerror(-r));
+			goto error_out;
+		}
+	}
+
+	// replies are stored by the reply callback
+	while ((search && !search_reply) || (server && !server_reply)) {
+		r = sd_bus_process(bus, NULL);
+		if (r < 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "sd_bus_process() error: %s", strerror(-r));
+			goto error_out;
+		}
+
+		if (r > 0) {
+			continue;
+		}
+
+		r = sd_bus_wait(bus, (uint64_t) -1);
+		if (r < 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "sd_bus_wait() error: %s", strerror(-r));
+			goto error_out;
+		}
+	}
+
+	// check both replies - a failed search update does not hide a failed server update
+	if (search_reply && system_dns_resolver_store_check_reply(search_reply, "SetLinkDomains")) {
+		error = -1;
 	}
 
+	if (server_reply && system_dns_resolver_store_check_reply(server_reply, "SetLinkDNS")) {
+		error = -1;
+	}
+
+	if (error) {
+		goto error_out;
+	}
+
+	SRPLG_LOG_INF(PLUGIN_NAME, "Set DNS resolver configuration successfully.");
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	// unref'ing a slot cancels a call still in flight
+	sd_bus_slot_unref(search_slot);
+	sd_bus_slot_unref(server_slot);
+	sd_bus_message_unref(search_reply);
+	sd_bus_message_unref(server_reply);
+	sd_bus_message_unref(search_msg);
+	sd_bus_message_unref(server_msg);
+
+	if (bus_acquired) {
+		// resolved reports the new state by a signal - until then the written parts are queried directly
+		ctx->dns_resolver_cache.valid &= ~resolver->changed;
+
+		system_bus_release(&ctx->bus, r);
+	}
+#else
+#endif
+
+	return error;
+}
+
+#ifdef SYSTEMD
+static int system_dns_resolver_store_reply(sd_bus_message *m, void *userdata, sd_bus_error *ret_error)
+{
+	sd_bus_message **reply = (sd_bus_message **) userdata;
+
+	*reply = sd_bus_message_ref(m);
+
+	return 0;
+}
+
+static int system_dns_resolver_store_check_reply(sd_bus_message *reply, const char *method)
+{
+	const sd_bus_error *sdb_err = NULL;
+
+	if (sd_bus_message_is_method_error(reply, NULL)) {
+		sdb_err = sd_bus_message_get_error(reply);
+		SRPLG_LOG_ERR(PLUGIN_NAME, "%s failed: %s", method, sdb_err ? sdb_err->message : "unknown error");
+		return -1;
+	}
+
+	return 0;
+}
+
+static int system_dns_resolver_new_search_call(sd_bus *bus, system_dns_search_element_t *head, sd_bus_message **msg)
+{
+	int r = 0;
+	system_dns_search_element_t *search_iter_el = NULL;
+
 	r = sd_bus_message_new_method_call(
 		bus,
-		&msg,
+		msg,
 		"org.freedesktop.resolve1",
 		"/org/freedesktop/resolve1",
 		"org.freedesktop.resolve1.Manager",
@@ -51,13 +207,13 @@ int system_dns_resolver_store_search(system_ctx_t *ctx, system_dns_search_elemen
 	}
 
 	// set ifindex to the first value in the list
-	r = sd_bus_message_append(msg, "i", SYSTEMD_IFINDEX);
+	r = sd_bus_message_append(*msg, "i", SYSTEMD_IFINDEX);
 	if (r < 0) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "sd_bus_message_append() error");
 		goto invalid;
 	}
 
-	r = sd_bus_message_open_container(msg, 'a', "(sb)");
+	r = sd_bus_message_open_container(*msg, 'a', "(sb)");
 	if (r < 0) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "sd_bus_message_open_container() error");
 		goto invalid;
@@ -65,62 +221,31 @@ int system_dns_resolver_store_search(system_ctx_t *ctx, system_dns_search_elemen
 
 	LL_FOREACH(head, search_iter_el)
 	{
-		r = sd_bus_message_append(msg, "(sb)", search_iter_el->search.domain, search_iter_el->search.search);
+		r = sd_bus_message_append(*msg, "(sb)", search_iter_el->search.domain, search_iter_el->search.search);
 		if (r < 0) {
 			SRPLG_LOG_ERR(PLUGIN_NAME, "sd_bus_message_append() error");
 			goto invalid;
 		}
 	}
 
-	r = sd_bus_message_close_container(msg);
+	r = sd_bus_message_close_container(*msg);
 	if (r < 0) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "sd_bus_message_close_container() error");
 		goto invalid;
 	}
 
-	r = sd_bus_call(bus, msg, 0, &sdb_err, &reply);
-	if (r < 0) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "sd_bus_call() error");
-		goto invalid;
-	}
-
-	// SRP_LOG_INF("Set domains successfully!");
-	goto finish;
-
 invalid:
-	SRPLG_LOG_ERR(PLUGIN_NAME, "sd-bus failure (%d): %s", r, sdb_err.message);
-	error = -1;
-
-finish:
-	sd_bus_message_unref(msg);
-	sd_bus_flush_close_unref(bus);
-#else
-#endif
-
-	return error;
+	return r;
 }
 
-int system_dns_resolver_store_server(system_ctx_t *ctx, system_dns_server_element_t *head)
+static int system_dns_resolver_new_server_call(sd_bus *bus, system_dns_server_element_t *head, sd_bus_message **msg)
 {
-	int error = 0;
+	int r = 0;
 	system_dns_server_element_t *server_iter_el = NULL;
 
-#ifdef SYSTEMD
-	int r;
-	sd_bus_error sdb_err = SD_BUS_ERROR_NULL;
-	sd_bus_message *msg = NULL;
-	sd_bus_message *reply = NULL;
-	sd_bus *bus = NULL;
-
-	r = sd_bus_open_system(&bus);
-	if (r < 0) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "Failed to open system bus: %s\n", strerror(-r));
-		goto invalid;
-	}
-
 	r = sd_bus_message_new_method_call(
 		bus,
-		&msg,
+		msg,
 		"org.freedesktop.resolve1",
 		"/org/freedesktop/resolve1",
 		"org.freedesktop.resolve1.Manager",
@@ -129,13 +254,13 @@ int system_dns_resolver_store_server(system_ctx_t *ctx, system_dns_server_elemen
 		goto invalid;
 	}
 
-	r = sd_bus_message_append(msg, "i", SYSTEMD_IFINDEX);
+	r = sd_bus_message_append(*msg, "i", SYSTEMD_IFINDEX);
 	if (r < 0) {
 		goto invalid;
 	}
 
 	// enter array of structs
-	r = sd_bus_message_open_container(msg, 'a', "(iay)");
+	r = sd_bus_message_open_container(*msg, 'a', "(iay)");
 	if (r < 0) {
 		goto invalid;
 	}
@@ -145,83 +270,47 @@ int system_dns_resolver_store_server(system_ctx_t *ctx, system_dns_server_elemen
 		system_dns_server_t *server = &server_iter_el->server;
 
 		// enter a struct first
-		r = sd_bus_message_open_container(msg, 'r', "iay");
+		r = sd_bus_message_open_container(*msg, 'r', "iay");
 		if (r < 0) {
 			goto invalid;
 		}
 
 		// set address family
-		r = sd_bus_message_append(msg, "i", server->address.family);
-		if (r < 0) {
-			goto invalid;
-		}
-
-		// enter array of bytes for an address
-		r = sd_bus_message_open_container(msg, 'a', "y");
+		r = sd_bus_message_append(*msg, "i", server->address.family);
 		if (r < 0) {
 			goto invalid;
 		}
 
-		// append address bytes accordingly with address family
+		// append address bytes accordingly with address family - whole array at once
 		switch (server->address.family) {
 			case AF_INET:
-				for (unsigned char j = 0; j < ARRAY_SIZE(server->address.value.v4); j++) {
-					r = sd_bus_message_append(msg, "y", server->address.value.v4[j]);
-					if (r < 0) {
-						goto invalid;
-					}
-				}
+				r = sd_bus_message_append_array(*msg, 'y', server->address.value.v4, sizeof(server->address.value.v4));
 				break;
 			case AF_INET6:
-				for (unsigned char j = 0; j < ARRAY_SIZE(server->address.value.v6); j++) {
-					r = sd_bus_message_append(msg, "y", server->address.value.v6[j]);
-					if (r < 0) {
-						goto invalid;
-					}
-				}
+				r = sd_bus_message_append_array(*msg, 'y', server->address.value.v6, sizeof(server->address.value.v6));
 				break;
 			default:
+				r = sd_bus_message_append_array(*msg, 'y', NULL, 0);
 				break;
 		}
-
-		// exit array
-		r = sd_bus_message_close_container(msg);
 		if (r < 0) {
 			goto invalid;
 		}
 
 		// exit struct
-		r = sd_bus_message_close_container(msg);
+		r = sd_bus_message_close_container(*msg);
 		if (r < 0) {
 			goto invalid;
 		}
 	}
 
 	// exit array of structs
-	r = sd_bus_message_close_container(msg);
+	r = sd_bus_message_close_container(*msg);
 	if (r < 0) {
 		goto invalid;
 	}
 
-	// finally call created method
-	r = sd_bus_call(bus, msg, 0, &sdb_err, &reply);
-	if (r < 0) {
-		goto invalid;
-	}
-
-	SRPLG_LOG_INF(PLUGIN_NAME, "Set DNS servers successfully.");
-	goto finish;
-
 invalid:
-	SRPLG_LOG_ERR(PLUGIN_NAME, "sd-bus failure (%d): %s", r, sdb_err.message);
-	error = -1;
-
-finish:
-	sd_bus_message_unref(msg);
-	sd_bus_message_unref(reply);
-	sd_bus_flush_close_unref(bus);
-#else
-#endif
-
-	return error;
+	return r;
 }
+#endif
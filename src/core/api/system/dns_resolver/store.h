@@ -19,4 +19,7 @@
 int system_dns_resolver_store_search(system_ctx_t *ctx, system_dns_search_element_t *head);
 int system_dns_resolver_store_server(system_ctx_t *ctx, system_dns_server_element_t *head);
 
+// store the changed parts of the resolver configuration with all calls in flight at once
+int system_dns_resolver_store(system_ctx_t *ctx, const system_dns_resolver_t *resolver);
+
 #endif // SYSTEM_PLUGIN_API_DNS_RESOLVER_STORE_H
\ No newline at end of file
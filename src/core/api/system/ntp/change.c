@@ -20,13 +20,24 @@
 #include "core/data/system/ntp/server/list.h"
 
 #include <assert.h>
+#include <stdlib.h>
+#include <linux/limits.h>
 #include <sysrepo.h>
 
-static int system_ntp_load_server_node_address(sr_session_ctx_t *session, const struct lyd_node *node, char *address_buffer, size_t buffer_size);
+#include <utlist.h>
+#include <uthash.h>
+
+static int system_ntp_change_server_get_record(system_ctx_t *ctx, const struct lyd_node *node, system_ntp_server_change_t **record);
+static int system_ntp_change_server_set_field(system_ctx_t *ctx, const srpc_change_ctx_t *change_ctx, uint32_t field, const char *deleted_value);
+static int system_ntp_change_server_load_address(sr_session_ctx_t *session, system_ntp_server_change_t *record);
+static int system_ntp_change_server_apply_record(system_ntp_server_t *server, const system_ntp_server_change_t *record);
+static int system_ntp_change_enabled_start(void *priv, void *data);
+static int system_ntp_change_enabled_stop(void *priv, void *data);
 
 int system_ntp_change_enabled(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
 {
 	int error = 0;
+	system_ctx_t *ctx = (system_ctx_t *) priv;
 	const char *node_name = LYD_NAME(change_ctx->node);
 	const char *node_value = lyd_get_value(change_ctx->node);
 	bool enabled = strcmp(node_value, "true") == 0 ? true : false;
@@ -38,18 +49,19 @@ int system_ntp_change_enabled(void *priv, sr_session_ctx_t *session, const srpc_
 	switch (change_ctx->operation) {
 		case SR_OP_CREATED:
 		case SR_OP_MODIFIED:
-			if (enabled) {
-				SRPC_SAFE_CALL_ERR(error, system("systemctl start ntp"), error_out);
-				SRPC_SAFE_CALL_ERR(error, system("systemctl enable ntp"), error_out);
-			} else {
-				SRPC_SAFE_CALL_ERR(error, system("systemctl stop ntp"), error_out);
-				SRPC_SAFE_CALL_ERR(error, system("systemctl disable ntp"), error_out);
+			error = system_change_apply_plan_state(&ctx->change_apply, "NTP service", enabled ? system_ntp_change_enabled_start : system_ntp_change_enabled_stop, NULL, NULL, NULL);
+			if (error) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "system_change_apply_plan_state() error (%d)", error);
+				goto error_out;
 			}
 			break;
 		case SR_OP_DELETED:
 			// set default value = true
-			SRPC_SAFE_CALL_ERR(error, system("systemctl start ntp"), error_out);
-			SRPC_SAFE_CALL_ERR(error, system("systemctl enable ntp"), error_out);
+			error = system_change_apply_plan_state(&ctx->change_apply, "NTP service", system_ntp_change_enabled_start, NULL, NULL, NULL);
+			if (error) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "system_change_apply_plan_state() error (%d)", error);
+				goto error_out;
+			}
 			break;
 		case SR_OP_MOVED:
 			break;
@@ -67,24 +79,38 @@ out:
 int system_ntp_change_server_name(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
 {
 	int error = 0;
+	system_ctx_t *ctx = priv;
 	const char *node_name = LYD_NAME(change_ctx->node);
 	const char *node_value = lyd_get_value(change_ctx->node);
+	system_ntp_server_change_t *record = NULL;
 
 	assert(strcmp(node_name, "name") == 0);
 
 	SRPLG_LOG_DBG(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
+	error = system_ntp_change_server_get_record(ctx, change_ctx->node, &record);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_change_server_get_record() error (%d)", error);
+		goto error_out;
+	}
+
+	// the list key decides what happens with the whole server
 	switch (change_ctx->operation) {
 		case SR_OP_CREATED:
-			break;
-		case SR_OP_MODIFIED:
-			break;
 		case SR_OP_DELETED:
+			record->operation = change_ctx->operation;
 			break;
+		case SR_OP_MODIFIED:
 		case SR_OP_MOVED:
 			break;
 	}
 
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
 	return error;
 }
 
@@ -94,67 +120,40 @@ int system_ntp_change_server_address(void *priv, sr_session_ctx_t *session, cons
 	system_ctx_t *ctx = priv;
 	const char *node_name = LYD_NAME(change_ctx->node);
 	const char *node_value = lyd_get_value(change_ctx->node);
-	system_ntp_server_t temp_server = {0};
-	system_ntp_server_element_t *found_server_el = NULL;
+	system_ntp_server_change_t *record = NULL;
 
 	assert(strcmp(node_name, "address") == 0);
 
 	SRPLG_LOG_DBG(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
-	system_ntp_server_init(&temp_server);
+	error = system_ntp_change_server_set_field(ctx, change_ctx, SYSTEM_NTP_SERVER_CHANGE_ADDRESS, NULL);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_change_server_set_field() error (%d)", error);
+		goto error_out;
+	}
 
-	switch (change_ctx->operation) {
-		case SR_OP_CREATED:
-			// set name and address to the same value - real datastore name is not used on the system
-			error = system_ntp_server_set_name(&temp_server, node_value);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_set_name() error (%d)", error);
-				goto error_out;
-			}
-			error = system_ntp_server_set_address(&temp_server, node_value);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_set_address() error (%d)", error);
-				goto error_out;
-			}
+	// record is already created by setting the field
+	error = system_ntp_change_server_get_record(ctx, change_ctx->node, &record);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_change_server_get_record() error (%d)", error);
+		goto error_out;
+	}
 
-			// add the new server to the list
-			error = system_ntp_server_list_add(&ctx->temp_ntp_servers, temp_server);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_list_add() error (%d)", error);
-				goto error_out;
-			}
-			break;
+	// remember the old address - servers are found on the system by their address
+	switch (change_ctx->operation) {
 		case SR_OP_MODIFIED:
-			// get existing server and change address
-			found_server_el = system_ntp_server_list_find(ctx->temp_ntp_servers, node_value);
-			if (!found_server_el) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_list_find() error");
-				goto error_out;
-			}
-
-			// name
-			error = system_ntp_server_set_name(&found_server_el->server, node_value);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_set_name() error (%d)", error);
-				goto error_out;
-			}
-
-			// address
-			error = system_ntp_server_set_address(&found_server_el->server, node_value);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_set_address() error (%d)", error);
+			record->previous_address = strdup(change_ctx->previous_value);
+			if (!record->previous_address) {
 				goto error_out;
 			}
-
 			break;
 		case SR_OP_DELETED:
-			// remove data from list
-			error = system_ntp_server_list_remove(&ctx->temp_ntp_servers, node_value);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_server_list_remove() error (%d)", error);
+			record->previous_address = strdup(node_value);
+			if (!record->previous_address) {
 				goto error_out;
 			}
 			break;
+		case SR_OP_CREATED:
 		case SR_OP_MOVED:
 			break;
 	}
@@ -173,31 +172,18 @@ int system_ntp_change_server_port(void *priv, sr_session_ctx_t *session, const s
 	int error = 0;
 	const char *node_name = LYD_NAME(change_ctx->node);
 	const char *node_value = lyd_get_value(change_ctx->node);
-	char address_buffer[100] = {0};
 
 	assert(strcmp(node_name, "port") == 0);
 
 	SRPLG_LOG_DBG(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
-	error = system_ntp_load_server_node_address(session, change_ctx->node, address_buffer, sizeof(address_buffer));
+	// deleted port - use the default one
+	error = system_ntp_change_server_set_field(priv, change_ctx, SYSTEM_NTP_SERVER_CHANGE_PORT, NULL);
 	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_load_server_node_address() error (%d)", error);
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_change_server_set_field() error (%d)", error);
 		goto error_out;
 	}
 
-	SRPLG_LOG_DBG(PLUGIN_NAME, "ADDRESS = %s, PORT=100", address_buffer);
-
-	switch (change_ctx->operation) {
-		case SR_OP_CREATED:
-			break;
-		case SR_OP_MODIFIED:
-			break;
-		case SR_OP_DELETED:
-			break;
-		case SR_OP_MOVED:
-			break;
-	}
-
 	goto out;
 
 error_out:
@@ -210,48 +196,19 @@ out:
 int system_ntp_change_server_association_type(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
 {
 	int error = 0;
-	system_ctx_t *ctx = priv;
 	const char *node_name = LYD_NAME(change_ctx->node);
 	const char *node_value = lyd_get_value(change_ctx->node);
-	char address_buffer[100] = {0};
-	system_ntp_server_element_t *found_server_el = NULL;
 
 	assert(strcmp(node_name, "association-type") == 0);
 
 	SRPLG_LOG_DBG(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
-	error = system_ntp_load_server_node_address(session, change_ctx->node, address_buffer, sizeof(address_buffer));
+	error = system_ntp_change_server_set_field(priv, change_ctx, SYSTEM_NTP_SERVER_CHANGE_ASSOCIATION_TYPE, "server");
 	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_load_server_node_address() error (%d)", error);
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_change_server_set_field() error (%d)", error);
 		goto error_out;
 	}
 
-	SRPLG_LOG_DBG(PLUGIN_NAME, "Changing association-type for server %s", address_buffer);
-
-	switch (change_ctx->operation) {
-		case SR_OP_CREATED:
-		case SR_OP_MODIFIED:
-			// find server
-			found_server_el = system_ntp_server_list_find(ctx->temp_ntp_servers, address_buffer);
-			if (!found_server_el) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_list_find() failed");
-				goto error_out;
-			}
-
-			// change value
-			error = system_ntp_server_set_association_type(&found_server_el->server, node_value);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_set_association_type() error (%d)", error);
-				goto error_out;
-			}
-			break;
-		case SR_OP_DELETED:
-			// nothing to do, only remove at address
-			break;
-		case SR_OP_MOVED:
-			break;
-	}
-
 	goto out;
 
 error_out:
@@ -264,48 +221,19 @@ out:
 int system_ntp_change_server_iburst(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
 {
 	int error = 0;
-	system_ctx_t *ctx = priv;
 	const char *node_name = LYD_NAME(change_ctx->node);
 	const char *node_value = lyd_get_value(change_ctx->node);
-	char address_buffer[100] = {0};
-	system_ntp_server_element_t *found_server_el = NULL;
 
 	assert(strcmp(node_name, "iburst") == 0);
 
 	SRPLG_LOG_DBG(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
-	error = system_ntp_load_server_node_address(session, change_ctx->node, address_buffer, sizeof(address_buffer));
+	error = system_ntp_change_server_set_field(priv, change_ctx, SYSTEM_NTP_SERVER_CHANGE_IBURST, "false");
 	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_load_server_node_address() error (%d)", error);
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_change_server_set_field() error (%d)", error);
 		goto error_out;
 	}
 
-	SRPLG_LOG_DBG(PLUGIN_NAME, "Changing iburst for server %s", address_buffer);
-
-	switch (change_ctx->operation) {
-		case SR_OP_CREATED:
-		case SR_OP_MODIFIED:
-			// find server
-			found_server_el = system_ntp_server_list_find(ctx->temp_ntp_servers, address_buffer);
-			if (!found_server_el) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_list_find() failed");
-				goto error_out;
-			}
-
-			// change value
-			error = system_ntp_server_set_iburst(&found_server_el->server, node_value);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_set_iburst() error (%d)", error);
-				goto error_out;
-			}
-			break;
-		case SR_OP_DELETED:
-			// nothing to do, only remove at address
-			break;
-		case SR_OP_MOVED:
-			break;
-	}
-
 	goto out;
 
 error_out:
@@ -318,46 +246,115 @@ out:
 int system_ntp_change_server_prefer(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
 {
 	int error = 0;
-	system_ctx_t *ctx = priv;
 	const char *node_name = LYD_NAME(change_ctx->node);
 	const char *node_value = lyd_get_value(change_ctx->node);
-	char address_buffer[100] = {0};
-	system_ntp_server_element_t *found_server_el = NULL;
 
 	assert(strcmp(node_name, "prefer") == 0);
 
 	SRPLG_LOG_DBG(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
-	error = system_ntp_load_server_node_address(session, change_ctx->node, address_buffer, sizeof(address_buffer));
+	error = system_ntp_change_server_set_field(priv, change_ctx, SYSTEM_NTP_SERVER_CHANGE_PREFER, "false");
 	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_load_server_node_address() error (%d)", error);
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_change_server_set_field() error (%d)", error);
 		goto error_out;
 	}
 
-	SRPLG_LOG_DBG(PLUGIN_NAME, "Changing prefer for server %s", address_buffer);
+	goto out;
 
-	switch (change_ctx->operation) {
-		case SR_OP_CREATED:
-		case SR_OP_MODIFIED:
-			// find server
-			found_server_el = system_ntp_server_list_find(ctx->temp_ntp_servers, address_buffer);
-			if (!found_server_el) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_list_find() failed");
-				goto error_out;
-			}
+error_out:
+	error = -1;
+
+out:
+	return error;
+}
 
-			// change value
-			error = system_ntp_server_set_prefer(&found_server_el->server, node_value);
+int system_ntp_change_server_apply(system_ctx_t *ctx, sr_session_ctx_t *session)
+{
+	int error = 0;
+	system_ntp_server_change_t *record = NULL, *tmp_record = NULL;
+	system_ntp_server_change_t *address_hash = NULL;
+	system_ntp_server_element_t *iter = NULL, *tmp_iter = NULL;
+	system_ntp_server_t new_server = {0};
+
+	// index deleted and modified servers by their address on the system
+	HASH_ITER(hh, ctx->temp_ntp_server_changes, record, tmp_record)
+	{
+		if (record->operation == SR_OP_CREATED) {
+			continue;
+		}
+
+		if (record->operation == SR_OP_DELETED && !record->previous_address) {
+			SRPLG_LOG_DBG(PLUGIN_NAME, "Deleted server %s has no address - nothing to remove", record->name);
+			continue;
+		}
+
+		// address not changed - one lookup per server instead of one per changed leaf
+		if (!record->previous_address) {
+			error = system_ntp_change_server_load_address(session, record);
 			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_set_prefer() error (%d)", error);
+				SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_change_server_load_address() error (%d) for server %s", error, record->name);
 				goto error_out;
 			}
-			break;
-		case SR_OP_DELETED:
-			// nothing to do, only remove at address
-			break;
-		case SR_OP_MOVED:
-			break;
+		}
+
+		HASH_ADD_KEYPTR(hh_address, address_hash, record->previous_address, strlen(record->previous_address), record);
+	}
+
+	// update the system list in place - the order of untouched servers is kept
+	LL_FOREACH_SAFE(ctx->temp_ntp_servers, iter, tmp_iter)
+	{
+		record = NULL;
+		if (iter->server.address) {
+			HASH_FIND(hh_address, address_hash, iter->server.address, strlen(iter->server.address), record);
+		}
+
+		if (!record) {
+			continue;
+		}
+
+		if (record->operation == SR_OP_DELETED) {
+			system_ntp_server_list_delete(&ctx->temp_ntp_servers, iter);
+			continue;
+		}
+
+		error = system_ntp_change_server_apply_record(&iter->server, record);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_change_server_apply_record() error (%d) for server %s", error, record->name);
+			goto error_out;
+		}
+
+		system_ntp_server_list_rehash(&ctx->temp_ntp_servers, iter);
+	}
+
+	// append created servers
+	HASH_ITER(hh, ctx->temp_ntp_server_changes, record, tmp_record)
+	{
+		if (record->operation != SR_OP_CREATED) {
+			continue;
+		}
+
+		system_ntp_server_init(&new_server);
+
+		// default association type if not present in the changes
+		error = system_ntp_server_set_association_type(&new_server, "server");
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_set_association_type() error (%d)", error);
+			goto error_out;
+		}
+
+		error = system_ntp_change_server_apply_record(&new_server, record);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_change_server_apply_record() error (%d) for server %s", error, record->name);
+			goto error_out;
+		}
+
+		error = system_ntp_server_list_add(&ctx->temp_ntp_servers, new_server);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_list_add() error (%d)", error);
+			goto error_out;
+		}
+
+		system_ntp_server_free(&new_server);
 	}
 
 	goto out;
@@ -366,45 +363,158 @@ error_out:
 	error = -1;
 
 out:
+	system_ntp_server_free(&new_server);
+	HASH_CLEAR(hh_address, address_hash);
+
 	return error;
 }
 
-static int system_ntp_load_server_node_address(sr_session_ctx_t *session, const struct lyd_node *node, char *address_buffer, size_t buffer_size)
+void system_ntp_change_server_free(system_ctx_t *ctx)
 {
-	int error = 0;
-	char path_buffer[PATH_MAX] = {0};
-	char address_path_buffer[PATH_MAX] = {0};
+	system_ntp_server_change_t *record = NULL, *tmp_record = NULL;
+
+	HASH_ITER(hh, ctx->temp_ntp_server_changes, record, tmp_record)
+	{
+		HASH_DEL(ctx->temp_ntp_server_changes, record);
+
+		free(record->name);
+		if (record->previous_address) {
+			free(record->previous_address);
+		}
+		system_ntp_server_free(&record->server);
+		free(record);
+	}
 
-	// sysrepo data
-	sr_val_t *address_value = NULL;
-	sr_xpath_ctx_t xpath_ctx = {0};
+	ctx->temp_ntp_server_changes = NULL;
+}
+
+static int system_ntp_change_server_get_record(system_ctx_t *ctx, const struct lyd_node *node, system_ntp_server_change_t **record)
+{
+	int error = 0;
+	const struct lyd_node *server_node = node;
 	const char *server_name = NULL;
+	system_ntp_server_change_t *found = NULL;
+
+	// leafs are children of the server list instance or of its udp container
+	while (server_node && server_node->schema->nodetype != LYS_LIST) {
+		server_node = lyd_parent(server_node);
+	}
+
+	if (!server_node) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to find server list instance for node %s", LYD_NAME(node));
+		goto error_out;
+	}
+
+	// list keys are always the first children of the instance
+	server_name = lyd_get_value(lyd_child(server_node));
+
+	HASH_FIND_STR(ctx->temp_ntp_server_changes, server_name, found);
+	if (!found) {
+		found = (system_ntp_server_change_t *) calloc(1, sizeof(system_ntp_server_change_t));
+		if (!found) {
+			goto error_out;
+		}
+
+		found->name = strdup(server_name);
+		if (!found->name) {
+			free(found);
+			goto error_out;
+		}
+
+		found->operation = SR_OP_MODIFIED;
+		system_ntp_server_init(&found->server);
 
-	// get node full path
-	error = (lyd_path(node, LYD_PATH_STD, path_buffer, sizeof(path_buffer)) == NULL);
+		HASH_ADD_KEYPTR(hh, ctx->temp_ntp_server_changes, found->name, strlen(found->name), found);
+	}
+
+	*record = found;
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	return error;
+}
+
+static int system_ntp_change_server_set_field(system_ctx_t *ctx, const srpc_change_ctx_t *change_ctx, uint32_t field, const char *deleted_value)
+{
+	int error = 0;
+	system_ntp_server_change_t *record = NULL;
+	const char *value = NULL;
+
+	error = system_ntp_change_server_get_record(ctx, change_ctx->node, &record);
 	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_path() failed");
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_change_server_get_record() error (%d)", error);
 		goto error_out;
 	}
 
-	// extract key
-	server_name = sr_xpath_key_value(path_buffer, "server", "name", &xpath_ctx);
-	if (!server_name) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_xpath_key_value() failed");
+	switch (change_ctx->operation) {
+		case SR_OP_CREATED:
+		case SR_OP_MODIFIED:
+			value = lyd_get_value(change_ctx->node);
+			break;
+		case SR_OP_DELETED:
+			// leaf removed from an existing server - fall back to the default value
+			value = deleted_value;
+			break;
+		case SR_OP_MOVED:
+			goto out;
+	}
+
+	switch (field) {
+		case SYSTEM_NTP_SERVER_CHANGE_ADDRESS:
+			// address of a deleted server is not needed - only the previous address is used
+			if (change_ctx->operation != SR_OP_DELETED) {
+				error = system_ntp_server_set_address(&record->server, value);
+			}
+			break;
+		case SYSTEM_NTP_SERVER_CHANGE_PORT:
+			error = system_ntp_server_set_port(&record->server, value);
+			break;
+		case SYSTEM_NTP_SERVER_CHANGE_ASSOCIATION_TYPE:
+			error = system_ntp_server_set_association_type(&record->server, value);
+			break;
+		case SYSTEM_NTP_SERVER_CHANGE_IBURST:
+			error = system_ntp_server_set_iburst(&record->server, value);
+			break;
+		case SYSTEM_NTP_SERVER_CHANGE_PREFER:
+			error = system_ntp_server_set_prefer(&record->server, value);
+			break;
+		default:
+			goto error_out;
+	}
+
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to set changed value for server %s (%d)", record->name, error);
 		goto error_out;
 	}
 
-	// fetch address of the current server
+	record->changed |= field;
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	return error;
+}
 
-	// create path
-	error = snprintf(address_path_buffer, sizeof(address_path_buffer), "/ietf-system:system/ntp/server[name=\"%s\"]/udp/address", server_name);
+static int system_ntp_change_server_load_address(sr_session_ctx_t *session, system_ntp_server_change_t *record)
+{
+	int error = 0;
+	char path_buffer[PATH_MAX] = {0};
+	sr_val_t *address_value = NULL;
+
+	error = snprintf(path_buffer, sizeof(path_buffer), SYSTEM_NTP_SERVER_YANG_PATH "[name=\"%s\"]/udp/address", record->name);
 	if (error < 0) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() failed");
 		goto error_out;
 	}
 
-	// fetch value
-	error = sr_get_item(session, address_path_buffer, 0, &address_value);
+	error = sr_get_item(session, path_buffer, 0, &address_value);
 	if (error) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_get_item() error (%d): %s", error, sr_strerror(error));
 		goto error_out;
@@ -413,10 +523,8 @@ static int system_ntp_load_server_node_address(sr_session_ctx_t *session, const
 	// assert the address is a string for getting string data
 	assert(address_value->type == SR_STRING_T);
 
-	// store value in the provided buffer
-	error = snprintf(address_buffer, buffer_size, "%s", address_value->data.string_val);
-	if (error < 0) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() failed");
+	record->previous_address = strdup(address_value->data.string_val);
+	if (!record->previous_address) {
 		goto error_out;
 	}
 
@@ -427,8 +535,72 @@ error_out:
 	error = -1;
 
 out:
-	// free gotten value
-	sr_free_val(address_value);
+	if (address_value) {
+		sr_free_val(address_value);
+	}
 
 	return error;
-}
\ No newline at end of file
+}
+
+static int system_ntp_change_server_apply_record(system_ntp_server_t *server, const system_ntp_server_change_t *record)
+{
+	int error = 0;
+
+	if (record->changed & SYSTEM_NTP_SERVER_CHANGE_ADDRESS) {
+		// set name and address to the same value - real datastore name is not used on the system
+		SRPC_SAFE_CALL_ERR(error, system_ntp_server_set_name(server, record->server.address), error_out);
+		SRPC_SAFE_CALL_ERR(error, system_ntp_server_set_address(server, record->server.address), error_out);
+	}
+	if (record->changed & SYSTEM_NTP_SERVER_CHANGE_PORT) {
+		SRPC_SAFE_CALL_ERR(error, system_ntp_server_set_port(server, record->server.port), error_out);
+	}
+	if (record->changed & SYSTEM_NTP_SERVER_CHANGE_ASSOCIATION_TYPE) {
+		SRPC_SAFE_CALL_ERR(error, system_ntp_server_set_association_type(server, record->server.association_type), error_out);
+	}
+	if (record->changed & SYSTEM_NTP_SERVER_CHANGE_IBURST) {
+		SRPC_SAFE_CALL_ERR(error, system_ntp_server_set_iburst(server, record->server.iburst), error_out);
+	}
+	if (record->changed & SYSTEM_NTP_SERVER_CHANGE_PREFER) {
+		SRPC_SAFE_CALL_ERR(error, system_ntp_server_set_prefer(server, record->server.prefer), error_out);
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	return error;
+}
+
+static int system_ntp_change_enabled_start(void *priv, void *data)
+{
+	int error = 0;
+
+	SRPC_SAFE_CALL_ERR(error, system("systemctl start ntp"), error_out);
+	SRPC_SAFE_CALL_ERR(error, system("systemctl enable ntp"), error_out);
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	return error;
+}
+
+static int system_ntp_change_enabled_stop(void *priv, void *data)
+{
+	int error = 0;
+
+	SRPC_SAFE_CALL_ERR(error, system("systemctl stop ntp"), error_out);
+	SRPC_SAFE_CALL_ERR(error, system("systemctl disable ntp"), error_out);
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	return error;
+}
@@ -27,4 +27,8 @@ int system_ntp_change_server_association_type(void *priv, sr_session_ctx_t *sess
 int system_ntp_change_server_iburst(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx);
 int system_ntp_change_server_prefer(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx);
 
+// apply per-server changes gathered in callback functions above on the loaded system servers
+int system_ntp_change_server_apply(system_ctx_t *ctx, sr_session_ctx_t *session);
+void system_ntp_change_server_free(system_ctx_t *ctx);
+
 #endif // SYSTEM_PLUGIN_API_NTP_CHANGE_H
\ No newline at end of file
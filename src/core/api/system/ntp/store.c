@@ -13,165 +13,344 @@
 #include "store.h"
 #include "core/common.h"
 #include "core/context.h"
-#include "libyang/printer_data.h"
 #include "srpc/ly_tree.h"
 #include "core/types.h"
 
 #include <assert.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sysrepo.h>
 #include <srpc.h>
 #include <utlist.h>
 
+#define SYSTEM_NTP_STORE_CONFIG_PATH "/ntp:ntp[config-file='/etc/ntp.conf']"
+
+// server from the desired list matched against the config-entries of /etc/ntp.conf
+typedef struct system_ntp_store_entry_s {
+	const system_ntp_server_t *server; ///< Desired server.
+	char word[100];					   ///< Address with an optional port as written in the config file.
+	bool iburst;					   ///< iburst option wanted.
+	bool prefer;					   ///< prefer option wanted.
+	bool found;						   ///< Server already present in the config file.
+} system_ntp_store_entry_t;
+
+static uint64_t system_ntp_store_get_id(const struct lyd_node *config_entry_node);
+static struct lyd_node *system_ntp_store_get_association(const struct lyd_node *config_entry_node);
+static system_ntp_store_entry_t *system_ntp_store_find_entry(system_ntp_store_entry_t *entries, size_t count, const char *association_type, const char *word);
+static int system_ntp_store_update_options(system_ctx_t *ctx, uint64_t id, const struct lyd_node *association_node, const system_ntp_store_entry_t *entry);
+static int system_ntp_store_set_option(system_ctx_t *ctx, uint64_t id, const char *association_type, uint64_t option_id, const char *option, bool add);
+static int system_ntp_store_create_entry(system_ctx_t *ctx, uint64_t id, const system_ntp_store_entry_t *entry);
+
 int system_ntp_store_server(system_ctx_t *ctx, system_ntp_server_element_t *head)
 {
 	int error = 0;
+	sr_data_t *subtree = NULL;
+	char path_buffer[PATH_MAX] = {0};
 
-	// config nodes
-	const struct ly_ctx *ly_ctx = NULL;
-	struct lyd_node *ntp_list_node = NULL, *config_entry_node = NULL, *server_node = NULL;
-	struct lyd_node *options_entry_node = NULL;
-	sr_conn_ctx_t *conn_ctx = NULL;
-	char id_buffer[100] = {0};
-	char full_address_buffer[100] = {0};
+	// ntp config nodes
+	struct lyd_node *config_entry_node = NULL, *association_node = NULL, *word_node = NULL;
 
-	size_t id, option_id;
+	system_ntp_store_entry_t *entries = NULL, *entry = NULL;
 	system_ntp_server_element_t *iter = NULL;
+	size_t entry_count = 0, i = 0;
+	uint64_t id = 0, last_id = 0;
 
-	conn_ctx = sr_session_get_connection(ctx->startup_session);
-	ly_ctx = sr_acquire_context(conn_ctx);
-	if (ly_ctx == NULL) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to get ly_ctx variable");
-		goto error_out;
-	}
+	LL_COUNT(head, iter, entry_count);
 
-	error = srpc_ly_tree_create_list(ly_ctx, NULL, &ntp_list_node, "/ntp:ntp", "config-file", "/etc/ntp.conf");
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_ly_tree_create_list() error (%d)", error);
+	if (entry_count) {
+		entries = calloc(entry_count, sizeof(*entries));
+		if (!entries) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "calloc() failed");
+			goto error_out;
+		}
 	}
 
-	id = 1;
 	LL_FOREACH(head, iter)
 	{
-		SRPLG_LOG_DBG(PLUGIN_NAME, "Adding NTP server %s", iter->server.name);
+		entry = &entries[i++];
 
-		// 1. create config entry
-		SRPLG_LOG_DBG(PLUGIN_NAME, "Creating new config-entries list node");
-		error = snprintf(id_buffer, sizeof(id_buffer), "%lu", id);
-		if (error < 0) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
-			goto error_out;
-		}
-		error = srpc_ly_tree_create_list(ly_ctx, ntp_list_node, &config_entry_node, "config-entries", "_id", id_buffer);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_ly_tree_create_list() error (%d)", error);
-			goto error_out;
-		}
-
-		// 2. add pool | server | peer node
-		SRPLG_LOG_DBG(PLUGIN_NAME, "Creating new server list node");
 		assert(
 			strcmp(iter->server.association_type, "server") == 0 ||
 			strcmp(iter->server.association_type, "pool") == 0 ||
 			strcmp(iter->server.association_type, "peer") == 0);
-		error = srpc_ly_tree_create_container(ly_ctx, config_entry_node, &server_node, iter->server.association_type);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_ly_tree_create_container() error (%d)", error);
+
+		entry->server = &iter->server;
+		entry->iburst = iter->server.iburst && !strcmp(iter->server.iburst, "true");
+		entry->prefer = iter->server.prefer && !strcmp(iter->server.prefer, "true");
+
+		if (iter->server.port) {
+			error = snprintf(entry->word, sizeof(entry->word), "%s:%s", iter->server.address, iter->server.port);
+		} else {
+			error = snprintf(entry->word, sizeof(entry->word), "%s", iter->server.address);
+		}
+		if (error < 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
 			goto error_out;
 		}
+	}
 
-		// 3. set word (address:port) to the server
-		SRPLG_LOG_DBG(PLUGIN_NAME, "Setting server list address and port");
-		if (iter->server.port) {
-			error = snprintf(full_address_buffer, sizeof(full_address_buffer), "%s:%s", iter->server.address, iter->server.port);
-			if (error < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
-				goto error_out;
+	// current config file entries - only the difference to the desired list is edited so unchanged entries keep their _id
+	error = sr_get_subtree(ctx->startup_session, SYSTEM_NTP_STORE_CONFIG_PATH, 0, &subtree);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_get_subtree() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	if (subtree) {
+		config_entry_node = srpc_ly_tree_get_child_list(subtree->tree, "config-entries");
+		while (config_entry_node) {
+			id = system_ntp_store_get_id(config_entry_node);
+			if (id > last_id) {
+				last_id = id;
 			}
-		} else {
-			error = snprintf(full_address_buffer, sizeof(full_address_buffer), "%s", iter->server.address);
-			if (error < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
-				goto error_out;
+
+			// other entries (driftfile, restrict...) are left untouched
+			association_node = system_ntp_store_get_association(config_entry_node);
+			if (association_node) {
+				word_node = srpc_ly_tree_get_child_leaf(association_node, "word");
+				entry = system_ntp_store_find_entry(entries, entry_count, LYD_NAME(association_node), word_node ? lyd_get_value(word_node) : NULL);
+
+				if (entry) {
+					entry->found = true;
+
+					error = system_ntp_store_update_options(ctx, id, association_node, entry);
+					if (error) {
+						SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_store_update_options() error (%d)", error);
+						goto error_out;
+					}
+				} else {
+					SRPLG_LOG_DBG(PLUGIN_NAME, "Removing NTP config entry %" PRIu64, id);
+
+					error = snprintf(path_buffer, sizeof(path_buffer), SYSTEM_NTP_STORE_CONFIG_PATH "/config-entries[_id='%" PRIu64 "']", id);
+					if (error < 0) {
+						SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
+						goto error_out;
+					}
+
+					error = sr_delete_item(ctx->startup_session, path_buffer, SR_EDIT_DEFAULT);
+					if (error) {
+						SRPLG_LOG_ERR(PLUGIN_NAME, "sr_delete_item() error (%d): %s", error, sr_strerror(error));
+						goto error_out;
+					}
+				}
 			}
+
+			config_entry_node = srpc_ly_tree_get_list_next(config_entry_node);
 		}
+	}
 
-		error = srpc_ly_tree_create_leaf(ly_ctx, server_node, NULL, "word", full_address_buffer);
+	// new servers are appended after the last entry
+	for (i = 0; i < entry_count; i++) {
+		if (entries[i].found) {
+			continue;
+		}
+
+		error = system_ntp_store_create_entry(ctx, ++last_id, &entries[i]);
 		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_ly_tree_create_leaf() error (%d)", error);
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_store_create_entry() error (%d)", error);
 			goto error_out;
 		}
+	}
 
-		// 4. setup properties (iburst and prefer)
-		SRPLG_LOG_DBG(PLUGIN_NAME, "Adding iburst and prefer options");
-		option_id = 1;
+	// edits are only staged - written to the config file with the rest of the transaction by system_store_apply()
+	SRPLG_LOG_INF(PLUGIN_NAME, "Staged /etc/ntp.conf config file changes");
 
-		if (iter->server.iburst) {
-			if (!strcmp(iter->server.iburst, "true")) {
-				SRPLG_LOG_DBG(PLUGIN_NAME, "Adding iburst options for server %s", iter->server.name);
-				error = snprintf(id_buffer, sizeof(id_buffer), "%lu", option_id);
-				if (error < 0) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
-					goto error_out;
-				}
-				error = srpc_ly_tree_create_list(ly_ctx, server_node, &options_entry_node, "config-entries", "_id", id_buffer);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_ly_tree_create_list() error (%d)", error);
-					goto error_out;
-				}
+	goto out;
 
-				error = srpc_ly_tree_create_leaf(ly_ctx, options_entry_node, NULL, "iburst", NULL);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_ly_tree_create_leaf() error (%d)", error);
-					goto error_out;
-				}
+error_out:
+	error = -1;
 
-				++option_id;
-			}
+out:
+	if (subtree) {
+		sr_release_data(subtree);
+	}
+
+	free(entries);
+
+	return error;
+}
+
+static uint64_t system_ntp_store_get_id(const struct lyd_node *config_entry_node)
+{
+	struct lyd_node *id_node = srpc_ly_tree_get_child_leaf(config_entry_node, "_id");
+
+	return id_node ? strtoull(lyd_get_value(id_node), NULL, 10) : 0;
+}
+
+static struct lyd_node *system_ntp_store_get_association(const struct lyd_node *config_entry_node)
+{
+	struct lyd_node *association_node = NULL;
+
+	// entry can be either server, pool or peer
+	association_node = srpc_ly_tree_get_child_container(config_entry_node, "server");
+	if (!association_node) {
+		association_node = srpc_ly_tree_get_child_container(config_entry_node, "pool");
+	}
+	if (!association_node) {
+		association_node = srpc_ly_tree_get_child_container(config_entry_node, "peer");
+	}
+
+	return association_node;
+}
+
+static system_ntp_store_entry_t *system_ntp_store_find_entry(system_ntp_store_entry_t *entries, size_t count, const char *association_type, const char *word)
+{
+	if (!word) {
+		return NULL;
+	}
+
+	// a duplicate line in the config file is matched only once and removed
+	for (size_t i = 0; i < count; i++) {
+		if (!entries[i].found && !strcmp(entries[i].server->association_type, association_type) && !strcmp(entries[i].word, word)) {
+			return &entries[i];
 		}
+	}
 
-		if (iter->server.prefer) {
-			if (!strcmp(iter->server.prefer, "true")) {
-				SRPLG_LOG_DBG(PLUGIN_NAME, "Adding prefer options for server %s", iter->server.name);
-				error = snprintf(id_buffer, sizeof(id_buffer), "%lu", option_id);
-				if (error < 0) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
-					goto error_out;
-				}
-				error = srpc_ly_tree_create_list(ly_ctx, server_node, &options_entry_node, "config-entries", "_id", id_buffer);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_ly_tree_create_list() error (%d)", error);
-					goto error_out;
-				}
+	return NULL;
+}
 
-				error = srpc_ly_tree_create_leaf(ly_ctx, options_entry_node, NULL, "prefer", NULL);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_ly_tree_create_leaf() error (%d)", error);
-					goto error_out;
-				}
+static int system_ntp_store_update_options(system_ctx_t *ctx, uint64_t id, const struct lyd_node *association_node, const system_ntp_store_entry_t *entry)
+{
+	int error = 0;
+	struct lyd_node *options_entry_node = NULL;
+	const char *association_type = entry->server->association_type;
+	bool iburst = false, prefer = false;
+	uint64_t option_id = 0, last_option_id = 0;
+
+	options_entry_node = srpc_ly_tree_get_child_list(association_node, "config-entries");
+	while (options_entry_node) {
+		option_id = system_ntp_store_get_id(options_entry_node);
+		if (option_id > last_option_id) {
+			last_option_id = option_id;
+		}
+
+		// keep the first wanted option, remove unwanted and repeated ones
+		if (srpc_ly_tree_get_child_leaf(options_entry_node, "iburst")) {
+			if (entry->iburst && !iburst) {
+				iburst = true;
+			} else {
+				error = system_ntp_store_set_option(ctx, id, association_type, option_id, "iburst", false);
 			}
+		} else if (srpc_ly_tree_get_child_leaf(options_entry_node, "prefer")) {
+			if (entry->prefer && !prefer) {
+				prefer = true;
+			} else {
+				error = system_ntp_store_set_option(ctx, id, association_type, option_id, "prefer", false);
+			}
+		}
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_store_set_option() error (%d)", error);
+			goto error_out;
+		}
+
+		options_entry_node = srpc_ly_tree_get_list_next(options_entry_node);
+	}
+
+	if (entry->iburst && !iburst) {
+		error = system_ntp_store_set_option(ctx, id, association_type, ++last_option_id, "iburst", true);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_store_set_option() error (%d)", error);
+			goto error_out;
 		}
+	}
+
+	if (entry->prefer && !prefer) {
+		error = system_ntp_store_set_option(ctx, id, association_type, ++last_option_id, "prefer", true);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_store_set_option() error (%d)", error);
+			goto error_out;
+		}
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	return error;
+}
+
+static int system_ntp_store_set_option(system_ctx_t *ctx, uint64_t id, const char *association_type, uint64_t option_id, const char *option, bool add)
+{
+	int error = 0;
+	char path_buffer[PATH_MAX] = {0};
+
+	SRPLG_LOG_DBG(PLUGIN_NAME, "%s %s option of NTP config entry %" PRIu64, add ? "Adding" : "Removing", option, id);
 
-		++id;
+	if (add) {
+		error = snprintf(path_buffer, sizeof(path_buffer), SYSTEM_NTP_STORE_CONFIG_PATH "/config-entries[_id='%" PRIu64 "']/%s/config-entries[_id='%" PRIu64 "']/%s", id, association_type, option_id, option);
+	} else {
+		error = snprintf(path_buffer, sizeof(path_buffer), SYSTEM_NTP_STORE_CONFIG_PATH "/config-entries[_id='%" PRIu64 "']/%s/config-entries[_id='%" PRIu64 "']", id, association_type, option_id);
+	}
+	if (error < 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
+		goto error_out;
 	}
 
-	// apply changes to the config file
-	SRPLG_LOG_INF(PLUGIN_NAME, "Applying created changes to the /etc/ntp.conf config file");
+	if (add) {
+		error = sr_set_item_str(ctx->startup_session, path_buffer, NULL, NULL, 0);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "sr_set_item_str() error (%d): %s", error, sr_strerror(error));
+			goto error_out;
+		}
+	} else {
+		error = sr_delete_item(ctx->startup_session, path_buffer, SR_EDIT_DEFAULT);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "sr_delete_item() error (%d): %s", error, sr_strerror(error));
+			goto error_out;
+		}
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	return error;
+}
 
-	// lyd_print_file(stdout, ntp_list_node, LYD_XML, 0);
+static int system_ntp_store_create_entry(system_ctx_t *ctx, uint64_t id, const system_ntp_store_entry_t *entry)
+{
+	int error = 0;
+	char path_buffer[PATH_MAX] = {0};
+	uint64_t option_id = 0;
 
-	error = sr_edit_batch(ctx->startup_session, ntp_list_node, "merge");
-	if (error != SR_ERR_OK) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_edit_batch() error (%d): %s", error, sr_strerror(error));
+	SRPLG_LOG_DBG(PLUGIN_NAME, "Adding NTP server %s as config entry %" PRIu64, entry->server->name, id);
+
+	// pool | server | peer node with the word (address:port)
+	error = snprintf(path_buffer, sizeof(path_buffer), SYSTEM_NTP_STORE_CONFIG_PATH "/config-entries[_id='%" PRIu64 "']/%s/word", id, entry->server->association_type);
+	if (error < 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
 		goto error_out;
 	}
 
-	error = sr_apply_changes(ctx->startup_session, 0);
-	if (error != 0) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_apply_changes() error (%d): %s", error, sr_strerror(error));
+	error = sr_set_item_str(ctx->startup_session, path_buffer, entry->word, NULL, 0);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_set_item_str() error (%d): %s", error, sr_strerror(error));
 		goto error_out;
 	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Successfully applied /etc/ntp.conf config file changes");
+	// properties (iburst and prefer)
+	if (entry->iburst) {
+		error = system_ntp_store_set_option(ctx, id, entry->server->association_type, ++option_id, "iburst", true);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_store_set_option() error (%d)", error);
+			goto error_out;
+		}
+	}
+
+	if (entry->prefer) {
+		error = system_ntp_store_set_option(ctx, id, entry->server->association_type, ++option_id, "prefer", true);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_store_set_option() error (%d)", error);
+			goto error_out;
+		}
+	}
 
 	goto out;
 
@@ -179,9 +358,5 @@ error_out:
 	error = -1;
 
 out:
-	if (ntp_list_node) {
-		lyd_free_tree(ntp_list_node);
-	}
-	sr_release_context(conn_ctx);
 	return error;
 }
\ No newline at end of file
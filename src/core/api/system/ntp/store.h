@@ -16,6 +16,7 @@
 #include "core/types.h"
 #include "core/context.h"
 
+// stage the minimal edit of /etc/ntp.conf config entries - committed by system_store_apply()
 int system_ntp_store_server(system_ctx_t *ctx, system_ntp_server_element_t *head);
 
 #endif // SYSTEM_PLUGIN_API_NTP_STORE_H
\ No newline at end of file
@@ -22,10 +22,6 @@ int system_store_hostname(system_ctx_t *ctx, const char *hostname)
 {
 	int error = 0;
 
-#ifdef AUGYANG
-	int augeas = 0;
-#endif
-
 	const size_t len = strlen(hostname);
 
 	error = sethostname(hostname, len);
@@ -35,22 +31,11 @@ int system_store_hostname(system_ctx_t *ctx, const char *hostname)
 	}
 
 #ifdef AUGYANG
+	// only staged - written to /etc/hostname together with other config files by system_store_apply()
 	SRPLG_LOG_INF(PLUGIN_NAME, "Setting /etc/hostname value using augeas datastore plugin");
 	error = sr_set_item_str(ctx->startup_session, "/hostname:hostname[config-file=\'/etc/hostname\']/hostname", hostname, NULL, 0);
 	if (error) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_set_item_str() error (%d): %s", error, sr_strerror(error));
-	} else {
-		SRPLG_LOG_INF(PLUGIN_NAME, "/etc/hostname set");
-		augeas = 1;
-	}
-
-	if (augeas) {
-		SRPLG_LOG_INF(PLUGIN_NAME, "Applying /etc/hostname changes");
-		error = sr_apply_changes(ctx->startup_session, 0);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "sr_apply_changes() error (%d): %s", error, sr_strerror(error));
-			return -1;
-		}
 	}
 #endif
 
@@ -110,4 +95,37 @@ error_out:
 out:
 
 	return error;
+}
+
+int system_store_apply(system_ctx_t *ctx)
+{
+	int error = 0;
+
+	// nothing is written if no edits were staged
+	error = sr_apply_changes(ctx->startup_session, 0);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_apply_changes() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+	// do not leave rejected edits in the session for the next transaction
+	sr_discard_changes(ctx->startup_session);
+
+out:
+	return error;
+}
+
+void system_store_discard(system_ctx_t *ctx)
+{
+	int error = 0;
+
+	error = sr_discard_changes(ctx->startup_session);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_discard_changes() error (%d): %s", error, sr_strerror(error));
+	}
 }
\ No newline at end of file
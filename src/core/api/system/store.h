@@ -20,4 +20,8 @@ int system_store_contact(system_ctx_t *ctx, const char *contact);
 int system_store_location(system_ctx_t *ctx, const char *location);
 int system_store_timezone_name(system_ctx_t *ctx, const char *timezone_name);
 
+// config file edits staged on the startup session by the store functions are written in one transaction
+int system_store_apply(system_ctx_t *ctx);
+void system_store_discard(system_ctx_t *ctx);
+
 #endif // SYSTEM_PLUGIN_API_STORE_H
\ No newline at end of file
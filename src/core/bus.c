@@ -0,0 +1,93 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "bus.h"
+#include "common.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <sysrepo.h>
+
+#ifdef SYSTEMD
+static void system_bus_close(system_bus_t *bus);
+#endif
+
+void system_bus_init(system_bus_t *bus)
+{
+	*bus = (system_bus_t){0};
+
+	pthread_mutex_init(&bus->lock, NULL);
+}
+
+#ifdef SYSTEMD
+int system_bus_acquire(system_bus_t *bus, sd_bus **connection)
+{
+	int error = 0;
+	int r = 0;
+
+	pthread_mutex_lock(&bus->lock);
+
+	// bus daemon restarted or the connection was dropped - reconnect
+	if (bus->bus && sd_bus_is_open(bus->bus) <= 0) {
+		SRPLG_LOG_INF(PLUGIN_NAME, "System bus connection lost - reconnecting");
+		system_bus_close(bus);
+	}
+
+	if (!bus->bus) {
+		r = sd_bus_open_system(&bus->bus);
+		if (r < 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Failed to open system bus: %s", strerror(-r));
+			bus->bus = NULL;
+			goto error_out;
+		}
+
+		bus->generation++;
+	}
+
+	*connection = bus->bus;
+
+	goto out;
+
+error_out:
+	error = -1;
+	pthread_mutex_unlock(&bus->lock);
+
+out:
+	return error;
+}
+
+void system_bus_release(system_bus_t *bus, int r)
+{
+	if (r == -ENOTCONN || r == -ECONNRESET || r == -EPIPE) {
+		system_bus_close(bus);
+	}
+
+	pthread_mutex_unlock(&bus->lock);
+}
+
+static void system_bus_close(system_bus_t *bus)
+{
+	bus->bus = sd_bus_flush_close_unref(bus->bus);
+}
+#endif
+
+void system_bus_free(system_bus_t *bus)
+{
+#ifdef SYSTEMD
+	if (bus->bus) {
+		system_bus_close(bus);
+	}
+#endif
+
+	pthread_mutex_destroy(&bus->lock);
+}
@@ -0,0 +1,46 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_BUS_H
+#define SYSTEM_PLUGIN_BUS_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#ifdef SYSTEMD
+#include <systemd/sd-bus.h>
+#endif
+
+typedef struct system_bus_s system_bus_t;
+
+// system bus connection shared by all D-Bus users of the plugin
+struct system_bus_s {
+#ifdef SYSTEMD
+	sd_bus *bus; ///< Opened on the first use and reopened after a disconnect.
+#endif
+	pthread_mutex_t lock; ///< Bus objects are not thread safe - serializes the subscription and apply threads.
+	uint32_t generation;  ///< Incremented on every (re)connect - matches added on an older connection are gone.
+};
+
+void system_bus_init(system_bus_t *bus);
+
+#ifdef SYSTEMD
+// lock the connection and open it if needed - every successful call is paired with system_bus_release()
+int system_bus_acquire(system_bus_t *bus, sd_bus **connection);
+
+// unlock the connection - r is the last sd-bus result, a lost connection is dropped and reopened on the next acquire
+void system_bus_release(system_bus_t *bus, int r);
+#endif
+
+void system_bus_free(system_bus_t *bus);
+
+#endif // SYSTEM_PLUGIN_BUS_H
@@ -22,6 +22,19 @@ extern const char *const PLUGIN_NAME;
 
 #define SYSTEM_SYSTEM_CONTAINER_YANG_PATH "/" BASE_YANG_MODULE ":system"
 
+// plugin module
+#define SYSTEM_PLUGIN_YANG_MODULE "sysrepo-plugin-system"
+#define SYSTEM_PLUGIN_APPLY_YANG_PATH "/" SYSTEM_PLUGIN_YANG_MODULE ":apply"
+#define SYSTEM_PLUGIN_COALESCING_YANG_PATH "/" SYSTEM_PLUGIN_YANG_MODULE ":coalescing"
+#define SYSTEM_PLUGIN_HOME_REMOVAL_YANG_PATH "/" SYSTEM_PLUGIN_YANG_MODULE ":home-removal"
+#define SYSTEM_PLUGIN_COALESCING_WINDOW_YANG_PATH SYSTEM_PLUGIN_COALESCING_YANG_PATH "/window"
+#define SYSTEM_PLUGIN_PASSWORD_HASHING_YANG_PATH "/" SYSTEM_PLUGIN_YANG_MODULE ":password-hashing"
+#define SYSTEM_PLUGIN_PASSWORD_HASHING_SCHEME_YANG_PATH SYSTEM_PLUGIN_PASSWORD_HASHING_YANG_PATH "/scheme"
+#define SYSTEM_PLUGIN_MANAGED_USERS_YANG_PATH "/" SYSTEM_PLUGIN_YANG_MODULE ":managed-users"
+#define SYSTEM_PLUGIN_USER_IMPORT_YANG_PATH "/" SYSTEM_PLUGIN_YANG_MODULE ":user-import"
+#define SYSTEM_PLUGIN_IMPORT_USERS_RPC_YANG_PATH "/" SYSTEM_PLUGIN_YANG_MODULE ":import-users"
+#define SYSTEM_PLUGIN_EXPORT_USERS_RPC_YANG_PATH "/" SYSTEM_PLUGIN_YANG_MODULE ":export-users"
+
 // rpc
 #define SYSTEM_SET_CURRENT_DATETIME_RPC_YANG_PATH "/" BASE_YANG_MODULE ":set-current-datetime"
 #define SYSTEM_RESTART_RPC_YANG_PATH "/" BASE_YANG_MODULE ":system-restart"
@@ -51,16 +64,29 @@ extern const char *const PLUGIN_NAME;
 // ntp //
 #define SYSTEM_NTP_ENABLED_YANG_PATH SYSTEM_SYSTEM_CONTAINER_YANG_PATH "/ntp/enabled"
 #define SYSTEM_NTP_SERVER_YANG_PATH SYSTEM_SYSTEM_CONTAINER_YANG_PATH "/ntp/server"
+#define SYSTEM_NTP_SERVER_NAME_YANG_PATH SYSTEM_NTP_SERVER_YANG_PATH "/name"
+#define SYSTEM_NTP_SERVER_ADDRESS_YANG_PATH SYSTEM_NTP_SERVER_YANG_PATH "/udp/address"
+#define SYSTEM_NTP_SERVER_PORT_YANG_PATH SYSTEM_NTP_SERVER_YANG_PATH "/udp/port"
+#define SYSTEM_NTP_SERVER_ASSOCIATION_TYPE_YANG_PATH SYSTEM_NTP_SERVER_YANG_PATH "/association-type"
+#define SYSTEM_NTP_SERVER_IBURST_YANG_PATH SYSTEM_NTP_SERVER_YANG_PATH "/iburst"
+#define SYSTEM_NTP_SERVER_PREFER_YANG_PATH SYSTEM_NTP_SERVER_YANG_PATH "/prefer"
 
 // dns-resolver //
 #define SYSTEM_DNS_RESOLVER_SEARCH_YANG_PATH SYSTEM_SYSTEM_CONTAINER_YANG_PATH "/dns-resolver/search"
 #define SYSTEM_DNS_RESOLVER_SERVER_YANG_PATH SYSTEM_SYSTEM_CONTAINER_YANG_PATH "/dns-resolver/server"
+#define SYSTEM_DNS_RESOLVER_SERVER_ADDRESS_YANG_PATH SYSTEM_DNS_RESOLVER_SERVER_YANG_PATH "/udp-and-tcp/address"
 #define SYSTEM_DNS_RESOLVER_TIMEOUT_YANG_PATH SYSTEM_SYSTEM_CONTAINER_YANG_PATH "/dns-resolver/options/timeout"
 #define SYSTEM_DNS_RESOLVER_ATTEMPTS_YANG_PATH SYSTEM_SYSTEM_CONTAINER_YANG_PATH "/dns-resolver/options/attempts"
 
 // authentication //
 #define SYSTEM_AUTHENTICATION_USER_AUTHENTICATION_ORDER_YANG_PATH SYSTEM_SYSTEM_CONTAINER_YANG_PATH "/authentication/user-authentication-order"
 #define SYSTEM_AUTHENTICATION_USER_YANG_PATH SYSTEM_SYSTEM_CONTAINER_YANG_PATH "/authentication/user"
+#define SYSTEM_AUTHENTICATION_USER_NAME_YANG_PATH SYSTEM_AUTHENTICATION_USER_YANG_PATH "/name"
+#define SYSTEM_AUTHENTICATION_USER_PASSWORD_YANG_PATH SYSTEM_AUTHENTICATION_USER_YANG_PATH "/password"
+#define SYSTEM_AUTHENTICATION_USER_AUTHORIZED_KEY_YANG_PATH SYSTEM_AUTHENTICATION_USER_YANG_PATH "/authorized-key"
+#define SYSTEM_AUTHENTICATION_USER_AUTHORIZED_KEY_NAME_YANG_PATH SYSTEM_AUTHENTICATION_USER_AUTHORIZED_KEY_YANG_PATH "/name"
+#define SYSTEM_AUTHENTICATION_USER_AUTHORIZED_KEY_ALGORITHM_YANG_PATH SYSTEM_AUTHENTICATION_USER_AUTHORIZED_KEY_YANG_PATH "/algorithm"
+#define SYSTEM_AUTHENTICATION_USER_AUTHORIZED_KEY_KEY_DATA_YANG_PATH SYSTEM_AUTHENTICATION_USER_AUTHORIZED_KEY_YANG_PATH "/key-data"
 
 #define SYSTEM_DATETIME_BUFFER_SIZE 30
 #define SYSTEM_UTS_LEN 64
@@ -75,8 +101,30 @@ extern const char *const PLUGIN_NAME;
 #define SYSTEM_AUTHENTICATION_DEFAULT_SHELL "/bin/bash"
 #define SYSTEM_AUTHENTICATION_DEFAULT_GECOS "ietf-system user"
 #define SYSTEM_AUTHENTICATION_SKEL_DIRECTORY "/etc/skel"
+#define SYSTEM_AUTHENTICATION_HOME_DIRECTORY "/home"
+
+// deleted home directories are moved here before being removed - relative to the home directory
+#define SYSTEM_AUTHENTICATION_TRASH_DIRECTORY ".sysrepo-plugin-system-trash"
 
 #define SYSTEM_AUTHENTICATION_SHADOW_PATH "/etc/shadow"
+#define SYSTEM_AUTHENTICATION_GROUP_PATH "/etc/group"
+#define SYSTEM_AUTHENTICATION_GSHADOW_PATH "/etc/gshadow"
+
+// UID and GID window of users managed by the plugin - root is managed as well
+#define SYSTEM_AUTHENTICATION_ID_MIN 1000
+#define SYSTEM_AUTHENTICATION_ID_MAX 65533
+
+// limits of the records copied out of passwd and shadow
+#define SYSTEM_AUTHENTICATION_NAME_MAX 256
+#define SYSTEM_AUTHENTICATION_HASH_MAX 1024
+
+// written for users without a password - no password login possible
+#define SYSTEM_AUTHENTICATION_LOCKED_PASSWORD "!"
+
+// shadow password aging of created users
+#define SYSTEM_AUTHENTICATION_DEFAULT_CHANGE_MIN 0
+#define SYSTEM_AUTHENTICATION_DEFAULT_CHANGE_MAX 99999
+#define SYSTEM_AUTHENTICATION_DEFAULT_WARN_DAYS 7
 
 #define ARRAY_SIZE(arr) (sizeof(arr) / sizeof(arr[0]))
 
@@ -14,6 +14,15 @@
 #define SYSTEM_PLUGIN_CONTEXT_H
 
 #include "core/types.h"
+#include "core/features.h"
+#include "core/bus.h"
+#include "core/subscription/change/dispatch.h"
+#include "core/subscription/change/apply.h"
+#include "core/api/system/authentication/trash.h"
+#include "core/api/system/authentication/key_cache.h"
+#include "core/api/system/authentication/password.h"
+#include "core/api/system/authentication/scope.h"
+#include "core/api/system/authentication/bulk.h"
 #include "srpc/types.h"
 #include "umgmt/types.h"
 #include <sysrepo_types.h>
@@ -24,20 +33,21 @@ typedef struct system_ctx_s system_ctx_t;
 
 struct system_ctx_s {
 	sr_session_ctx_t *startup_session;
-	system_dns_search_element_t *temp_dns_search;	  ///< Allocated before changes iteration and free'd after.
-	system_dns_server_element_t *temp_dns_servers;	  ///< Allocated before changes iteration and free'd after.
-	system_ntp_server_element_t *temp_ntp_servers;	  ///< Allocated before changes iteration and free'd after.
-	srpc_feature_status_hash_t *ietf_system_features; ///< IETF System YANG module features.
-	struct {
-		system_local_user_element_t *created;
-		system_local_user_element_t *modified;
-		system_local_user_element_t *deleted;
-		struct {
-			system_local_user_element_t *created;
-			system_local_user_element_t *modified;
-			system_local_user_element_t *deleted;
-		} keys;
-	} temp_users; ///< Users created/modified/deleted during change callbacks. After changes the user modifications are applied on the system values.
+	system_dns_resolver_t temp_dns_resolver;					  ///< Search domains and servers - allocated before changes iteration and free'd after.
+	system_ntp_server_element_t *temp_ntp_servers;				  ///< Allocated before changes iteration and free'd after.
+	system_ntp_server_change_t *temp_ntp_server_changes;		  ///< Per-server changes gathered in one changes iteration.
+	system_bus_t bus;											  ///< System bus connection shared by all sd-bus calls.
+	system_dns_resolver_cache_t dns_resolver_cache;				  ///< Global resolved DNS state - protected by the bus lock.
+	system_features_t features;									  ///< IETF System YANG module features.
+	system_change_dispatcher_t change_dispatcher;				  ///< Routes ietf-system change nodes to their callbacks.
+	system_change_apply_t change_apply;							  ///< Applies planned changes on the system after they are committed.
+	system_local_user_changes_t temp_users;						  ///< Per-user change records gathered during change callbacks - applied on the system after the changes.
+	system_local_user_walk_t temp_user_walk;					  ///< User currently walked - its record and last key are reused for all nodes of the user.
+	system_authentication_trash_t home_trash;					  ///< Removes home directories of deleted users in the background.
+	system_authentication_key_cache_t key_cache;				  ///< Parsed authorized keys of users by file identity.
+	enum system_authentication_password_scheme_e password_scheme; ///< Scheme for hashing cleartext passwords - read and set atomically.
+	system_authentication_scope_t user_scope;					  ///< Local users managed by the plugin.
+	system_authentication_bulk_t user_import;					  ///< Imports users from a file in the background.
 };
 
 #endif // SYSTEM_PLUGIN_CONTEXT_H
\ No newline at end of file
@@ -16,6 +16,10 @@
 #include <string.h>
 #include <stdlib.h>
 #include <utlist.h>
+#include <uthash.h>
+
+static void system_authorized_key_list_index_add(system_authorized_key_element_t *index, system_authorized_key_element_t *el);
+static void system_authorized_key_list_index_remove(system_authorized_key_element_t *el);
 
 void system_authorized_key_list_init(system_authorized_key_element_t **head)
 {
@@ -23,6 +27,11 @@ void system_authorized_key_list_init(system_authorized_key_element_t **head)
 }
 
 int system_authorized_key_list_add(system_authorized_key_element_t **head, system_authorized_key_t key)
+{
+	return system_authorized_key_list_append(head, key, NULL);
+}
+
+int system_authorized_key_list_append(system_authorized_key_element_t **head, system_authorized_key_t key, system_authorized_key_element_t **added_el)
 {
 	system_authorized_key_element_t *new_el = (system_authorized_key_element_t *) malloc(sizeof(system_authorized_key_element_t));
 
@@ -30,14 +39,21 @@ int system_authorized_key_list_add(system_authorized_key_element_t **head, syste
 		return -1;
 	}
 
+	*new_el = (system_authorized_key_element_t){0};
+
 	// copy value
 	system_authorized_key_init(&new_el->key);
 	system_authorized_key_set_name(&new_el->key, key.name);
 	system_authorized_key_set_algorithm(&new_el->key, key.algorithm);
 	system_authorized_key_set_data(&new_el->key, key.data);
 
-	// add to list
-	LL_APPEND(*head, new_el);
+	// add to list and index
+	system_authorized_key_list_index_add(*head, new_el);
+	DL_APPEND(*head, new_el);
+
+	if (added_el) {
+		*added_el = new_el;
+	}
 
 	return 0;
 }
@@ -45,13 +61,8 @@ int system_authorized_key_list_add(system_authorized_key_element_t **head, syste
 system_authorized_key_element_t *system_authorized_key_list_find(system_authorized_key_element_t *head, const char *name)
 {
 	system_authorized_key_element_t *found = NULL;
-	system_authorized_key_element_t el = {
-		.key = {
-			.name = (char *) name,
-		},
-	};
 
-	LL_SEARCH(head, found, &el, system_authorized_key_element_cmp_fn);
+	HASH_FIND_STR(head, name, found);
 
 	return found;
 }
@@ -65,7 +76,8 @@ int system_authorized_key_list_remove(system_authorized_key_element_t **head, co
 	}
 
 	// remove and free found element
-	LL_DELETE(*head, found);
+	system_authorized_key_list_index_remove(found);
+	DL_DELETE(*head, found);
 	system_authorized_key_free(&found->key);
 	free(found);
 
@@ -80,16 +92,52 @@ int system_authorized_key_element_cmp_fn(void *e1, void *e2)
 	return strcmp(s1->key.name, s2->key.name);
 }
 
+void system_authorized_key_list_delete(system_authorized_key_element_t **head, system_authorized_key_element_t *el)
+{
+	system_authorized_key_list_index_remove(el);
+	DL_DELETE(*head, el);
+	system_authorized_key_free(&el->key);
+	free(el);
+}
+
+void system_authorized_key_list_rehash(system_authorized_key_element_t **head, system_authorized_key_element_t *el)
+{
+	// el can be the list head - index it using another element of the same table
+	system_authorized_key_list_index_remove(el);
+	system_authorized_key_list_index_add(el == *head ? el->next : *head, el);
+}
+
 void system_authorized_key_list_free(system_authorized_key_element_t **head)
 {
 	system_authorized_key_element_t *iter_el = NULL, *tmp_el = NULL;
+	system_authorized_key_element_t *index = *head;
+
+	// elements are free'd below - only the index tables are dropped here
+	HASH_CLEAR(hh, index);
 
 	LL_FOREACH_SAFE(*head, iter_el, tmp_el)
 	{
-		LL_DELETE(*head, iter_el);
+		DL_DELETE(*head, iter_el);
 		system_authorized_key_free(&iter_el->key);
 		free(iter_el);
 	}
 
 	system_authorized_key_list_init(head);
 }
+
+// every element of the list is indexed - any element, including the list head, can be used as the table head
+static void system_authorized_key_list_index_add(system_authorized_key_element_t *index, system_authorized_key_element_t *el)
+{
+	const char *name = el->key.name ? el->key.name : "";
+
+	HASH_ADD_KEYPTR(hh, index, name, strlen(name), el);
+}
+
+static void system_authorized_key_list_index_remove(system_authorized_key_element_t *el)
+{
+	// uthash only moves the table head stored in the local pointer - the list is unlinked by the caller
+	system_authorized_key_element_t *index = el;
+
+	HASH_DELETE(hh, index, el);
+	el->hh = (UT_hash_handle){0};
+}
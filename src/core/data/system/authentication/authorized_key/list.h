@@ -17,9 +17,12 @@
 
 void system_authorized_key_list_init(system_authorized_key_element_t **head);
 int system_authorized_key_list_add(system_authorized_key_element_t **head, system_authorized_key_t key);
+int system_authorized_key_list_append(system_authorized_key_element_t **head, system_authorized_key_t key, system_authorized_key_element_t **added_el);
 system_authorized_key_element_t *system_authorized_key_list_find(system_authorized_key_element_t *head, const char *name);
 int system_authorized_key_list_remove(system_authorized_key_element_t **head, const char *name);
 int system_authorized_key_element_cmp_fn(void *e1, void *e2);
+void system_authorized_key_list_delete(system_authorized_key_element_t **head, system_authorized_key_element_t *el);
+void system_authorized_key_list_rehash(system_authorized_key_element_t **head, system_authorized_key_element_t *el);
 void system_authorized_key_list_free(system_authorized_key_element_t **head);
 
 #endif // SYSTEM_PLUGIN_DATA_AUTHENTICATION_AUTHORIZED_KEY_LIST_H
\ No newline at end of file
@@ -16,6 +16,10 @@
 #include <string.h>
 #include <stdlib.h>
 #include <utlist.h>
+#include <uthash.h>
+
+static void system_local_user_list_index_add(system_local_user_element_t *index, system_local_user_element_t *el);
+static void system_local_user_list_index_remove(system_local_user_element_t *el);
 
 void system_local_user_list_init(system_local_user_element_t **head)
 {
@@ -23,6 +27,11 @@ void system_local_user_list_init(system_local_user_element_t **head)
 }
 
 int system_local_user_list_add(system_local_user_element_t **head, system_local_user_t user)
+{
+	return system_local_user_list_append(head, user, NULL);
+}
+
+int system_local_user_list_append(system_local_user_element_t **head, system_local_user_t user, system_local_user_element_t **added_el)
 {
 	system_local_user_element_t *new_el = (system_local_user_element_t *) malloc(sizeof(system_local_user_element_t));
 
@@ -30,13 +39,20 @@ int system_local_user_list_add(system_local_user_element_t **head, system_local_
 		return -1;
 	}
 
+	*new_el = (system_local_user_element_t){0};
+
 	// copy value
 	system_local_user_init(&new_el->user);
 	system_local_user_set_name(&new_el->user, user.name);
 	system_local_user_set_password(&new_el->user, user.password);
 
-	// add to list
-	LL_APPEND(*head, new_el);
+	// add to list and index
+	system_local_user_list_index_add(*head, new_el);
+	DL_APPEND(*head, new_el);
+
+	if (added_el) {
+		*added_el = new_el;
+	}
 
 	return 0;
 }
@@ -44,13 +60,8 @@ int system_local_user_list_add(system_local_user_element_t **head, system_local_
 system_local_user_element_t *system_local_user_list_find(system_local_user_element_t *head, const char *name)
 {
 	system_local_user_element_t *found = NULL;
-	system_local_user_element_t el = {
-		.user = {
-			.name = (char *) name,
-		},
-	};
 
-	LL_SEARCH(head, found, &el, system_local_user_element_cmp_fn);
+	HASH_FIND_STR(head, name, found);
 
 	return found;
 }
@@ -92,7 +103,8 @@ int system_local_user_list_remove(system_local_user_element_t **head, const char
 	}
 
 	// remove and free found element
-	LL_DELETE(*head, found);
+	system_local_user_list_index_remove(found);
+	DL_DELETE(*head, found);
 	system_local_user_free(&found->user);
 	free(found);
 
@@ -107,16 +119,52 @@ int system_local_user_element_cmp_fn(void *e1, void *e2)
 	return strcmp(s1->user.name, s2->user.name);
 }
 
+void system_local_user_list_delete(system_local_user_element_t **head, system_local_user_element_t *el)
+{
+	system_local_user_list_index_remove(el);
+	DL_DELETE(*head, el);
+	system_local_user_free(&el->user);
+	free(el);
+}
+
+void system_local_user_list_rehash(system_local_user_element_t **head, system_local_user_element_t *el)
+{
+	// el can be the list head - index it using another element of the same table
+	system_local_user_list_index_remove(el);
+	system_local_user_list_index_add(el == *head ? el->next : *head, el);
+}
+
 void system_local_user_list_free(system_local_user_element_t **head)
 {
 	system_local_user_element_t *iter_el = NULL, *tmp_el = NULL;
+	system_local_user_element_t *index = *head;
+
+	// elements are free'd below - only the index tables are dropped here
+	HASH_CLEAR(hh, index);
 
 	LL_FOREACH_SAFE(*head, iter_el, tmp_el)
 	{
-		LL_DELETE(*head, iter_el);
+		DL_DELETE(*head, iter_el);
 		system_local_user_free(&iter_el->user);
 		free(iter_el);
 	}
 
 	system_local_user_list_init(head);
 }
+
+// every element of the list is indexed - any element, including the list head, can be used as the table head
+static void system_local_user_list_index_add(system_local_user_element_t *index, system_local_user_element_t *el)
+{
+	const char *name = el->user.name ? el->user.name : "";
+
+	HASH_ADD_KEYPTR(hh, index, name, strlen(name), el);
+}
+
+static void system_local_user_list_index_remove(system_local_user_element_t *el)
+{
+	// uthash only moves the table head stored in the local pointer - the list is unlinked by the caller
+	system_local_user_element_t *index = el;
+
+	HASH_DELETE(hh, index, el);
+	el->hh = (UT_hash_handle){0};
+}
@@ -17,10 +17,13 @@
 
 void system_local_user_list_init(system_local_user_element_t **head);
 int system_local_user_list_add(system_local_user_element_t **head, system_local_user_t user);
+int system_local_user_list_append(system_local_user_element_t **head, system_local_user_t user, system_local_user_element_t **added_el);
 system_local_user_element_t *system_local_user_list_find(system_local_user_element_t *head, const char *name);
 system_local_user_element_t *system_local_user_list_complement(system_local_user_element_t *union_head, system_local_user_element_t *head);
 int system_local_user_list_remove(system_local_user_element_t **head, const char *name);
 int system_local_user_element_cmp_fn(void *e1, void *e2);
+void system_local_user_list_delete(system_local_user_element_t **head, system_local_user_element_t *el);
+void system_local_user_list_rehash(system_local_user_element_t **head, system_local_user_element_t *el);
 void system_local_user_list_free(system_local_user_element_t **head);
 
 #endif // SYSTEM_PLUGIN_DATA_AUTHENTICATION_LOCAL_USER_LIST_H
\ No newline at end of file
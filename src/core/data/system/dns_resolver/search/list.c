@@ -16,6 +16,10 @@
 #include <string.h>
 #include <stdlib.h>
 #include <utlist.h>
+#include <uthash.h>
+
+static void system_dns_search_list_index_add(system_dns_search_element_t *index, system_dns_search_element_t *el);
+static void system_dns_search_list_index_remove(system_dns_search_element_t *el);
 
 void system_dns_search_list_init(system_dns_search_element_t **head)
 {
@@ -30,14 +34,17 @@ int system_dns_search_list_add(system_dns_search_element_t **head, system_dns_se
 		return -1;
 	}
 
+	*new_el = (system_dns_search_element_t){0};
+
 	// copy value
 	system_dns_search_init(&new_el->search);
 	system_dns_search_set_domain(&new_el->search, search.domain);
 	system_dns_search_set_ifindex(&new_el->search, search.ifindex);
 	system_dns_search_set_search(&new_el->search, search.search);
 
-	// add to list
-	LL_APPEND(*head, new_el);
+	// add to list and index
+	system_dns_search_list_index_add(*head, new_el);
+	DL_APPEND(*head, new_el);
 
 	return 0;
 }
@@ -45,13 +52,8 @@ int system_dns_search_list_add(system_dns_search_element_t **head, system_dns_se
 system_dns_search_element_t *system_dns_search_list_find(system_dns_search_element_t *head, const char *domain)
 {
 	system_dns_search_element_t *found = NULL;
-	system_dns_search_element_t el = {
-		.search = {
-			.domain = (char *) domain,
-		},
-	};
 
-	LL_SEARCH(head, found, &el, system_dns_search_element_cmp_fn);
+	HASH_FIND_STR(head, domain, found);
 
 	return found;
 }
@@ -65,7 +67,8 @@ int system_dns_search_list_remove(system_dns_search_element_t **head, const char
 	}
 
 	// remove and free found element
-	LL_DELETE(*head, found);
+	system_dns_search_list_index_remove(found);
+	DL_DELETE(*head, found);
 	system_dns_search_free(&found->search);
 	free(found);
 
@@ -80,16 +83,67 @@ int system_dns_search_element_cmp_fn(void *e1, void *e2)
 	return strcmp(s1->search.domain, s2->search.domain);
 }
 
+int system_dns_search_list_copy(system_dns_search_element_t **dst, system_dns_search_element_t *src)
+{
+	system_dns_search_element_t *iter_el = NULL;
+
+	LL_FOREACH(src, iter_el)
+	{
+		if (system_dns_search_list_add(dst, iter_el->search)) {
+			system_dns_search_list_free(dst);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+void system_dns_search_list_delete(system_dns_search_element_t **head, system_dns_search_element_t *el)
+{
+	system_dns_search_list_index_remove(el);
+	DL_DELETE(*head, el);
+	system_dns_search_free(&el->search);
+	free(el);
+}
+
+void system_dns_search_list_rehash(system_dns_search_element_t **head, system_dns_search_element_t *el)
+{
+	// el can be the list head - index it using another element of the same table
+	system_dns_search_list_index_remove(el);
+	system_dns_search_list_index_add(el == *head ? el->next : *head, el);
+}
+
 void system_dns_search_list_free(system_dns_search_element_t **head)
 {
 	system_dns_search_element_t *iter_el = NULL, *tmp_el = NULL;
+	system_dns_search_element_t *index = *head;
+
+	// elements are free'd below - only the index tables are dropped here
+	HASH_CLEAR(hh, index);
 
 	LL_FOREACH_SAFE(*head, iter_el, tmp_el)
 	{
-		LL_DELETE(*head, iter_el);
+		DL_DELETE(*head, iter_el);
 		system_dns_search_free(&iter_el->search);
 		free(iter_el);
 	}
 
 	system_dns_search_list_init(head);
 }
+
+// every element of the list is indexed - any element, including the list head, can be used as the table head
+static void system_dns_search_list_index_add(system_dns_search_element_t *index, system_dns_search_element_t *el)
+{
+	const char *name = el->search.domain ? el->search.domain : "";
+
+	HASH_ADD_KEYPTR(hh, index, name, strlen(name), el);
+}
+
+static void system_dns_search_list_index_remove(system_dns_search_element_t *el)
+{
+	// uthash only moves the table head stored in the local pointer - the list is unlinked by the caller
+	system_dns_search_element_t *index = el;
+
+	HASH_DELETE(hh, index, el);
+	el->hh = (UT_hash_handle){0};
+}
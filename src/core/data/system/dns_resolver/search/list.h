@@ -20,6 +20,9 @@ int system_dns_search_list_add(system_dns_search_element_t **head, system_dns_se
 system_dns_search_element_t *system_dns_search_list_find(system_dns_search_element_t *head, const char *domain);
 int system_dns_search_list_remove(system_dns_search_element_t **head, const char *domain);
 int system_dns_search_element_cmp_fn(void *e1, void *e2);
+int system_dns_search_list_copy(system_dns_search_element_t **dst, system_dns_search_element_t *src);
+void system_dns_search_list_delete(system_dns_search_element_t **head, system_dns_search_element_t *el);
+void system_dns_search_list_rehash(system_dns_search_element_t **head, system_dns_search_element_t *el);
 void system_dns_search_list_free(system_dns_search_element_t **head);
 
 #endif // SYSTEM_PLUGIN_DATA_DNS_RESOLVER_SEARCH_LIST_H
\ No newline at end of file
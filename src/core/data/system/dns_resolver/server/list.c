@@ -16,7 +16,13 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
 #include <utlist.h>
+#include <uthash.h>
+
+static void system_dns_server_list_index_add(system_dns_server_element_t *index, system_dns_server_element_t *el);
+static void system_dns_server_list_index_remove(system_dns_server_element_t *el);
+static void system_dns_server_address_key(const system_ip_address_t *address, const void **key, size_t *key_length);
 
 void system_dns_server_list_init(system_dns_server_element_t **head)
 {
@@ -31,14 +37,17 @@ int system_dns_server_list_add(system_dns_server_element_t **head, system_dns_se
 		return -1;
 	}
 
+	*new_el = (system_dns_server_element_t){0};
+
 	// copy value
 	system_dns_server_init(&new_el->server);
 	system_dns_server_set_name(&new_el->server, server.name);
 	system_dns_server_set_address(&new_el->server, server.address);
 	system_dns_server_set_port(&new_el->server, server.port);
 
-	// add to list
-	LL_APPEND(*head, new_el);
+	// add to list and index
+	system_dns_server_list_index_add(*head, new_el);
+	DL_APPEND(*head, new_el);
 
 	return 0;
 }
@@ -46,13 +55,20 @@ int system_dns_server_list_add(system_dns_server_element_t **head, system_dns_se
 system_dns_server_element_t *system_dns_server_list_find(system_dns_server_element_t *head, const char *name)
 {
 	system_dns_server_element_t *found = NULL;
-	system_dns_server_element_t el = {
-		.server = {
-			.name = (char *) name,
-		},
-	};
 
-	LL_SEARCH(head, found, &el, system_dns_server_element_cmp_fn);
+	HASH_FIND_STR(head, name, found);
+
+	return found;
+}
+
+system_dns_server_element_t *system_dns_server_list_find_address(system_dns_server_element_t *head, const system_ip_address_t *address)
+{
+	system_dns_server_element_t *found = NULL;
+	const void *key = NULL;
+	size_t key_length = 0;
+
+	system_dns_server_address_key(address, &key, &key_length);
+	HASH_FIND(hh_address, head, key, key_length, found);
 
 	return found;
 }
@@ -66,7 +82,8 @@ int system_dns_server_list_remove(system_dns_server_element_t **head, const char
 	}
 
 	// remove and free found element
-	LL_DELETE(*head, found);
+	system_dns_server_list_index_remove(found);
+	DL_DELETE(*head, found);
 	system_dns_server_free(&found->server);
 	free(found);
 
@@ -81,16 +98,98 @@ int system_dns_server_element_cmp_fn(void *e1, void *e2)
 	return strcmp(s1->server.name, s2->server.name);
 }
 
+int system_dns_server_list_copy(system_dns_server_element_t **dst, system_dns_server_element_t *src)
+{
+	system_dns_server_element_t *iter_el = NULL;
+
+	LL_FOREACH(src, iter_el)
+	{
+		if (system_dns_server_list_add(dst, iter_el->server)) {
+			system_dns_server_list_free(dst);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+void system_dns_server_list_delete(system_dns_server_element_t **head, system_dns_server_element_t *el)
+{
+	system_dns_server_list_index_remove(el);
+	DL_DELETE(*head, el);
+	system_dns_server_free(&el->server);
+	free(el);
+}
+
+void system_dns_server_list_rehash(system_dns_server_element_t **head, system_dns_server_element_t *el)
+{
+	// el can be the list head - index it using another element of the same table
+	system_dns_server_list_index_remove(el);
+	system_dns_server_list_index_add(el == *head ? el->next : *head, el);
+}
+
 void system_dns_server_list_free(system_dns_server_element_t **head)
 {
 	system_dns_server_element_t *iter_el = NULL, *tmp_el = NULL;
+	system_dns_server_element_t *index = *head;
+	system_dns_server_element_t *address_index = *head;
+
+	// elements are free'd below - only the index tables are dropped here
+	HASH_CLEAR(hh, index);
+	HASH_CLEAR(hh_address, address_index);
 
 	LL_FOREACH_SAFE(*head, iter_el, tmp_el)
 	{
-		LL_DELETE(*head, iter_el);
+		DL_DELETE(*head, iter_el);
 		system_dns_server_free(&iter_el->server);
 		free(iter_el);
 	}
 
 	system_dns_server_list_init(head);
-}
\ No newline at end of file
+}
+
+// every element of the list is indexed - any element, including the list head, can be used as the table head
+static void system_dns_server_list_index_add(system_dns_server_element_t *index, system_dns_server_element_t *el)
+{
+	const char *name = el->server.name ? el->server.name : "";
+	system_dns_server_element_t *address_index = index;
+	const void *key = NULL;
+	size_t key_length = 0;
+
+	HASH_ADD_KEYPTR(hh, index, name, strlen(name), el);
+
+	system_dns_server_address_key(&el->server.address, &key, &key_length);
+	HASH_ADD_KEYPTR(hh_address, address_index, key, key_length, el);
+}
+
+static void system_dns_server_list_index_remove(system_dns_server_element_t *el)
+{
+	// uthash only moves the table head stored in the local pointer - the list is unlinked by the caller
+	system_dns_server_element_t *index = el;
+
+	HASH_DELETE(hh, index, el);
+	el->hh = (UT_hash_handle){0};
+
+	index = el;
+	HASH_DELETE(hh_address, index, el);
+	el->hh_address = (UT_hash_handle){0};
+}
+
+static void system_dns_server_address_key(const system_ip_address_t *address, const void **key, size_t *key_length)
+{
+#ifdef SYSTEMD
+	if (address->family == AF_INET) {
+		*key = address->value.v4;
+		*key_length = sizeof(address->value.v4);
+	} else if (address->family == AF_INET6) {
+		*key = address->value.v6;
+		*key_length = sizeof(address->value.v6);
+	} else {
+		*key = "";
+		*key_length = 0;
+	}
+#else
+	*key = address->value ? address->value : "";
+	*key_length = strlen(*key);
+#endif
+}
@@ -18,8 +18,12 @@
 void system_dns_server_list_init(system_dns_server_element_t **head);
 int system_dns_server_list_add(system_dns_server_element_t **head, system_dns_server_t server);
 system_dns_server_element_t *system_dns_server_list_find(system_dns_server_element_t *head, const char *name);
+system_dns_server_element_t *system_dns_server_list_find_address(system_dns_server_element_t *head, const system_ip_address_t *address);
 int system_dns_server_list_remove(system_dns_server_element_t **head, const char *name);
 int system_dns_server_element_cmp_fn(void *e1, void *e2);
+int system_dns_server_list_copy(system_dns_server_element_t **dst, system_dns_server_element_t *src);
+void system_dns_server_list_delete(system_dns_server_element_t **head, system_dns_server_element_t *el);
+void system_dns_server_list_rehash(system_dns_server_element_t **head, system_dns_server_element_t *el);
 void system_dns_server_list_free(system_dns_server_element_t **head);
 
 #endif // SYSTEM_PLUGIN_DATA_DNS_RESOLVER_SERVER_LIST_H
\ No newline at end of file
@@ -17,6 +17,10 @@
 #include <string.h>
 #include <stdlib.h>
 #include <utlist.h>
+#include <uthash.h>
+
+static void system_ntp_server_list_index_add(system_ntp_server_element_t *index, system_ntp_server_element_t *el);
+static void system_ntp_server_list_index_remove(system_ntp_server_element_t *el);
 
 void system_ntp_server_list_init(system_ntp_server_element_t **head)
 {
@@ -31,6 +35,8 @@ int system_ntp_server_list_add(system_ntp_server_element_t **head, system_ntp_se
 		return -1;
 	}
 
+	*new_el = (system_ntp_server_element_t){0};
+
 	// copy value
 	system_ntp_server_init(&new_el->server);
 	system_ntp_server_set_name(&new_el->server, server.name);
@@ -40,8 +46,9 @@ int system_ntp_server_list_add(system_ntp_server_element_t **head, system_ntp_se
 	system_ntp_server_set_iburst(&new_el->server, server.iburst);
 	system_ntp_server_set_prefer(&new_el->server, server.prefer);
 
-	// add to list
-	LL_APPEND(*head, new_el);
+	// add to list and index
+	system_ntp_server_list_index_add(*head, new_el);
+	DL_APPEND(*head, new_el);
 
 	return 0;
 }
@@ -49,13 +56,8 @@ int system_ntp_server_list_add(system_ntp_server_element_t **head, system_ntp_se
 system_ntp_server_element_t *system_ntp_server_list_find(system_ntp_server_element_t *head, const char *name)
 {
 	system_ntp_server_element_t *found = NULL;
-	system_ntp_server_element_t el = {
-		.server = {
-			.name = (char *) name,
-		},
-	};
 
-	LL_SEARCH(head, found, &el, system_ntp_server_element_cmp_fn);
+	HASH_FIND_STR(head, name, found);
 
 	return found;
 }
@@ -69,7 +71,8 @@ int system_ntp_server_list_remove(system_ntp_server_element_t **head, const char
 	}
 
 	// remove and free found element
-	LL_DELETE(*head, found);
+	system_ntp_server_list_index_remove(found);
+	DL_DELETE(*head, found);
 	system_ntp_server_free(&found->server);
 	free(found);
 
@@ -92,16 +95,67 @@ int system_ntp_server_element_address_cmp_fn(void *e1, void *e2)
 	return strcmp(s1->server.address, s2->server.address);
 }
 
+int system_ntp_server_list_copy(system_ntp_server_element_t **dst, system_ntp_server_element_t *src)
+{
+	system_ntp_server_element_t *iter_el = NULL;
+
+	LL_FOREACH(src, iter_el)
+	{
+		if (system_ntp_server_list_add(dst, iter_el->server)) {
+			system_ntp_server_list_free(dst);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+void system_ntp_server_list_delete(system_ntp_server_element_t **head, system_ntp_server_element_t *el)
+{
+	system_ntp_server_list_index_remove(el);
+	DL_DELETE(*head, el);
+	system_ntp_server_free(&el->server);
+	free(el);
+}
+
+void system_ntp_server_list_rehash(system_ntp_server_element_t **head, system_ntp_server_element_t *el)
+{
+	// el can be the list head - index it using another element of the same table
+	system_ntp_server_list_index_remove(el);
+	system_ntp_server_list_index_add(el == *head ? el->next : *head, el);
+}
+
 void system_ntp_server_list_free(system_ntp_server_element_t **head)
 {
 	system_ntp_server_element_t *iter_el = NULL, *tmp_el = NULL;
+	system_ntp_server_element_t *index = *head;
+
+	// elements are free'd below - only the index tables are dropped here
+	HASH_CLEAR(hh, index);
 
 	LL_FOREACH_SAFE(*head, iter_el, tmp_el)
 	{
-		LL_DELETE(*head, iter_el);
+		DL_DELETE(*head, iter_el);
 		system_ntp_server_free(&iter_el->server);
 		free(iter_el);
 	}
 
 	system_ntp_server_list_init(head);
-}
\ No newline at end of file
+}
+
+// every element of the list is indexed - any element, including the list head, can be used as the table head
+static void system_ntp_server_list_index_add(system_ntp_server_element_t *index, system_ntp_server_element_t *el)
+{
+	const char *name = el->server.name ? el->server.name : "";
+
+	HASH_ADD_KEYPTR(hh, index, name, strlen(name), el);
+}
+
+static void system_ntp_server_list_index_remove(system_ntp_server_element_t *el)
+{
+	// uthash only moves the table head stored in the local pointer - the list is unlinked by the caller
+	system_ntp_server_element_t *index = el;
+
+	HASH_DELETE(hh, index, el);
+	el->hh = (UT_hash_handle){0};
+}
@@ -21,6 +21,9 @@ system_ntp_server_element_t *system_ntp_server_list_find(system_ntp_server_eleme
 int system_ntp_server_list_remove(system_ntp_server_element_t **head, const char *name);
 int system_ntp_server_element_cmp_fn(void *e1, void *e2);
 int system_ntp_server_element_address_cmp_fn(void *e1, void *e2);
+int system_ntp_server_list_copy(system_ntp_server_element_t **dst, system_ntp_server_element_t *src);
+void system_ntp_server_list_delete(system_ntp_server_element_t **head, system_ntp_server_element_t *el);
+void system_ntp_server_list_rehash(system_ntp_server_element_t **head, system_ntp_server_element_t *el);
 void system_ntp_server_list_free(system_ntp_server_element_t **head);
 
 #endif // SYSTEM_PLUGIN_DATA_NTP_SERVER_LIST_H
\ No newline at end of file
@@ -0,0 +1,100 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "features.h"
+#include "core/common.h"
+
+#include <stddef.h>
+
+#include <sysrepo.h>
+#include <libyang/libyang.h>
+
+#include <srpc.h>
+
+static const struct {
+	uint32_t feature;
+	const char *name;
+} system_features_names[] = {
+	{SYSTEM_FEATURE_RADIUS, "radius"},
+	{SYSTEM_FEATURE_AUTHENTICATION, "authentication"},
+	{SYSTEM_FEATURE_LOCAL_USERS, "local-users"},
+	{SYSTEM_FEATURE_RADIUS_AUTHENTICATION, "radius-authentication"},
+	{SYSTEM_FEATURE_NTP, "ntp"},
+	{SYSTEM_FEATURE_NTP_UDP_PORT, "ntp-udp-port"},
+	{SYSTEM_FEATURE_TIMEZONE_NAME, "timezone-name"},
+	{SYSTEM_FEATURE_DNS_UDP_TCP_PORT, "dns-udp-tcp-port"},
+};
+
+void system_features_init(system_features_t *features)
+{
+	*features = (system_features_t){0};
+}
+
+int system_features_refresh(system_features_t *features, sr_session_ctx_t *session)
+{
+	int error = 0;
+	sr_conn_ctx_t *conn_ctx = NULL;
+	const struct ly_ctx *ly_ctx = NULL;
+	const struct lys_module *module = NULL;
+	uint32_t enabled = 0;
+
+	conn_ctx = sr_session_get_connection(session);
+	ly_ctx = sr_acquire_context(conn_ctx);
+	if (ly_ctx == NULL) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to get ly_ctx variable");
+		goto error_out;
+	}
+
+	// features can only be changed by installing a new context - nothing to do if it is the same one
+	if (features->ly_ctx == ly_ctx && features->ly_ctx_change_count == ly_ctx_get_change_count(ly_ctx)) {
+		goto out;
+	}
+
+	module = ly_ctx_get_module_implemented(ly_ctx, IETF_SYSTEM_YANG_MODULE);
+	if (!module) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Module %s not implemented in the current context", IETF_SYSTEM_YANG_MODULE);
+		goto error_out;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(system_features_names); i++) {
+		if (lys_feature_value(module, system_features_names[i].name) == LY_SUCCESS) {
+			enabled |= system_features_names[i].feature;
+		}
+	}
+
+	features->enabled = enabled;
+	features->ly_ctx = ly_ctx;
+	features->ly_ctx_change_count = ly_ctx_get_change_count(ly_ctx);
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (ly_ctx) {
+		sr_release_context(conn_ctx);
+	}
+
+	return error;
+}
+
+const char *system_features_get_name(uint32_t feature)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(system_features_names); i++) {
+		if (system_features_names[i].feature == feature) {
+			return system_features_names[i].name;
+		}
+	}
+
+	return NULL;
+}
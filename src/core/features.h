@@ -0,0 +1,52 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_FEATURES_H
+#define SYSTEM_PLUGIN_FEATURES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <sysrepo_types.h>
+
+typedef struct system_features_s system_features_t;
+
+// ietf-system features used by the plugin
+enum system_feature_e {
+	SYSTEM_FEATURE_RADIUS = 1 << 0,
+	SYSTEM_FEATURE_AUTHENTICATION = 1 << 1,
+	SYSTEM_FEATURE_LOCAL_USERS = 1 << 2,
+	SYSTEM_FEATURE_RADIUS_AUTHENTICATION = 1 << 3,
+	SYSTEM_FEATURE_NTP = 1 << 4,
+	SYSTEM_FEATURE_NTP_UDP_PORT = 1 << 5,
+	SYSTEM_FEATURE_TIMEZONE_NAME = 1 << 6,
+	SYSTEM_FEATURE_DNS_UDP_TCP_PORT = 1 << 7,
+};
+
+struct system_features_s {
+	uint32_t enabled;			  ///< Enabled features - system_feature_e flags.
+	const struct ly_ctx *ly_ctx;  ///< Context the features were compiled from.
+	uint16_t ly_ctx_change_count; ///< Change count of the context the features were compiled from.
+};
+
+// check a feature compiled into the bitmask - no sysrepo or libyang calls
+#define SYSTEM_FEATURE_ENABLED(features, feature) (((features)->enabled & (feature)) != 0)
+
+void system_features_init(system_features_t *features);
+
+// compile enabled features of the ietf-system module - only done if the context changed since the last call
+int system_features_refresh(system_features_t *features, sr_session_ctx_t *session);
+
+// feature name for logging
+const char *system_features_get_name(uint32_t feature);
+
+#endif // SYSTEM_PLUGIN_FEATURES_H
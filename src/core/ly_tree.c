@@ -186,4 +186,64 @@ int system_ly_tree_create_state_clock_current_datetime(const struct ly_ctx *ly_c
 int system_ly_tree_create_state_clock_boot_datetime(const struct ly_ctx *ly_ctx, struct lyd_node *clock_container_node, const char *boot_datetime)
 {
 	return srpc_ly_tree_create_leaf(ly_ctx, clock_container_node, NULL, "boot-datetime", boot_datetime);
+}
+
+int system_ly_tree_create_plugin_apply_pending_transactions(const struct ly_ctx *ly_ctx, struct lyd_node *apply_container_node, const char *pending_transactions)
+{
+	return srpc_ly_tree_create_leaf(ly_ctx, apply_container_node, NULL, "pending-transactions", pending_transactions);
+}
+
+int system_ly_tree_create_plugin_apply_last_applied_request_id(const struct ly_ctx *ly_ctx, struct lyd_node *apply_container_node, const char *last_applied_request_id)
+{
+	return srpc_ly_tree_create_leaf(ly_ctx, apply_container_node, NULL, "last-applied-request-id", last_applied_request_id);
+}
+
+int system_ly_tree_create_plugin_apply_failed_transactions(const struct ly_ctx *ly_ctx, struct lyd_node *apply_container_node, const char *failed_transactions)
+{
+	return srpc_ly_tree_create_leaf(ly_ctx, apply_container_node, NULL, "failed-transactions", failed_transactions);
+}
+
+int system_ly_tree_create_plugin_home_removal_pending_homes(const struct ly_ctx *ly_ctx, struct lyd_node *home_removal_container_node, const char *pending_homes)
+{
+	return srpc_ly_tree_create_leaf(ly_ctx, home_removal_container_node, NULL, "pending-homes", pending_homes);
+}
+
+int system_ly_tree_create_plugin_home_removal_pending_entries(const struct ly_ctx *ly_ctx, struct lyd_node *home_removal_container_node, const char *pending_entries)
+{
+	return srpc_ly_tree_create_leaf(ly_ctx, home_removal_container_node, NULL, "pending-entries", pending_entries);
+}
+
+int system_ly_tree_create_plugin_home_removal_pending_bytes(const struct ly_ctx *ly_ctx, struct lyd_node *home_removal_container_node, const char *pending_bytes)
+{
+	return srpc_ly_tree_create_leaf(ly_ctx, home_removal_container_node, NULL, "pending-bytes", pending_bytes);
+}
+
+int system_ly_tree_create_plugin_user_import_running(const struct ly_ctx *ly_ctx, struct lyd_node *user_import_container_node, const char *running)
+{
+	return srpc_ly_tree_create_leaf(ly_ctx, user_import_container_node, NULL, "running", running);
+}
+
+int system_ly_tree_create_plugin_user_import_failed(const struct ly_ctx *ly_ctx, struct lyd_node *user_import_container_node, const char *failed)
+{
+	return srpc_ly_tree_create_leaf(ly_ctx, user_import_container_node, NULL, "failed", failed);
+}
+
+int system_ly_tree_create_plugin_user_import_imported_users(const struct ly_ctx *ly_ctx, struct lyd_node *user_import_container_node, const char *imported_users)
+{
+	return srpc_ly_tree_create_leaf(ly_ctx, user_import_container_node, NULL, "imported-users", imported_users);
+}
+
+int system_ly_tree_create_plugin_user_import_batches(const struct ly_ctx *ly_ctx, struct lyd_node *user_import_container_node, const char *batches)
+{
+	return srpc_ly_tree_create_leaf(ly_ctx, user_import_container_node, NULL, "batches", batches);
+}
+
+int system_ly_tree_create_plugin_user_import_processed_bytes(const struct ly_ctx *ly_ctx, struct lyd_node *user_import_container_node, const char *processed_bytes)
+{
+	return srpc_ly_tree_create_leaf(ly_ctx, user_import_container_node, NULL, "processed-bytes", processed_bytes);
+}
+
+int system_ly_tree_create_plugin_user_import_total_bytes(const struct ly_ctx *ly_ctx, struct lyd_node *user_import_container_node, const char *total_bytes)
+{
+	return srpc_ly_tree_create_leaf(ly_ctx, user_import_container_node, NULL, "total-bytes", total_bytes);
 }
\ No newline at end of file
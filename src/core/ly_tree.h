@@ -65,4 +65,22 @@ int system_ly_tree_create_state_clock(const struct ly_ctx *ly_ctx, struct lyd_no
 int system_ly_tree_create_state_clock_current_datetime(const struct ly_ctx *ly_ctx, struct lyd_node *clock_container_node, const char *current_datetime);
 int system_ly_tree_create_state_clock_boot_datetime(const struct ly_ctx *ly_ctx, struct lyd_node *clock_container_node, const char *boot_datetime);
 
+// plugin apply state
+int system_ly_tree_create_plugin_apply_pending_transactions(const struct ly_ctx *ly_ctx, struct lyd_node *apply_container_node, const char *pending_transactions);
+int system_ly_tree_create_plugin_apply_last_applied_request_id(const struct ly_ctx *ly_ctx, struct lyd_node *apply_container_node, const char *last_applied_request_id);
+int system_ly_tree_create_plugin_apply_failed_transactions(const struct ly_ctx *ly_ctx, struct lyd_node *apply_container_node, const char *failed_transactions);
+
+// plugin home removal state
+int system_ly_tree_create_plugin_home_removal_pending_homes(const struct ly_ctx *ly_ctx, struct lyd_node *home_removal_container_node, const char *pending_homes);
+int system_ly_tree_create_plugin_home_removal_pending_entries(const struct ly_ctx *ly_ctx, struct lyd_node *home_removal_container_node, const char *pending_entries);
+int system_ly_tree_create_plugin_home_removal_pending_bytes(const struct ly_ctx *ly_ctx, struct lyd_node *home_removal_container_node, const char *pending_bytes);
+
+// plugin user import state
+int system_ly_tree_create_plugin_user_import_running(const struct ly_ctx *ly_ctx, struct lyd_node *user_import_container_node, const char *running);
+int system_ly_tree_create_plugin_user_import_failed(const struct ly_ctx *ly_ctx, struct lyd_node *user_import_container_node, const char *failed);
+int system_ly_tree_create_plugin_user_import_imported_users(const struct ly_ctx *ly_ctx, struct lyd_node *user_import_container_node, const char *imported_users);
+int system_ly_tree_create_plugin_user_import_batches(const struct ly_ctx *ly_ctx, struct lyd_node *user_import_container_node, const char *batches);
+int system_ly_tree_create_plugin_user_import_processed_bytes(const struct ly_ctx *ly_ctx, struct lyd_node *user_import_container_node, const char *processed_bytes);
+int system_ly_tree_create_plugin_user_import_total_bytes(const struct ly_ctx *ly_ctx, struct lyd_node *user_import_container_node, const char *total_bytes);
+
 #endif // SYSTEM_PLUGIN_LY_TREE_H
\ No newline at end of file
@@ -17,7 +17,6 @@
 
 // API for getting system data
 #include "srpc/common.h"
-#include "srpc/feature_status.h"
 #include "srpc/ly_tree.h"
 #include "core/api/system/load.h"
 #include "core/api/system/authentication/load.h"
@@ -97,8 +96,12 @@ int system_startup_load_data(system_ctx_t *ctx, sr_session_ctx_t *session)
 		goto error_out;
 	}
 
-	// reload features hash before adding all system values
-	SRPC_SAFE_CALL_ERR(error, srpc_feature_status_hash_reload(&ctx->ietf_system_features, session, IETF_SYSTEM_YANG_MODULE), error_out);
+	// refresh features before using them - the bitmask is only recompiled if the context changed
+	error = system_features_refresh(&ctx->features, session);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_features_refresh() error (%d)", error);
+		goto error_out;
+	}
 
 	// load system container info
 	error = system_ly_tree_create_system(ly_ctx, &system_container_node);
@@ -191,7 +194,7 @@ static int system_startup_load_timezone_name(void *priv, sr_session_ctx_t *sessi
 	struct lyd_node *clock_container_node = NULL;
 	bool timezone_name_enabled = false;
 
-	timezone_name_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "timezone-name");
+	timezone_name_enabled = SYSTEM_FEATURE_ENABLED(&ctx->features, SYSTEM_FEATURE_TIMEZONE_NAME);
 
 	if (timezone_name_enabled) {
 		error = system_load_timezone_name(ctx, timezone_name_buffer);
@@ -237,21 +240,12 @@ static int system_startup_load_dns_resolver(void *priv, sr_session_ctx_t *sessio
 		goto error_out;
 	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Loading DNS search values from the system");
-
-	// load values
-
-	error = system_dns_resolver_load_search(ctx, &search_head);
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_resolver_load_search_values() error (%d)", error);
-		goto error_out;
-	}
-
-	SRPLG_LOG_INF(PLUGIN_NAME, "Loading DNS server values from the system");
+	SRPLG_LOG_INF(PLUGIN_NAME, "Loading DNS search and server values from the system");
 
-	error = system_dns_resolver_load_server(ctx, &servers_head);
+	// load values - both requests are sent at once
+	error = system_dns_resolver_load(ctx, &search_head, &servers_head);
 	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_resolver_load_server_values() error (%d)", error);
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_resolver_load() error (%d)", error);
 		goto error_out;
 	}
 
@@ -330,8 +324,8 @@ static int system_startup_load_authentication(void *priv, sr_session_ctx_t *sess
 	system_local_user_element_t *user_head = NULL, *user_iter = NULL;
 	system_authorized_key_element_t *key_iter = NULL;
 
-	bool enabled_authentication = srpc_feature_status_hash_check(ctx->ietf_system_features, "authentication");
-	bool enabled_local_users = srpc_feature_status_hash_check(ctx->ietf_system_features, "local-users");
+	bool enabled_authentication = SYSTEM_FEATURE_ENABLED(&ctx->features, SYSTEM_FEATURE_AUTHENTICATION);
+	bool enabled_local_users = SYSTEM_FEATURE_ENABLED(&ctx->features, SYSTEM_FEATURE_LOCAL_USERS);
 
 	if (enabled_authentication) {
 		// create authentication container
@@ -356,15 +350,11 @@ static int system_startup_load_authentication(void *priv, sr_session_ctx_t *sess
 
 			SRPLG_LOG_INF(PLUGIN_NAME, "Loading user authorized keys");
 
-			LL_FOREACH(user_head, user_iter)
-			{
-				system_authorized_key_list_init(&user_iter->user.key_head);
-
-				error = system_authentication_load_user_authorized_key(ctx, user_iter->user.name, &user_iter->user.key_head);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_load_user_authorized_key() error (%d)", error);
-					goto error_out;
-				}
+			// users are scanned in parallel
+			error = system_authentication_load_users_authorized_keys(ctx, user_head);
+			if (error) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_load_users_authorized_keys() error (%d)", error);
+				goto error_out;
 			}
 
 			SRPLG_LOG_INF(PLUGIN_NAME, "Saving users and their keys to the datastore");
@@ -11,15 +11,17 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 #include "change.h"
+#include "core/subscription/change/dispatch.h"
+#include "core/subscription/change/apply.h"
 #include "core/common.h"
 #include "core/context.h"
 #include "libyang/printer_data.h"
 #include "core/ly_tree.h"
 #include "srpc/common.h"
-#include "srpc/feature_status.h"
 #include "srpc/ly_tree.h"
 #include "sysrepo_types.h"
 #include "core/api/system/authentication/load.h"
+#include "core/api/system/authentication/password.h"
 #include "core/data/system/authentication/local_user/list.h"
 #include "core/data/system/dns_resolver/search/list.h"
 #include "core/data/system/dns_resolver/server/list.h"
@@ -47,6 +49,7 @@
 #include <sysrepo/xpath.h>
 #include <assert.h>
 #include <errno.h>
+#include <stdlib.h>
 #include <pwd.h>
 #include <linux/limits.h>
 
@@ -54,18 +57,81 @@
 
 #include <utlist.h>
 
-int system_subscription_change_contact(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
+// names of the planned operations holding the whole desired state
+#define SYSTEM_CHANGE_APPLY_NTP_SERVERS "NTP servers"
+#define SYSTEM_CHANGE_APPLY_DNS_RESOLVER "DNS resolver"
+
+// groups
+static int system_subscription_change_ntp_server_prepare(void *priv, sr_session_ctx_t *session);
+static int system_subscription_change_ntp_server_apply(void *priv, sr_session_ctx_t *session);
+static void system_subscription_change_ntp_server_cleanup(void *priv);
+static int system_subscription_change_ntp_server_execute(void *priv, void *data);
+static void system_subscription_change_ntp_server_free(void *data);
+static int system_subscription_change_ntp_server_copy(void *data, void **copy);
+
+static int system_subscription_change_dns_resolver_prepare(void *priv, sr_session_ctx_t *session);
+static int system_subscription_change_dns_resolver_apply(void *priv, sr_session_ctx_t *session);
+static void system_subscription_change_dns_resolver_cleanup(void *priv);
+static int system_subscription_change_dns_resolver_execute(void *priv, void *data);
+static void system_subscription_change_dns_resolver_free(void *data);
+static int system_subscription_change_dns_resolver_copy(void *data, void **copy);
+static void system_subscription_change_dns_resolver_free_state(system_dns_resolver_t *resolver);
+
+static int system_subscription_change_authentication_user_prepare(void *priv, sr_session_ctx_t *session);
+static int system_subscription_change_authentication_user_apply(void *priv, sr_session_ctx_t *session);
+static void system_subscription_change_authentication_user_cleanup(void *priv);
+static int system_subscription_change_authentication_user_execute(void *priv, void *data);
+static void system_subscription_change_authentication_user_free(void *data);
+
+const system_change_group_t system_change_group_ntp_server = {
+	"NTP server",
+	system_subscription_change_ntp_server_prepare,
+	system_subscription_change_ntp_server_apply,
+	system_subscription_change_ntp_server_cleanup,
+};
+
+const system_change_group_t system_change_group_dns_resolver = {
+	"DNS resolver",
+	system_subscription_change_dns_resolver_prepare,
+	system_subscription_change_dns_resolver_apply,
+	system_subscription_change_dns_resolver_cleanup,
+};
+
+const system_change_group_t system_change_group_authentication_user = {
+	"local user",
+	system_subscription_change_authentication_user_prepare,
+	system_subscription_change_authentication_user_apply,
+	system_subscription_change_authentication_user_cleanup,
+};
+
+int system_subscription_change_system(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
 {
 	int error = SR_ERR_OK;
 	system_ctx_t *ctx = (system_ctx_t *) private_data;
 
 	if (event == SR_EV_ABORT) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "Aborting changes for %s", xpath);
-		goto error_out;
+		// nothing has been applied on the system yet - only drop the planned operations
+		SRPLG_LOG_INF(PLUGIN_NAME, "aborting changes for: %s", xpath);
+		system_change_apply_discard(&ctx->change_apply);
 	} else if (event == SR_EV_CHANGE) {
-		error = srpc_iterate_changes(ctx, session, xpath, system_change_contact, NULL, NULL);
+		error = system_change_apply_begin(&ctx->change_apply, request_id);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_change_apply_begin() error (%d)", error);
+			goto error_out;
+		}
+
+		// walk all changes once and route every node to its callback - system changes are only planned here
+		error = system_change_dispatcher_dispatch(&ctx->change_dispatcher, ctx, session, SYSTEM_SYSTEM_CONTAINER_YANG_PATH "//.");
 		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() error (%d)", error);
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_change_dispatcher_dispatch() error (%d)", error);
+			system_change_apply_discard(&ctx->change_apply);
+			goto error_out;
+		}
+	} else if (event == SR_EV_DONE) {
+		// changes are stored in the datastore - apply them on the system in the background
+		error = system_change_apply_commit(&ctx->change_apply, request_id);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_change_apply_commit() error (%d)", error);
 			goto error_out;
 		}
 	}
@@ -79,655 +145,688 @@ out:
 	return error;
 }
 
-int system_subscription_change_hostname(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
+int system_subscription_change_plugin_coalescing(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
 {
 	int error = SR_ERR_OK;
 	system_ctx_t *ctx = (system_ctx_t *) private_data;
-
-	if (event == SR_EV_ABORT) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "Aborting changes for %s", xpath);
+	sr_val_t *window_value = NULL;
+	uint32_t window = 0;
+
+	// subscribed with SR_SUBSCR_DONE_ONLY and SR_SUBSCR_ENABLED - the window is always valid
+	error = sr_get_item(session, SYSTEM_PLUGIN_COALESCING_WINDOW_YANG_PATH, 0, &window_value);
+	if (error == SR_ERR_OK) {
+		window = window_value->data.uint32_val;
+	} else if (error != SR_ERR_NOT_FOUND) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_get_item() error (%d): %s", error, sr_strerror(error));
 		goto error_out;
-	} else if (event == SR_EV_CHANGE) {
-		error = srpc_iterate_changes(ctx, session, xpath, system_change_hostname, NULL, NULL);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() error (%d)", error);
-			goto error_out;
-		}
 	}
 
+	SRPLG_LOG_INF(PLUGIN_NAME, "Commit coalescing window set to %u ms", window);
+
+	system_change_apply_set_window(&ctx->change_apply, window);
+
+	error = SR_ERR_OK;
+
 	goto out;
 
 error_out:
 	error = SR_ERR_CALLBACK_FAILED;
 
 out:
+	if (window_value) {
+		sr_free_val(window_value);
+	}
+
 	return error;
 }
 
-int system_subscription_change_location(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
+int system_subscription_change_plugin_password_hashing(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
 {
 	int error = SR_ERR_OK;
 	system_ctx_t *ctx = (system_ctx_t *) private_data;
-
-	if (event == SR_EV_ABORT) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "Aborting changes for %s", xpath);
-		goto error_out;
-	} else if (event == SR_EV_CHANGE) {
-		error = srpc_iterate_changes(ctx, session, xpath, system_change_location, NULL, NULL);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() error (%d)", error);
+	sr_val_t *scheme_value = NULL;
+	enum system_authentication_password_scheme_e scheme = SYSTEM_AUTHENTICATION_PASSWORD_SCHEME_SHA_512;
+
+	// subscribed with SR_SUBSCR_DONE_ONLY and SR_SUBSCR_ENABLED - the scheme is always valid
+	error = sr_get_item(session, SYSTEM_PLUGIN_PASSWORD_HASHING_SCHEME_YANG_PATH, 0, &scheme_value);
+	if (error == SR_ERR_OK) {
+		if (system_authentication_password_scheme_from_string(scheme_value->data.enum_val, &scheme)) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Unknown password hashing scheme %s", scheme_value->data.enum_val);
 			goto error_out;
 		}
+	} else if (error != SR_ERR_NOT_FOUND) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_get_item() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
 	}
 
+	SRPLG_LOG_INF(PLUGIN_NAME, "Password hashing scheme set to %s", scheme_value ? scheme_value->data.enum_val : "sha-512");
+
+	__atomic_store_n(&ctx->password_scheme, scheme, __ATOMIC_RELAXED);
+
+	error = SR_ERR_OK;
+
 	goto out;
 
 error_out:
 	error = SR_ERR_CALLBACK_FAILED;
 
 out:
+	if (scheme_value) {
+		sr_free_val(scheme_value);
+	}
+
 	return error;
 }
 
-int system_subscription_change_timezone_name(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
+int system_subscription_change_plugin_managed_users(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
 {
 	int error = SR_ERR_OK;
 	system_ctx_t *ctx = (system_ctx_t *) private_data;
-
-	// feature
-	bool timezone_name_enabled = false;
-
-	if (event == SR_EV_ABORT) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "aborting changes for: %s", xpath);
+	sr_data_t *subtree = NULL;
+	const struct lyd_node *range_node = NULL, *min_node = NULL, *max_node = NULL;
+	const struct lyd_node *name_prefix_node = NULL, *group_node = NULL;
+	system_authentication_scope_range_t *ranges = NULL, *new_ranges = NULL;
+	size_t range_count = 0;
+	const char *name_prefix = NULL;
+	const char *group = NULL;
+
+	// subscribed with SR_SUBSCR_DONE_ONLY and SR_SUBSCR_ENABLED - an empty container means the default scope
+	error = sr_get_subtree(session, SYSTEM_PLUGIN_MANAGED_USERS_YANG_PATH, 0, &subtree);
+	if (error != SR_ERR_OK && error != SR_ERR_NOT_FOUND) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_get_subtree() error (%d): %s", error, sr_strerror(error));
 		goto error_out;
-	} else if (event == SR_EV_CHANGE) {
-		// reload features in case of changes during plugin runtime
-		SRPC_SAFE_CALL_ERR(error, srpc_feature_status_hash_reload(&ctx->ietf_system_features, session, IETF_SYSTEM_YANG_MODULE), error_out);
+	}
 
-		// get feature
-		timezone_name_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "timezone-name");
+	if (subtree) {
+		range_node = srpc_ly_tree_get_child_list(subtree->tree, "uid-range");
+		while (range_node) {
+			min_node = srpc_ly_tree_get_child_leaf(range_node, "min");
+			max_node = srpc_ly_tree_get_child_leaf(range_node, "max");
 
-		if (timezone_name_enabled) {
-			error = srpc_iterate_changes(ctx, session, xpath, system_change_timezone_name, NULL, NULL);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() error (%d)", error);
+			new_ranges = realloc(ranges, sizeof(*ranges) * (range_count + 1));
+			if (!new_ranges) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "realloc() failed");
 				goto error_out;
 			}
-		}
-	}
+			ranges = new_ranges;
 
-	goto out;
+			// max is mandatory and not lower than min
+			ranges[range_count].min = (unsigned int) strtoul(lyd_get_value(min_node), NULL, 10);
+			ranges[range_count].max = (unsigned int) strtoul(lyd_get_value(max_node), NULL, 10);
+			range_count++;
 
-error_out:
-	error = SR_ERR_CALLBACK_FAILED;
+			range_node = srpc_ly_tree_get_list_next(range_node);
+		}
 
-out:
-	return error;
-}
+		name_prefix_node = srpc_ly_tree_get_child_leaf(subtree->tree, "name-prefix");
+		if (name_prefix_node) {
+			name_prefix = lyd_get_value(name_prefix_node);
+		}
 
-int system_subscription_change_timezone_utc_offset(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
-{
-	int error = SR_ERR_OK;
-	// system_ctx_t *ctx = (system_ctx_t *) private_data;
+		group_node = srpc_ly_tree_get_child_leaf(subtree->tree, "group");
+		if (group_node) {
+			group = lyd_get_value(group_node);
+		}
+	}
 
-	if (event == SR_EV_ABORT) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "aborting changes for: %s", xpath);
+	SRPLG_LOG_INF(PLUGIN_NAME, "Managed user scope set to %zu UID ranges, name prefix %s and group %s", range_count, name_prefix ? name_prefix : "(any)", group ? group : "(any)");
+
+	// used by following loads, stores and transactions - users already in the datastore are kept
+	error = system_authentication_scope_set(&ctx->user_scope, ranges, range_count, name_prefix, group);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_scope_set() error (%d)", error);
 		goto error_out;
-	} else if (event == SR_EV_CHANGE) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "Unsupported option for now");
 	}
 
+	error = SR_ERR_OK;
+
 	goto out;
 
 error_out:
 	error = SR_ERR_CALLBACK_FAILED;
 
 out:
-	return error;
-}
-
-int system_subscription_change_ntp_enabled(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
-{
-	int error = SR_ERR_OK;
-
-	bool ntp_enabled = false;
-
-	system_ctx_t *ctx = (system_ctx_t *) private_data;
-	if (event == SR_EV_ABORT) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "aborting changes for: %s", xpath);
-		goto error_out;
-	} else if (event == SR_EV_CHANGE) {
-		// reload features in case of changes during plugin runtime
-		SRPC_SAFE_CALL_ERR(error, srpc_feature_status_hash_reload(&ctx->ietf_system_features, session, IETF_SYSTEM_YANG_MODULE), error_out);
-
-		// get feature
-		ntp_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "ntp");
+	free(ranges);
 
-		if (ntp_enabled) {
-			SRPC_SAFE_CALL_ERR(error, srpc_iterate_changes(ctx, session, xpath, system_ntp_change_enabled, NULL, NULL), error_out);
-		}
+	if (subtree) {
+		sr_release_data(subtree);
 	}
 
-	goto out;
-error_out:
-	error = SR_ERR_CALLBACK_FAILED;
-
-out:
-	return SR_ERR_CALLBACK_FAILED;
+	return error;
 }
 
-int system_subscription_change_ntp_server(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
+int system_subscription_update_authentication_password(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
 {
 	int error = SR_ERR_OK;
-
-	char xpath_buffer[PATH_MAX] = {0};
 	system_ctx_t *ctx = (system_ctx_t *) private_data;
-	system_ntp_server_element_t *iter = NULL;
-
-	// features
-	bool ntp_enabled = false;
-	bool ntp_udp_port_enabled = false;
+	sr_change_iter_t *changes_iterator = NULL;
+	sr_change_oper_t operation = SR_OP_CREATED;
+	const struct lyd_node *node = NULL;
+	const char *prev_value = NULL;
+	const char *prev_list = NULL;
+	int prev_default = 0;
+	const char *value = NULL;
+	system_authentication_password_t *passwords = NULL, *new_passwords = NULL;
+	char **paths = NULL, **new_paths = NULL;
+	size_t count = 0, size = 0;
+
+	if (event != SR_EV_UPDATE) {
+		goto out;
+	}
 
-	if (event == SR_EV_ABORT) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "aborting changes for: %s", xpath);
+	error = sr_get_changes_iter(session, SYSTEM_AUTHENTICATION_USER_PASSWORD_YANG_PATH, &changes_iterator);
+	if (error != SR_ERR_OK) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_get_changes_iter() error (%d): %s", error, sr_strerror(error));
 		goto error_out;
-	} else if (event == SR_EV_CHANGE) {
-		// make sure the last change servers were free'd and set to NULL
-		assert(ctx->temp_ntp_servers == NULL);
-
-		// reload features in case of changes during plugin runtime
-		SRPC_SAFE_CALL_ERR(error, srpc_feature_status_hash_reload(&ctx->ietf_system_features, session, IETF_SYSTEM_YANG_MODULE), error_out);
-
-		// get features
-		ntp_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "ntp");
-		ntp_udp_port_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "ntp-udp-port");
+	}
 
-		if (ntp_enabled) {
-			// load all system NTP servers
-			error = system_ntp_load_server(ctx, &ctx->temp_ntp_servers);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_load_server() error (%d)", error);
-				goto error_out;
-			}
+	// collect all cleartext passwords first - the change tree stays valid until the iterator is free'd
+	while (sr_get_change_tree_next(session, changes_iterator, &operation, &node, &prev_value, &prev_list, &prev_default) == SR_ERR_OK) {
+		if (operation != SR_OP_CREATED && operation != SR_OP_MODIFIED) {
+			continue;
+		}
 
-			// process changes and use store API to store the configured list
-			SRPLG_LOG_DBG(PLUGIN_NAME, "Servers before changes:");
-			LL_FOREACH(ctx->temp_ntp_servers, iter)
-			{
-				SRPLG_LOG_DBG(PLUGIN_NAME, "\t<%s, %s, %s, %s, %s, %s>", iter->server.name, iter->server.address, iter->server.port, iter->server.association_type, iter->server.iburst, iter->server.prefer);
-			}
+		value = lyd_get_value(node);
+		if (!system_authentication_password_is_cleartext(value)) {
+			continue;
+		}
 
-			// name change
-			error = snprintf(xpath_buffer, sizeof(xpath_buffer), "%s//name", xpath);
-			if (error < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
-				goto error_out;
-			}
-			error = srpc_iterate_changes(ctx, session, xpath_buffer, system_ntp_change_server_name, NULL, NULL);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for name failed: %d", error);
-				goto error_out;
-			}
+		if (count == size) {
+			size = size ? size * 2 : 16;
 
-			// address change
-			error = snprintf(xpath_buffer, sizeof(xpath_buffer), "%s//udp/address", xpath);
-			if (error < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
-				goto error_out;
-			}
-			error = srpc_iterate_changes(ctx, session, xpath_buffer, system_ntp_change_server_address, NULL, NULL);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for address failed: %d", error);
+			new_passwords = realloc(passwords, size * sizeof(*passwords));
+			if (!new_passwords) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "realloc() failed");
 				goto error_out;
 			}
+			passwords = new_passwords;
 
-			if (ntp_udp_port_enabled) {
-				// port change
-				error = snprintf(xpath_buffer, sizeof(xpath_buffer), "%s//udp/port", xpath);
-				if (error < 0) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
-					goto error_out;
-				}
-				error = srpc_iterate_changes(ctx, session, xpath_buffer, system_ntp_change_server_port, NULL, NULL);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for port failed: %d", error);
-					goto error_out;
-				}
-			}
-
-			// association-type
-			error = snprintf(xpath_buffer, sizeof(xpath_buffer), "%s//association-type", xpath);
-			if (error < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
-				goto error_out;
-			}
-			error = srpc_iterate_changes(ctx, session, xpath_buffer, system_ntp_change_server_association_type, NULL, NULL);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for association-type failed: %d", error);
+			new_paths = realloc(paths, size * sizeof(*paths));
+			if (!new_paths) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "realloc() failed");
 				goto error_out;
 			}
+			paths = new_paths;
+		}
 
-			// iburst
-			error = snprintf(xpath_buffer, sizeof(xpath_buffer), "%s//iburst", xpath);
-			if (error < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
-				goto error_out;
-			}
-			error = srpc_iterate_changes(ctx, session, xpath_buffer, system_ntp_change_server_iburst, NULL, NULL);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for iburst failed: %d", error);
-				goto error_out;
-			}
+		paths[count] = lyd_path(node, LYD_PATH_STD, NULL, 0);
+		if (!paths[count]) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_path() failed");
+			goto error_out;
+		}
 
-			// prefer
-			error = snprintf(xpath_buffer, sizeof(xpath_buffer), "%s//prefer", xpath);
-			if (error < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
-				goto error_out;
-			}
-			error = srpc_iterate_changes(ctx, session, xpath_buffer, system_ntp_change_server_prefer, NULL, NULL);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for prefer failed: %d", error);
-				goto error_out;
-			}
+		passwords[count] = (system_authentication_password_t){
+			.cleartext = value + sizeof(SYSTEM_AUTHENTICATION_PASSWORD_CLEARTEXT_PREFIX) - 1,
+		};
+		count++;
+	}
 
-			SRPLG_LOG_DBG(PLUGIN_NAME, "Servers after changes:");
-			LL_FOREACH(ctx->temp_ntp_servers, iter)
-			{
-				SRPLG_LOG_DBG(PLUGIN_NAME, "\t<%s, %s, %s, %s, %s, %s>", iter->server.name, iter->server.address, iter->server.port, iter->server.association_type, iter->server.iburst, iter->server.prefer);
-			}
+	if (!count) {
+		goto out;
+	}
 
-			// delete entries before applying changes - faster than searching for each server and changing libyang tree
-			error = sr_delete_item(ctx->startup_session, "/ntp:ntp[config-file=\"/etc/ntp.conf\"]/config-entries", SR_EDIT_DEFAULT);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "sr_delete_item() error (%d): %s", error, sr_strerror(error));
-				goto error_out;
-			}
-			error = sr_apply_changes(ctx->startup_session, 0);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "sr_apply_changes() error (%d): %s", error, sr_strerror(error));
-				goto error_out;
-			}
+	SRPLG_LOG_INF(PLUGIN_NAME, "Hashing %zu cleartext passwords", count);
 
-			SRPLG_LOG_INF(PLUGIN_NAME, "Deleted /etc/ntp.conf config file data");
+	// hashing is expensive on purpose - bulk imports are spread across the workers
+	error = system_authentication_password_hash(passwords, count, __atomic_load_n(&ctx->password_scheme, __ATOMIC_RELAXED));
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_password_hash() error (%d)", error);
+		goto error_out;
+	}
 
-			// store generated data
-			error = system_ntp_store_server(ctx, ctx->temp_ntp_servers);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_store_server() error (%d)", error);
-				goto error_out;
-			}
+	for (size_t i = 0; i < count; i++) {
+		error = sr_set_item_str(session, paths[i], passwords[i].hash, NULL, 0);
+		if (error != SR_ERR_OK) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "sr_set_item_str() error (%d) for %s: %s", error, paths[i], sr_strerror(error));
+			goto error_out;
 		}
 	}
 
+	error = SR_ERR_OK;
+
 	goto out;
+
 error_out:
 	error = SR_ERR_CALLBACK_FAILED;
 
 out:
+	if (passwords) {
+		system_authentication_password_free(passwords, count);
+		free(passwords);
+	}
 
-	system_ntp_server_list_free(&ctx->temp_ntp_servers);
+	for (size_t i = 0; i < count; i++) {
+		free(paths[i]);
+	}
 
-	return SR_ERR_CALLBACK_FAILED;
+	free(paths);
+
+	if (changes_iterator) {
+		sr_free_change_iter(changes_iterator);
+	}
+
+	return error;
 }
 
-int system_subscription_change_dns_resolver_search(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
+int system_subscription_change_finish(void *priv, bool failed)
 {
-	int error = SR_ERR_OK;
-	system_dns_search_element_t *iter = NULL;
+	int error = 0;
+	system_ctx_t *ctx = (system_ctx_t *) priv;
+
+	// a failed operation may have staged only a part of its edits - keep the config files as they are
+	if (failed) {
+		SRPLG_LOG_WRN(PLUGIN_NAME, "Discarding config file changes of a failed transaction");
+		system_store_discard(ctx);
+		goto out;
+	}
 
-	system_ctx_t *ctx = (system_ctx_t *) private_data;
-	if (event == SR_EV_ABORT) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "aborting changes for: %s", xpath);
+	// all config file edits of the transaction are written at once
+	error = system_store_apply(ctx);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_store_apply() error (%d)", error);
 		goto error_out;
-	} else if (event == SR_EV_CHANGE) {
-		// make sure the last change search values were free'd and set to NULL
-		assert(ctx->temp_dns_search == NULL);
+	}
 
-		// load all system DNS search domains first
-		error = system_dns_resolver_load_search(ctx, &ctx->temp_dns_search);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_resolver_load_search() error (%d)", error);
-			goto error_out;
-		}
+	goto out;
 
-		SRPLG_LOG_DBG(PLUGIN_NAME, "Search domains before changes:");
-		LL_FOREACH(ctx->temp_dns_search, iter)
-		{
-			SRPLG_LOG_DBG(PLUGIN_NAME, "\t<%s>", iter->search.domain);
-		}
+error_out:
+	error = -1;
 
-		error = srpc_iterate_changes(ctx, session, xpath, system_dns_resolver_change_search, NULL, NULL);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for name failed: %d", error);
-			goto error_out;
-		}
+out:
+	return error;
+}
 
-		SRPLG_LOG_DBG(PLUGIN_NAME, "Search domains after changes:");
-		LL_FOREACH(ctx->temp_dns_search, iter)
-		{
-			SRPLG_LOG_DBG(PLUGIN_NAME, "\t<%s>", iter->search.domain);
-		}
+static int system_subscription_change_ntp_server_prepare(void *priv, sr_session_ctx_t *session)
+{
+	int error = 0;
+	system_ctx_t *ctx = (system_ctx_t *) priv;
+	system_ntp_server_element_t *iter = NULL;
+	bool planned = false;
+
+	// make sure the last change servers were free'd and set to NULL
+	assert(ctx->temp_ntp_servers == NULL);
+	assert(ctx->temp_ntp_server_changes == NULL);
+
+	// a commit not yet applied on the system already holds the state to build on
+	error = system_change_apply_get_state(&ctx->change_apply, SYSTEM_CHANGE_APPLY_NTP_SERVERS, &planned, (void **) &ctx->temp_ntp_servers);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_change_apply_get_state() error (%d)", error);
+		goto error_out;
+	}
+
+	if (!planned) {
+		// servers are read through the startup session - wait for the worker to stop using it
+		system_change_apply_wait(&ctx->change_apply);
 
-		error = system_dns_resolver_store_search(ctx, ctx->temp_dns_search);
+		// load all system NTP servers
+		error = system_ntp_load_server(ctx, &ctx->temp_ntp_servers);
 		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_resolver_store_search() error (%d)", error);
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_load_server() error (%d)", error);
 			goto error_out;
 		}
 	}
 
+	SRPLG_LOG_DBG(PLUGIN_NAME, "Servers before changes:");
+	LL_FOREACH(ctx->temp_ntp_servers, iter)
+	{
+		SRPLG_LOG_DBG(PLUGIN_NAME, "\t<%s, %s, %s, %s, %s, %s>", iter->server.name, iter->server.address, iter->server.port, iter->server.association_type, iter->server.iburst, iter->server.prefer);
+	}
+
 	goto out;
 
 error_out:
-	error = SR_ERR_CALLBACK_FAILED;
+	error = -1;
 
 out:
-
-	system_dns_search_list_free(&ctx->temp_dns_search);
-
 	return error;
 }
 
-int system_subscription_change_dns_resolver_server(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
+static int system_subscription_change_ntp_server_apply(void *priv, sr_session_ctx_t *session)
 {
-	int error = SR_ERR_OK;
-
-	char xpath_buffer[PATH_MAX] = {0};
-	system_ctx_t *ctx = (system_ctx_t *) private_data;
-	system_dns_server_element_t *iter = NULL;
+	int error = 0;
+	system_ctx_t *ctx = (system_ctx_t *) priv;
+	system_ntp_server_element_t *iter = NULL;
 
-	if (event == SR_EV_ABORT) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "aborting changes for: %s", xpath);
+	// apply all per-server changes on the loaded servers at once
+	error = system_ntp_change_server_apply(ctx, session);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_change_server_apply() error (%d)", error);
 		goto error_out;
-	} else if (event == SR_EV_CHANGE) {
-		// make sure the last change servers were free'd and set to NULL
-		assert(ctx->temp_dns_servers == NULL);
+	}
 
-		// load all system DNS servers first
-		error = system_dns_resolver_load_server(ctx, &ctx->temp_dns_servers);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_resolver_load_server() error (%d)", error);
-			goto error_out;
-		}
+	SRPLG_LOG_DBG(PLUGIN_NAME, "Servers after changes:");
+	LL_FOREACH(ctx->temp_ntp_servers, iter)
+	{
+		SRPLG_LOG_DBG(PLUGIN_NAME, "\t<%s, %s, %s, %s, %s, %s>", iter->server.name, iter->server.address, iter->server.port, iter->server.association_type, iter->server.iburst, iter->server.prefer);
+	}
 
-		SRPLG_LOG_DBG(PLUGIN_NAME, "Servers before changes:");
-		LL_FOREACH(ctx->temp_dns_servers, iter)
-		{
-			SRPLG_LOG_DBG(PLUGIN_NAME, "\t<%s>", iter->server.name);
-		}
+	// servers are stored by the apply worker - it owns the list from now on
+	error = system_change_apply_plan_state(&ctx->change_apply, SYSTEM_CHANGE_APPLY_NTP_SERVERS, system_subscription_change_ntp_server_execute, system_subscription_change_ntp_server_free, system_subscription_change_ntp_server_copy, ctx->temp_ntp_servers);
+	ctx->temp_ntp_servers = NULL;
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_change_apply_plan_state() error (%d)", error);
+		goto error_out;
+	}
 
-		// process changes and use store API to store the configured list
+	goto out;
 
-		// name change
-		error = snprintf(xpath_buffer, sizeof(xpath_buffer), "%s//name", xpath);
-		if (error < 0) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
-			goto error_out;
-		}
-		error = srpc_iterate_changes(ctx, session, xpath_buffer, system_dns_resolver_change_server_name, NULL, NULL);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for name failed: %d", error);
-			goto error_out;
-		}
+error_out:
+	error = -1;
 
-		// address change
-		error = snprintf(xpath_buffer, sizeof(xpath_buffer), "%s//udp-and-tcp/address", xpath);
-		if (error < 0) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
-			goto error_out;
-		}
-		error = srpc_iterate_changes(ctx, session, xpath_buffer, system_dns_resolver_change_server_address, NULL, NULL);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for address failed: %d", error);
-			goto error_out;
-		}
+out:
+	return error;
+}
 
-		// port change
-		error = snprintf(xpath_buffer, sizeof(xpath_buffer), "%s//udp-and-tcp/port", xpath);
-		if (error < 0) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
-			goto error_out;
-		}
-		error = srpc_iterate_changes(ctx, session, xpath_buffer, system_dns_resolver_change_server_port, NULL, NULL);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for port failed: %d", error);
-			goto error_out;
-		}
+static void system_subscription_change_ntp_server_cleanup(void *priv)
+{
+	system_ctx_t *ctx = (system_ctx_t *) priv;
 
-		SRPLG_LOG_DBG(PLUGIN_NAME, "Servers after changes:");
-		LL_FOREACH(ctx->temp_dns_servers, iter)
-		{
-			SRPLG_LOG_DBG(PLUGIN_NAME, "\t<%s>", iter->server.name);
-		}
+	system_ntp_server_list_free(&ctx->temp_ntp_servers);
+	system_ntp_change_server_free(ctx);
+}
 
-		// store generated data
-		error = system_dns_resolver_store_server(ctx, ctx->temp_dns_servers);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_resolver_store_server() error (%d)", error);
-			goto error_out;
-		}
+static int system_subscription_change_ntp_server_execute(void *priv, void *data)
+{
+	int error = 0;
+	system_ctx_t *ctx = (system_ctx_t *) priv;
+	system_ntp_server_element_t *servers = (system_ntp_server_element_t *) data;
+
+	// stage only changed config entries - committed with the rest of the transaction in system_subscription_change_finish()
+	error = system_ntp_store_server(ctx, servers);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_store_server() error (%d)", error);
+		goto error_out;
 	}
 
 	goto out;
+
 error_out:
-	error = SR_ERR_CALLBACK_FAILED;
+	error = -1;
 
 out:
+	return error;
+}
 
-	system_dns_server_list_free(&ctx->temp_dns_servers);
+static void system_subscription_change_ntp_server_free(void *data)
+{
+	system_ntp_server_element_t *servers = (system_ntp_server_element_t *) data;
 
-	return error;
+	system_ntp_server_list_free(&servers);
 }
 
-int system_subscription_change_dns_resolver_timeout(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
+static int system_subscription_change_ntp_server_copy(void *data, void **copy)
 {
-	int error = SR_ERR_OK;
-	// system_ctx_t *ctx = (system_ctx_t *) private_data;
-	if (event == SR_EV_ABORT) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "aborting changes for: %s", xpath);
+	system_ntp_server_element_t *list = NULL;
+
+	if (system_ntp_server_list_copy(&list, (system_ntp_server_element_t *) data)) {
+		return -1;
+	}
+
+	*copy = list;
+
+	return 0;
+}
+
+static int system_subscription_change_dns_resolver_prepare(void *priv, sr_session_ctx_t *session)
+{
+	int error = 0;
+	system_ctx_t *ctx = (system_ctx_t *) priv;
+	system_dns_resolver_t *planned_resolver = NULL;
+	bool planned = false;
+
+	// make sure the last change values were free'd and set to NULL
+	assert(ctx->temp_dns_resolver.search == NULL);
+	assert(ctx->temp_dns_resolver.servers == NULL);
+
+	// a commit not yet applied on the system already holds the state to build on
+	error = system_change_apply_get_state(&ctx->change_apply, SYSTEM_CHANGE_APPLY_DNS_RESOLVER, &planned, (void **) &planned_resolver);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_change_apply_get_state() error (%d)", error);
 		goto error_out;
-	} else if (event == SR_EV_CHANGE) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "Unsupported option for now");
+	}
+
+	if (planned) {
+		// parts changed by the planned state are kept - it can be superseded by this transaction
+		ctx->temp_dns_resolver = *planned_resolver;
+		free(planned_resolver);
+	} else {
+		// load all system DNS search domains and servers first - both in one round-trip
+		error = system_dns_resolver_load(ctx, &ctx->temp_dns_resolver.search, &ctx->temp_dns_resolver.servers);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_resolver_load() error (%d)", error);
+			goto error_out;
+		}
 	}
 
 	goto out;
+
 error_out:
-	error = SR_ERR_CALLBACK_FAILED;
+	error = -1;
 
 out:
 	return error;
 }
 
-int system_subscription_change_dns_resolver_attempts(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
+static int system_subscription_change_dns_resolver_apply(void *priv, sr_session_ctx_t *session)
 {
-	int error = SR_ERR_OK;
-	// system_ctx_t *ctx = (system_ctx_t *) private_data;
-	if (event == SR_EV_ABORT) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "aborting changes for: %s", xpath);
+	int error = 0;
+	system_ctx_t *ctx = (system_ctx_t *) priv;
+	system_dns_resolver_t *resolver = NULL;
+	system_dns_search_element_t *search_iter = NULL;
+	system_dns_server_element_t *server_iter = NULL;
+
+	SRPLG_LOG_DBG(PLUGIN_NAME, "Search domains after changes:");
+	LL_FOREACH(ctx->temp_dns_resolver.search, search_iter)
+	{
+		SRPLG_LOG_DBG(PLUGIN_NAME, "\t<%s>", search_iter->search.domain);
+	}
+
+	SRPLG_LOG_DBG(PLUGIN_NAME, "Servers after changes:");
+	LL_FOREACH(ctx->temp_dns_resolver.servers, server_iter)
+	{
+		SRPLG_LOG_DBG(PLUGIN_NAME, "\t<%s>", server_iter->server.name);
+	}
+
+	resolver = malloc(sizeof(*resolver));
+	if (!resolver) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "malloc() failed");
+		goto error_out;
+	}
+
+	// search domains and servers of the transaction are stored at once by the apply worker - it owns the lists from now on
+	*resolver = ctx->temp_dns_resolver;
+	ctx->temp_dns_resolver = (system_dns_resolver_t){0};
+
+	error = system_change_apply_plan_state(&ctx->change_apply, SYSTEM_CHANGE_APPLY_DNS_RESOLVER, system_subscription_change_dns_resolver_execute, system_subscription_change_dns_resolver_free, system_subscription_change_dns_resolver_copy, resolver);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_change_apply_plan_state() error (%d)", error);
 		goto error_out;
-	} else if (event == SR_EV_CHANGE) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "Unsupported option for now");
 	}
 
 	goto out;
 
 error_out:
-	error = SR_ERR_CALLBACK_FAILED;
+	error = -1;
 
 out:
 	return error;
 }
 
-int system_subscription_change_authentication_user_authentication_order(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
+static void system_subscription_change_dns_resolver_cleanup(void *priv)
 {
-	int error = SR_ERR_OK;
-	// system_ctx_t *ctx = (system_ctx_t *) private_data;
-	if (event == SR_EV_ABORT) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "aborting changes for: %s", xpath);
+	system_ctx_t *ctx = (system_ctx_t *) priv;
+
+	system_subscription_change_dns_resolver_free_state(&ctx->temp_dns_resolver);
+}
+
+static int system_subscription_change_dns_resolver_execute(void *priv, void *data)
+{
+	int error = 0;
+	system_ctx_t *ctx = (system_ctx_t *) priv;
+
+	error = system_dns_resolver_store(ctx, (system_dns_resolver_t *) data);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_resolver_store() error (%d)", error);
+		return -1;
+	}
+
+	return 0;
+}
+
+static void system_subscription_change_dns_resolver_free(void *data)
+{
+	system_dns_resolver_t *resolver = (system_dns_resolver_t *) data;
+
+	system_subscription_change_dns_resolver_free_state(resolver);
+	free(resolver);
+}
+
+static int system_subscription_change_dns_resolver_copy(void *data, void **copy)
+{
+	int error = 0;
+	system_dns_resolver_t *resolver = (system_dns_resolver_t *) data;
+	system_dns_resolver_t *resolver_copy = NULL;
+
+	resolver_copy = calloc(1, sizeof(*resolver_copy));
+	if (!resolver_copy) {
 		goto error_out;
-	} else if (event == SR_EV_CHANGE) {
 	}
 
+	error = system_dns_search_list_copy(&resolver_copy->search, resolver->search);
+	if (error) {
+		goto error_out;
+	}
+
+	error = system_dns_server_list_copy(&resolver_copy->servers, resolver->servers);
+	if (error) {
+		goto error_out;
+	}
+
+	resolver_copy->changed = resolver->changed;
+
+	*copy = resolver_copy;
+
 	goto out;
 
 error_out:
-	error = SR_ERR_CALLBACK_FAILED;
+	error = -1;
+
+	if (resolver_copy) {
+		system_subscription_change_dns_resolver_free(resolver_copy);
+	}
 
 out:
 	return error;
 }
 
-int system_subscription_change_authentication_user(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
+static void system_subscription_change_dns_resolver_free_state(system_dns_resolver_t *resolver)
 {
-	int error = SR_ERR_OK;
+	system_dns_search_list_free(&resolver->search);
+	system_dns_server_list_free(&resolver->servers);
+	resolver->changed = 0;
+}
 
-	char xpath_buffer[PATH_MAX] = {0};
-	system_ctx_t *ctx = (system_ctx_t *) private_data;
+static int system_subscription_change_authentication_user_prepare(void *priv, sr_session_ctx_t *session)
+{
+	int error = 0;
+	system_ctx_t *ctx = (system_ctx_t *) priv;
 
-	bool authentication_enabled = false;
-	bool local_users_enabled = false;
-	system_local_user_element_t *user_iter = NULL;
+	// system state is read below - wait for earlier transactions to be applied
+	system_change_apply_wait(&ctx->change_apply);
 
-	if (event == SR_EV_ABORT) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "aborting changes for: %s", xpath);
-		error = -1;
+	// assert user database is NULL from the last change
+	assert(ctx->temp_users.users == NULL);
+	assert(ctx->temp_users.db == NULL);
+
+	// user database is parsed once for the whole transaction - it is stored by the apply worker together with the changes
+	ctx->temp_users.db = um_db_new();
+	if (!ctx->temp_users.db) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_new() failed");
 		goto error_out;
-	} else if (event == SR_EV_CHANGE) {
-		// assert user database is NULL from the last change
-		assert(ctx->temp_users.created == NULL);
-		assert(ctx->temp_users.modified == NULL);
-		assert(ctx->temp_users.deleted == NULL);
-
-		// reload features in case of changes during plugin runtime
-		SRPC_SAFE_CALL_ERR(error, srpc_feature_status_hash_reload(&ctx->ietf_system_features, session, IETF_SYSTEM_YANG_MODULE), error_out);
-
-		// get features
-		authentication_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "authentication");
-		local_users_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "local-users");
-
-		if (authentication_enabled && local_users_enabled) {
-			// load current users into modifed list so they can also be modified
-			error = system_authentication_load_user(ctx, &ctx->temp_users.modified);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_load_user() error (%d)", error);
-				goto error_out;
-			}
+	}
 
-			// also key users list
-			error = system_authentication_load_user(ctx, &ctx->temp_users.keys.modified);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_load_user() error (%d)", error);
-				goto error_out;
-			}
+	error = um_db_load(ctx->temp_users.db);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_load() error (%d)", error);
+		goto error_out;
+	}
 
-			// load all keys for the modified list
-			LL_FOREACH(ctx->temp_users.keys.modified, user_iter)
-			{
-				error = system_authentication_load_user_authorized_key(ctx, user_iter->user.name, &user_iter->user.key_head);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_load_user_authorized_key() error (%d) for user %s", error, user_iter->user.name);
-					goto error_out;
-				}
-			}
+	goto out;
 
-			// name change
-			error = snprintf(xpath_buffer, sizeof(xpath_buffer), "%s/name", xpath);
-			if (error < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
-				goto error_out;
-			}
-			error = srpc_iterate_changes(ctx, session, xpath_buffer, system_authentication_change_user_name, NULL, NULL);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for user:name failed: %d", error);
-				goto error_out;
-			}
+error_out:
+	error = -1;
 
-			// password change
-			error = snprintf(xpath_buffer, sizeof(xpath_buffer), "%s/password", xpath);
-			if (error < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
-				goto error_out;
-			}
-			error = srpc_iterate_changes(ctx, session, xpath_buffer, system_authentication_change_user_password, NULL, NULL);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for user:password failed: %d", error);
-				goto error_out;
-			}
+out:
+	return error;
+}
 
-			// authorized-key name change
-			error = snprintf(xpath_buffer, sizeof(xpath_buffer), "%s/authorized-key//name", xpath);
-			if (error < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
-				goto error_out;
-			}
-			error = srpc_iterate_changes(ctx, session, xpath_buffer, system_authentication_user_change_authorized_key_name, NULL, NULL);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for user:authorized-key:name failed: %d", error);
-				goto error_out;
-			}
+static int system_subscription_change_authentication_user_apply(void *priv, sr_session_ctx_t *session)
+{
+	int error = 0;
+	system_ctx_t *ctx = (system_ctx_t *) priv;
+	system_local_user_changes_t *changes = NULL;
+
+	// users outside of the managed user scope or conflicting with the database fail the transaction before anything is planned
+	error = system_authentication_change_user_check(ctx, &ctx->temp_users);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_check() error (%d)", error);
+		goto error_out;
+	}
 
-			// authorized-key algorithm change
-			error = snprintf(xpath_buffer, sizeof(xpath_buffer), "%s/authorized-key//algorithm", xpath);
-			if (error < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
-				goto error_out;
-			}
-			error = srpc_iterate_changes(ctx, session, xpath_buffer, system_authentication_user_change_authorized_key_algorithm, NULL, NULL);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for user:authorized-key:algorithm failed: %d", error);
-				goto error_out;
-			}
+	// per-user records are applied by the apply worker - it owns them from now on
+	changes = malloc(sizeof(*changes));
+	if (!changes) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "malloc() failed");
+		goto error_out;
+	}
 
-			// authorized-key key-data change
-			error = snprintf(xpath_buffer, sizeof(xpath_buffer), "%s/authorized-key//key-data", xpath);
-			if (error < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
-				goto error_out;
-			}
-			error = srpc_iterate_changes(ctx, session, xpath_buffer, system_authentication_user_change_authorized_key_key_data, NULL, NULL);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for user:authorized-key:key-data failed: %d", error);
-				goto error_out;
-			}
+	*changes = ctx->temp_users;
+	ctx->temp_users = (system_local_user_changes_t){0};
 
-			// apply all changes regarding created/modified/deleted users
-			error = system_authentication_user_apply_changes(ctx);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_user_apply_changes() error (%d)", error);
-				goto error_out;
-			}
-		}
+	error = system_change_apply_plan(&ctx->change_apply, "local users", system_subscription_change_authentication_user_execute, system_subscription_change_authentication_user_free, changes);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_change_apply_plan() error (%d)", error);
+		goto error_out;
 	}
 
 	goto out;
 
 error_out:
-	error = SR_ERR_CALLBACK_FAILED;
+	error = -1;
 
 out:
-	if (ctx->temp_users.created) {
-		system_local_user_list_free(&ctx->temp_users.created);
-	}
-	if (ctx->temp_users.modified) {
-		system_local_user_list_free(&ctx->temp_users.modified);
-	}
-	if (ctx->temp_users.deleted) {
-		system_local_user_list_free(&ctx->temp_users.deleted);
-	}
+	return error;
+}
 
-	// key lists
-	if (ctx->temp_users.keys.created) {
-		system_local_user_list_free(&ctx->temp_users.keys.created);
-	}
-	if (ctx->temp_users.keys.modified) {
-		system_local_user_list_free(&ctx->temp_users.keys.modified);
-	}
-	if (ctx->temp_users.keys.deleted) {
-		system_local_user_list_free(&ctx->temp_users.keys.deleted);
+static void system_subscription_change_authentication_user_cleanup(void *priv)
+{
+	system_ctx_t *ctx = (system_ctx_t *) priv;
+
+	system_authentication_change_user_free(&ctx->temp_users);
+
+	// walk points into the changes tree and the free'd records
+	system_authentication_change_user_reset_walk(ctx);
+}
+
+static int system_subscription_change_authentication_user_execute(void *priv, void *data)
+{
+	int error = 0;
+	system_ctx_t *ctx = (system_ctx_t *) priv;
+
+	// apply all changes regarding created/modified/deleted users
+	error = system_authentication_user_apply_changes(ctx, (system_local_user_changes_t *) data);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_user_apply_changes() error (%d)", error);
+		return -1;
 	}
 
-	ctx->temp_users.created = ctx->temp_users.modified = ctx->temp_users.deleted = NULL;
-	ctx->temp_users.keys.created = ctx->temp_users.keys.modified = ctx->temp_users.keys.deleted = NULL;
+	return 0;
+}
 
-	return error;
-}
\ No newline at end of file
+static void system_subscription_change_authentication_user_free(void *data)
+{
+	system_local_user_changes_t *changes = (system_local_user_changes_t *) data;
+
+	system_authentication_change_user_free(changes);
+	free(changes);
+}
@@ -13,27 +13,33 @@
 #ifndef SYSTEM_PLUGIN_SUBSCRIPTION_CHANGE_H
 #define SYSTEM_PLUGIN_SUBSCRIPTION_CHANGE_H
 
+#include "core/subscription/change/dispatch.h"
+
+#include <stdbool.h>
+
 #include <sysrepo_types.h>
 
-// system container //
-int system_subscription_change_contact(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
-int system_subscription_change_hostname(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
-int system_subscription_change_location(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
-int system_subscription_change_timezone_name(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
-int system_subscription_change_timezone_utc_offset(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
-
-// ntp //
-int system_subscription_change_ntp_enabled(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
-int system_subscription_change_ntp_server(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
-
-// dns //
-int system_subscription_change_dns_resolver_search(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
-int system_subscription_change_dns_resolver_server(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
-int system_subscription_change_dns_resolver_timeout(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
-int system_subscription_change_dns_resolver_attempts(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
-
-// authentication //
-int system_subscription_change_authentication_user_authentication_order(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
-int system_subscription_change_authentication_user(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
+// module change callback - all ietf-system changes are dispatched from here
+int system_subscription_change_system(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
+
+// plugin configuration change callback - window used for coalescing commits
+int system_subscription_change_plugin_coalescing(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
+
+// plugin configuration change callback - scheme used for hashing cleartext passwords
+int system_subscription_change_plugin_password_hashing(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
+
+// plugin configuration change callback - scope of local users managed by the plugin
+int system_subscription_change_plugin_managed_users(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
+
+// update callback - cleartext passwords are replaced by their hash before the change is stored
+int system_subscription_update_authentication_password(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
+
+// apply worker callback - commits config file edits staged by the operations of a transaction
+int system_subscription_change_finish(void *priv, bool failed);
+
+// change groups used in routes
+extern const system_change_group_t system_change_group_ntp_server;
+extern const system_change_group_t system_change_group_dns_resolver;
+extern const system_change_group_t system_change_group_authentication_user;
 
 #endif // SYSTEM_PLUGIN_SUBSCRIPTION_CHANGE_H
\ No newline at end of file
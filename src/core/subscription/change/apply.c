@@ -0,0 +1,432 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "apply.h"
+#include "core/common.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sysrepo.h>
+
+#include <utlist.h>
+
+static void *system_change_apply_worker(void *arg);
+static int system_change_apply_add(system_change_apply_t *apply, const char *name, system_change_apply_cb execute, system_change_apply_free_cb free_cb, system_change_apply_copy_cb copy_cb, bool state, void *data);
+static void system_change_apply_coalesce(system_change_apply_t *apply);
+static void system_change_apply_execute(system_change_apply_t *apply, system_change_apply_transaction_t *batch);
+static bool system_change_apply_superseded(system_change_apply_transaction_t *transaction, system_change_apply_op_t *op);
+static void system_change_apply_transaction_free(system_change_apply_transaction_t *transaction);
+
+int system_change_apply_init(system_change_apply_t *apply, void *priv, system_change_apply_finish_cb finish)
+{
+	int error = 0;
+
+	*apply = (system_change_apply_t){0};
+	apply->priv = priv;
+	apply->finish = finish;
+
+	pthread_mutex_init(&apply->lock, NULL);
+	pthread_cond_init(&apply->queued, NULL);
+	pthread_cond_init(&apply->idle, NULL);
+
+	error = pthread_create(&apply->worker, NULL, system_change_apply_worker, apply);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "pthread_create() error (%d)", error);
+		goto error_out;
+	}
+
+	apply->running = true;
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	return error;
+}
+
+int system_change_apply_begin(system_change_apply_t *apply, uint32_t request_id)
+{
+	int error = 0;
+
+	if (apply->plan) {
+		SRPLG_LOG_WRN(PLUGIN_NAME, "Discarding operations planned for request %u - the transaction was never finished", apply->plan->request_id);
+		system_change_apply_discard(apply);
+	}
+
+	apply->plan = calloc(1, sizeof(*apply->plan));
+	if (!apply->plan) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "calloc() failed");
+		goto error_out;
+	}
+
+	apply->plan->request_id = request_id;
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	return error;
+}
+
+int system_change_apply_plan(system_change_apply_t *apply, const char *name, system_change_apply_cb execute, system_change_apply_free_cb free_cb, void *data)
+{
+	return system_change_apply_add(apply, name, execute, free_cb, NULL, false, data);
+}
+
+int system_change_apply_plan_state(system_change_apply_t *apply, const char *name, system_change_apply_cb execute, system_change_apply_free_cb free_cb, system_change_apply_copy_cb copy_cb, void *data)
+{
+	return system_change_apply_add(apply, name, execute, free_cb, copy_cb, true, data);
+}
+
+int system_change_apply_get_state(system_change_apply_t *apply, const char *name, bool *found, void **data)
+{
+	int error = 0;
+	system_change_apply_transaction_t *transaction = NULL;
+	system_change_apply_op_t *op = NULL;
+	system_change_apply_op_t *last = NULL;
+
+	*found = false;
+	*data = NULL;
+
+	pthread_mutex_lock(&apply->lock);
+
+	// transactions being applied are older than the pending ones - the last match is the newest state
+	LL_FOREACH(apply->applying, transaction)
+	{
+		LL_FOREACH(transaction->ops, op)
+		{
+			if (op->state && op->copy && !strcmp(op->name, name)) {
+				last = op;
+			}
+		}
+	}
+
+	LL_FOREACH(apply->pending, transaction)
+	{
+		LL_FOREACH(transaction->ops, op)
+		{
+			if (op->state && op->copy && !strcmp(op->name, name)) {
+				last = op;
+			}
+		}
+	}
+
+	// data of the operation is only read by the worker - safe to copy while it is being applied
+	if (last) {
+		error = last->copy(last->data, data);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Copying planned %s failed (%d)", name, error);
+			goto error_out;
+		}
+
+		*found = true;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	pthread_mutex_unlock(&apply->lock);
+
+	return error;
+}
+
+int system_change_apply_commit(system_change_apply_t *apply, uint32_t request_id)
+{
+	int error = 0;
+	system_change_apply_transaction_t *transaction = apply->plan;
+
+	apply->plan = NULL;
+
+	// nothing routed in the transaction or nothing with an effect on the system
+	if (!transaction || !transaction->ops) {
+		goto out;
+	}
+
+	if (transaction->request_id != request_id) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Planned request %u does not match the finished request %u", transaction->request_id, request_id);
+		goto error_out;
+	}
+
+	pthread_mutex_lock(&apply->lock);
+	LL_APPEND(apply->pending, transaction);
+	apply->status.pending++;
+	pthread_cond_signal(&apply->queued);
+	pthread_mutex_unlock(&apply->lock);
+
+	transaction = NULL;
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (transaction) {
+		system_change_apply_transaction_free(transaction);
+	}
+
+	return error;
+}
+
+void system_change_apply_discard(system_change_apply_t *apply)
+{
+	if (apply->plan) {
+		system_change_apply_transaction_free(apply->plan);
+		apply->plan = NULL;
+	}
+}
+
+void system_change_apply_wait(system_change_apply_t *apply)
+{
+	pthread_mutex_lock(&apply->lock);
+	while (apply->pending || apply->applying) {
+		// the caller runs in a change event - waiting for the whole window could hit the callback timeout
+		apply->flush = true;
+		pthread_cond_signal(&apply->queued);
+		pthread_cond_wait(&apply->idle, &apply->lock);
+	}
+	pthread_mutex_unlock(&apply->lock);
+}
+
+void system_change_apply_set_window(system_change_apply_t *apply, uint32_t window)
+{
+	pthread_mutex_lock(&apply->lock);
+	apply->window = window;
+	pthread_mutex_unlock(&apply->lock);
+}
+
+void system_change_apply_get_status(system_change_apply_t *apply, system_change_apply_status_t *status)
+{
+	pthread_mutex_lock(&apply->lock);
+	*status = apply->status;
+	pthread_mutex_unlock(&apply->lock);
+}
+
+void system_change_apply_free(system_change_apply_t *apply)
+{
+	if (apply->running) {
+		pthread_mutex_lock(&apply->lock);
+		apply->stop = true;
+		pthread_cond_signal(&apply->queued);
+		pthread_mutex_unlock(&apply->lock);
+
+		pthread_join(apply->worker, NULL);
+		apply->running = false;
+	}
+
+	system_change_apply_discard(apply);
+
+	pthread_cond_destroy(&apply->idle);
+	pthread_cond_destroy(&apply->queued);
+	pthread_mutex_destroy(&apply->lock);
+}
+
+static int system_change_apply_add(system_change_apply_t *apply, const char *name, system_change_apply_cb execute, system_change_apply_free_cb free_cb, system_change_apply_copy_cb copy_cb, bool state, void *data)
+{
+	int error = 0;
+	system_change_apply_op_t *op = NULL;
+
+	if (!apply->plan) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to plan %s - no transaction started", name);
+		goto error_out;
+	}
+
+	op = malloc(sizeof(*op));
+	if (!op) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "malloc() failed");
+		goto error_out;
+	}
+
+	*op = (system_change_apply_op_t){
+		.name = name,
+		.execute = execute,
+		.free = free_cb,
+		.copy = copy_cb,
+		.state = state,
+		.data = data,
+	};
+
+	LL_APPEND(apply->plan->ops, op);
+
+	SRPLG_LOG_DBG(PLUGIN_NAME, "Planned %s for request %u", name, apply->plan->request_id);
+
+	goto out;
+
+error_out:
+	error = -1;
+
+	if (free_cb && data) {
+		free_cb(data);
+	}
+
+out:
+	return error;
+}
+
+static void *system_change_apply_worker(void *arg)
+{
+	system_change_apply_t *apply = arg;
+	system_change_apply_transaction_t *transaction = NULL, *tmp = NULL;
+
+	pthread_mutex_lock(&apply->lock);
+
+	for (;;) {
+		while (!apply->pending && !apply->stop) {
+			pthread_cond_wait(&apply->queued, &apply->lock);
+		}
+
+		// queued transactions are applied before stopping - they were already committed in the datastore
+		if (!apply->pending) {
+			break;
+		}
+
+		if (apply->window && !apply->stop) {
+			// collect commits following the first one and apply all of them at once
+			system_change_apply_coalesce(apply);
+
+			apply->applying = apply->pending;
+			apply->pending = NULL;
+		} else {
+			transaction = apply->pending;
+			LL_DELETE(apply->pending, transaction);
+			transaction->next = NULL;
+			apply->applying = transaction;
+		}
+
+		pthread_mutex_unlock(&apply->lock);
+
+		system_change_apply_execute(apply, apply->applying);
+
+		pthread_mutex_lock(&apply->lock);
+
+		LL_FOREACH_SAFE(apply->applying, transaction, tmp)
+		{
+			LL_DELETE(apply->applying, transaction);
+
+			apply->status.pending--;
+			if (transaction->failed) {
+				apply->status.failed++;
+			} else {
+				apply->status.last_applied_request_id = transaction->request_id;
+			}
+
+			system_change_apply_transaction_free(transaction);
+		}
+
+		if (!apply->pending) {
+			apply->flush = false;
+			pthread_cond_broadcast(&apply->idle);
+		}
+	}
+
+	pthread_mutex_unlock(&apply->lock);
+
+	return NULL;
+}
+
+static void system_change_apply_coalesce(system_change_apply_t *apply)
+{
+	struct timespec deadline = {0};
+
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += apply->window / 1000;
+	deadline.tv_nsec += (long) (apply->window % 1000) * 1000000L;
+	if (deadline.tv_nsec >= 1000000000L) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+
+	// woken up on every queued commit - keep waiting until the window expires, the worker is stopped or the queue is flushed
+	while (!apply->stop && !apply->flush) {
+		if (pthread_cond_timedwait(&apply->queued, &apply->lock, &deadline) == ETIMEDOUT) {
+			break;
+		}
+	}
+}
+
+static void system_change_apply_execute(system_change_apply_t *apply, system_change_apply_transaction_t *batch)
+{
+	system_change_apply_transaction_t *transaction = NULL;
+	system_change_apply_op_t *op = NULL;
+
+	LL_FOREACH(batch, transaction)
+	{
+		SRPLG_LOG_INF(PLUGIN_NAME, "Applying changes of request %u", transaction->request_id);
+
+		// operations work on different parts of the system - a failed one does not stop the rest
+		LL_FOREACH(transaction->ops, op)
+		{
+			if (system_change_apply_superseded(transaction, op)) {
+				SRPLG_LOG_DBG(PLUGIN_NAME, "Skipping %s for request %u - superseded by a later commit", op->name, transaction->request_id);
+				continue;
+			}
+
+			if (op->execute(apply->priv, op->data)) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "Applying %s for request %u failed", op->name, transaction->request_id);
+				transaction->failed = true;
+			}
+		}
+
+		if (apply->finish && apply->finish(apply->priv, transaction->failed)) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Finishing request %u failed", transaction->request_id);
+			transaction->failed = true;
+		}
+	}
+}
+
+static bool system_change_apply_superseded(system_change_apply_transaction_t *transaction, system_change_apply_op_t *op)
+{
+	system_change_apply_transaction_t *later = NULL;
+	system_change_apply_op_t *later_op = NULL;
+
+	if (!op->state) {
+		return false;
+	}
+
+	LL_FOREACH(transaction->next, later)
+	{
+		LL_FOREACH(later->ops, later_op)
+		{
+			if (later_op->state && !strcmp(later_op->name, op->name)) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+static void system_change_apply_transaction_free(system_change_apply_transaction_t *transaction)
+{
+	system_change_apply_op_t *op = NULL, *tmp = NULL;
+
+	LL_FOREACH_SAFE(transaction->ops, op, tmp)
+	{
+		LL_DELETE(transaction->ops, op);
+		if (op->free && op->data) {
+			op->free(op->data);
+		}
+		free(op);
+	}
+
+	free(transaction);
+}
@@ -0,0 +1,105 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_SUBSCRIPTION_CHANGE_APPLY_H
+#define SYSTEM_PLUGIN_SUBSCRIPTION_CHANGE_APPLY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <pthread.h>
+
+typedef struct system_change_apply_op_s system_change_apply_op_t;
+typedef struct system_change_apply_transaction_s system_change_apply_transaction_t;
+typedef struct system_change_apply_status_s system_change_apply_status_t;
+typedef struct system_change_apply_s system_change_apply_t;
+
+// executes a planned operation on the system - called from the worker thread
+typedef int (*system_change_apply_cb)(void *priv, void *data);
+typedef void (*system_change_apply_free_cb)(void *data);
+typedef int (*system_change_apply_copy_cb)(void *data, void **copy);
+
+// finishes an applied transaction - edits staged by its operations are committed together here
+typedef int (*system_change_apply_finish_cb)(void *priv, bool failed);
+
+struct system_change_apply_op_s {
+	const char *name;				  ///< Name of the operation used for logging.
+	system_change_apply_cb execute;	  ///< Applies the planned data on the system.
+	system_change_apply_free_cb free; ///< Frees the planned data. Can be NULL.
+	system_change_apply_copy_cb copy; ///< Copies the planned data for the next transaction. Can be NULL.
+	bool state;						  ///< Data is the whole desired state of its part of the system - replaced by later operations of the same name.
+	void *data;						  ///< Data planned in the change event - owned by the operation.
+	system_change_apply_op_t *next;
+};
+
+struct system_change_apply_transaction_s {
+	uint32_t request_id;		   ///< Request ID of the sysrepo event which planned the operations.
+	system_change_apply_op_t *ops; ///< Operations in the order they were planned.
+	bool failed;				   ///< Applying at least one operation failed.
+	system_change_apply_transaction_t *next;
+};
+
+struct system_change_apply_status_s {
+	uint32_t pending;				  ///< Committed transactions not yet applied on the system.
+	uint32_t last_applied_request_id; ///< Request ID of the last applied transaction.
+	uint32_t failed;				  ///< Number of transactions which failed to be applied.
+};
+
+// changes are validated and planned in SR_EV_CHANGE and applied on a worker thread after SR_EV_DONE
+struct system_change_apply_s {
+	void *priv;									 ///< Passed to every executed operation.
+	system_change_apply_finish_cb finish;		 ///< Called once after the operations of each transaction. Can be NULL.
+	pthread_t worker;							 ///< Thread executing committed transactions.
+	pthread_mutex_t lock;						 ///< Protects the pending list, the worker state and the status.
+	pthread_cond_t queued;						 ///< Signaled when a transaction is queued or the worker should stop.
+	pthread_cond_t idle;						 ///< Signaled when all queued transactions are applied.
+	bool running;								 ///< Worker thread started.
+	bool stop;									 ///< Worker thread should stop after applying queued transactions.
+	uint32_t window;							 ///< Milliseconds the worker waits for more commits to coalesce with the first queued one - 0 disables coalescing.
+	bool flush;									 ///< A change event waits for the system state - queued commits are applied without waiting out the window.
+	system_change_apply_transaction_t *plan;	 ///< Transaction planned in the current change event - used only by the subscription thread.
+	system_change_apply_transaction_t *pending;	 ///< Committed transactions waiting for the worker.
+	system_change_apply_transaction_t *applying; ///< Transactions being applied by the worker.
+	system_change_apply_status_t status;		 ///< Status exposed as operational data.
+};
+
+int system_change_apply_init(system_change_apply_t *apply, void *priv, system_change_apply_finish_cb finish);
+
+// start planning a new transaction - operations left from an unfinished transaction are discarded
+int system_change_apply_begin(system_change_apply_t *apply, uint32_t request_id);
+
+// add an operation to the current transaction - data is owned by the operation even if planning fails
+int system_change_apply_plan(system_change_apply_t *apply, const char *name, system_change_apply_cb execute, system_change_apply_free_cb free_cb, void *data);
+
+// add an operation carrying the whole desired state of its part of the system - when coalescing, only the last one of the same name is applied
+int system_change_apply_plan_state(system_change_apply_t *apply, const char *name, system_change_apply_cb execute, system_change_apply_free_cb free_cb, system_change_apply_copy_cb copy_cb, void *data);
+
+// copy the last desired state of the given name committed but not yet applied - found is false if the system state is up to date
+int system_change_apply_get_state(system_change_apply_t *apply, const char *name, bool *found, void **data);
+
+// queue the planned transaction for the worker - called on SR_EV_DONE
+int system_change_apply_commit(system_change_apply_t *apply, uint32_t request_id);
+
+// drop the planned transaction - called on SR_EV_ABORT and failed change events
+void system_change_apply_discard(system_change_apply_t *apply);
+
+// apply committed transactions without waiting out the coalescing window and wait until they are applied - used before reading system state
+void system_change_apply_wait(system_change_apply_t *apply);
+
+void system_change_apply_set_window(system_change_apply_t *apply, uint32_t window);
+
+void system_change_apply_get_status(system_change_apply_t *apply, system_change_apply_status_t *status);
+
+// apply queued transactions and stop the worker
+void system_change_apply_free(system_change_apply_t *apply);
+
+#endif // SYSTEM_PLUGIN_SUBSCRIPTION_CHANGE_APPLY_H
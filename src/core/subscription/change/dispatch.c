@@ -0,0 +1,226 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "dispatch.h"
+#include "core/common.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <sysrepo.h>
+#include <libyang/libyang.h>
+
+static int system_change_dispatcher_resolve(system_change_dispatcher_t *dispatcher, const struct ly_ctx *ly_ctx);
+static void system_change_dispatcher_table_free(system_change_dispatcher_t *dispatcher);
+
+void system_change_dispatcher_init(system_change_dispatcher_t *dispatcher)
+{
+	*dispatcher = (system_change_dispatcher_t){0};
+}
+
+int system_change_dispatcher_set_routes(system_change_dispatcher_t *dispatcher, const system_change_route_t *routes, size_t routes_count)
+{
+	int error = 0;
+
+	system_change_dispatcher_free(dispatcher);
+
+	dispatcher->routes = malloc(sizeof(system_change_route_t) * routes_count);
+	if (!dispatcher->routes) {
+		goto error_out;
+	}
+
+	memcpy(dispatcher->routes, routes, sizeof(system_change_route_t) * routes_count);
+	dispatcher->routes_count = routes_count;
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	return error;
+}
+
+int system_change_dispatcher_dispatch(system_change_dispatcher_t *dispatcher, void *priv, sr_session_ctx_t *session, const char *xpath)
+{
+	int error = 0;
+
+	// sysrepo
+	sr_change_iter_t *changes_iterator = NULL;
+	sr_change_oper_t operation = SR_OP_CREATED;
+	const struct lyd_node *node = NULL;
+	const char *prev_value = NULL;
+	const char *prev_list = NULL;
+	int prev_default = 0;
+
+	srpc_change_ctx_t change_ctx = {0};
+	system_change_route_entry_t *entry = NULL;
+
+	// groups touched in this walk - in order of the first routed node
+	const system_change_group_t *groups[SYSTEM_CHANGE_DISPATCH_GROUPS_MAX] = {0};
+	size_t groups_count = 0;
+	size_t i = 0;
+
+	error = sr_get_changes_iter(session, xpath, &changes_iterator);
+	if (error != SR_ERR_OK) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_get_changes_iter() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	while (sr_get_change_tree_next(session, changes_iterator, &operation, &node, &prev_value, &prev_list, &prev_default) == SR_ERR_OK) {
+		// (re)build the table if the schema context changed since the last walk
+		if (dispatcher->ly_ctx != LYD_CTX(node) || dispatcher->ly_ctx_change_count != ly_ctx_get_change_count(LYD_CTX(node))) {
+			error = system_change_dispatcher_resolve(dispatcher, LYD_CTX(node));
+			if (error) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "system_change_dispatcher_resolve() error (%d)", error);
+				goto error_out;
+			}
+		}
+
+		// containers, list instances and leafs without any effect on the system are not routed
+		HASH_FIND_PTR(dispatcher->table, &node->schema, entry);
+		if (!entry) {
+			continue;
+		}
+
+		if (entry->route->group) {
+			for (i = 0; i < groups_count; i++) {
+				if (groups[i] == entry->route->group) {
+					break;
+				}
+			}
+
+			if (i == groups_count) {
+				if (groups_count == SYSTEM_CHANGE_DISPATCH_GROUPS_MAX) {
+					SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to handle more than %d change groups", SYSTEM_CHANGE_DISPATCH_GROUPS_MAX);
+					goto error_out;
+				}
+
+				groups[groups_count++] = entry->route->group;
+
+				if (entry->route->group->prepare) {
+					error = entry->route->group->prepare(priv, session);
+					if (error) {
+						SRPLG_LOG_ERR(PLUGIN_NAME, "Preparing %s changes failed (%d)", entry->route->group->name, error);
+						goto error_out;
+					}
+				}
+			}
+		}
+
+		change_ctx.operation = operation;
+		change_ctx.node = node;
+		change_ctx.previous_value = prev_value;
+
+		error = entry->route->cb(priv, session, &change_ctx);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Change callback for %s failed (%d)", entry->route->path, error);
+			goto error_out;
+		}
+	}
+
+	for (i = 0; i < groups_count; i++) {
+		if (groups[i]->apply) {
+			error = groups[i]->apply(priv, session);
+			if (error) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "Applying %s changes failed (%d)", groups[i]->name, error);
+				goto error_out;
+			}
+		}
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	for (i = 0; i < groups_count; i++) {
+		if (groups[i]->cleanup) {
+			groups[i]->cleanup(priv);
+		}
+	}
+
+	if (changes_iterator) {
+		sr_free_change_iter(changes_iterator);
+	}
+
+	return error;
+}
+
+void system_change_dispatcher_free(system_change_dispatcher_t *dispatcher)
+{
+	system_change_dispatcher_table_free(dispatcher);
+
+	if (dispatcher->routes) {
+		free(dispatcher->routes);
+	}
+
+	system_change_dispatcher_init(dispatcher);
+}
+
+static int system_change_dispatcher_resolve(system_change_dispatcher_t *dispatcher, const struct ly_ctx *ly_ctx)
+{
+	int error = 0;
+	const struct lysc_node *schema = NULL;
+	system_change_route_entry_t *entry = NULL;
+
+	system_change_dispatcher_table_free(dispatcher);
+
+	for (size_t i = 0; i < dispatcher->routes_count; i++) {
+		const system_change_route_t *route = &dispatcher->routes[i];
+
+		// nodes of disabled features are not compiled - nothing can be changed there
+		schema = lys_find_path(ly_ctx, NULL, route->path, 0);
+		if (!schema) {
+			SRPLG_LOG_DBG(PLUGIN_NAME, "Skipping route for %s - node not found in the current context", route->path);
+			continue;
+		}
+
+		entry = malloc(sizeof(*entry));
+		if (!entry) {
+			goto error_out;
+		}
+
+		entry->schema = schema;
+		entry->route = route;
+
+		HASH_ADD_PTR(dispatcher->table, schema, entry);
+	}
+
+	dispatcher->ly_ctx = ly_ctx;
+	dispatcher->ly_ctx_change_count = ly_ctx_get_change_count(ly_ctx);
+
+	goto out;
+
+error_out:
+	error = -1;
+	system_change_dispatcher_table_free(dispatcher);
+
+out:
+	return error;
+}
+
+static void system_change_dispatcher_table_free(system_change_dispatcher_t *dispatcher)
+{
+	system_change_route_entry_t *entry = NULL, *tmp = NULL;
+
+	HASH_ITER(hh, dispatcher->table, entry, tmp)
+	{
+		HASH_DEL(dispatcher->table, entry);
+		free(entry);
+	}
+
+	dispatcher->table = NULL;
+	dispatcher->ly_ctx = NULL;
+	dispatcher->ly_ctx_change_count = 0;
+}
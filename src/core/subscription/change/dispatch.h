@@ -0,0 +1,67 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_SUBSCRIPTION_CHANGE_DISPATCH_H
+#define SYSTEM_PLUGIN_SUBSCRIPTION_CHANGE_DISPATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <sysrepo_types.h>
+#include <srpc.h>
+
+#include <uthash.h>
+
+// maximum number of different groups touched in one changes walk
+#define SYSTEM_CHANGE_DISPATCH_GROUPS_MAX 8
+
+typedef struct system_change_group_s system_change_group_t;
+typedef struct system_change_route_s system_change_route_t;
+typedef struct system_change_route_entry_s system_change_route_entry_t;
+typedef struct system_change_dispatcher_s system_change_dispatcher_t;
+
+typedef int (*system_change_cb)(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx);
+
+// handlers working on the same system data - data is loaded once before the first routed node of the group and stored once after all changes
+struct system_change_group_s {
+	const char *name;
+	int (*prepare)(void *priv, sr_session_ctx_t *session); ///< Called before the first change node of the group is handled. Can be NULL.
+	int (*apply)(void *priv, sr_session_ctx_t *session);   ///< Called after all change nodes have been handled. Can be NULL.
+	void (*cleanup)(void *priv);						   ///< Always called after apply, even on errors. Can be NULL.
+};
+
+struct system_change_route_s {
+	const char *path;					///< Data path of the routed schema node.
+	system_change_cb cb;				///< Callback called for every change of the node.
+	const system_change_group_t *group; ///< Group of the route - NULL for standalone callbacks.
+};
+
+struct system_change_route_entry_s {
+	const struct lysc_node *schema;
+	const system_change_route_t *route;
+	UT_hash_handle hh;
+};
+
+struct system_change_dispatcher_s {
+	system_change_route_t *routes;		///< Copy of the routes used for resolving the table.
+	size_t routes_count;				///< Number of routes.
+	const struct ly_ctx *ly_ctx;		///< Context used for resolving the table.
+	uint16_t ly_ctx_change_count;		///< Change count of the context used for resolving the table.
+	system_change_route_entry_t *table; ///< Routes indexed by schema node.
+};
+
+void system_change_dispatcher_init(system_change_dispatcher_t *dispatcher);
+int system_change_dispatcher_set_routes(system_change_dispatcher_t *dispatcher, const system_change_route_t *routes, size_t routes_count);
+int system_change_dispatcher_dispatch(system_change_dispatcher_t *dispatcher, void *priv, sr_session_ctx_t *session, const char *xpath);
+void system_change_dispatcher_free(system_change_dispatcher_t *dispatcher);
+
+#endif // SYSTEM_PLUGIN_SUBSCRIPTION_CHANGE_DISPATCH_H
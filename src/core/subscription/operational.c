@@ -13,11 +13,13 @@
 #include "operational.h"
 #include "core/common.h"
 #include "core/ly_tree.h"
+#include "core/context.h"
 
 #include <sys/sysinfo.h>
 #include <sys/utsname.h>
 #include <string.h>
 #include <errno.h>
+#include <inttypes.h>
 
 #include <sysrepo.h>
 #include <assert.h>
@@ -146,6 +148,157 @@ out:
 	return error;
 }
 
+int system_subscription_operational_apply(sr_session_ctx_t *session, uint32_t sub_id, const char *module_name, const char *path, const char *request_xpath, uint32_t request_id, struct lyd_node **parent, void *private_data)
+{
+	int error = SR_ERR_OK;
+	system_ctx_t *ctx = (system_ctx_t *) private_data;
+	system_change_apply_status_t status = {0};
+	const struct ly_ctx *ly_ctx = NULL;
+	struct lyd_node *apply_container_node = *parent;
+	char value_buffer[11] = {0};
+
+	system_change_apply_get_status(&ctx->change_apply, &status);
+
+	// make sure the passed parent node is the apply container node - the one we subscribed to
+	assert(strcmp(LYD_NAME(apply_container_node), "apply") == 0);
+
+	snprintf(value_buffer, sizeof(value_buffer), "%u", status.pending);
+	error = system_ly_tree_create_plugin_apply_pending_transactions(ly_ctx, apply_container_node, value_buffer);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ly_tree_create_plugin_apply_pending_transactions() error (%d)", error);
+		goto error_out;
+	}
+
+	snprintf(value_buffer, sizeof(value_buffer), "%u", status.last_applied_request_id);
+	error = system_ly_tree_create_plugin_apply_last_applied_request_id(ly_ctx, apply_container_node, value_buffer);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ly_tree_create_plugin_apply_last_applied_request_id() error (%d)", error);
+		goto error_out;
+	}
+
+	snprintf(value_buffer, sizeof(value_buffer), "%u", status.failed);
+	error = system_ly_tree_create_plugin_apply_failed_transactions(ly_ctx, apply_container_node, value_buffer);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ly_tree_create_plugin_apply_failed_transactions() error (%d)", error);
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = SR_ERR_CALLBACK_FAILED;
+
+out:
+	return error;
+}
+
+int system_subscription_operational_home_removal(sr_session_ctx_t *session, uint32_t sub_id, const char *module_name, const char *path, const char *request_xpath, uint32_t request_id, struct lyd_node **parent, void *private_data)
+{
+	int error = SR_ERR_OK;
+	system_ctx_t *ctx = (system_ctx_t *) private_data;
+	system_authentication_trash_status_t status = {0};
+	const struct ly_ctx *ly_ctx = NULL;
+	struct lyd_node *home_removal_container_node = *parent;
+	char value_buffer[21] = {0};
+
+	system_authentication_trash_get_status(&ctx->home_trash, &status);
+
+	// make sure the passed parent node is the home-removal container node - the one we subscribed to
+	assert(strcmp(LYD_NAME(home_removal_container_node), "home-removal") == 0);
+
+	snprintf(value_buffer, sizeof(value_buffer), "%u", status.pending_homes);
+	error = system_ly_tree_create_plugin_home_removal_pending_homes(ly_ctx, home_removal_container_node, value_buffer);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ly_tree_create_plugin_home_removal_pending_homes() error (%d)", error);
+		goto error_out;
+	}
+
+	snprintf(value_buffer, sizeof(value_buffer), "%" PRIu64, status.pending_entries);
+	error = system_ly_tree_create_plugin_home_removal_pending_entries(ly_ctx, home_removal_container_node, value_buffer);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ly_tree_create_plugin_home_removal_pending_entries() error (%d)", error);
+		goto error_out;
+	}
+
+	snprintf(value_buffer, sizeof(value_buffer), "%" PRIu64, status.pending_bytes);
+	error = system_ly_tree_create_plugin_home_removal_pending_bytes(ly_ctx, home_removal_container_node, value_buffer);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ly_tree_create_plugin_home_removal_pending_bytes() error (%d)", error);
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = SR_ERR_CALLBACK_FAILED;
+
+out:
+	return error;
+}
+
+int system_subscription_operational_user_import(sr_session_ctx_t *session, uint32_t sub_id, const char *module_name, const char *path, const char *request_xpath, uint32_t request_id, struct lyd_node **parent, void *private_data)
+{
+	int error = SR_ERR_OK;
+	system_ctx_t *ctx = (system_ctx_t *) private_data;
+	system_authentication_bulk_status_t status = {0};
+	const struct ly_ctx *ly_ctx = NULL;
+	struct lyd_node *user_import_container_node = *parent;
+	char value_buffer[21] = {0};
+
+	system_authentication_bulk_get_status(&ctx->user_import, &status);
+
+	// make sure the passed parent node is the user-import container node - the one we subscribed to
+	assert(strcmp(LYD_NAME(user_import_container_node), "user-import") == 0);
+
+	error = system_ly_tree_create_plugin_user_import_running(ly_ctx, user_import_container_node, status.running ? "true" : "false");
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ly_tree_create_plugin_user_import_running() error (%d)", error);
+		goto error_out;
+	}
+
+	error = system_ly_tree_create_plugin_user_import_failed(ly_ctx, user_import_container_node, status.failed ? "true" : "false");
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ly_tree_create_plugin_user_import_failed() error (%d)", error);
+		goto error_out;
+	}
+
+	snprintf(value_buffer, sizeof(value_buffer), "%u", status.imported_users);
+	error = system_ly_tree_create_plugin_user_import_imported_users(ly_ctx, user_import_container_node, value_buffer);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ly_tree_create_plugin_user_import_imported_users() error (%d)", error);
+		goto error_out;
+	}
+
+	snprintf(value_buffer, sizeof(value_buffer), "%u", status.batches);
+	error = system_ly_tree_create_plugin_user_import_batches(ly_ctx, user_import_container_node, value_buffer);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ly_tree_create_plugin_user_import_batches() error (%d)", error);
+		goto error_out;
+	}
+
+	snprintf(value_buffer, sizeof(value_buffer), "%" PRIu64, status.processed_bytes);
+	error = system_ly_tree_create_plugin_user_import_processed_bytes(ly_ctx, user_import_container_node, value_buffer);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ly_tree_create_plugin_user_import_processed_bytes() error (%d)", error);
+		goto error_out;
+	}
+
+	snprintf(value_buffer, sizeof(value_buffer), "%" PRIu64, status.total_bytes);
+	error = system_ly_tree_create_plugin_user_import_total_bytes(ly_ctx, user_import_container_node, value_buffer);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ly_tree_create_plugin_user_import_total_bytes() error (%d)", error);
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = SR_ERR_CALLBACK_FAILED;
+
+out:
+	return error;
+}
+
 static int system_get_platform_info(struct system_platform *platform)
 {
 	struct utsname uname_data = {0};
@@ -12,9 +12,15 @@
  */
 #include "rpc.h"
 #include "core/common.h"
+#include "core/context.h"
+#include "core/api/system/authentication/bulk.h"
+#include "core/api/system/authentication/load.h"
+#include "core/data/system/authentication/local_user/list.h"
 
 #include <assert.h>
+#include <string.h>
 #include <sysrepo.h>
+#include <sysrepo/values.h>
 
 #include <time.h>
 
@@ -75,6 +81,99 @@ int system_subscription_rpc_shutdown(sr_session_ctx_t *session, uint32_t subscri
 	return error;
 }
 
+int system_subscription_rpc_import_users(sr_session_ctx_t *session, uint32_t subscription_id, const char *op_path, const sr_val_t *input, const size_t input_cnt, sr_event_t event, uint32_t request_id, sr_val_t **output, size_t *output_cnt, void *private_data)
+{
+	int error = SR_ERR_OK;
+	system_ctx_t *ctx = (system_ctx_t *) private_data;
+	const char *path = NULL;
+	uint32_t batch_size = SYSTEM_AUTHENTICATION_BULK_BATCH_SIZE;
+
+	for (size_t i = 0; i < input_cnt; i++) {
+		const char *name = strrchr(input[i].xpath, '/') + 1;
+
+		if (!strcmp(name, "path")) {
+			path = input[i].data.string_val;
+		} else if (!strcmp(name, "batch-size")) {
+			batch_size = input[i].data.uint32_val;
+		}
+	}
+
+	// path is mandatory
+	assert(path != NULL);
+
+	// the file is imported in the background - progress is available in the user-import container
+	error = system_authentication_bulk_import(&ctx->user_import, sr_session_get_connection(session), path, batch_size);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_bulk_import() error (%d)", error);
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = SR_ERR_CALLBACK_FAILED;
+
+out:
+	return error;
+}
+
+int system_subscription_rpc_export_users(sr_session_ctx_t *session, uint32_t subscription_id, const char *op_path, const sr_val_t *input, const size_t input_cnt, sr_event_t event, uint32_t request_id, sr_val_t **output, size_t *output_cnt, void *private_data)
+{
+	int error = SR_ERR_OK;
+	system_ctx_t *ctx = (system_ctx_t *) private_data;
+	system_local_user_element_t *user_head = NULL;
+	uint32_t count = 0;
+
+	// assert only one input value - path
+	assert(input_cnt == 1);
+
+	// committed user changes are on the system only once applied
+	system_change_apply_wait(&ctx->change_apply);
+
+	// users are read from the user database into a list - no data tree is built
+	system_local_user_list_init(&user_head);
+
+	error = system_authentication_load_user(ctx, &user_head);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_load_user() error (%d)", error);
+		goto error_out;
+	}
+
+	error = system_authentication_bulk_export(user_head, input[0].data.string_val, &count);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_bulk_export() error (%d)", error);
+		goto error_out;
+	}
+
+	SRPLG_LOG_INF(PLUGIN_NAME, "Exported %u users to %s", count, input[0].data.string_val);
+
+	error = sr_new_values(1, output);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_new_values() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	error = sr_val_set_xpath(&(*output)[0], SYSTEM_PLUGIN_EXPORT_USERS_RPC_YANG_PATH "/exported-users");
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_val_set_xpath() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	(*output)[0].type = SR_UINT32_T;
+	(*output)[0].data.uint32_val = count;
+	*output_cnt = 1;
+
+	goto out;
+
+error_out:
+	error = SR_ERR_CALLBACK_FAILED;
+
+out:
+	system_local_user_list_free(&user_head);
+
+	return error;
+}
+
 static int system_set_current_datetime(const char *current_datetime)
 {
 	struct tm t = {0};
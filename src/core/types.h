@@ -13,18 +13,31 @@
 #ifndef SYSTEM_PLUGIN_TYPES_H
 #define SYSTEM_PLUGIN_TYPES_H
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <sysrepo_types.h>
+#include <uthash.h>
+
+#include "umgmt/types.h"
+
 // DNS
 
 typedef struct system_ntp_server_s system_ntp_server_t;
 typedef struct system_ntp_server_element_s system_ntp_server_element_t;
+typedef struct system_ntp_server_change_s system_ntp_server_change_t;
 typedef struct system_dns_search_s system_dns_search_t;
 typedef struct system_dns_search_element_s system_dns_search_element_t;
 typedef struct system_dns_server_s system_dns_server_t;
 typedef struct system_dns_server_element_s system_dns_server_element_t;
+typedef struct system_dns_resolver_s system_dns_resolver_t;
+typedef struct system_dns_resolver_cache_s system_dns_resolver_cache_t;
 typedef struct system_ip_address_s system_ip_address_t;
 typedef union system_ip_address_value_u system_ip_address_value_t;
 typedef struct system_local_user_s system_local_user_t;
 typedef struct system_local_user_element_s system_local_user_element_t;
+typedef struct system_local_user_change_s system_local_user_change_t;
+typedef struct system_local_user_changes_s system_local_user_changes_t;
+typedef struct system_local_user_walk_s system_local_user_walk_t;
 typedef struct system_authorized_key_s system_authorized_key_t;
 typedef struct system_authorized_key_element_s system_authorized_key_element_t;
 
@@ -54,6 +67,26 @@ struct system_ntp_server_s {
 struct system_ntp_server_element_s {
 	system_ntp_server_t server;
 	struct system_ntp_server_element_s *next;
+	struct system_ntp_server_element_s *prev;
+	UT_hash_handle hh; ///< Elements by name.
+};
+
+enum system_ntp_server_change_field_e {
+	SYSTEM_NTP_SERVER_CHANGE_ADDRESS = 1 << 0,
+	SYSTEM_NTP_SERVER_CHANGE_PORT = 1 << 1,
+	SYSTEM_NTP_SERVER_CHANGE_ASSOCIATION_TYPE = 1 << 2,
+	SYSTEM_NTP_SERVER_CHANGE_IBURST = 1 << 3,
+	SYSTEM_NTP_SERVER_CHANGE_PREFER = 1 << 4,
+};
+
+struct system_ntp_server_change_s {
+	char *name;					///< Datastore server name - key of the record.
+	sr_change_oper_t operation; ///< Operation on the whole server - based on the change of the name key.
+	char *previous_address;		///< Address of the server on the system before the change.
+	uint32_t changed;			///< Changed fields of the server - system_ntp_server_change_field_e flags.
+	system_ntp_server_t server; ///< New values of the changed fields.
+	UT_hash_handle hh;			///< Records by name.
+	UT_hash_handle hh_address;	///< Records by previous address - used while applying changes.
 };
 
 struct system_dns_search_s {
@@ -71,11 +104,38 @@ struct system_dns_server_s {
 struct system_dns_search_element_s {
 	system_dns_search_t search;
 	struct system_dns_search_element_s *next;
+	struct system_dns_search_element_s *prev;
+	UT_hash_handle hh; ///< Elements by domain.
 };
 
 struct system_dns_server_element_s {
 	system_dns_server_t server;
 	struct system_dns_server_element_s *next;
+	struct system_dns_server_element_s *prev;
+	UT_hash_handle hh;		   ///< Elements by name.
+	UT_hash_handle hh_address; ///< Elements by address.
+};
+
+// parts of the resolver configuration changed in a transaction
+enum system_dns_resolver_change_e {
+	SYSTEM_DNS_RESOLVER_CHANGE_SEARCH = 1 << 0,
+	SYSTEM_DNS_RESOLVER_CHANGE_SERVER = 1 << 1,
+};
+
+struct system_dns_resolver_s {
+	system_dns_search_element_t *search;
+	system_dns_server_element_t *servers;
+	uint32_t changed; ///< Parts to store on the system - system_dns_resolver_change_e flags.
+};
+
+// resolved state kept in sync by PropertiesChanged signals - stale parts are queried directly
+struct system_dns_resolver_cache_s {
+	system_dns_search_element_t *search;
+	system_dns_server_element_t *servers;
+	uint32_t valid;			 ///< Parts in sync with resolved - system_dns_resolver_change_e flags.
+	uint32_t bus_generation; ///< Bus connection the signal match was added on.
+	uint64_t search_expires; ///< Monotonic time in ms after which search domains are queried again.
+	uint64_t server_expires; ///< Monotonic time in ms after which servers are queried again.
 };
 
 struct system_local_user_s {
@@ -87,6 +147,38 @@ struct system_local_user_s {
 struct system_local_user_element_s {
 	system_local_user_t user;
 	system_local_user_element_t *next;
+	system_local_user_element_t *prev;
+	UT_hash_handle hh; ///< Elements by name.
+};
+
+enum system_local_user_change_field_e {
+	SYSTEM_LOCAL_USER_CHANGE_PASSWORD = 1 << 0,
+};
+
+struct system_local_user_change_s {
+	char *name;					///< User name - key of the record.
+	sr_change_oper_t operation; ///< Operation on the whole user - based on the change of the name key.
+	uint32_t changed;			///< Changed fields of the user - system_local_user_change_field_e flags.
+	char *password;				///< New password hash - NULL removes the password.
+	struct {
+		system_authorized_key_element_t *created;
+		system_authorized_key_element_t *modified; ///< Current keys of the user - loaded with the first modified key and changed in place.
+		system_authorized_key_element_t *deleted;
+	} keys;			   ///< Authorized keys delta of the user.
+	bool keys_loaded;  ///< Current keys of the user loaded into the modified keys.
+	UT_hash_handle hh; ///< Records by user name - in order of the first change of the user.
+};
+
+struct system_local_user_changes_s {
+	um_db_t *db;					   ///< User database of the transaction - loaded once before the changes and stored once after applying them.
+	system_local_user_change_t *users; ///< Per-user change records.
+};
+
+struct system_local_user_walk_s {
+	const struct lyd_node *user_node;	  ///< User list instance in the changes tree - nodes of one user are walked one after another.
+	system_local_user_change_t *record;	  ///< Change record of the walked user.
+	const struct lyd_node *key_node;	  ///< Last handled authorized-key list instance.
+	system_authorized_key_element_t *key; ///< Key element of the last handled authorized-key list instance.
 };
 
 struct system_authorized_key_s {
@@ -98,6 +190,8 @@ struct system_authorized_key_s {
 struct system_authorized_key_element_s {
 	system_authorized_key_t key;
 	system_authorized_key_element_t *next;
+	system_authorized_key_element_t *prev;
+	UT_hash_handle hh; ///< Elements by name.
 };
 
 #endif // SYSTEM_PLUGIN_TYPES_H
\ No newline at end of file
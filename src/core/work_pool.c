@@ -0,0 +1,79 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "work_pool.h"
+#include "common.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <sysrepo.h>
+
+static void *system_work_pool_thread(void *arg);
+
+void system_work_pool_run(size_t count, system_work_pool_cb worker, void *arg)
+{
+	system_work_pool_t pool = {
+		.count = count,
+		.next = 0,
+		.worker = worker,
+		.arg = arg,
+	};
+	pthread_t workers[SYSTEM_WORK_POOL_WORKERS_MAX - 1];
+	size_t worker_count = 0;
+	size_t max_workers = 0;
+	long cpus = 0;
+
+	if (!count) {
+		return;
+	}
+
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	max_workers = cpus > 0 ? (size_t) cpus : 1;
+	if (max_workers > SYSTEM_WORK_POOL_WORKERS_MAX) {
+		max_workers = SYSTEM_WORK_POOL_WORKERS_MAX;
+	}
+	if (max_workers > count) {
+		max_workers = count;
+	}
+
+	// the calling thread is one of the workers - failing to start others only slows the jobs down
+	for (size_t i = 0; i + 1 < max_workers; i++) {
+		if (pthread_create(&workers[worker_count], NULL, system_work_pool_thread, &pool)) {
+			SRPLG_LOG_WRN(PLUGIN_NAME, "pthread_create() failed - running %zu jobs with %zu workers", count, worker_count + 1);
+			break;
+		}
+		worker_count++;
+	}
+
+	worker(&pool, arg);
+
+	for (size_t i = 0; i < worker_count; i++) {
+		pthread_join(workers[i], NULL);
+	}
+}
+
+bool system_work_pool_next(system_work_pool_t *pool, size_t *index)
+{
+	*index = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+
+	return *index < pool->count;
+}
+
+static void *system_work_pool_thread(void *arg)
+{
+	system_work_pool_t *pool = arg;
+
+	pool->worker(pool, pool->arg);
+
+	return NULL;
+}
@@ -0,0 +1,40 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_WORK_POOL_H
+#define SYSTEM_PLUGIN_WORK_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// upper bound of threads of a pool - the number of online CPUs is used if lower
+#define SYSTEM_WORK_POOL_WORKERS_MAX 8
+
+typedef struct system_work_pool_s system_work_pool_t;
+
+// worker routine - takes jobs until none are left, state needed by all jobs of one worker lives in the routine
+typedef void (*system_work_pool_cb)(system_work_pool_t *pool, void *arg);
+
+struct system_work_pool_s {
+	size_t count;
+	size_t next; ///< Next job - taken atomically by the workers.
+	system_work_pool_cb worker;
+	void *arg;
+};
+
+// run the worker routine on up to SYSTEM_WORK_POOL_WORKERS_MAX threads until all count jobs are done
+void system_work_pool_run(size_t count, system_work_pool_cb worker, void *arg);
+
+// take the index of the next job - false once all jobs are taken
+bool system_work_pool_next(system_work_pool_t *pool, size_t *index);
+
+#endif // SYSTEM_PLUGIN_WORK_POOL_H
@@ -41,8 +41,12 @@ int system_aug_running_ds_load(system_ctx_t *ctx, sr_session_ctx_t *session)
 		goto error_out;
 	}
 
-	// reload features hash before adding all system values
-	SRPC_SAFE_CALL_ERR(error, srpc_feature_status_hash_reload(&ctx->ietf_system_features, session, IETF_SYSTEM_YANG_MODULE), error_out);
+	// refresh features before using them - the bitmask is only recompiled if the context changed
+	error = system_features_refresh(&ctx->features, session);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_features_refresh() error (%d)", error);
+		goto error_out;
+	}
 
 	// load system container info
 	error = system_ly_tree_create_system(ly_ctx, &system_container_node);
@@ -125,8 +129,8 @@ static int system_aug_running_load_ntp(void *priv, sr_session_ctx_t *session, co
 	struct lyd_node *ntp_container_node = NULL, *server_list_node = NULL;
 
 	// feature check
-	bool ntp_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "ntp");
-	bool ntp_udp_port_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "ntp-udp-port");
+	bool ntp_enabled = SYSTEM_FEATURE_ENABLED(&ctx->features, SYSTEM_FEATURE_NTP);
+	bool ntp_udp_port_enabled = SYSTEM_FEATURE_ENABLED(&ctx->features, SYSTEM_FEATURE_NTP_UDP_PORT);
 
 	// load list
 	system_ntp_server_element_t *ntp_server_head = NULL, *ntp_server_iter = NULL;
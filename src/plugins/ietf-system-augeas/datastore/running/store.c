@@ -40,8 +40,12 @@ int system_aug_running_ds_store(system_ctx_t *ctx, sr_session_ctx_t *session)
 		},
 	};
 
-	// reload feature status hash before storing system data
-	SRPC_SAFE_CALL_ERR(error, srpc_feature_status_hash_reload(&ctx->ietf_system_features, session, IETF_SYSTEM_YANG_MODULE), error_out);
+	// refresh features before using them - the bitmask is only recompiled if the context changed
+	error = system_features_refresh(&ctx->features, session);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_features_refresh() error (%d)", error);
+		goto error_out;
+	}
 
 	for (size_t i = 0; i < ARRAY_SIZE(store_values); i++) {
 		const srpc_startup_store_t *store = &store_values[i];
@@ -53,6 +57,13 @@ int system_aug_running_ds_store(system_ctx_t *ctx, sr_session_ctx_t *session)
 		}
 	}
 
+	// config file edits staged by the callbacks are written in one transaction
+	error = system_store_apply(ctx);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_store_apply() error (%d)", error);
+		goto error_out;
+	}
+
 	goto out;
 
 error_out:
@@ -135,8 +146,8 @@ static int system_aug_running_store_ntp(void *priv, const struct lyd_node *syste
 
 	system_ntp_server_element_t *ntp_server_head = NULL;
 
-	bool ntp_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "ntp");
-	bool ntp_udp_port_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "ntp-udp-port");
+	bool ntp_enabled = SYSTEM_FEATURE_ENABLED(&ctx->features, SYSTEM_FEATURE_NTP);
+	bool ntp_udp_port_enabled = SYSTEM_FEATURE_ENABLED(&ctx->features, SYSTEM_FEATURE_NTP_UDP_PORT);
 
 	system_ntp_server_t temp_server = {0};
 	srpc_check_status_t server_check_status = srpc_check_status_none;
@@ -17,7 +17,7 @@
 
 // API for getting system data
 #include "srpc/common.h"
-#include "srpc/feature_status.h"
+#include "core/features.h"
 #include "srpc/ly_tree.h"
 #include "srpc/types.h"
 #include "core/api/system/authentication/check.h"
@@ -99,8 +99,12 @@ int system_running_ds_store(system_ctx_t *ctx, sr_session_ctx_t *session)
 		},
 	};
 
-	// reload feature status hash before storing system data
-	SRPC_SAFE_CALL_ERR(error, srpc_feature_status_hash_reload(&ctx->ietf_system_features, session, IETF_SYSTEM_YANG_MODULE), error_out);
+	// refresh features before using them - the bitmask is only recompiled if the context changed
+	error = system_features_refresh(&ctx->features, session);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_features_refresh() error (%d)", error);
+		goto error_out;
+	}
 
 	for (size_t i = 0; i < ARRAY_SIZE(store_values); i++) {
 		const srpc_startup_store_t *store = &store_values[i];
@@ -174,7 +178,7 @@ static int system_running_store_timezone_name(void *priv, const struct lyd_node
 	int error = 0;
 	system_ctx_t *ctx = (system_ctx_t *) priv;
 	srpc_check_status_t check_status = srpc_check_status_none;
-	bool timezone_name_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "timezone-name");
+	bool timezone_name_enabled = SYSTEM_FEATURE_ENABLED(&ctx->features, SYSTEM_FEATURE_TIMEZONE_NAME);
 
 	struct lyd_node *clock_container_node = NULL, *timezone_name_node = NULL;
 
@@ -474,8 +478,8 @@ static int system_running_store_authentication(void *priv, const struct lyd_node
 	system_authorized_key_t temp_key = {0};
 
 	// features
-	bool authentication_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "authentication");
-	bool local_users_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "local-users");
+	bool authentication_enabled = SYSTEM_FEATURE_ENABLED(&ctx->features, SYSTEM_FEATURE_AUTHENTICATION);
+	bool local_users_enabled = SYSTEM_FEATURE_ENABLED(&ctx->features, SYSTEM_FEATURE_LOCAL_USERS);
 
 	// srpc
 	srpc_check_status_t user_check_status = srpc_check_status_none, key_check_status = srpc_check_status_none;
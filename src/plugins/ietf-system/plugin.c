@@ -13,6 +13,7 @@
 #include "plugin.h"
 #include "core/common.h"
 #include "core/context.h"
+#include "core/features.h"
 
 // stdlib
 #include <stdbool.h>
@@ -24,7 +25,6 @@
 #include <libyang/tree_data.h>
 
 #include "srpc/common.h"
-#include "srpc/feature_status.h"
 #include "srpc/types.h"
 
 // startup
@@ -33,9 +33,20 @@
 
 // subs
 #include "core/subscription/change.h"
+#include "core/subscription/change/dispatch.h"
+#include "core/subscription/change/apply.h"
 #include "core/subscription/operational.h"
 #include "core/subscription/rpc.h"
 
+// change API
+#include "core/api/system/change.h"
+#include "core/api/system/ntp/change.h"
+#include "core/api/system/dns_resolver/change.h"
+#include "core/api/system/dns_resolver/load.h"
+#include "core/api/system/authentication/change.h"
+#include "core/api/system/authentication/authorized_keys.h"
+#include "core/api/system/authentication/store.h"
+
 #include <srpc.h>
 
 int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
@@ -54,63 +65,123 @@ int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
 
 	// init context
 	ctx = malloc(sizeof(*ctx));
+	if (!ctx) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "malloc() failed");
+		goto error_out;
+	}
+
 	*ctx = (system_ctx_t){0};
+	system_change_dispatcher_init(&ctx->change_dispatcher);
+	system_features_init(&ctx->features);
+	system_bus_init(&ctx->bus);
+	system_authentication_key_cache_init(&ctx->key_cache);
+	system_authentication_scope_init(&ctx->user_scope);
+	system_authentication_bulk_init(&ctx->user_import);
 
 	*private_data = ctx;
 
-	// module changes
-	srpc_module_change_t module_changes[] = {
+	// start removing home directories left from the last run - deleted homes are queued by the apply worker
+	error = system_authentication_trash_init(&ctx->home_trash);
+	if (error) {
+		SRPLG_LOG_WRN(PLUGIN_NAME, "system_authentication_trash_init() error (%d) - home directories of deleted users are removed synchronously", error);
+		error = 0;
+	}
+
+	// keys added to authorized_keys while the plugin was not running are indexed again
+	error = system_authentication_authorized_keys_build_index();
+	if (error) {
+		SRPLG_LOG_WRN(PLUGIN_NAME, "system_authentication_authorized_keys_build_index() error (%d) - keys of some users are not indexed", error);
+		error = 0;
+	}
+
+	// start the worker applying committed changes on the system
+	error = system_change_apply_init(&ctx->change_apply, ctx, system_subscription_change_finish);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_change_apply_init() error (%d)", error);
+		goto error_out;
+	}
+
+	// module change routes - only nodes with an effect on the system are routed
+	system_change_route_t change_routes[] = {
 		{
-			SYSTEM_CONTACT_YANG_PATH,
-			system_subscription_change_contact,
+			SYSTEM_HOSTNAME_YANG_PATH,
+			system_change_hostname,
+			NULL,
 		},
 		{
-			SYSTEM_HOSTNAME_YANG_PATH,
-			system_subscription_change_hostname,
+			SYSTEM_TIMEZONE_NAME_YANG_PATH,
+			system_change_timezone_name,
+			NULL,
 		},
 		{
-			SYSTEM_LOCATION_YANG_PATH,
-			system_subscription_change_location,
+			SYSTEM_NTP_ENABLED_YANG_PATH,
+			system_ntp_change_enabled,
+			NULL,
 		},
 		{
-			SYSTEM_TIMEZONE_NAME_YANG_PATH,
-			system_subscription_change_timezone_name,
+			SYSTEM_NTP_SERVER_NAME_YANG_PATH,
+			system_ntp_change_server_name,
+			&system_change_group_ntp_server,
 		},
 		{
-			SYSTEM_TIMEZONE_UTC_OFFSET_YANG_PATH,
-			system_subscription_change_timezone_utc_offset,
+			SYSTEM_NTP_SERVER_ADDRESS_YANG_PATH,
+			system_ntp_change_server_address,
+			&system_change_group_ntp_server,
 		},
 		{
-			SYSTEM_NTP_ENABLED_YANG_PATH,
-			system_subscription_change_ntp_enabled,
+			SYSTEM_NTP_SERVER_PORT_YANG_PATH,
+			system_ntp_change_server_port,
+			&system_change_group_ntp_server,
 		},
 		{
-			SYSTEM_NTP_SERVER_YANG_PATH,
-			system_subscription_change_ntp_server,
+			SYSTEM_NTP_SERVER_ASSOCIATION_TYPE_YANG_PATH,
+			system_ntp_change_server_association_type,
+			&system_change_group_ntp_server,
+		},
+		{
+			SYSTEM_NTP_SERVER_IBURST_YANG_PATH,
+			system_ntp_change_server_iburst,
+			&system_change_group_ntp_server,
+		},
+		{
+			SYSTEM_NTP_SERVER_PREFER_YANG_PATH,
+			system_ntp_change_server_prefer,
+			&system_change_group_ntp_server,
 		},
 		{
 			SYSTEM_DNS_RESOLVER_SEARCH_YANG_PATH,
-			system_subscription_change_dns_resolver_search,
+			system_dns_resolver_change_search,
+			&system_change_group_dns_resolver,
+		},
+		{
+			SYSTEM_DNS_RESOLVER_SERVER_ADDRESS_YANG_PATH,
+			system_dns_resolver_change_server_address,
+			&system_change_group_dns_resolver,
 		},
 		{
-			SYSTEM_DNS_RESOLVER_SERVER_YANG_PATH,
-			system_subscription_change_dns_resolver_server,
+			SYSTEM_AUTHENTICATION_USER_NAME_YANG_PATH,
+			system_authentication_change_user_name,
+			&system_change_group_authentication_user,
 		},
 		{
-			SYSTEM_DNS_RESOLVER_TIMEOUT_YANG_PATH,
-			system_subscription_change_dns_resolver_timeout,
+			SYSTEM_AUTHENTICATION_USER_PASSWORD_YANG_PATH,
+			system_authentication_change_user_password,
+			&system_change_group_authentication_user,
 		},
 		{
-			SYSTEM_DNS_RESOLVER_ATTEMPTS_YANG_PATH,
-			system_subscription_change_dns_resolver_attempts,
+			SYSTEM_AUTHENTICATION_USER_AUTHORIZED_KEY_NAME_YANG_PATH,
+			system_authentication_user_change_authorized_key_name,
+			&system_change_group_authentication_user,
 		},
 		{
-			SYSTEM_AUTHENTICATION_USER_AUTHENTICATION_ORDER_YANG_PATH,
-			system_subscription_change_authentication_user_authentication_order,
+			SYSTEM_AUTHENTICATION_USER_AUTHORIZED_KEY_ALGORITHM_YANG_PATH,
+			system_authentication_user_change_authorized_key_algorithm,
+			&system_change_group_authentication_user,
 		},
 		{
-			SYSTEM_AUTHENTICATION_USER_YANG_PATH,
-			system_subscription_change_authentication_user,
+			SYSTEM_AUTHENTICATION_USER_AUTHORIZED_KEY_KEY_DATA_YANG_PATH,
+			system_authentication_user_change_authorized_key_key_data,
+			&system_change_group_authentication_user,
 		},
 	};
 
@@ -129,6 +200,14 @@ int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
 			SYSTEM_SHUTDOWN_RPC_YANG_PATH,
 			system_subscription_rpc_shutdown,
 		},
+		{
+			SYSTEM_PLUGIN_IMPORT_USERS_RPC_YANG_PATH,
+			system_subscription_rpc_import_users,
+		},
+		{
+			SYSTEM_PLUGIN_EXPORT_USERS_RPC_YANG_PATH,
+			system_subscription_rpc_export_users,
+		},
 	};
 
 	// operational getters
@@ -143,31 +222,34 @@ int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
 			SYSTEM_STATE_CLOCK_YANG_PATH "/*",
 			system_subscription_operational_clock,
 		},
+		{
+			SYSTEM_PLUGIN_YANG_MODULE,
+			SYSTEM_PLUGIN_APPLY_YANG_PATH "/*",
+			system_subscription_operational_apply,
+		},
+		{
+			SYSTEM_PLUGIN_YANG_MODULE,
+			SYSTEM_PLUGIN_HOME_REMOVAL_YANG_PATH "/*",
+			system_subscription_operational_home_removal,
+		},
+		{
+			SYSTEM_PLUGIN_YANG_MODULE,
+			SYSTEM_PLUGIN_USER_IMPORT_YANG_PATH "/*",
+			system_subscription_operational_user_import,
+		},
 	};
 
-	ctx->ietf_system_features = srpc_feature_status_hash_new();
-
-	// load feature status
-	SRPC_SAFE_CALL_ERR(error, srpc_feature_status_hash_load(&ctx->ietf_system_features, running_session, "ietf-system"), error_out);
-
-	// log status of features
-	const char *features[] = {
-		"radius",
-		"authentication",
-		"local-users",
-		"radius-authentication",
-		"ntp",
-		"ntp-udp-port",
-		"timezone-name",
-		"dns-udp-tcp-port",
-	};
+	// compile feature status - refreshed only when a new context with other features is installed
+	error = system_features_refresh(&ctx->features, running_session);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_features_refresh() error (%d)", error);
+		goto error_out;
+	}
 
 	SRPLG_LOG_INF(PLUGIN_NAME, "Checking ietf-system YANG module used features");
 
-	for (size_t i = 0; i < ARRAY_SIZE(features); i++) {
-		const char *feature = features[i];
-
-		SRPLG_LOG_INF(PLUGIN_NAME, "ietf-system feature \"%s\" status = %s", feature, srpc_feature_status_hash_check(ctx->ietf_system_features, feature) ? "enabled" : "disabled");
+	for (uint32_t feature = SYSTEM_FEATURE_RADIUS; feature <= SYSTEM_FEATURE_DNS_UDP_TCP_PORT; feature <<= 1) {
+		SRPLG_LOG_INF(PLUGIN_NAME, "ietf-system feature \"%s\" status = %s", system_features_get_name(feature), SYSTEM_FEATURE_ENABLED(&ctx->features, feature) ? "enabled" : "disabled");
 	}
 
 	connection = sr_session_get_connection(running_session);
@@ -179,6 +261,20 @@ int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
 
 	ctx->startup_session = startup_session;
 
+	// the managed user scope is read once subscribed - it has to be known before users are loaded or stored
+	error = sr_module_change_subscribe(running_session, SYSTEM_PLUGIN_YANG_MODULE, SYSTEM_PLUGIN_MANAGED_USERS_YANG_PATH, system_subscription_change_plugin_managed_users, *private_data, 0, SR_SUBSCR_ENABLED | SR_SUBSCR_DONE_ONLY, &subscription);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_module_change_subscribe() error for \"%s\" (%d): %s", SYSTEM_PLUGIN_MANAGED_USERS_YANG_PATH, error, sr_strerror(error));
+		goto error_out;
+	}
+
+	// cleartext passwords are hashed before the data is stored in the system or seen by other subscribers
+	error = system_authentication_store_hash_datastore(ctx, startup_session, running_session);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_store_hash_datastore() error (%d)", error);
+		goto error_out;
+	}
+
 	error = srpc_check_empty_datastore(startup_session, SYSTEM_HOSTNAME_YANG_PATH, &empty_startup);
 	if (error) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "Failed checking datastore contents: %d", error);
@@ -208,18 +304,38 @@ int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
 		}
 	}
 
-	// subscribe every module change
-	for (size_t i = 0; i < ARRAY_SIZE(module_changes); i++) {
-		const srpc_module_change_t *change = &module_changes[i];
+	// routes are resolved into schema nodes on the first changes walk
+	error = system_change_dispatcher_set_routes(&ctx->change_dispatcher, change_routes, ARRAY_SIZE(change_routes));
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_change_dispatcher_set_routes() error (%d)", error);
+		goto error_out;
+	}
 
-		// in case of work on a specific callback set it to NULL
-		if (change->cb) {
-			error = sr_module_change_subscribe(running_session, BASE_YANG_MODULE, change->path, change->cb, *private_data, 0, SR_SUBSCR_DEFAULT, &subscription);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "sr_module_change_subscribe() error for \"%s\" (%d): %s", change->path, error, sr_strerror(error));
-				goto error_out;
-			}
-		}
+	// subscribe once for the whole module - changes are walked once and dispatched using the routes
+	error = sr_module_change_subscribe(running_session, BASE_YANG_MODULE, SYSTEM_SYSTEM_CONTAINER_YANG_PATH, system_subscription_change_system, *private_data, 0, SR_SUBSCR_DEFAULT, &subscription);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_module_change_subscribe() error for \"%s\" (%d): %s", SYSTEM_SYSTEM_CONTAINER_YANG_PATH, error, sr_strerror(error));
+		goto error_out;
+	}
+
+	// cleartext passwords are hashed in the update event - other subscribers see only the hashes
+	error = sr_module_change_subscribe(running_session, BASE_YANG_MODULE, SYSTEM_AUTHENTICATION_USER_PASSWORD_YANG_PATH, system_subscription_update_authentication_password, *private_data, 0, SR_SUBSCR_UPDATE, &subscription);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_module_change_subscribe() error for \"%s\" (%d): %s", SYSTEM_AUTHENTICATION_USER_PASSWORD_YANG_PATH, error, sr_strerror(error));
+		goto error_out;
+	}
+
+	// plugin configuration - current window is read once subscribed
+	error = sr_module_change_subscribe(running_session, SYSTEM_PLUGIN_YANG_MODULE, SYSTEM_PLUGIN_COALESCING_YANG_PATH, system_subscription_change_plugin_coalescing, *private_data, 0, SR_SUBSCR_ENABLED | SR_SUBSCR_DONE_ONLY, &subscription);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_module_change_subscribe() error for \"%s\" (%d): %s", SYSTEM_PLUGIN_COALESCING_YANG_PATH, error, sr_strerror(error));
+		goto error_out;
+	}
+
+	error = sr_module_change_subscribe(running_session, SYSTEM_PLUGIN_YANG_MODULE, SYSTEM_PLUGIN_PASSWORD_HASHING_YANG_PATH, system_subscription_change_plugin_password_hashing, *private_data, 0, SR_SUBSCR_ENABLED | SR_SUBSCR_DONE_ONLY, &subscription);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_module_change_subscribe() error for \"%s\" (%d): %s", SYSTEM_PLUGIN_PASSWORD_HASHING_YANG_PATH, error, sr_strerror(error));
+		goto error_out;
 	}
 
 	// subscribe every rpc
@@ -242,7 +358,7 @@ int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
 
 		// in case of work on a specific callback set it to NULL
 		if (op->cb) {
-			error = sr_oper_get_subscribe(running_session, BASE_YANG_MODULE, op->path, op->cb, NULL, SR_SUBSCR_DEFAULT, &subscription);
+			error = sr_oper_get_subscribe(running_session, op->module, op->path, op->cb, *private_data, SR_SUBSCR_DEFAULT, &subscription);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "sr_oper_get_subscribe() error (%d): %s", error, sr_strerror(error));
 				goto error_out;
@@ -256,6 +372,21 @@ error_out:
 	error = -1;
 	SRPLG_LOG_ERR(PLUGIN_NAME, "Error occured while initializing the plugin (%d)", error);
 
+	// cleanup is not called for a failed init - no callback may run with the context once it is freed
+	if (subscription) {
+		sr_unsubscribe(subscription);
+	}
+
+	// workers started so far are stopped and joined
+	if (ctx) {
+		sr_plugin_cleanup_cb(running_session, ctx);
+		*private_data = NULL;
+	}
+
+	if (startup_session) {
+		sr_session_stop(startup_session);
+	}
+
 out:
 	return error ? SR_ERR_CALLBACK_FAILED : SR_ERR_OK;
 }
@@ -264,9 +395,17 @@ void sr_plugin_cleanup_cb(sr_session_ctx_t *running_session, void *private_data)
 {
 	system_ctx_t *ctx = (system_ctx_t *) private_data;
 
-	if (ctx->ietf_system_features) {
-		srpc_feature_status_hash_free(&ctx->ietf_system_features);
-	}
+	// an import stops after its current batch - its transactions are applied below
+	system_authentication_bulk_free(&ctx->user_import);
+
+	// changes already committed are applied before the worker stops
+	system_change_apply_free(&ctx->change_apply);
+	system_authentication_trash_free(&ctx->home_trash);
+	system_authentication_key_cache_free(&ctx->key_cache);
+	system_authentication_scope_free(&ctx->user_scope);
+	system_change_dispatcher_free(&ctx->change_dispatcher);
+	system_bus_free(&ctx->bus);
+	system_dns_resolver_cache_free(&ctx->dns_resolver_cache);
 
 	free(ctx);
 }
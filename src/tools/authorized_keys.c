@@ -0,0 +1,73 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+// sshd AuthorizedKeysCommand answering lookups from the key index kept by the plugin:
+//
+//   AuthorizedKeysCommand /usr/local/bin/ietf-system-authorized-keys %u %k
+//   AuthorizedKeysCommandUser nobody
+//
+// only the index entry of the offered key is read - the lookup does not depend on the number of keys of the user
+#include "core/api/system/authentication/key_index.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char **argv)
+{
+	const char *user = NULL;
+	const char *data = NULL;
+	char path_buffer[4096] = {0};
+	char name_buffer[SYSTEM_AUTHENTICATION_KEY_INDEX_NAME_SIZE] = {0};
+	char *line = NULL;
+	size_t line_size = 0;
+	ssize_t line_length = 0;
+	FILE *entry_file = NULL;
+	size_t data_length = 0;
+
+	if (argc != 3) {
+		fprintf(stderr, "usage: %s <user> <key-data>\n", argv[0]);
+		return 1;
+	}
+
+	user = argv[1];
+	data = argv[2];
+	data_length = strlen(data);
+
+	if (system_authentication_key_index_check_user(user)) {
+		return 1;
+	}
+
+	system_authentication_key_index_name(system_authentication_key_index_hash(data, data_length), name_buffer);
+
+	if (snprintf(path_buffer, sizeof(path_buffer), "%s/%s/%s", SYSTEM_AUTHENTICATION_KEY_INDEX_DIRECTORY, user, name_buffer) >= (int) sizeof(path_buffer)) {
+		return 1;
+	}
+
+	// no entry - the key is not authorized
+	entry_file = fopen(path_buffer, "r");
+	if (!entry_file) {
+		return 0;
+	}
+
+	// entries hold "<key-data> <line>" of all keys with the same hash - print only lines of the offered key
+	while ((line_length = getline(&line, &line_size, entry_file)) != -1) {
+		if ((size_t) line_length > data_length && !strncmp(line, data, data_length) && line[data_length] == ' ') {
+			fputs(line + data_length + 1, stdout);
+		}
+	}
+
+	free(line);
+	fclose(entry_file);
+
+	return 0;
+}
@@ -23,6 +23,7 @@ import platform
 import datetime
 import pwd
 import spwd
+import re
 
 class SystemTestCase(unittest.TestCase):
     def setUp(self):
@@ -290,6 +291,21 @@ class NTPTestCase(SystemTestCase):
         data.free()
 
 class AuthenticationTestCase(SystemTestCase):
+    def wait_for_worker(self, check):
+        # passwd, shadow and home directories are written by the apply worker after the commit
+        for _ in range(50):
+            if check():
+                return True
+            time.sleep(0.1)
+        return check()
+
+    def user_exists(self, name):
+        try:
+            pwd.getpwnam(name)
+            return True
+        except KeyError:
+            return False
+
     def test_authentication_import(self):
         expected_authentication = '<system xmlns="urn:ietf:params:xml:ns:yang:ietf-system"><authentication><user><name>test_user</name><password>$6$S05zV2Np5LQzaOpM$qqUxvFsEVg7iwaqnEHhF4ZJv8dwXdtgFpLTHyr78Rr8cz/ml2riPyBlPol.3V8qVXFohR0XSTJXMHO4XLjrXd1</password><authorized-key><name>test_rsa.pub</name><algorithm>ssh-rsa</algorithm><key-data>AAAAB3NzaC1yc2EAAAADAQABAAABAQCiIf32L0B77f//ldk1QpUyfaJQUgI4mXSPtkmaokxUUlj8j9pxlwpFDSmsrZn2H0DJhZZ3ktAGsbFJabZJhV73l7HhQggC/6uzrNPSe+R3lOMGYIAhHaWbGSnT/uvpPMBVA/nWulDkBphiXv606WQHDxqGkngF1kzvvpd5FPpc/jy2vv+66HaP6XA9MgzHLYTOTb3ct3dVoz7HDAQ8tC5l3/3YYLyMhc3LxOBQLZ9PklWvQeSyO6neKi3Au0T13SpUGjtuqKpiCvE/X0ZuFtZSZzPo5UDASD65Er8jOqqYDcfHR1hsfJJjJA/nP+VKoGeBzUBxhxNetqswnEcPDEBv</key-data></authorized-key></user></authentication></system>'
 
@@ -299,6 +315,8 @@ class AuthenticationTestCase(SystemTestCase):
         auth = data.print_mem("xml")
         self.assertEqual(auth, expected_authentication, "authentication data is wrong")
 
+        self.assertTrue(self.wait_for_worker(lambda: os.path.exists('/home/test_user/.ssh/authorized_keys')), "/home/test_user/.ssh/authorized_keys doesn't exist")
+
         user = pwd.getpwnam("test_user")
         self.assertEqual(user.pw_name, "test_user", "username in /etc/passwd is wrong")
         self.assertEqual(user.pw_dir, "/home/test_user", "homedir in /etc/passwd is wrong")
@@ -313,14 +331,20 @@ class AuthenticationTestCase(SystemTestCase):
         self.assertEqual(os.path.isdir('/home/test_user'), True, "/home/test_user doesn't exist")
 
         self.assertEqual(os.path.isdir('/home/test_user/.ssh'), True, "/home/test_user/.ssh doesn't exist")
-        self.assertEqual(os.path.exists('/home/test_user/.ssh/test_rsa.pub'), True, "/home/test_user/.ssh/test_rsa.pub doesn't exist")
 
-        with open('/home/test_user/.ssh/test_rsa.pub') as f:
-            self.assertEqual(f.readline().strip(), "ssh-rsa", "key algorithm differs")
-            self.assertEqual(f.readline().strip(), "AAAAB3NzaC1yc2EAAAADAQABAAABAQCiIf32L0B77f//ldk1QpUyfaJQUgI4mXSPtkmaokxUUlj8j9pxlwpFDSmsrZn2H0DJhZZ3ktAGsbFJabZJhV73l7HhQggC/6uzrNPSe+R3lOMGYIAhHaWbGSnT/uvpPMBVA/nWulDkBphiXv606WQHDxqGkngF1kzvvpd5FPpc/jy2vv+66HaP6XA9MgzHLYTOTb3ct3dVoz7HDAQ8tC5l3/3YYLyMhc3LxOBQLZ9PklWvQeSyO6neKi3Au0T13SpUGjtuqKpiCvE/X0ZuFtZSZzPo5UDASD65Er8jOqqYDcfHR1hsfJJjJA/nP+VKoGeBzUBxhxNetqswnEcPDEBv", "key data differs")
+        # managed keys are "<algorithm> <key-data> <name>" lines
+        with open('/home/test_user/.ssh/authorized_keys') as f:
+            keys = [line.split(" ", 2) for line in f.read().splitlines()]
+
+        self.assertEqual(len(keys), 1, "unexpected number of lines in authorized_keys")
+        self.assertEqual(keys[0][2], "test_rsa.pub", "key name differs")
+        self.assertEqual(keys[0][0], "ssh-rsa", "key algorithm differs")
+        self.assertEqual(keys[0][1], "AAAAB3NzaC1yc2EAAAADAQABAAABAQCiIf32L0B77f//ldk1QpUyfaJQUgI4mXSPtkmaokxUUlj8j9pxlwpFDSmsrZn2H0DJhZZ3ktAGsbFJabZJhV73l7HhQggC/6uzrNPSe+R3lOMGYIAhHaWbGSnT/uvpPMBVA/nWulDkBphiXv606WQHDxqGkngF1kzvvpd5FPpc/jy2vv+66HaP6XA9MgzHLYTOTb3ct3dVoz7HDAQ8tC5l3/3YYLyMhc3LxOBQLZ9PklWvQeSyO6neKi3Au0T13SpUGjtuqKpiCvE/X0ZuFtZSZzPo5UDASD65Er8jOqqYDcfHR1hsfJJjJA/nP+VKoGeBzUBxhxNetqswnEcPDEBv", "key data differs")
 
         self.session.replace_config_ly(self.initial_data, "ietf-system")
 
+        self.assertTrue(self.wait_for_worker(lambda: not self.user_exists("test_user") and not os.path.exists('/home/test_user')), "test_user not deleted by the apply worker")
+
         with self.assertRaises(KeyError):
             pwd.getpwnam("test_user")
 
@@ -331,6 +355,138 @@ class AuthenticationTestCase(SystemTestCase):
 
         data.free()
 
+    def test_authentication_cleartext_password(self):
+        self.session.set_item("/ietf-system:system/authentication/user[name='test_user']/password", "$0$cleartext")
+        self.session.apply_changes()
+
+        data = self.session.get_data_ly("/ietf-system:system/authentication/user[name='test_user']/password")
+        auth = data.print_mem("xml")
+        data.free()
+
+        password = re.search("<password>(.*)</password>", auth).group(1)
+        self.assertTrue(password.startswith("$6$"), "password is not hashed with SHA-512 crypt")
+
+        # wait for the apply worker
+        for _ in range(50):
+            try:
+                shadow = spwd.getspnam("test_user")
+                break
+            except KeyError:
+                time.sleep(0.1)
+
+        self.assertEqual(shadow.sp_pwdp, password, "password in /etc/shadow is wrong")
+
+        self.session.replace_config_ly(self.initial_data, "ietf-system")
+
+    def test_authentication_managed_users(self):
+        self.session.set_item("/sysrepo-plugin-system:managed-users/name-prefix", "ops-")
+        self.session.apply_changes()
+
+        # users outside of the scope are rejected
+        self.session.set_item("/ietf-system:system/authentication/user[name='scope_user']", None)
+        with self.assertRaises(sysrepo.SysrepoCallbackFailedError):
+            self.session.apply_changes()
+        self.session.discard_changes()
+
+        self.session.set_item("/ietf-system:system/authentication/user[name='ops-user']", None)
+        self.session.apply_changes()
+
+        # wait for the apply worker
+        for _ in range(50):
+            try:
+                user = pwd.getpwnam("ops-user")
+                break
+            except KeyError:
+                time.sleep(0.1)
+
+        self.assertGreaterEqual(user.pw_uid, 1000, "UID of the created user is outside of the default range")
+
+        self.session.replace_config_ly(self.initial_data, "ietf-system")
+        self.session.delete_item("/sysrepo-plugin-system:managed-users")
+        self.session.apply_changes()
+
+    def test_authentication_import_export_users(self):
+        ctx = self.conn.get_ly_ctx()
+
+        with open("/tmp/ietf-system-import", "w") as f:
+            f.write("# imported users\nimport_user_1:$0$password\nimport_user_2:\nimport_user_3:\n")
+
+        rpc_input = ctx.parse_data_mem('<import-users xmlns="urn:telekom:params:xml:ns:yang:sysrepo-plugin-system"><path>/tmp/ietf-system-import</path><batch-size>2</batch-size></import-users>', "xml", rpc=True, strict=False)
+        self.session.rpc_send_ly(rpc_input).free()
+        rpc_input.free()
+
+        # wait for the import
+        for _ in range(100):
+            data = self.session.get_data_ly("/sysrepo-plugin-system:user-import")
+            state = data.print_mem("xml")
+            data.free()
+            if "<running>false</running>" in state:
+                break
+            time.sleep(0.1)
+
+        self.assertIn("<imported-users>3</imported-users>", state, "unexpected number of imported users")
+        self.assertIn("<batches>2</batches>", state, "unexpected number of import batches")
+
+        data = self.session.get_data_ly("/ietf-system:system/authentication")
+        auth = data.print_mem("xml")
+        data.free()
+
+        for name in ("import_user_1", "import_user_2", "import_user_3"):
+            self.assertIn("<name>%s</name>" % name, auth, "imported user missing in the datastore")
+
+        rpc_input = ctx.parse_data_mem('<export-users xmlns="urn:telekom:params:xml:ns:yang:sysrepo-plugin-system"><path>/tmp/ietf-system-export</path></export-users>', "xml", rpc=True, strict=False)
+        rpc_output = self.session.rpc_send_ly(rpc_input)
+        rpc_input.free()
+        rpc_output.free()
+
+        with open("/tmp/ietf-system-export") as f:
+            exported = dict(line.rstrip("\n").split(":", 1) for line in f if not line.startswith("#"))
+
+        self.assertTrue(exported["import_user_1"].startswith("$6$"), "exported password is not hashed")
+        self.assertEqual(exported["import_user_2"], "", "unexpected password of an exported user")
+
+        os.remove("/tmp/ietf-system-import")
+        os.remove("/tmp/ietf-system-export")
+        self.session.replace_config_ly(self.initial_data, "ietf-system")
+
+@unittest.skipUnless(os.environ.get('SYSTEM_PLUGIN_BENCHMARK'), "benchmarks run only with SYSTEM_PLUGIN_BENCHMARK set")
+class AuthenticationBenchmarkTestCase(SystemTestCase):
+    user_count = 10000
+
+    def test_authentication_bulk_create(self):
+        ctx = self.conn.get_ly_ctx()
+        names = ["bench_user_%05d" % i for i in range(self.user_count)]
+
+        users = "".join("<user><name>%s</name></user>" % name for name in names)
+        data = ctx.parse_data_mem('<system xmlns="urn:ietf:params:xml:ns:yang:ietf-system"><authentication>%s</authentication></system>' % users, "xml", config=True, strict=True)
+        self.session.edit_batch_ly(data)
+        data.free()
+
+        start = time.monotonic()
+        self.session.apply_changes()
+        elapsed = time.monotonic() - start
+        print("\ncreated %d users in one commit in %.3f s" % (self.user_count, elapsed))
+
+        # wait for the apply worker
+        for _ in range(600):
+            try:
+                pwd.getpwnam(names[-1])
+                break
+            except KeyError:
+                time.sleep(0.1)
+
+        uids = set()
+        gids = set()
+        for name in names:
+            user = pwd.getpwnam(name)
+            uids.add(user.pw_uid)
+            gids.add(user.pw_gid)
+
+        self.assertEqual(len(uids), self.user_count, "created users share UIDs")
+        self.assertEqual(len(gids), self.user_count, "created users share GIDs")
+
+        self.session.replace_config_ly(self.initial_data, "ietf-system")
+
 class PlatformTestCase(SystemStateTestCase):
     def test_platform(self):
         data = self.session.get_data_ly('/ietf-system:system-state/platform')
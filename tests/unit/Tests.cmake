@@ -30,6 +30,24 @@ target_link_libraries(
     "-Wl,--wrap=unlink"
     "-Wl,--wrap=symlink"
     "-Wl,--wrap=sr_apply_changes"
+    "-Wl,--wrap=lckpwdf"
+    "-Wl,--wrap=ulckpwdf"
 )
 
 add_test(NAME system_utest COMMAND system_utest)
+
+# key-data decoding microbenchmark - run by hand
+add_executable(
+    key_data_bench
+
+    ${CMAKE_SOURCE_DIR}/tests/unit/key_data_bench.c
+)
+
+target_link_libraries(
+    key_data_bench
+
+    ${PLUGIN_CORE_LIBRARY_NAME}
+    ${SYSREPO_LIBRARIES}
+    ${LIBYANG_LIBRARIES}
+    ${SYSTEMD_LIBRARIES}
+)
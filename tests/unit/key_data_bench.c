@@ -0,0 +1,76 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "core/api/system/authentication/key_data.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// decoding throughput of the scalar and the dispatched base64 decoder - run by hand, not part of the tests
+#define KEY_DATA_BENCH_TOTAL (256 * 1024 * 1024)
+
+typedef int (*key_data_decode_fn)(const char *data, size_t length, uint8_t *out, size_t *out_length);
+
+static const char key_data_bench_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static double key_data_bench_run(key_data_decode_fn decode, const char *data, size_t length, uint8_t *out)
+{
+	struct timespec start = {0}, end = {0};
+	size_t rounds = KEY_DATA_BENCH_TOTAL / length;
+	size_t out_length = 0;
+	double seconds = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (size_t i = 0; i < rounds; i++) {
+		if (decode(data, length, out, &out_length)) {
+			fprintf(stderr, "decoding failed\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	seconds = (double) (end.tv_sec - start.tv_sec) + (double) (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	return (double) (rounds * length) / seconds / (1024 * 1024);
+}
+
+int main(void)
+{
+	// typical key-data sizes - ed25519, RSA 4096, a certificate and a large blob
+	const size_t sizes[] = {68, 716, 2048, 65536};
+	char *data = NULL;
+	uint8_t *out = NULL;
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		data = malloc(sizes[i]);
+		out = malloc(SYSTEM_AUTHENTICATION_KEY_DATA_DECODED_SIZE(sizes[i]));
+		if (!data || !out) {
+			return EXIT_FAILURE;
+		}
+
+		for (size_t j = 0; j < sizes[i]; j++) {
+			data[j] = key_data_bench_alphabet[rand() % 64];
+		}
+
+		printf("%6zu characters: scalar %8.1f MiB/s, dispatched %8.1f MiB/s\n", sizes[i],
+			   key_data_bench_run(system_authentication_key_data_decode_scalar, data, sizes[i], out),
+			   key_data_bench_run(system_authentication_key_data_decode, data, sizes[i], out));
+
+		free(data);
+		free(out);
+	}
+
+	return EXIT_SUCCESS;
+}
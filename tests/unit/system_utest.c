@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 
 // plugin code
 #include "core/context.h"
@@ -39,6 +40,12 @@
 // ntp load API
 #include "core/api/system/dns_resolver/load.h"
 
+// password files patch API
+#include "core/api/system/authentication/patch.h"
+
+// authorized key data API
+#include "core/api/system/authentication/key_data.h"
+
 // init functionality
 static int setup(void **state);
 static int teardown(void **state);
@@ -65,12 +72,39 @@ static void test_check_timezone_name_incorrect(void **state);
 static void test_load_dns_resolver_search_correct(void **state);
 static void test_load_dns_resolver_server_correct(void **state);
 
+// password files patch
+static void test_patch_commit_unchanged_lines(void **state);
+static void test_patch_commit_remove(void **state);
+static void test_patch_commit_append_without_newline(void **state);
+static void test_patch_commit_owner_mode(void **state);
+static void test_patch_commit_missing_record(void **state);
+static void test_patch_commit_add_taken(void **state);
+static void test_patch_write_field(void **state);
+static void test_patch_commit_append_members(void **state);
+static void test_patch_write_members(void **state);
+
+// password files patch helpers
+static void patch_test_init(system_authentication_patch_t *patch, char *dir, size_t dir_size, const char *content);
+static void patch_test_assert_content(const char *path, const char *content);
+static void patch_test_cleanup(system_authentication_patch_t *patch, const char *dir);
+
+// authorized key data
+static void test_key_data_decode_scalar_equal(void **state);
+static void test_key_data_check_valid(void **state);
+static void test_key_data_check_invalid(void **state);
+
+// authorized key data helpers
+static void key_data_test_field(uint8_t *blob, size_t *length, const void *value, uint32_t value_length);
+static void key_data_test_encode(const uint8_t *data, size_t length, char *out);
+
 // wrapper functions
 int __wrap_gethostname(char *buffer, size_t buffer_size);
 int __wrap_sethostname(char *hostname, size_t len);
 int __wrap_unlink(const char *pathname);
 int __wrap_symlink(const char *target, const char *linkpath);
 int __wrap_sr_apply_changes(sr_session_ctx_t *session, uint32_t timeout_ms);
+int __wrap_lckpwdf(void);
+int __wrap_ulckpwdf(void);
 
 int main(void)
 {
@@ -88,6 +122,18 @@ int main(void)
 		cmocka_unit_test(test_check_timezone_name_incorrect),
 		// cmocka_unit_test(test_load_dns_resolver_search_correct),
 		// cmocka_unit_test(test_load_dns_resolver_server_correct),
+		cmocka_unit_test(test_patch_commit_unchanged_lines),
+		cmocka_unit_test(test_patch_commit_remove),
+		cmocka_unit_test(test_patch_commit_append_without_newline),
+		cmocka_unit_test(test_patch_commit_owner_mode),
+		cmocka_unit_test(test_patch_commit_missing_record),
+		cmocka_unit_test(test_patch_commit_add_taken),
+		cmocka_unit_test(test_patch_write_field),
+		cmocka_unit_test(test_patch_commit_append_members),
+		cmocka_unit_test(test_patch_write_members),
+		cmocka_unit_test(test_key_data_decode_scalar_equal),
+		cmocka_unit_test(test_key_data_check_valid),
+		cmocka_unit_test(test_key_data_check_invalid),
 	};
 
 	return cmocka_run_group_tests(tests, setup, teardown);
@@ -293,6 +339,513 @@ static void test_load_dns_resolver_server_correct(void **state)
 	assert_int_equal(rc, 0);
 }
 
+static const char *patch_test_passwd = "root:x:0:0:root:/root:/bin/bash\n"
+										"# keep  this comment\n"
+										"alice:x:1000:1000:Alice,,,:/home/alice:/bin/sh\n"
+										"bob:x:1001:1001::/home/bob:/bin/sh\n";
+
+static void test_patch_commit_unchanged_lines(void **state)
+{
+	system_authentication_patch_t patch = {0};
+	char dir[PATH_MAX] = {0};
+	int rc = 0;
+
+	patch_test_init(&patch, dir, sizeof(dir), patch_test_passwd);
+
+	rc = system_authentication_patch_set_field(&patch, SYSTEM_AUTHENTICATION_PATCH_PASSWD, "alice", 6, "/bin/bash");
+	assert_int_equal(rc, 0);
+
+	rc = system_authentication_patch_commit(&patch);
+	assert_int_equal(rc, 0);
+
+	// only the changed field differs from the original
+	patch_test_assert_content(patch.paths[SYSTEM_AUTHENTICATION_PATCH_PASSWD],
+							  "root:x:0:0:root:/root:/bin/bash\n"
+							  "# keep  this comment\n"
+							  "alice:x:1000:1000:Alice,,,:/home/alice:/bin/bash\n"
+							  "bob:x:1001:1001::/home/bob:/bin/sh\n");
+
+	patch_test_cleanup(&patch, dir);
+}
+
+static void test_patch_commit_remove(void **state)
+{
+	system_authentication_patch_t patch = {0};
+	char dir[PATH_MAX] = {0};
+	int rc = 0;
+
+	patch_test_init(&patch, dir, sizeof(dir), patch_test_passwd);
+
+	rc = system_authentication_patch_remove(&patch, SYSTEM_AUTHENTICATION_PATCH_PASSWD, "alice");
+	assert_int_equal(rc, 0);
+
+	// removing a record not in the file is not an error
+	rc = system_authentication_patch_remove(&patch, SYSTEM_AUTHENTICATION_PATCH_PASSWD, "carol");
+	assert_int_equal(rc, 0);
+
+	rc = system_authentication_patch_commit(&patch);
+	assert_int_equal(rc, 0);
+
+	patch_test_assert_content(patch.paths[SYSTEM_AUTHENTICATION_PATCH_PASSWD],
+							  "root:x:0:0:root:/root:/bin/bash\n"
+							  "# keep  this comment\n"
+							  "bob:x:1001:1001::/home/bob:/bin/sh\n");
+
+	patch_test_cleanup(&patch, dir);
+}
+
+static void test_patch_commit_append_without_newline(void **state)
+{
+	system_authentication_patch_t patch = {0};
+	char dir[PATH_MAX] = {0};
+	int rc = 0;
+
+	patch_test_init(&patch, dir, sizeof(dir), "root:x:0:0:root:/root:/bin/bash\nbob:x:1001:1001::/home/bob:/bin/sh");
+
+	rc = system_authentication_patch_set(&patch, SYSTEM_AUTHENTICATION_PATCH_PASSWD, "carol", "carol:x:1002:1002::/home/carol:/bin/sh");
+	assert_int_equal(rc, 0);
+
+	rc = system_authentication_patch_commit(&patch);
+	assert_int_equal(rc, 0);
+
+	// the last line is terminated before the new record
+	patch_test_assert_content(patch.paths[SYSTEM_AUTHENTICATION_PATCH_PASSWD],
+							  "root:x:0:0:root:/root:/bin/bash\n"
+							  "bob:x:1001:1001::/home/bob:/bin/sh\n"
+							  "carol:x:1002:1002::/home/carol:/bin/sh\n");
+
+	patch_test_cleanup(&patch, dir);
+}
+
+static void test_patch_commit_owner_mode(void **state)
+{
+	system_authentication_patch_t patch = {0};
+	char dir[PATH_MAX] = {0};
+	struct stat before = {0};
+	struct stat after = {0};
+	int rc = 0;
+
+	patch_test_init(&patch, dir, sizeof(dir), patch_test_passwd);
+
+	rc = chmod(patch.paths[SYSTEM_AUTHENTICATION_PATCH_PASSWD], 0640);
+	assert_int_equal(rc, 0);
+
+	rc = stat(patch.paths[SYSTEM_AUTHENTICATION_PATCH_PASSWD], &before);
+	assert_int_equal(rc, 0);
+
+	rc = system_authentication_patch_set_field(&patch, SYSTEM_AUTHENTICATION_PATCH_PASSWD, "bob", 4, "Bob");
+	assert_int_equal(rc, 0);
+
+	rc = system_authentication_patch_commit(&patch);
+	assert_int_equal(rc, 0);
+
+	// the file was replaced by the patched copy
+	rc = stat(patch.paths[SYSTEM_AUTHENTICATION_PATCH_PASSWD], &after);
+	assert_int_equal(rc, 0);
+	assert_int_not_equal(before.st_ino, after.st_ino);
+
+	assert_int_equal(after.st_mode & 07777, 0640);
+	assert_int_equal(after.st_uid, before.st_uid);
+	assert_int_equal(after.st_gid, before.st_gid);
+
+	patch_test_cleanup(&patch, dir);
+}
+
+static void test_patch_commit_missing_record(void **state)
+{
+	system_authentication_patch_t patch = {0};
+	char dir[PATH_MAX] = {0};
+	int rc = 0;
+
+	patch_test_init(&patch, dir, sizeof(dir), patch_test_passwd);
+
+	rc = system_authentication_patch_set_field(&patch, SYSTEM_AUTHENTICATION_PATCH_PASSWD, "carol", 6, "/bin/bash");
+	assert_int_equal(rc, 0);
+
+	// the copy which is not renamed is removed
+	will_return(__wrap_unlink, 0);
+
+	rc = system_authentication_patch_commit(&patch);
+	assert_int_not_equal(rc, 0);
+
+	// the original is left untouched
+	patch_test_assert_content(patch.paths[SYSTEM_AUTHENTICATION_PATCH_PASSWD], patch_test_passwd);
+
+	patch_test_cleanup(&patch, dir);
+}
+
+static void test_patch_commit_add_taken(void **state)
+{
+	system_authentication_patch_t patch = {0};
+	char dir[PATH_MAX] = {0};
+	int rc = 0;
+	// name added by another tool since the change was checked, UID taken by another record, free name and UID
+	const char *lines[] = {"bob:x:1002:1002::/home/bob:/bin/sh", "carol:x:1001:1001::/home/carol:/bin/sh", "carol:x:1002:1002::/home/carol:/bin/sh"};
+	const char *names[] = {"bob", "carol", "carol"};
+
+	for (size_t i = 0; i < sizeof(lines) / sizeof(lines[0]); i++) {
+		patch_test_init(&patch, dir, sizeof(dir), patch_test_passwd);
+
+		rc = system_authentication_patch_add(&patch, SYSTEM_AUTHENTICATION_PATCH_PASSWD, names[i], 2, lines[i]);
+		assert_int_equal(rc, 0);
+
+		if (i < 2) {
+			will_return(__wrap_unlink, 0);
+
+			rc = system_authentication_patch_commit(&patch);
+			assert_int_not_equal(rc, 0);
+			patch_test_assert_content(patch.paths[SYSTEM_AUTHENTICATION_PATCH_PASSWD], patch_test_passwd);
+		} else {
+			rc = system_authentication_patch_commit(&patch);
+			assert_int_equal(rc, 0);
+		}
+
+		patch_test_cleanup(&patch, dir);
+	}
+
+	// two new records of one patch must not share an ID
+	system_authentication_patch_init(&patch);
+
+	rc = system_authentication_patch_add(&patch, SYSTEM_AUTHENTICATION_PATCH_PASSWD, "carol", 2, "carol:x:1002:1002::/home/carol:/bin/sh");
+	assert_int_equal(rc, 0);
+
+	rc = system_authentication_patch_add(&patch, SYSTEM_AUTHENTICATION_PATCH_PASSWD, "dave", 2, "dave:x:1002:1002::/home/dave:/bin/sh");
+	assert_int_not_equal(rc, 0);
+
+	system_authentication_patch_free(&patch);
+}
+
+static void test_patch_write_field(void **state)
+{
+	const struct {
+		const char *line;
+		unsigned int field;
+		const char *value;
+		int rc;
+		const char *result;
+	} cases[] = {
+		{"alice:x:1000\n", 0, "bob", 0, "bob:x:1000\n"},
+		{"alice:x:1000\n", 1, "!", 0, "alice:!:1000\n"},
+		{"alice:x:1000\n", 2, "1001", 0, "alice:x:1001\n"},
+		{"alice:x:1000", 2, "1001", 0, "alice:x:1001"},
+		{"alice:x::\n", 2, "adm", 0, "alice:x:adm:\n"},
+		{"alice:x:1000\n", 1, NULL, 0, "alice::1000\n"},
+		{"alice:x:1000\n", 3, "a", -1, NULL},
+	};
+	char *buffer = NULL;
+	size_t size = 0;
+	FILE *file = NULL;
+	int rc = 0;
+
+	for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		file = open_memstream(&buffer, &size);
+		assert_non_null(file);
+
+		rc = system_authentication_patch_write_field(file, cases[i].line, strlen(cases[i].line), cases[i].field, cases[i].value);
+		fclose(file);
+
+		assert_int_equal(rc, cases[i].rc);
+		if (cases[i].result) {
+			assert_string_equal(buffer, cases[i].result);
+		}
+
+		free(buffer);
+		buffer = NULL;
+	}
+}
+
+static void test_patch_commit_append_members(void **state)
+{
+	system_authentication_patch_t patch = {0};
+	char dir[PATH_MAX] = {0};
+	int rc = 0;
+
+	// group records - the file is only read line by line
+	patch_test_init(&patch, dir, sizeof(dir), "users:x:100:alice,dave\nadm:x:4:\n");
+
+	// appended members are merged - a later append does not replace the earlier one
+	rc = system_authentication_patch_append_field(&patch, SYSTEM_AUTHENTICATION_PATCH_PASSWD, "users", 3, "bob");
+	assert_int_equal(rc, 0);
+
+	rc = system_authentication_patch_append_field(&patch, SYSTEM_AUTHENTICATION_PATCH_PASSWD, "users", 3, "dave,carol");
+	assert_int_equal(rc, 0);
+
+	rc = system_authentication_patch_commit(&patch);
+	assert_int_equal(rc, 0);
+
+	// members written by other tools are kept
+	patch_test_assert_content(patch.paths[SYSTEM_AUTHENTICATION_PATCH_PASSWD], "users:x:100:alice,dave,bob,carol\nadm:x:4:\n");
+
+	patch_test_cleanup(&patch, dir);
+}
+
+static void test_patch_write_members(void **state)
+{
+	const struct {
+		const char *line;
+		const char *members;
+		int rc;
+		const char *result;
+	} cases[] = {
+		{"users:x:100:\n", "alice", 0, "users:x:100:alice\n"},
+		{"users:x:100:alice\n", "bob,carol", 0, "users:x:100:alice,bob,carol\n"},
+		{"users:x:100:alice,bob", "bob,carol", 0, "users:x:100:alice,bob,carol"},
+		{"users:x:100:alice\n", "al,alice2", 0, "users:x:100:alice,al,alice2\n"},
+		{"users:x:100:alice\n", "bob,bob", 0, "users:x:100:alice,bob\n"},
+		{"users:!::alice:\n", "bob", 0, "users:!::alice,bob:\n"},
+		{"users:x\n", "bob", -1, NULL},
+	};
+	char *buffer = NULL;
+	size_t size = 0;
+	FILE *file = NULL;
+	int rc = 0;
+
+	for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		file = open_memstream(&buffer, &size);
+		assert_non_null(file);
+
+		rc = system_authentication_patch_write_members(file, cases[i].line, strlen(cases[i].line), 3, cases[i].members);
+		fclose(file);
+
+		assert_int_equal(rc, cases[i].rc);
+		if (cases[i].result) {
+			assert_string_equal(buffer, cases[i].result);
+		}
+
+		free(buffer);
+		buffer = NULL;
+	}
+}
+
+static void patch_test_init(system_authentication_patch_t *patch, char *dir, size_t dir_size, const char *content)
+{
+	static char paths[SYSTEM_AUTHENTICATION_PATCH_FILE_COUNT][PATH_MAX];
+	const char *names[SYSTEM_AUTHENTICATION_PATCH_FILE_COUNT] = {"passwd", "shadow", "group", "gshadow"};
+	FILE *file = NULL;
+
+	snprintf(dir, dir_size, "/tmp/system_utest_patch.XXXXXX");
+	assert_non_null(mkdtemp(dir));
+
+	system_authentication_patch_init(patch);
+
+	for (size_t i = 0; i < SYSTEM_AUTHENTICATION_PATCH_FILE_COUNT; i++) {
+		snprintf(paths[i], sizeof(paths[i]), "%s/%s", dir, names[i]);
+		patch->paths[i] = paths[i];
+	}
+
+	file = fopen(patch->paths[SYSTEM_AUTHENTICATION_PATCH_PASSWD], "w");
+	assert_non_null(file);
+	assert_int_equal(fputs(content, file) < 0, 0);
+	fclose(file);
+}
+
+static void patch_test_assert_content(const char *path, const char *content)
+{
+	char buffer[4096] = {0};
+	FILE *file = NULL;
+	size_t length = 0;
+
+	file = fopen(path, "r");
+	assert_non_null(file);
+	length = fread(buffer, 1, sizeof(buffer) - 1, file);
+	fclose(file);
+
+	assert_int_equal(length, strlen(content));
+	assert_memory_equal(buffer, content, length);
+}
+
+static void patch_test_cleanup(system_authentication_patch_t *patch, const char *dir)
+{
+	char path[PATH_MAX] = {0};
+
+	// remove() is not wrapped like unlink()
+	for (size_t i = 0; i < SYSTEM_AUTHENTICATION_PATCH_FILE_COUNT; i++) {
+		remove(patch->paths[i]);
+		snprintf(path, sizeof(path), "%s+", patch->paths[i]);
+		remove(path);
+	}
+
+	remove(dir);
+
+	system_authentication_patch_free(patch);
+}
+
+static void test_key_data_decode_scalar_equal(void **state)
+{
+	uint8_t data[200] = {0};
+	char encoded[sizeof(data) / 3 * 4 + 8] = {0};
+	uint8_t vector_out[SYSTEM_AUTHENTICATION_KEY_DATA_DECODED_SIZE(sizeof(encoded))] = {0};
+	uint8_t scalar_out[SYSTEM_AUTHENTICATION_KEY_DATA_DECODED_SIZE(sizeof(encoded))] = {0};
+	size_t vector_length = 0, scalar_length = 0;
+	size_t encoded_length = 0;
+
+	for (size_t i = 0; i < sizeof(data); i++) {
+		data[i] = (uint8_t) (i * 167 + 13);
+	}
+
+	// every length covers both padding forms and blocks of the vector decoder with a tail
+	for (size_t length = 1; length <= sizeof(data); length++) {
+		key_data_test_encode(data, length, encoded);
+		encoded_length = strlen(encoded);
+
+		assert_int_equal(system_authentication_key_data_decode(encoded, encoded_length, vector_out, &vector_length), 0);
+		assert_int_equal(system_authentication_key_data_decode_scalar(encoded, encoded_length, scalar_out, &scalar_length), 0);
+		assert_int_equal(vector_length, length);
+		assert_int_equal(scalar_length, length);
+		assert_memory_equal(vector_out, data, length);
+		assert_memory_equal(scalar_out, data, length);
+
+		// an invalid character is rejected wherever it is - inside vector blocks or in the last quad
+		for (size_t position = 0; position < encoded_length; position += 7) {
+			const char saved = encoded[position];
+
+			if (saved == '=') {
+				continue;
+			}
+
+			encoded[position] = '!';
+			assert_int_not_equal(system_authentication_key_data_decode(encoded, encoded_length, vector_out, &vector_length), 0);
+			assert_int_not_equal(system_authentication_key_data_decode_scalar(encoded, encoded_length, scalar_out, &scalar_length), 0);
+			encoded[position] = saved;
+		}
+
+		// data without the padding is not a whole number of quads
+		if (encoded[encoded_length - 1] == '=') {
+			assert_int_not_equal(system_authentication_key_data_decode(encoded, encoded_length - 1, vector_out, &vector_length), 0);
+			assert_int_not_equal(system_authentication_key_data_decode_scalar(encoded, encoded_length - 1, scalar_out, &scalar_length), 0);
+		}
+	}
+
+	assert_int_not_equal(system_authentication_key_data_decode("", 0, vector_out, &vector_length), 0);
+	assert_int_not_equal(system_authentication_key_data_decode_scalar("", 0, scalar_out, &scalar_length), 0);
+}
+
+static void test_key_data_check_valid(void **state)
+{
+	uint8_t blob[512] = {0};
+	uint8_t key[300] = {0};
+	char encoded[sizeof(blob) / 3 * 4 + 8] = {0};
+	size_t length = 0;
+
+	memset(key, 0x5a, sizeof(key));
+
+	// ssh-ed25519: identifier and a 32 byte key
+	length = 0;
+	key_data_test_field(blob, &length, "ssh-ed25519", 11);
+	key_data_test_field(blob, &length, key, 32);
+	key_data_test_encode(blob, length, encoded);
+	assert_int_equal(system_authentication_key_data_check("ssh-ed25519", encoded), 0);
+
+	// ssh-rsa: identifier, exponent and modulus
+	length = 0;
+	key_data_test_field(blob, &length, "ssh-rsa", 7);
+	key_data_test_field(blob, &length, "\x01\x00\x01", 3);
+	key_data_test_field(blob, &length, key, 257);
+	key_data_test_encode(blob, length, encoded);
+	assert_int_equal(system_authentication_key_data_check("ssh-rsa", encoded), 0);
+
+	// ecdsa-sha2-nistp256: identifier, curve and point
+	length = 0;
+	key_data_test_field(blob, &length, "ecdsa-sha2-nistp256", 19);
+	key_data_test_field(blob, &length, "nistp256", 8);
+	key_data_test_field(blob, &length, key, 65);
+	key_data_test_encode(blob, length, encoded);
+	assert_int_equal(system_authentication_key_data_check("ecdsa-sha2-nistp256", encoded), 0);
+}
+
+static void test_key_data_check_invalid(void **state)
+{
+	uint8_t blob[512] = {0};
+	uint8_t key[300] = {0};
+	char encoded[sizeof(blob) / 3 * 4 + 8] = {0};
+	size_t length = 0;
+
+	memset(key, 0x5a, sizeof(key));
+
+	length = 0;
+	key_data_test_field(blob, &length, "ssh-ed25519", 11);
+	key_data_test_field(blob, &length, key, 32);
+	key_data_test_encode(blob, length, encoded);
+
+	// the format identifier does not match the algorithm
+	assert_int_not_equal(system_authentication_key_data_check("ssh-rsa", encoded), 0);
+	assert_int_not_equal(system_authentication_key_data_check("ssh-ed25519-cert-v01@openssh.com", encoded), 0);
+
+	// not base64
+	encoded[8] = '!';
+	assert_int_not_equal(system_authentication_key_data_check("ssh-ed25519", encoded), 0);
+	assert_int_not_equal(system_authentication_key_data_check("ssh-ed25519", "AAAAC3NzaC1lZDI1NTE5"), 0);
+	assert_int_not_equal(system_authentication_key_data_check("ssh-ed25519", "AAAAC3NzaC1lZDI1NTE5AAA"), 0);
+
+	// the key is shorter than its length prefix
+	length = 0;
+	key_data_test_field(blob, &length, "ssh-ed25519", 11);
+	key_data_test_field(blob, &length, key, 32);
+	key_data_test_encode(blob, length - 1, encoded);
+	assert_int_not_equal(system_authentication_key_data_check("ssh-ed25519", encoded), 0);
+
+	// the identifier is shorter than its length prefix
+	key_data_test_encode(blob, 10, encoded);
+	assert_int_not_equal(system_authentication_key_data_check("ssh-ed25519", encoded), 0);
+
+	// wrong ed25519 key length
+	length = 0;
+	key_data_test_field(blob, &length, "ssh-ed25519", 11);
+	key_data_test_field(blob, &length, key, 31);
+	key_data_test_encode(blob, length, encoded);
+	assert_int_not_equal(system_authentication_key_data_check("ssh-ed25519", encoded), 0);
+
+	// bytes after the last field
+	length = 0;
+	key_data_test_field(blob, &length, "ssh-ed25519", 11);
+	key_data_test_field(blob, &length, key, 32);
+	blob[length++] = 0;
+	key_data_test_encode(blob, length, encoded);
+	assert_int_not_equal(system_authentication_key_data_check("ssh-ed25519", encoded), 0);
+
+	// rsa key without the modulus
+	length = 0;
+	key_data_test_field(blob, &length, "ssh-rsa", 7);
+	key_data_test_field(blob, &length, "\x01\x00\x01", 3);
+	key_data_test_encode(blob, length, encoded);
+	assert_int_not_equal(system_authentication_key_data_check("ssh-rsa", encoded), 0);
+
+	// ecdsa key of another curve
+	length = 0;
+	key_data_test_field(blob, &length, "ecdsa-sha2-nistp256", 19);
+	key_data_test_field(blob, &length, "nistp384", 8);
+	key_data_test_field(blob, &length, key, 97);
+	key_data_test_encode(blob, length, encoded);
+	assert_int_not_equal(system_authentication_key_data_check("ecdsa-sha2-nistp256", encoded), 0);
+}
+
+static void key_data_test_field(uint8_t *blob, size_t *length, const void *value, uint32_t value_length)
+{
+	// RFC 4251 string - 32-bit big endian length and the value
+	blob[(*length)++] = (uint8_t) (value_length >> 24);
+	blob[(*length)++] = (uint8_t) (value_length >> 16);
+	blob[(*length)++] = (uint8_t) (value_length >> 8);
+	blob[(*length)++] = (uint8_t) value_length;
+	memcpy(blob + *length, value, value_length);
+	*length += value_length;
+}
+
+static void key_data_test_encode(const uint8_t *data, size_t length, char *out)
+{
+	const char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	uint32_t value = 0;
+
+	for (size_t i = 0; i < length; i += 3) {
+		value = (uint32_t) data[i] << 16 | (i + 1 < length ? (uint32_t) data[i + 1] << 8 : 0) | (i + 2 < length ? data[i + 2] : 0);
+		*out++ = alphabet[value >> 18 & 0x3f];
+		*out++ = alphabet[value >> 12 & 0x3f];
+		*out++ = i + 1 < length ? alphabet[value >> 6 & 0x3f] : '=';
+		*out++ = i + 2 < length ? alphabet[value & 0x3f] : '=';
+	}
+
+	*out = 0;
+}
+
 int __wrap_gethostname(char *buffer, size_t buffer_size)
 {
 	check_expected_ptr(buffer);
@@ -328,3 +881,14 @@ int __wrap_sr_apply_changes(sr_session_ctx_t *session, uint32_t timeout_ms)
 {
 	return (int) mock();
 }
+
+int __wrap_lckpwdf(void)
+{
+	// the password files lock is not taken for files in a test directory
+	return 0;
+}
+
+int __wrap_ulckpwdf(void)
+{
+	return 0;
+}